@@ -251,6 +251,15 @@ QList< Interval<int> > AbstractColumn::maskedIntervals() const {
 	return m_abstract_column_private->m_masking.intervals();
 }
 
+/**
+ * \brief Return the bitmap of the masked rows
+ *
+ * The bitmap shares its data with the column (implicit sharing), use it to test or process many rows at once.
+ */
+MaskBitmap AbstractColumn::maskedRows() const {
+	return m_abstract_column_private->m_masking;
+}
+
 /**
  * \brief Clear all masking information
  */
@@ -277,6 +286,19 @@ void AbstractColumn::setMasked(int row, bool mask) {
 	setMasked(Interval<int>(row,row), mask);
 }
 
+/**
+ * \brief Reorder the masking of the rows
+ *
+ * Row i gets the masking of row permutation[i], used when the data of the column was reordered.
+ */
+void AbstractColumn::permuteMasks(const QVector<int>& permutation) {
+	if (m_abstract_column_private->m_masking.isEmpty())
+		return;
+
+	exec(new AbstractColumnPermuteMasksCmd(m_abstract_column_private, permutation),
+			"maskingAboutToChange", "maskingChanged", Q_ARG(const AbstractColumn*,this));
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //@}
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -42,6 +42,7 @@ class QDate;
 class QTime;
 template<class T> class QList;
 template<class T> class Interval;
+class MaskBitmap;
 
 class AbstractColumn : public AbstractAspect
 {
@@ -90,6 +91,7 @@ class AbstractColumn : public AbstractAspect
 		bool isMasked(int row) const;
 		bool isMasked(Interval<int> i) const;
 		QList< Interval<int> > maskedIntervals() const;
+		MaskBitmap maskedRows() const;
 		void clearMasks();
 		void setMasked(Interval<int> i, bool mask = true);
 		void setMasked(int row, bool mask = true);
@@ -100,8 +102,8 @@ class AbstractColumn : public AbstractAspect
 		virtual void setFormula(int row, QString formula);
 		virtual void clearFormulas();
 
-		double minimum() const;
-		double maximum() const;
+		virtual double minimum() const;
+		virtual double maximum() const;
 
 		virtual QString textAt(int row) const;
 		virtual void setTextAt(int row, const QString& new_value);
@@ -138,6 +140,7 @@ class AbstractColumn : public AbstractAspect
 
 		virtual void handleRowInsertion(int before, int count);
 		virtual void handleRowRemoval(int first, int count);
+		void permuteMasks(const QVector<int>& permutation);
 
 	private:
 		AbstractColumnPrivate* m_abstract_column_private;
@@ -146,6 +149,7 @@ class AbstractColumn : public AbstractAspect
 		friend class AbstractColumnInsertRowsCmd;
 		friend class AbstractColumnClearMasksCmd;
 		friend class AbstractColumnSetMaskedCmd;
+		friend class AbstractColumnPermuteMasksCmd;
 };
 
 #endif
@@ -31,7 +31,7 @@
 #define ABSTRACT_COLUMN_PRIVATE_H
 
 #include "backend/core/AbstractColumn.h"
-#include "backend/lib/IntervalAttribute.h"
+#include "backend/lib/MaskBitmap.h"
 
 class AbstractColumnPrivate {
 	public:
@@ -42,7 +42,7 @@ class AbstractColumnPrivate {
 
 	public:
 		AbstractColumn *m_owner;
-		IntervalAttribute<bool> m_masking;
+		MaskBitmap m_masking;
 };
 
 #endif // ifndef ABSTRACT_COLUMN_PRIVATE_H
@@ -104,6 +104,13 @@ void AspectTreeModel::setSelectableAspects(QList<const char*> list) {
 	m_selectableAspects=list;
 }
 
+/*!
+  the aspects in \c list are shown but can't be selected, even if their class is selectable
+*/
+void AspectTreeModel::setNonSelectableAspects(const QList<const AbstractAspect*>& list) {
+	m_nonSelectableAspects = list;
+}
+
 QModelIndex AspectTreeModel::index(int row, int column, const QModelIndex &parent) const {
 	if (!hasIndex(row, column, parent))
 		return QModelIndex();
@@ -254,6 +261,9 @@ Qt::ItemFlags AspectTreeModel::flags(const QModelIndex &index) const {
 			result = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
 	}
 
+	if (m_nonSelectableAspects.contains(aspect))
+		result &= ~(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+
 	//the columns "name" and "description" are editable
 	if (index.column() == 0 || index.column() == 3)
 		result |= Qt::ItemIsEditable;
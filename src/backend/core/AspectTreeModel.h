@@ -54,6 +54,7 @@ public:
 	bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
 	Qt::ItemFlags flags(const QModelIndex &index) const;
 	void setSelectableAspects(QList<const char*>);
+	void setNonSelectableAspects(const QList<const AbstractAspect*>&);
 	QModelIndex modelIndexOfAspect(const AbstractAspect*, int column=0) const;
 	QModelIndex modelIndexOfAspect(const QString& path, int column=0) const;
 
@@ -77,6 +78,7 @@ private:
 	AbstractAspect* m_root;
 	bool m_folderSelectable;
 	QList<const char*> m_selectableAspects;
+	QList<const AbstractAspect*> m_nonSelectableAspects;
 	int m_defaultHeaderHeight;
 
 	QString m_filterString;
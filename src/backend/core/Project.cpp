@@ -29,6 +29,7 @@
 #include "backend/core/Project.h"
 #include "backend/lib/XmlStreamReader.h"
 #include "backend/spreadsheet/Spreadsheet.h"
+#include "backend/spreadsheet/FormulaEngine.h"
 #include "backend/worksheet/Worksheet.h"
 #include "backend/worksheet/plots/cartesian/XYEquationCurve.h"
 #include "backend/worksheet/plots/cartesian/XYDataReductionCurve.h"
@@ -39,6 +40,7 @@
 #include "backend/worksheet/plots/cartesian/XYFitCurve.h"
 #include "backend/worksheet/plots/cartesian/XYFourierFilterCurve.h"
 #include "backend/worksheet/plots/cartesian/XYFourierTransformCurve.h"
+#include "backend/worksheet/plots/cartesian/XYPowerSpectrumCurve.h"
 #include "backend/worksheet/plots/cartesian/Axis.h"
 #include "backend/datapicker/DatapickerCurve.h"
 
@@ -81,6 +83,7 @@ class Project::Private {
 		Private() :
 			mdiWindowVisibility(Project::folderOnly),
 			scriptingEngine(0),
+			formulaEngine(0),
 			version(LVERSION),
 			author(QString(qgetenv("USER"))),
 			modificationTime(QDateTime::currentDateTime()),
@@ -91,6 +94,7 @@ class Project::Private {
 		QUndoStack undo_stack;
 		MdiWindowVisibility mdiWindowVisibility;
 		AbstractScriptingEngine* scriptingEngine;
+		FormulaEngine* formulaEngine;
 		QString fileName;
 		QString version;
 		QString author;
@@ -122,6 +126,10 @@ Project::Project() : Folder(i18n("Project")), d(new Private()) {
 // 	d->scriptingEngine = ScriptingEngineManager::instance()->engine(engine_name);
 
 	connect(this, SIGNAL(aspectDescriptionChanged(const AbstractAspect*)),this, SLOT(descriptionChanged(const AbstractAspect*)));
+
+	//recalculation of the formula columns
+	d->formulaEngine = new FormulaEngine(this);
+	connect(d->formulaEngine, SIGNAL(statusInfo(QString)), this, SIGNAL(statusInfo(QString)));
 }
 
 Project::~Project() {
@@ -131,6 +139,7 @@ Project::~Project() {
 	foreach(Worksheet* w, children<Worksheet>())
 		w->setIsClosing();
 
+	delete d->formulaEngine;
 	d->undo_stack.clear();
 	delete d;
 }
@@ -165,6 +174,10 @@ AbstractScriptingEngine* Project::scriptingEngine() const {
 	return d->scriptingEngine;
 }
 
+FormulaEngine* Project::formulaEngine() const {
+	return d->formulaEngine;
+}
+
 CLASS_D_ACCESSOR_IMPL(Project, QString, fileName, FileName, fileName)
 BASIC_D_ACCESSOR_IMPL(Project, QString, version, Version, version)
 CLASS_D_ACCESSOR_IMPL(Project, QString, author, Author, author)
@@ -315,6 +328,7 @@ bool Project::load(XmlStreamReader* reader) {
 					XYFitCurve* fitCurve = dynamic_cast<XYFitCurve*>(aspect);
 					XYFourierFilterCurve* filterCurve = dynamic_cast<XYFourierFilterCurve*>(aspect);
 					XYFourierTransformCurve* dftCurve = dynamic_cast<XYFourierTransformCurve*>(aspect);
+					XYPowerSpectrumCurve* psdCurve = dynamic_cast<XYPowerSpectrumCurve*>(aspect);
 					if (equationCurve) {
 						//curves defined by a mathematical equations recalculate their own columns on load again.
 						equationCurve->recalculate();
@@ -343,6 +357,9 @@ bool Project::load(XmlStreamReader* reader) {
 					} else if (dftCurve) {
 						RESTORE_COLUMN_POINTER(dftCurve, xDataColumn, XDataColumn);
 						RESTORE_COLUMN_POINTER(dftCurve, yDataColumn, YDataColumn);
+					} else if (psdCurve) {
+						RESTORE_COLUMN_POINTER(psdCurve, xDataColumn, XDataColumn);
+						RESTORE_COLUMN_POINTER(psdCurve, yDataColumn, YDataColumn);
 					} else {
 						RESTORE_COLUMN_POINTER(curve, xColumn, XColumn);
 						RESTORE_COLUMN_POINTER(curve, yColumn, YColumn);
@@ -35,6 +35,7 @@
 
 class QString;
 class AbstractScriptingEngine;
+class FormulaEngine;
 
 class Project : public Folder {
 	Q_OBJECT
@@ -59,6 +60,7 @@ class Project : public Folder {
 		virtual QMenu* createFolderContextMenu(const Folder*);
 
 		AbstractScriptingEngine* scriptingEngine() const;
+		FormulaEngine* formulaEngine() const;
 
 		void setMdiWindowVisibility(MdiWindowVisibility visibility);
 		MdiWindowVisibility mdiWindowVisibility() const;
@@ -256,3 +256,95 @@ void AbstractColumnRemoveRowsCmd::undo() {
 	m_col->m_masking = m_masking;
 }
 
+/** ***************************************************************************
+ * \class AbstractColumnPermuteMasksCmd
+ * \brief Reorder the masking of the rows like the data of the column
+ ** ***************************************************************************/
+
+/**
+ * \var AbstractColumnPermuteMasksCmd::m_col
+ * \brief The private AbstractColumn data to modify
+ */
+
+/**
+ * \var AbstractColumnPermuteMasksCmd::m_permutation
+ * \brief Row i gets the masking of row m_permutation[i]
+ */
+
+/**
+ * \var AbstractColumnPermuteMasksCmd::m_masking
+ * \brief The old masks
+ */
+
+/**
+ * \var AbstractColumnPermuteMasksCmd::m_new_masking
+ * \brief The reordered masks
+ */
+
+/**
+ * \var AbstractColumnPermuteMasksCmd::m_copied
+ * \brief A status flag
+ */
+
+/**
+ * \brief Ctor
+ */
+AbstractColumnPermuteMasksCmd::AbstractColumnPermuteMasksCmd(AbstractColumnPrivate * col, const QVector<int>& permutation, QUndoCommand * parent)
+: QUndoCommand( parent ), m_col(col), m_permutation(permutation)
+{
+	setText(i18n("%1: reorder masks", col->name()));
+	m_copied = false;
+}
+
+/**
+ * \brief Dtor
+ */
+AbstractColumnPermuteMasksCmd::~AbstractColumnPermuteMasksCmd()
+{
+}
+
+/**
+ * \brief Execute the command
+ */
+void AbstractColumnPermuteMasksCmd::redo()
+{
+	if(!m_copied)
+	{
+		m_masking = m_col->m_masking;
+
+		//rows behind the permutation keep their masking
+		const int rows = m_permutation.size();
+		m_new_masking = m_masking;
+		m_new_masking.setValue(Interval<int>(0, rows - 1), false);
+
+		int start = -1;
+		for(int i=0; i<rows; i++)
+		{
+			if(m_masking.isSet(m_permutation.at(i)))
+			{
+				if(start == -1)
+					start = i;
+			}
+			else if(start != -1)
+			{
+				m_new_masking.setValue(Interval<int>(start, i-1));
+				start = -1;
+			}
+		}
+		if(start != -1)
+			m_new_masking.setValue(Interval<int>(start, rows-1));
+
+		m_copied = true;
+	}
+	m_col->m_masking = m_new_masking;
+	emit m_col->owner()->dataChanged(m_col->owner());
+}
+
+/**
+ * \brief Undo the command
+ */
+void AbstractColumnPermuteMasksCmd::undo()
+{
+	m_col->m_masking = m_masking;
+	emit m_col->owner()->dataChanged(m_col->owner());
+}
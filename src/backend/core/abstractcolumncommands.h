@@ -32,6 +32,7 @@
 
 #include "AbstractColumnPrivate.h"
 #include <QUndoCommand>
+#include <QVector>
 
 class AbstractColumnClearMasksCmd : public QUndoCommand {
 public:
@@ -43,7 +44,7 @@ public:
 
 private:
 	AbstractColumnPrivate *m_col;
-	IntervalAttribute<bool> m_masking;
+	MaskBitmap m_masking;
 	bool m_copied;
 
 };
@@ -61,7 +62,7 @@ private:
 	AbstractColumnPrivate * m_col;
 	Interval<int> m_interval;
 	bool m_masked;
-	IntervalAttribute<bool> m_masking;
+	MaskBitmap m_masking;
 	bool m_copied;
 
 };
@@ -94,7 +95,24 @@ protected:
 	AbstractColumnPrivate * m_col;
 	int m_first;
 	int m_count;
-	IntervalAttribute<bool> m_masking;
+	MaskBitmap m_masking;
+};
+
+class AbstractColumnPermuteMasksCmd : public QUndoCommand
+{
+public:
+	explicit AbstractColumnPermuteMasksCmd(AbstractColumnPrivate * col, const QVector<int>& permutation, QUndoCommand * parent = 0 );
+	~AbstractColumnPermuteMasksCmd();
+
+	virtual void redo();
+	virtual void undo();
+
+private:
+	AbstractColumnPrivate * m_col;
+	QVector<int> m_permutation;
+	MaskBitmap m_masking;
+	MaskBitmap m_new_masking;
+	bool m_copied;
 };
 
 #endif // ifndef ABSTRACTCOLUMNCOMMANDS_H
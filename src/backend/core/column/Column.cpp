@@ -31,6 +31,8 @@
 #include "backend/core/column/ColumnPrivate.h"
 #include "backend/core/column/columncommands.h"
 #include "backend/lib/XmlStreamReader.h"
+#include "backend/lib/PackedDateTime.h"
+#include "backend/lib/TextDictionary.h"
 #include "backend/core/datatypes/String2DateTimeFilter.h"
 #include "backend/core/datatypes/DateTime2StringFilter.h"
 
@@ -102,7 +104,7 @@ Column::Column(const QString& name, QStringList data)
  * \param data initial data vector
  */
 Column::Column(const QString& name, QList<QDateTime> data)
-	: AbstractColumn(name), m_column_private( new ColumnPrivate(this, AbstractColumn::DateTime, new QList<QDateTime>(data)) ) {
+	: AbstractColumn(name), m_column_private( new ColumnPrivate(this, AbstractColumn::DateTime, new QVector<qint64>(PackedDateTime::pack(data))) ) {
 	init();
 }
 
@@ -390,6 +392,33 @@ void Column::replaceValues(int first, const QVector<double>& new_values) {
 	}
 }
 
+/**
+ * \brief Reorder the rows: row i gets the value and the masking of row permutation[i]
+ *
+ * The rows behind the permutation are not changed.
+ * Only the permutation is kept for undo, not a copy of the data.
+ */
+void Column::permuteRows(const QVector<int>& permutation) {
+	if (permutation.isEmpty() || permutation.size() > rowCount())
+		return;
+
+	setStatisticsAvailable(false);
+	beginMacro(i18n("%1: reorder rows", name()));
+	exec(new ColumnPermuteRowsCmd(m_column_private, permutation));
+	permuteMasks(permutation);
+	endMacro();
+}
+
+/**
+ * \brief Set the memory used by the undo commands for the data of all columns
+ *
+ * When the limit is reached, the data of older commands is compressed and, if that is not enough,
+ * written to temporary files, see ColumnRowsBackup.
+ */
+void Column::setUndoMemoryLimit(qint64 bytes) {
+	ColumnRowsBackup::setMemoryLimit(bytes);
+}
+
 void Column::setStatisticsAvailable(bool available) {
 	m_column_private->statisticsAvailable = available;
 }
@@ -556,12 +585,55 @@ double Column::valueAt(int row) const {
 	return m_column_private->valueAt(row);
 }
 
+/**
+ * \brief Return the smallest value
+ *
+ * For DateTime, Month and Day columns this is the smallest date time as Julian day (see DateTime2DoubleFilter).
+ */
+double Column::minimum() const {
+	if (columnMode() == AbstractColumn::Numeric || columnMode() == AbstractColumn::Text)
+		return AbstractColumn::minimum();
+
+	//the order of the packed values is the order of the date times
+	const QVector<qint64>* values = static_cast< QVector<qint64>* >(data());
+	qint64 min = Q_INT64_C(0x7fffffffffffffff);
+	bool valid = false;
+	for (int row = 0; row < values->size(); ++row) {
+		const qint64 value = values->at(row);
+		if (PackedDateTime::isValid(value) && value <= min) {
+			min = value;
+			valid = true;
+		}
+	}
+	return valid ? PackedDateTime::toJulianDay(min) : INFINITY;
+}
+
+/**
+ * \brief Return the largest value
+ *
+ * For DateTime, Month and Day columns this is the largest date time as Julian day (see DateTime2DoubleFilter).
+ */
+double Column::maximum() const {
+	if (columnMode() == AbstractColumn::Numeric || columnMode() == AbstractColumn::Text)
+		return AbstractColumn::maximum();
+
+	//invalid values are smaller than all valid values
+	const QVector<qint64>* values = static_cast< QVector<qint64>* >(data());
+	qint64 max = PackedDateTime::invalid();
+	for (int row = 0; row < values->size(); ++row)
+		max = qMax(max, values->at(row));
+	return PackedDateTime::isValid(max) ? PackedDateTime::toJulianDay(max) : -INFINITY;
+}
+
 /*
  * call this function if the data of the column was changed directly via the data()-pointer
  * and not via the setValueAt() in order to emit the dataChanged-signal.
  * This is used e.g. in \c XYFitCurvePrivate::recalculate()
  */
 void Column::setChanged() {
+	if (columnMode() == AbstractColumn::Text)
+		m_column_private->internTexts();
+
 	if (!m_suppressDataChangedSignal)
 		emit dataChanged(this);
 
@@ -652,14 +724,30 @@ void Column::save(QXmlStreamWriter* writer) const {
 			writer->writeCharacters(QByteArray::fromRawData(data,size).toBase64());
 			break;
 		}
-	case AbstractColumn::Text:
-		for(i=0; i<rowCount(); ++i) {
-			writer->writeStartElement("row");
-			writer->writeAttribute("index", QString::number(i));
-			writer->writeCharacters(textAt(i));
-			writer->writeEndElement();
+	case AbstractColumn::Text: {
+			//texts with few distinct values are saved dictionary encoded, the distinct texts and the codes of the rows
+			const QStringList* texts = static_cast< QStringList* >(m_column_private->dataPointer());
+			QVector<int> codes;
+			QStringList dictionary;
+			if (TextDictionary::encode(*texts, texts->size()/2, codes, dictionary)) {
+				writer->writeStartElement("dictionary");
+				foreach (const QString& text, dictionary)
+					writer->writeTextElement("text", text);
+				writer->writeEndElement();
+
+				const char* data = reinterpret_cast<const char*>(codes.constData());
+				writer->writeTextElement("codes", QByteArray::fromRawData(data, codes.size()*sizeof(int)).toBase64());
+				break;
+			}
+
+			for(i=0; i<rowCount(); ++i) {
+				writer->writeStartElement("row");
+				writer->writeAttribute("index", QString::number(i));
+				writer->writeCharacters(textAt(i));
+				writer->writeEndElement();
+			}
+			break;
 		}
-		break;
 
 	case AbstractColumn::DateTime:
 	case AbstractColumn::Month:
@@ -698,6 +786,7 @@ private:
  * \brief Load the column from XML
  */
 bool Column::load(XmlStreamReader* reader) {
+	QStringList dictionary;
 	if(reader->isStartElement() && reader->name() == "column") {
 		if (!readBasicAttributes(reader))
 			return false;
@@ -737,6 +826,10 @@ bool Column::load(XmlStreamReader* reader) {
 					ret_val = XmlReadFormula(reader);
 				else if(reader->name() == "row")
 					ret_val = XmlReadRow(reader);
+				else if(reader->name() == "dictionary")
+					ret_val = XmlReadDictionary(reader, dictionary);
+				else if(reader->name() == "codes")
+					ret_val = XmlReadCodes(reader, dictionary);
 				else { // unknown element
 					reader->raiseWarning(i18n("unknown element '%1'", reader->name().toString()));
 					if (!reader->skipToEndElement()) return false;
@@ -876,6 +969,40 @@ bool Column::XmlReadRow(XmlStreamReader * reader) {
 	return true;
 }
 
+/**
+ * \brief Read XML dictionary element (the distinct texts of a dictionary encoded text column)
+ */
+bool Column::XmlReadDictionary(XmlStreamReader * reader, QStringList& dictionary) {
+	Q_ASSERT(reader->isStartElement() && reader->name() == "dictionary");
+
+	dictionary.clear();
+	while (reader->readNext()) {
+		if (reader->isEndElement() && reader->name() == "dictionary") break;
+
+		if (reader->isStartElement() && reader->name() == "text") {
+			// null strings have no code, only empty strings are in the dictionary
+			const QString text = reader->readElementText();
+			dictionary << (text.isNull() ? QString("") : text);
+		}
+	}
+
+	return !reader->hasError();
+}
+
+/**
+ * \brief Read XML codes element (the codes of the rows of a dictionary encoded text column)
+ */
+bool Column::XmlReadCodes(XmlStreamReader * reader, const QStringList& dictionary) {
+	Q_ASSERT(reader->isStartElement() && reader->name() == "codes");
+
+	const QByteArray bytes = QByteArray::fromBase64(reader->readElementText().toAscii());
+	QVector<int> codes(bytes.size()/sizeof(int));
+	memcpy(codes.data(), bytes.constData(), codes.size()*sizeof(int));
+	m_column_private->replaceTexts(0, TextDictionary::decode(codes, dictionary));
+
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //@}
 ////////////////////////////////////////////////////////////////////////////////
@@ -916,6 +1043,13 @@ AbstractColumn::PlotDesignation Column::plotDesignation() const {
 	return m_column_private->plotDesignation();
 }
 
+/**
+ * \brief Return the filter converting the texts entered by the user into the values of the column
+ */
+AbstractSimpleFilter* Column::inputFilter() const {
+	return m_column_private->inputFilter();
+}
+
 AbstractSimpleFilter* Column::outputFilter() const {
 	return m_column_private->outputFilter();
 }
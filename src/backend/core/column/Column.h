@@ -97,6 +97,7 @@ class Column : public AbstractColumn {
 		int width() const;
 		void setWidth(int value);
 		void clear();
+		AbstractSimpleFilter *inputFilter() const;
 		AbstractSimpleFilter *outputFilter() const;
 		ColumnStringIO *asStringColumn() const;
 
@@ -124,11 +125,16 @@ class Column : public AbstractColumn {
 		void setDateTimeAt(int row, const QDateTime& new_value);
 		void replaceDateTimes(int first, const QList<QDateTime>& new_values);
 		double valueAt(int row) const;
+		virtual double minimum() const;
+		virtual double maximum() const;
 		void setValueAt(int row, double new_value);
 		virtual void replaceValues(int first, const QVector<double>& new_values);
+		void permuteRows(const QVector<int>& permutation);
 		void setChanged();
 		void setSuppressDataChangedSignal(bool);
 
+		static void setUndoMemoryLimit(qint64 bytes);
+
 		void save(QXmlStreamWriter*) const;
 		bool load(XmlStreamReader*);
 
@@ -137,6 +143,8 @@ class Column : public AbstractColumn {
 		bool XmlReadOutputFilter(XmlStreamReader * reader);
 		bool XmlReadFormula(XmlStreamReader * reader);
 		bool XmlReadRow(XmlStreamReader * reader);
+		bool XmlReadDictionary(XmlStreamReader * reader, QStringList& dictionary);
+		bool XmlReadCodes(XmlStreamReader * reader, const QStringList& dictionary);
 
 		void handleRowInsertion(int before, int count);
 		void handleRowRemoval(int first, int count);
@@ -154,6 +162,7 @@ class Column : public AbstractColumn {
 	signals:
 		void widthAboutToChange(const Column*);
 		void widthChanged(const Column*);
+		void formulaChanged(const Column*);
 
 	private slots:
 		void handleFormatChange();
@@ -41,6 +41,8 @@
 #include "backend/core/datatypes/DateTime2DoubleFilter.h"
 #include "backend/core/datatypes/DayOfWeek2DoubleFilter.h"
 #include "backend/core/datatypes/Month2DoubleFilter.h"
+#include "backend/lib/PackedDateTime.h"
+#include <cstring>
 
 
 /**
@@ -63,7 +65,7 @@
  * \brief Pointer to the data vector
  *
  * This will point to a QVector<double>, QStringList or
- * QList<QDateTime> depending on the stored data type.
+ * QVector<qint64> (packed date times, see PackedDateTime) depending on the stored data type.
  */
 
 /**
@@ -95,7 +97,7 @@
  * \brief Ctor
  */
 ColumnPrivate::ColumnPrivate(Column* owner, AbstractColumn::ColumnMode mode)
-	: statisticsAvailable(false), m_column_mode(mode), m_plot_designation(AbstractColumn::noDesignation), m_width(0), m_owner(owner) {
+	: statisticsAvailable(false), m_column_mode(mode), m_plot_designation(AbstractColumn::noDesignation), m_width(0), m_owner(owner), m_intern_texts(true) {
 	Q_ASSERT(owner != 0); // a ColumnPrivate without owner is not allowed
 	// because the owner must become the parent aspect of the input and output filters
 	switch(mode) {
@@ -112,19 +114,19 @@ ColumnPrivate::ColumnPrivate(Column* owner, AbstractColumn::ColumnMode mode)
 	case AbstractColumn::DateTime:
 		m_input_filter = new String2DateTimeFilter();
 		m_output_filter = new DateTime2StringFilter();
-		m_data = new QList<QDateTime>();
+		m_data = new QVector<qint64>();
 		break;
 	case AbstractColumn::Month:
 		m_input_filter = new String2MonthFilter();
 		m_output_filter = new DateTime2StringFilter();
 		static_cast<DateTime2StringFilter *>(m_output_filter)->setFormat("MMMM");
-		m_data = new QList<QDateTime>();
+		m_data = new QVector<qint64>();
 		break;
 	case AbstractColumn::Day:
 		m_input_filter = new String2DayOfWeekFilter();
 		m_output_filter = new DateTime2StringFilter();
 		static_cast<DateTime2StringFilter *>(m_output_filter)->setFormat("dddd");
-		m_data = new QList<QDateTime>();
+		m_data = new QVector<qint64>();
 		break;
 	}
 
@@ -138,7 +140,7 @@ ColumnPrivate::ColumnPrivate(Column* owner, AbstractColumn::ColumnMode mode)
  * \brief Special ctor (to be called from Column only!)
  */
 ColumnPrivate::ColumnPrivate(Column* owner, AbstractColumn::ColumnMode mode, void* data)
-	: statisticsAvailable(false), m_column_mode(mode), m_data(data), m_plot_designation(AbstractColumn::noDesignation), m_width(0), m_owner(owner) {
+	: statisticsAvailable(false), m_column_mode(mode), m_data(data), m_plot_designation(AbstractColumn::noDesignation), m_width(0), m_owner(owner), m_intern_texts(true) {
 
 	switch(mode) {
 	case AbstractColumn::Numeric:
@@ -175,6 +177,8 @@ ColumnPrivate::ColumnPrivate(Column* owner, AbstractColumn::ColumnMode mode, voi
 
 	m_input_filter->setName("InputFilter");
 	m_output_filter->setName("OutputFilter");
+
+	internTexts();
 }
 
 /**
@@ -195,7 +199,7 @@ ColumnPrivate::~ColumnPrivate() {
 	case AbstractColumn::DateTime:
 	case AbstractColumn::Month:
 	case AbstractColumn::Day:
-		delete static_cast< QList<QDateTime>* >(m_data);
+		delete static_cast< QVector<qint64>* >(m_data);
 		break;
 	} // switch(m_column_mode)
 }
@@ -232,6 +236,8 @@ void ColumnPrivate::setColumnMode(AbstractColumn::ColumnMode mode) {
 	Column* temp_col = 0;
 
 	emit m_owner->modeAboutToChange(m_owner);
+	m_text_dictionary.clear();
+	m_intern_texts = true;
 
 	// determine the conversion filter and allocate the new data vector
 	switch(m_column_mode) {
@@ -251,19 +257,19 @@ void ColumnPrivate::setColumnMode(AbstractColumn::ColumnMode mode) {
 			filter = new Double2DateTimeFilter();
 			filter_is_temporary = true;
 			temp_col = new Column("temp_col", *(static_cast< QVector<double>* >(old_data)));
-			m_data = new QList<QDateTime>();
+			m_data = new QVector<qint64>();
 			break;
 		case AbstractColumn::Month:
 			filter = new Double2MonthFilter();
 			filter_is_temporary = true;
 			temp_col = new Column("temp_col", *(static_cast< QVector<double>* >(old_data)));
-			m_data = new QList<QDateTime>();
+			m_data = new QVector<qint64>();
 			break;
 		case AbstractColumn::Day:
 			filter = new Double2DayOfWeekFilter();
 			filter_is_temporary = true;
 			temp_col = new Column("temp_col", *(static_cast< QVector<double>* >(old_data)));
-			m_data = new QList<QDateTime>();
+			m_data = new QVector<qint64>();
 			break;
 		} // switch(mode)
 		break;
@@ -282,19 +288,19 @@ void ColumnPrivate::setColumnMode(AbstractColumn::ColumnMode mode) {
 			filter = new String2DateTimeFilter();
 			filter_is_temporary = true;
 			temp_col = new Column("temp_col", *(static_cast< QStringList* >(old_data)));
-			m_data = new QList<QDateTime>();
+			m_data = new QVector<qint64>();
 			break;
 		case AbstractColumn::Month:
 			filter = new String2MonthFilter();
 			filter_is_temporary = true;
 			temp_col = new Column("temp_col", *(static_cast< QStringList* >(old_data)));
-			m_data = new QList<QDateTime>();
+			m_data = new QVector<qint64>();
 			break;
 		case AbstractColumn::Day:
 			filter = new String2DayOfWeekFilter();
 			filter_is_temporary = true;
 			temp_col = new Column("temp_col", *(static_cast< QStringList* >(old_data)));
-			m_data = new QList<QDateTime>();
+			m_data = new QVector<qint64>();
 			break;
 		} // switch(mode)
 		break;
@@ -310,7 +316,7 @@ void ColumnPrivate::setColumnMode(AbstractColumn::ColumnMode mode) {
 		case AbstractColumn::Text:
 			filter = outputFilter();
 			filter_is_temporary = false;
-			temp_col = new Column("temp_col", *(static_cast< QList<QDateTime>* >(old_data)));
+			temp_col = new Column("temp_col", PackedDateTime::unpack(*static_cast< QVector<qint64>* >(old_data)));
 			m_data = new QStringList();
 			break;
 		case AbstractColumn::Numeric:
@@ -321,7 +327,7 @@ void ColumnPrivate::setColumnMode(AbstractColumn::ColumnMode mode) {
 			else
 				filter = new DateTime2DoubleFilter();
 			filter_is_temporary = true;
-			temp_col = new Column("temp_col", *(static_cast< QList<QDateTime>* >(old_data)));
+			temp_col = new Column("temp_col", PackedDateTime::unpack(*static_cast< QVector<qint64>* >(old_data)));
 			m_data = new QVector<double>();
 			break;
 		case AbstractColumn::Month:
@@ -461,6 +467,10 @@ void ColumnPrivate::replaceData(void * data) {
  */
 bool ColumnPrivate::copy(const AbstractColumn * other) {
 	if (other->columnMode() != columnMode()) return false;
+	const Column* column = dynamic_cast<const Column*>(other);
+	if (column)
+		return copy(column->m_column_private);
+
 	int num_rows = other->rowCount();
 
 	emit m_owner->dataAboutToChange(m_owner);
@@ -476,14 +486,15 @@ bool ColumnPrivate::copy(const AbstractColumn * other) {
 		}
 	case AbstractColumn::Text: {
 			for(int i=0; i<num_rows; i++)
-				static_cast< QStringList* >(m_data)->replace(i, other->textAt(i));
+				static_cast< QStringList* >(m_data)->replace(i, internText(other->textAt(i)));
 			break;
 		}
 	case AbstractColumn::DateTime:
 	case AbstractColumn::Month:
 	case AbstractColumn::Day: {
+			qint64* ptr = static_cast< QVector<qint64>* >(m_data)->data();
 			for(int i=0; i<num_rows; i++)
-				static_cast< QList<QDateTime>* >(m_data)->replace(i, other->dateTimeAt(i));
+				ptr[i] = PackedDateTime::pack(other->dateTimeAt(i));
 			break;
 		}
 	}
@@ -507,6 +518,9 @@ bool ColumnPrivate::copy(const AbstractColumn * other) {
 bool ColumnPrivate::copy(const AbstractColumn * source, int source_start, int dest_start, int num_rows) {
 	if (source->columnMode() != m_column_mode) return false;
 	if (num_rows == 0) return true;
+	const Column* column = dynamic_cast<const Column*>(source);
+	if (column)
+		return copy(column->m_column_private, source_start, dest_start, num_rows);
 
 	emit m_owner->dataAboutToChange(m_owner);
 	if (dest_start + num_rows > rowCount())
@@ -522,14 +536,16 @@ bool ColumnPrivate::copy(const AbstractColumn * source, int source_start, int de
 		}
 	case AbstractColumn::Text:
 		for(int i=0; i<num_rows; i++)
-			static_cast< QStringList* >(m_data)->replace(dest_start+i, source->textAt(source_start + i));
+			static_cast< QStringList* >(m_data)->replace(dest_start+i, internText(source->textAt(source_start + i)));
 		break;
 	case AbstractColumn::DateTime:
 	case AbstractColumn::Month:
-	case AbstractColumn::Day:
-		for(int i=0; i<num_rows; i++)
-			static_cast< QList<QDateTime>* >(m_data)->replace(dest_start+i, source->dateTimeAt(source_start + i));
-		break;
+	case AbstractColumn::Day: {
+			qint64* ptr = static_cast< QVector<qint64>* >(m_data)->data();
+			for(int i=0; i<num_rows; i++)
+				ptr[dest_start+i] = PackedDateTime::pack(source->dateTimeAt(source_start + i));
+			break;
+		}
 	}
 
 	if (!m_owner->m_suppressDataChangedSignal)
@@ -544,34 +560,29 @@ bool ColumnPrivate::copy(const AbstractColumn * source, int source_start, int de
  * This function will return false if the data type
  * of 'other' is not the same as the type of 'this'.
  * Use a filter to convert a column to another type.
+ * The data is implicitly shared with 'other' and only copied
+ * when one of the two columns is changed.
  */
 bool ColumnPrivate::copy(const ColumnPrivate * other) {
 	if (other->columnMode() != m_column_mode) return false;
-	int num_rows = other->rowCount();
 
 	emit m_owner->dataAboutToChange(m_owner);
-	resizeTo(num_rows);
 
-	// copy the data
+	// share the data with the other column, the data is detached when one of the columns is changed
 	switch(m_column_mode) {
-	case AbstractColumn::Numeric: {
-			double * ptr = static_cast< QVector<double>* >(m_data)->data();
-			for(int i=0; i<num_rows; i++)
-				ptr[i] = other->valueAt(i);
-			break;
-		}
-	case AbstractColumn::Text: {
-			for(int i=0; i<num_rows; i++)
-				static_cast< QStringList* >(m_data)->replace(i, other->textAt(i));
-			break;
-		}
+	case AbstractColumn::Numeric:
+		*static_cast< QVector<double>* >(m_data) = *static_cast< QVector<double>* >(other->m_data);
+		break;
+	case AbstractColumn::Text:
+		*static_cast< QStringList* >(m_data) = *static_cast< QStringList* >(other->m_data);
+		m_text_dictionary = other->m_text_dictionary;
+		m_intern_texts = other->m_intern_texts;
+		break;
 	case AbstractColumn::DateTime:
 	case AbstractColumn::Month:
-	case AbstractColumn::Day: {
-			for(int i=0; i<num_rows; i++)
-				static_cast< QList<QDateTime>* >(m_data)->replace(i, other->dateTimeAt(i));
-			break;
-		}
+	case AbstractColumn::Day:
+		*static_cast< QVector<qint64>* >(m_data) = *static_cast< QVector<qint64>* >(other->m_data);
+		break;
 	}
 
 	if (!m_owner->m_suppressDataChangedSignal)
@@ -602,20 +613,26 @@ bool ColumnPrivate::copy(const ColumnPrivate * source, int source_start, int des
 	switch(m_column_mode) {
 	case AbstractColumn::Numeric: {
 			double * ptr = static_cast< QVector<double>* >(m_data)->data();
-			for(int i=0; i<num_rows; i++)
-				ptr[dest_start+i] = source->valueAt(source_start + i);
+			const QVector<double>* source_data = static_cast< QVector<double>* >(source->m_data);
+			const int count = qBound(0, source_data->size() - source_start, num_rows);
+			memcpy(ptr + dest_start, source_data->constData() + source_start, count * sizeof(double));
+			for(int i=count; i<num_rows; i++)
+				ptr[dest_start+i] = NAN;
 			break;
 		}
 	case AbstractColumn::Text:
 		for(int i=0; i<num_rows; i++)
-			static_cast< QStringList* >(m_data)->replace(dest_start+i, source->textAt(source_start + i));
+			static_cast< QStringList* >(m_data)->replace(dest_start+i, internText(source->textAt(source_start + i)));
 		break;
 	case AbstractColumn::DateTime:
 	case AbstractColumn::Month:
-	case AbstractColumn::Day:
-		for(int i=0; i<num_rows; i++)
-			static_cast< QList<QDateTime>* >(m_data)->replace(dest_start+i, source->dateTimeAt(source_start + i));
-		break;
+	case AbstractColumn::Day: {
+			qint64* ptr = static_cast< QVector<qint64>* >(m_data)->data();
+			const QVector<qint64>* source_data = static_cast< QVector<qint64>* >(source->m_data);
+			for(int i=0; i<num_rows; i++)
+				ptr[dest_start+i] = source_data->value(source_start + i, PackedDateTime::invalid());
+			break;
+		}
 	}
 
 	if (!m_owner->m_suppressDataChangedSignal)
@@ -638,7 +655,7 @@ int ColumnPrivate::rowCount() const {
 	case AbstractColumn::DateTime:
 	case AbstractColumn::Month:
 	case AbstractColumn::Day:
-		return static_cast< QList<QDateTime>* >(m_data)->size();
+		return static_cast< QVector<qint64>* >(m_data)->size();
 	case AbstractColumn::Text:
 		return static_cast< QStringList* >(m_data)->size();
 	}
@@ -663,20 +680,20 @@ void ColumnPrivate::resizeTo(int new_size) {
 	switch(m_column_mode) {
 	case AbstractColumn::Numeric: {
 			QVector<double> *numeric_data = static_cast< QVector<double>* >(m_data);
-			numeric_data->insert(numeric_data->end(), new_size-old_size, NAN);
+			if (new_size > old_size)
+				numeric_data->insert(numeric_data->end(), new_size-old_size, NAN);
+			else
+				numeric_data->resize(new_size);
 			break;
 		}
 	case AbstractColumn::DateTime:
 	case AbstractColumn::Month:
 	case AbstractColumn::Day: {
-			int new_rows = new_size - old_size;
-			if (new_rows > 0) {
-				for(int i=0; i<new_rows; i++)
-					static_cast< QList<QDateTime>* >(m_data)->append(QDateTime());
-			} else {
-				for(int i=0; i<-new_rows; i++)
-					static_cast< QList<QDateTime>* >(m_data)->removeLast();
-			}
+			QVector<qint64> *dateTimes = static_cast< QVector<qint64>* >(m_data);
+			if (new_size > old_size)
+				dateTimes->insert(dateTimes->end(), new_size-old_size, PackedDateTime::invalid());
+			else
+				dateTimes->resize(new_size);
 			break;
 		}
 	case AbstractColumn::Text: {
@@ -709,8 +726,7 @@ void ColumnPrivate::insertRows(int before, int count) {
 		case AbstractColumn::DateTime:
 		case AbstractColumn::Month:
 		case AbstractColumn::Day:
-			for(int i=0; i<count; i++)
-				static_cast< QList<QDateTime>* >(m_data)->insert(before, QDateTime());
+			static_cast< QVector<qint64>* >(m_data)->insert(before, count, PackedDateTime::invalid());
 			break;
 		case AbstractColumn::Text:
 			for(int i=0; i<count; i++)
@@ -740,8 +756,7 @@ void ColumnPrivate::removeRows(int first, int count) {
 		case AbstractColumn::DateTime:
 		case AbstractColumn::Month:
 		case AbstractColumn::Day:
-			for(int i=0; i<corrected_count; i++)
-				static_cast< QList<QDateTime>* >(m_data)->removeAt(first);
+			static_cast< QVector<qint64>* >(m_data)->remove(first, corrected_count);
 			break;
 		case AbstractColumn::Text:
 			for(int i=0; i<corrected_count; i++)
@@ -827,6 +842,7 @@ void ColumnPrivate::setFormula(const QString& formula, const QStringList& variab
 	m_formula = formula;
 	m_formulaVariableNames = variableNames;
 	m_formulaVariableColumnPathes = variableColumnPathes;
+	emit m_owner->formulaChanged(m_owner);
 }
 
 /**
@@ -929,7 +945,7 @@ QDateTime ColumnPrivate::dateTimeAt(int row) const {
 	        m_column_mode != AbstractColumn::Month &&
 	        m_column_mode != AbstractColumn::Day)
 		return QDateTime();
-	return static_cast< QList<QDateTime>* >(m_data)->value(row);
+	return PackedDateTime::unpack(static_cast< QVector<qint64>* >(m_data)->value(row, PackedDateTime::invalid()));
 }
 
 /**
@@ -952,7 +968,7 @@ void ColumnPrivate::setTextAt(int row, const QString& new_value) {
 	if (row >= rowCount())
 		resizeTo(row+1);
 
-	static_cast< QStringList* >(m_data)->replace(row, new_value);
+	static_cast< QStringList* >(m_data)->replace(row, internText(new_value));
 	if (!m_owner->m_suppressDataChangedSignal)
 		emit m_owner->dataChanged(m_owner);
 }
@@ -971,12 +987,51 @@ void ColumnPrivate::replaceTexts(int first, const QStringList& new_values) {
 		resizeTo(first + num_rows);
 
 	for(int i=0; i<num_rows; i++)
-		static_cast< QStringList* >(m_data)->replace(first+i, new_values.at(i));
+		static_cast< QStringList* >(m_data)->replace(first+i, internText(new_values.at(i)));
 
 	if (!m_owner->m_suppressDataChangedSignal)
 		emit m_owner->dataChanged(m_owner);
 }
 
+/**
+ * \brief Let equal texts of the column share their data
+ *
+ * Use this when the texts were changed directly via the data pointer. The dictionary
+ * of the texts is rebuilt, interning is stopped if the column has too many distinct texts.
+ */
+void ColumnPrivate::internTexts() {
+	if (m_column_mode != AbstractColumn::Text) return;
+
+	QStringList* texts = static_cast< QStringList* >(m_data);
+	QVector<int> codes;
+	QStringList strings;
+	if (!TextDictionary::encode(*texts, MaxInternedTexts, codes, strings)) {
+		m_text_dictionary.clear();
+		m_intern_texts = false;
+		return;
+	}
+
+	*texts = TextDictionary::decode(codes, strings);
+	m_text_dictionary = TextDictionary(strings);
+	m_intern_texts = true;
+}
+
+/**
+ * \brief Return the copy of \c text shared by all rows with this text
+ *
+ * Columns with few distinct texts (categories, states, ...) need one pointer per row only.
+ */
+QString ColumnPrivate::internText(const QString& text) {
+	if (!m_intern_texts) return text;
+
+	if (m_text_dictionary.size() >= MaxInternedTexts) {
+		m_text_dictionary.clear();
+		m_intern_texts = false;
+		return text;
+	}
+	return m_text_dictionary.intern(text);
+}
+
 /**
  * \brief Set the content of row 'row'
  *
@@ -1020,7 +1075,7 @@ void ColumnPrivate::setDateTimeAt(int row, const QDateTime& new_value) {
 	if (row >= rowCount())
 		resizeTo(row+1);
 
-	static_cast< QList<QDateTime>* >(m_data)->replace(row, new_value);
+	static_cast< QVector<qint64>* >(m_data)->replace(row, PackedDateTime::pack(new_value));
 	if (!m_owner->m_suppressDataChangedSignal)
 		emit m_owner->dataChanged(m_owner);
 }
@@ -1031,6 +1086,15 @@ void ColumnPrivate::setDateTimeAt(int row, const QDateTime& new_value) {
  * Use this only when columnMode() is DateTime, Month or Day
  */
 void ColumnPrivate::replaceDateTimes(int first, const QList<QDateTime>& new_values) {
+	replaceDateTimes(first, PackedDateTime::pack(new_values));
+}
+
+/**
+ * \brief Replace a range of values with packed date times
+ *
+ * Use this only when columnMode() is DateTime, Month or Day
+ */
+void ColumnPrivate::replaceDateTimes(int first, const QVector<qint64>& new_values) {
 	if (m_column_mode != AbstractColumn::DateTime &&
 	        m_column_mode != AbstractColumn::Month &&
 	        m_column_mode != AbstractColumn::Day)
@@ -1041,8 +1105,8 @@ void ColumnPrivate::replaceDateTimes(int first, const QList<QDateTime>& new_valu
 	if (first + num_rows > rowCount())
 		resizeTo(first + num_rows);
 
-	for(int i=0; i<num_rows; i++)
-		static_cast< QList<QDateTime>* >(m_data)->replace(first+i, new_values.at(i));
+	qint64* ptr = static_cast< QVector<qint64>* >(m_data)->data();
+	memcpy(ptr + first, new_values.constData(), num_rows * sizeof(qint64));
 
 	if (!m_owner->m_suppressDataChangedSignal)
 		emit m_owner->dataChanged(m_owner);
@@ -1075,12 +1139,59 @@ void ColumnPrivate::replaceValues(int first, const QVector<double>& new_values)
 
 	emit m_owner->dataAboutToChange(m_owner);
 	int num_rows = new_values.size();
-	if (first + num_rows > rowCount())
-		resizeTo(first + num_rows);
+	if (first == 0 && num_rows >= rowCount()) {
+		//all values are replaced: share the data with new_values (implicit sharing), nothing is copied
+		*static_cast< QVector<double>* >(m_data) = new_values;
+	} else {
+		if (first + num_rows > rowCount())
+			resizeTo(first + num_rows);
+
+		double * ptr = static_cast< QVector<double>* >(m_data)->data();
+		memcpy(ptr + first, new_values.constData(), num_rows * sizeof(double));
+	}
 
-	double * ptr = static_cast< QVector<double>* >(m_data)->data();
-	for(int i=0; i<num_rows; i++)
-		ptr[first+i] = new_values.at(i);
+	if (!m_owner->m_suppressDataChangedSignal)
+		emit m_owner->dataChanged(m_owner);
+}
+
+/**
+ * \brief Reorder the rows
+ *
+ * Row i gets the value of row permutation[i], the rows behind the permutation are not changed.
+ * The data is reordered in one pass for all column modes.
+ */
+void ColumnPrivate::permuteRows(const QVector<int>& permutation) {
+	const int num_rows = permutation.size();
+	if (num_rows > rowCount()) return;
+
+	emit m_owner->dataAboutToChange(m_owner);
+	switch (m_column_mode) {
+	case AbstractColumn::Numeric: {
+			QVector<double>* values = static_cast< QVector<double>* >(m_data);
+			const QVector<double> old_values = values->mid(0, num_rows);
+			double* ptr = values->data();
+			for (int i = 0; i < num_rows; ++i)
+				ptr[i] = old_values.at(permutation.at(i));
+			break;
+		}
+	case AbstractColumn::Text: {
+			QStringList* texts = static_cast<QStringList*>(m_data);
+			const QStringList old_texts = *texts;
+			for (int i = 0; i < num_rows; ++i)
+				(*texts)[i] = old_texts.at(permutation.at(i));
+			break;
+		}
+	case AbstractColumn::DateTime:
+	case AbstractColumn::Month:
+	case AbstractColumn::Day: {
+			QVector<qint64>* dateTimes = static_cast< QVector<qint64>* >(m_data);
+			const QVector<qint64> old_dateTimes = dateTimes->mid(0, num_rows);
+			qint64* ptr = dateTimes->data();
+			for (int i = 0; i < num_rows; ++i)
+				ptr[i] = old_dateTimes.at(permutation.at(i));
+			break;
+		}
+	}
 
 	if (!m_owner->m_suppressDataChangedSignal)
 		emit m_owner->dataChanged(m_owner);
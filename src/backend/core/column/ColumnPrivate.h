@@ -31,6 +31,7 @@
 #define COLUMNPRIVATE_H
 
 #include "backend/lib/IntervalAttribute.h"
+#include "backend/lib/TextDictionary.h"
 #include "backend/core/column/Column.h"
 
 class AbstractSimpleFilter;
@@ -82,6 +83,7 @@ class ColumnPrivate: QObject {
 		QString textAt(int row) const;
 		void setTextAt(int row, const QString& new_value);
 		void replaceTexts(int first, const QStringList& new_values);
+		void internTexts();
 		QDate dateAt(int row) const;
 		void setDateAt(int row, const QDate& new_value);
 		QTime timeAt(int row) const;
@@ -89,14 +91,21 @@ class ColumnPrivate: QObject {
 		QDateTime dateTimeAt(int row) const;
 		void setDateTimeAt(int row, const QDateTime& new_value);
 		void replaceDateTimes(int first, const QList<QDateTime>& new_values);
+		void replaceDateTimes(int first, const QVector<qint64>& new_values);
 		double valueAt(int row) const;
 		void setValueAt(int row, double new_value);
 		void replaceValues(int first, const QVector<double>& new_values);
+		void permuteRows(const QVector<int>& permutation);
 
 		Column::ColumnStatistics statistics;
 		bool statisticsAvailable;
 
 	private:
+		QString internText(const QString& text);
+
+		//texts are not interned anymore if a column has more distinct texts
+		enum { MaxInternedTexts = 65536 };
+
 		AbstractColumn::ColumnMode m_column_mode;
 		void* m_data;
 		AbstractSimpleFilter* m_input_filter;
@@ -108,6 +117,8 @@ class ColumnPrivate: QObject {
 		AbstractColumn::PlotDesignation m_plot_designation;
 		int m_width;
 		Column* m_owner;
+		TextDictionary m_text_dictionary;
+		bool m_intern_texts;
 };
 
 #endif
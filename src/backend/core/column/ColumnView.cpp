@@ -0,0 +1,215 @@
+/***************************************************************************
+    File                 : ColumnView.cpp
+    Project              : LabPlot
+    Description          : Read-only view of the values of a column
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ColumnView.h"
+#include "backend/core/column/Column.h"
+#include "backend/lib/PackedDateTime.h"
+
+#include <cmath>
+
+/*!
+  \class ColumnView
+  \brief Read-only view of the values (as double) and of the masking of a column.
+
+  The values of numeric columns are shared with the column (implicit sharing), taking a view copies nothing.
+  The column detaches its data when it is changed later, so the view always shows the values at the time
+  it was taken and can be used in other threads. Date and time values are converted to Julian days,
+  the values of other columns are read with AbstractColumn::valueAt().
+
+  mid(), stride() and valid() restrict the view to a range of rows, to every n-th row or to the valid rows
+  (not masked and not NaN) and share the values with the original view, too. Only valid() has to copy
+  the values if there are invalid rows.
+
+  \ingroup backend
+*/
+
+/*!
+ * creates the view of all rows of \c column. The view is empty if \c column is 0.
+ */
+ColumnView::ColumnView(const AbstractColumn* column) : m_first(0), m_count(0), m_step(1) {
+	if (!column)
+		return;
+
+	const Column* col = dynamic_cast<const Column*>(column);
+	if (col && col->columnMode() == AbstractColumn::Numeric)
+		m_values = *static_cast<QVector<double>* >(col->data());
+	else if (col && col->columnMode() != AbstractColumn::Text) {
+		//date time values as Julian days
+		const QVector<qint64>* dateTimes = static_cast<QVector<qint64>* >(col->data());
+		m_values.resize(dateTimes->size());
+		PackedDateTime::toJulianDays(dateTimes->constData(), m_values.data(), dateTimes->size());
+	} else {
+		const int rows = column->rowCount();
+		m_values.resize(rows);
+		double* data = m_values.data();
+		for (int row = 0; row < rows; ++row)
+			data[row] = column->valueAt(row);
+	}
+
+	m_masked = column->maskedRows();
+	m_count = m_values.size();
+}
+
+/*!
+ * pointer to the values of a contiguous view (see isContiguous())
+ */
+const double* ColumnView::constData() const {
+	Q_ASSERT(isContiguous());
+	return m_values.constData() + m_first;
+}
+
+/*!
+ * values of the view. The vector shares the data with the column if the view shows all rows of the column.
+ */
+QVector<double> ColumnView::values() const {
+	if (isShared())
+		return m_values;
+
+	if (isContiguous())
+		return m_values.mid(m_first, m_count);
+
+	QVector<double> result(m_count);
+	double* data = result.data();
+	for (int row = 0; row < m_count; ++row)
+		data[row] = valueAt(row);
+	return result;
+}
+
+/*!
+ * smallest value of the view, NaN if there are no values
+ */
+double ColumnView::minimum() const {
+	double min = INFINITY;
+	for (int row = 0; row < m_count; ++row)
+		if (valueAt(row) < min)
+			min = valueAt(row);
+	return std::isinf(min) ? NAN : min;
+}
+
+/*!
+ * largest value of the view, NaN if there are no values
+ */
+double ColumnView::maximum() const {
+	double max = -INFINITY;
+	for (int row = 0; row < m_count; ++row)
+		if (valueAt(row) > max)
+			max = valueAt(row);
+	return std::isinf(max) ? NAN : max;
+}
+
+/*!
+ * view of \c count rows starting at row \c first of this view. All remaining rows are used if \c count is negative.
+ */
+ColumnView ColumnView::mid(int first, int count) const {
+	first = qBound(0, first, m_count);
+	if (count < 0 || count > m_count - first)
+		count = m_count - first;
+
+	ColumnView view(*this);
+	view.m_first = m_first + first * m_step;
+	view.m_count = count;
+	return view;
+}
+
+/*!
+ * view of every \c step-th row of this view, starting with the first row
+ */
+ColumnView ColumnView::stride(int step) const {
+	Q_ASSERT(step > 0);
+	ColumnView view(*this);
+	view.m_step = m_step * step;
+	view.m_count = (m_count + step - 1) / step;
+	return view;
+}
+
+/*!
+ * view of the rows of this view that are neither masked nor NaN.
+ * If all rows are valid, the view shares the values with this view, otherwise the valid values are copied.
+ */
+ColumnView ColumnView::valid() const {
+	int row = 0;
+	while (row < m_count && !std::isnan(valueAt(row)) && !isMasked(row))
+		++row;
+	if (row == m_count)
+		return *this;
+
+	ColumnView view;
+	view.m_values.resize(m_count);
+	double* data = view.m_values.data();
+	int count = 0;
+	for (row = 0; row < m_count; ++row) {
+		if (!std::isnan(valueAt(row)) && !isMasked(row))
+			data[count++] = valueAt(row);
+	}
+	view.m_values.resize(count);
+	view.m_count = count;
+	return view;
+}
+
+/*!
+ * copies the valid data points (no NaN and no masked value in \c x and \c y, x-value inside [\c xmin, \c xmax])
+ * of the views into \c xdata and \c ydata. If all data points are valid and the views show all rows of their columns,
+ * \c xdata and \c ydata share the data with the columns and nothing is copied.
+ */
+void ColumnView::validData(const ColumnView& x, const ColumnView& y, double xmin, double xmax,
+		QVector<double>& xdata, QVector<double>& ydata) {
+	const int rows = qMin(x.rowCount(), y.rowCount());
+
+	//only use those data where _all_ values (for x and y) are valid and only when inside given range
+	int row = 0;
+	while (row < rows && !std::isnan(x.valueAt(row)) && !std::isnan(y.valueAt(row)) && !x.isMasked(row) && !y.isMasked(row)
+			&& x.valueAt(row) >= xmin && x.valueAt(row) <= xmax)
+		++row;
+
+	if (row == rows && x.rowCount() == rows && y.rowCount() == rows) {
+		xdata = x.values();
+		ydata = y.values();
+		return;
+	}
+
+	xdata.resize(rows);
+	ydata.resize(rows);
+	double* xout = xdata.data();
+	double* yout = ydata.data();
+	int count = 0;
+	for (; count < row; ++count) {
+		xout[count] = x.valueAt(count);
+		yout[count] = y.valueAt(count);
+	}
+	for (; row < rows; ++row) {
+		if (std::isnan(x.valueAt(row)) || std::isnan(y.valueAt(row)) || x.isMasked(row) || y.isMasked(row))
+			continue;
+
+		if (x.valueAt(row) >= xmin && x.valueAt(row) <= xmax) {
+			xout[count] = x.valueAt(row);
+			yout[count] = y.valueAt(row);
+			++count;
+		}
+	}
+	xdata.resize(count);
+	ydata.resize(count);
+}
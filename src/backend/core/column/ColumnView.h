@@ -0,0 +1,68 @@
+/***************************************************************************
+    File                 : ColumnView.h
+    Project              : LabPlot
+    Description          : Read-only view of the values of a column
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef COLUMNVIEW_H
+#define COLUMNVIEW_H
+
+#include "backend/lib/MaskBitmap.h"
+#include <QVector>
+
+class AbstractColumn;
+
+class ColumnView {
+	public:
+		explicit ColumnView(const AbstractColumn* column = 0);
+
+		int rowCount() const { return m_count; }
+		double valueAt(int row) const { return m_values.at(m_first + row * m_step); }
+		bool isMasked(int row) const { return m_masked.isSet(m_first + row * m_step); }
+		bool isContiguous() const { return m_step == 1 || m_count < 2; }
+		const double* constData() const;
+		QVector<double> values() const;
+		double minimum() const;
+		double maximum() const;
+
+		ColumnView mid(int first, int count = -1) const;
+		ColumnView stride(int step) const;
+		ColumnView valid() const;
+
+		static void validData(const ColumnView& x, const ColumnView& y, double xmin, double xmax,
+				QVector<double>& xdata, QVector<double>& ydata);
+
+	protected:
+		QVector<double> m_values;
+		MaskBitmap m_masked;
+
+	private:
+		bool isShared() const { return m_first == 0 && m_count == m_values.size() && isContiguous(); }
+
+		int m_first;
+		int m_count;
+		int m_step;
+};
+
+#endif
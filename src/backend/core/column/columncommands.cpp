@@ -29,8 +29,14 @@
 
 #include "columncommands.h"
 #include "ColumnPrivate.h"
+#include "backend/lib/PackedDateTime.h"
+#include "backend/lib/TextDictionary.h"
 #include <KLocale>
+#include <QDataStream>
+#include <QSet>
+#include <QTemporaryFile>
 #include <cmath>
+#include <cstring>
 
 /** ***************************************************************************
  * \class ColumnSetModeCmd
@@ -118,7 +124,7 @@ ColumnSetModeCmd::~ColumnSetModeCmd() {
 			case AbstractColumn::DateTime:
 			case AbstractColumn::Month:
 			case AbstractColumn::Day:
-				delete static_cast< QList<QDateTime>* >(m_new_data);
+				delete static_cast< QVector<qint64>* >(m_new_data);
 				break;
 			}
 	} else {
@@ -133,7 +139,7 @@ ColumnSetModeCmd::~ColumnSetModeCmd() {
 			case AbstractColumn::DateTime:
 			case AbstractColumn::Month:
 			case AbstractColumn::Day:
-				delete static_cast< QList<QDateTime>* >(m_old_data);
+				delete static_cast< QVector<qint64>* >(m_old_data);
 				break;
 			}
 	}
@@ -175,6 +181,365 @@ void ColumnSetModeCmd::undo() {
 	m_undone = true;
 }
 
+/** ***************************************************************************
+ * \class ColumnRowsBackup
+ * \brief Backup of a range of rows used by the undo commands
+ *
+ * A backup of all rows shares the data with the column (implicit sharing),
+ * the data is only copied when one of them is changed. All backups together use at most
+ * memoryLimit() bytes of memory. When this limit is exceeded, the oldest backups are compressed
+ * (numeric data is delta encoded before). If this is not sufficient, the oldest compressed backups
+ * are written to temporary files. Compressed backups are uncompressed temporarily in restore() and
+ * createData() only. If a compressed backup can't be read back, e.g. because the temporary file was damaged,
+ * restore() and createData() fail and the commands leave the data of the column unchanged.
+ ** ***************************************************************************/
+
+QList<ColumnRowsBackup*> ColumnRowsBackup::s_backups;
+qint64 ColumnRowsBackup::s_memory_limit = Q_INT64_C(512)*1024*1024;
+qint64 ColumnRowsBackup::s_memory_usage = 0;
+
+ColumnRowsBackup::ColumnRowsBackup() : m_mode(AbstractColumn::Numeric), m_row_count(0), m_file(0), m_memory_usage(0) {
+}
+
+ColumnRowsBackup::~ColumnRowsBackup() {
+	s_backups.removeOne(this);
+	setMemoryUsage(0);
+	delete m_file;
+}
+
+/**
+ * \brief Save the \c count rows of \c col starting at row \c first
+ */
+void ColumnRowsBackup::save(const ColumnPrivate* col, int first, int count) {
+	clear();
+	m_mode = col->columnMode();
+	first = qMax(first, 0);
+	count = qMax(qMin(count, col->rowCount() - first), 0);
+	m_row_count = count;
+	const bool all = (first == 0 && count == col->rowCount());
+
+	switch(m_mode) {
+	case AbstractColumn::Numeric: {
+			const QVector<double>* values = static_cast< QVector<double>* >(col->dataPointer());
+			m_values = all ? *values : values->mid(first, count);
+			break;
+		}
+	case AbstractColumn::Text: {
+			const QStringList* texts = static_cast< QStringList* >(col->dataPointer());
+			m_texts = all ? *texts : texts->mid(first, count);
+			break;
+		}
+	case AbstractColumn::DateTime:
+	case AbstractColumn::Month:
+	case AbstractColumn::Day: {
+			const QVector<qint64>* dateTimes = static_cast< QVector<qint64>* >(col->dataPointer());
+			m_date_times = all ? *dateTimes : dateTimes->mid(first, count);
+			break;
+		}
+	}
+
+	setMemoryUsage(uncompressedSize());
+	s_backups.removeOne(this);
+	s_backups.append(this);
+	applyMemoryLimit();
+}
+
+/**
+ * \brief Write the saved rows into \c col starting at row \c dest
+ *
+ * Returns \c false if the compressed rows couldn't be read, \c col is not changed in this case.
+ */
+bool ColumnRowsBackup::restore(ColumnPrivate* col, int dest) const {
+	if (m_row_count == 0 || col->columnMode() != m_mode)
+		return true;
+
+	QVector<double> values = m_values;
+	QStringList texts = m_texts;
+	QVector<qint64> dateTimes = m_date_times;
+	if (isCompressed() && !uncompress(values, texts, dateTimes))
+		return false;
+
+	switch(m_mode) {
+	case AbstractColumn::Numeric:
+		col->replaceValues(dest, values);
+		break;
+	case AbstractColumn::Text:
+		col->replaceTexts(dest, texts);
+		break;
+	case AbstractColumn::DateTime:
+	case AbstractColumn::Month:
+	case AbstractColumn::Day:
+		col->replaceDateTimes(dest, dateTimes);
+		break;
+	}
+	return true;
+}
+
+/**
+ * \brief Create new column data containing the saved rows
+ *
+ * The new data shares the values with the backup. Use it with ColumnPrivate::replaceData()
+ * to restore all rows of a column without copying.
+ * Returns 0 if the compressed rows couldn't be read.
+ */
+void* ColumnRowsBackup::createData() const {
+	QVector<double> values = m_values;
+	QStringList texts = m_texts;
+	QVector<qint64> dateTimes = m_date_times;
+	if (isCompressed() && !uncompress(values, texts, dateTimes))
+		return 0;
+
+	switch(m_mode) {
+	case AbstractColumn::Numeric:
+		return new QVector<double>(values);
+	case AbstractColumn::Text:
+		return new QStringList(texts);
+	case AbstractColumn::DateTime:
+	case AbstractColumn::Month:
+	case AbstractColumn::Day:
+		return new QVector<qint64>(dateTimes);
+	}
+	return 0;
+}
+
+int ColumnRowsBackup::rowCount() const {
+	return m_row_count;
+}
+
+/**
+ * \brief The memory used by the backup in bytes, 0 if the backup was written to a temporary file
+ */
+qint64 ColumnRowsBackup::memoryUsage() const {
+	return m_memory_usage;
+}
+
+/**
+ * \brief Delete column data of the mode \c mode
+ */
+void ColumnRowsBackup::deleteData(AbstractColumn::ColumnMode mode, void* data) {
+	switch(mode) {
+	case AbstractColumn::Numeric:
+		delete static_cast< QVector<double>* >(data);
+		break;
+	case AbstractColumn::Text:
+		delete static_cast< QStringList* >(data);
+		break;
+	case AbstractColumn::DateTime:
+	case AbstractColumn::Month:
+	case AbstractColumn::Day:
+		delete static_cast< QVector<qint64>* >(data);
+		break;
+	}
+}
+
+/**
+ * \brief Set the memory available for all backups to \c bytes
+ */
+void ColumnRowsBackup::setMemoryLimit(qint64 bytes) {
+	s_memory_limit = bytes;
+	applyMemoryLimit();
+}
+
+qint64 ColumnRowsBackup::memoryLimit() {
+	return s_memory_limit;
+}
+
+void ColumnRowsBackup::clear() {
+	m_row_count = 0;
+	m_values.clear();
+	m_texts.clear();
+	m_date_times.clear();
+	m_compressed.clear();
+	delete m_file;
+	m_file = 0;
+	setMemoryUsage(0);
+}
+
+bool ColumnRowsBackup::isCompressed() const {
+	return !m_compressed.isEmpty() || m_file;
+}
+
+/**
+ * \brief Compress the saved rows
+ *
+ * Numeric values are stored as the XOR of the bit patterns of neighbouring values,
+ * which makes smooth or constant data (and NaN after clearing) well compressible.
+ * Packed date times are stored as differences of neighbouring values, regular time
+ * series become constant. Texts with few distinct values are dictionary encoded.
+ */
+void ColumnRowsBackup::compress() {
+	if (isCompressed() || m_row_count == 0)
+		return;
+
+	QByteArray bytes;
+	if (m_mode == AbstractColumn::Numeric) {
+		bytes.resize(m_row_count * sizeof(quint64));
+		quint64* out = reinterpret_cast<quint64*>(bytes.data());
+		quint64 previous = 0;
+		for (int i = 0; i < m_row_count; ++i) {
+			quint64 word;
+			memcpy(&word, m_values.constData() + i, sizeof(word));
+			out[i] = word ^ previous;
+			previous = word;
+		}
+	} else if (m_mode == AbstractColumn::Text) {
+		QDataStream stream(&bytes, QIODevice::WriteOnly);
+		QVector<int> codes;
+		QStringList dictionary;
+		const bool encoded = TextDictionary::encode(m_texts, m_row_count/2, codes, dictionary);
+		stream << encoded;
+		if (encoded)
+			stream << dictionary << codes;
+		else
+			stream << m_texts;
+	} else {
+		bytes.resize(m_row_count * sizeof(quint64));
+		quint64* out = reinterpret_cast<quint64*>(bytes.data());
+		quint64 previous = 0;
+		for (int i = 0; i < m_row_count; ++i) {
+			const quint64 word = m_date_times.at(i);
+			out[i] = word - previous;
+			previous = word;
+		}
+	}
+
+	m_compressed = qCompress(bytes, 1);
+	m_values.clear();
+	m_texts.clear();
+	m_date_times.clear();
+	setMemoryUsage(m_compressed.size());
+}
+
+/**
+ * \brief Write the compressed rows to a temporary file
+ *
+ * Returns \c false if the file could not be written, the data is kept in memory in this case.
+ */
+bool ColumnRowsBackup::spill() {
+	if (m_compressed.isEmpty())
+		return false;
+
+	QTemporaryFile* file = new QTemporaryFile();
+	if (!file->open() || file->write(m_compressed) != m_compressed.size() || !file->flush()) {
+		delete file;
+		return false;
+	}
+	file->close();
+
+	m_file = file;
+	m_compressed.clear();
+	setMemoryUsage(0);
+	return true;
+}
+
+/**
+ * \brief Uncompress the saved rows into \c values, \c texts or \c dateTimes
+ *
+ * Returns \c false if the temporary file can't be read or the compressed data is damaged.
+ */
+bool ColumnRowsBackup::uncompress(QVector<double>& values, QStringList& texts, QVector<qint64>& dateTimes) const {
+	QByteArray compressed = m_compressed;
+	if (m_file) {
+		if (!m_file->open())
+			return false;
+		compressed = m_file->readAll();
+		m_file->close();
+	}
+
+	const QByteArray bytes = qUncompress(compressed);
+	if (m_mode != AbstractColumn::Text && bytes.size() != (qint64)m_row_count * (qint64)sizeof(quint64))
+		return false;
+
+	if (m_mode == AbstractColumn::Numeric) {
+		values.resize(m_row_count);
+		const quint64* in = reinterpret_cast<const quint64*>(bytes.constData());
+		quint64 word = 0;
+		for (int i = 0; i < m_row_count; ++i) {
+			word ^= in[i];
+			memcpy(values.data() + i, &word, sizeof(word));
+		}
+	} else if (m_mode == AbstractColumn::Text) {
+		QDataStream stream(bytes);
+		bool encoded;
+		stream >> encoded;
+		if (encoded) {
+			QVector<int> codes;
+			QStringList dictionary;
+			stream >> dictionary >> codes;
+			texts = TextDictionary::decode(codes, dictionary);
+		} else
+			stream >> texts;
+		if (stream.status() != QDataStream::Ok || texts.size() != m_row_count)
+			return false;
+	} else {
+		dateTimes.resize(m_row_count);
+		const quint64* in = reinterpret_cast<const quint64*>(bytes.constData());
+		quint64 word = 0;
+		for (int i = 0; i < m_row_count; ++i) {
+			word += in[i];
+			dateTimes[i] = word;
+		}
+	}
+	return true;
+}
+
+/**
+ * \brief Estimated size of the uncompressed rows in bytes
+ */
+qint64 ColumnRowsBackup::uncompressedSize() const {
+	switch(m_mode) {
+	case AbstractColumn::Numeric:
+		return (qint64)m_row_count * sizeof(double);
+	case AbstractColumn::Text: {
+			//interned texts share their data, it is counted once
+			qint64 size = (qint64)m_row_count * sizeof(void*);
+			QSet<const QChar*> counted;
+			foreach(const QString& text, m_texts) {
+				if (!counted.contains(text.constData())) {
+					counted.insert(text.constData());
+					size += sizeof(QString) + text.size() * sizeof(QChar);
+				}
+			}
+			return size;
+		}
+	case AbstractColumn::DateTime:
+	case AbstractColumn::Month:
+	case AbstractColumn::Day:
+		return (qint64)m_row_count * sizeof(qint64);
+	}
+	return 0;
+}
+
+/**
+ * \brief Set the memory used by this backup to \c bytes and update the sum of all backups
+ */
+void ColumnRowsBackup::setMemoryUsage(qint64 bytes) {
+	s_memory_usage += bytes - m_memory_usage;
+	m_memory_usage = bytes;
+}
+
+/**
+ * \brief Reduce the memory used by all backups to memoryLimit()
+ *
+ * The oldest backups are compressed first. If the compressed backups still don't fit,
+ * the oldest compressed backups are written to temporary files.
+ */
+void ColumnRowsBackup::applyMemoryLimit() {
+	for (int i = 0; i < s_backups.size() && s_memory_usage > s_memory_limit; ++i) {
+		ColumnRowsBackup* backup = s_backups.at(i);
+		if (!backup->isCompressed())
+			backup->compress();
+	}
+
+	for (int i = 0; i < s_backups.size() && s_memory_usage > s_memory_limit; ++i) {
+		ColumnRowsBackup* backup = s_backups.at(i);
+		if (backup->m_compressed.isEmpty())
+			continue;
+		if (!backup->spill())
+			break;
+	}
+}
+
 /** ***************************************************************************
  * \class ColumnFullCopyCmd
  * \brief Copy a complete column
@@ -192,48 +557,42 @@ void ColumnSetModeCmd::undo() {
 
 /**
  * \var ColumnFullCopyCmd::m_backup
- * \brief A backup column
+ * \brief The data of the column before the copy
  */
 
 /**
- * \var ColumnFullCopyCmd::m_backup_owner
- * \brief A dummy owner for the backup column
- *
- * This is needed because a ColumnPrivate must have an owner. We want access
- * to the ColumnPrivate object to access its data pointer for fast data
- * replacement without too much copying.
+ * \var ColumnFullCopyCmd::m_new_backup
+ * \brief The copied data, saved on undo
  */
 
 /**
- * \brief Ctor
+ * \var ColumnFullCopyCmd::m_copied
+ * \brief Status flag
  */
-ColumnFullCopyCmd::ColumnFullCopyCmd(ColumnPrivate * col, const AbstractColumn * src, QUndoCommand * parent )
-	: QUndoCommand( parent ), m_col(col), m_src(src), m_backup(0), m_backup_owner(0) {
-	setText(i18n("%1: change cell values", col->name()));
-}
 
 /**
- * \brief Dtor
+ * \brief Ctor
  */
-ColumnFullCopyCmd::~ColumnFullCopyCmd() {
-	delete m_backup;
-	delete m_backup_owner;
+ColumnFullCopyCmd::ColumnFullCopyCmd(ColumnPrivate * col, const AbstractColumn * src, QUndoCommand * parent )
+	: QUndoCommand( parent ), m_col(col), m_src(src), m_copied(false) {
+	setText(i18n("%1: change cell values", col->name()));
 }
 
 /**
  * \brief Execute the command
  */
 void ColumnFullCopyCmd::redo() {
-	if(m_backup == 0) {
-		m_backup_owner = new Column("temp", m_src->columnMode());
-		m_backup = new ColumnPrivate(m_backup_owner, m_src->columnMode());
-		m_backup->copy(m_col);
+	if(!m_copied) {
+		m_backup.save(m_col, 0, m_col->rowCount());
 		m_col->copy(m_src);
+		m_copied = true;
 	} else {
-		// swap data of orig. column and backup
-		void * data_temp = m_col->dataPointer();
-		m_col->replaceData(m_backup->dataPointer());
-		m_backup->replaceData(data_temp);
+		void* newData = m_new_backup.createData();
+		if (!newData)
+			return;
+		void* data = m_col->dataPointer();
+		m_col->replaceData(newData);
+		ColumnRowsBackup::deleteData(m_col->columnMode(), data);
 	}
 }
 
@@ -241,10 +600,13 @@ void ColumnFullCopyCmd::redo() {
  * \brief Undo the command
  */
 void ColumnFullCopyCmd::undo() {
-	// swap data of orig. column and backup
-	void * data_temp = m_col->dataPointer();
-	m_col->replaceData(m_backup->dataPointer());
-	m_backup->replaceData(data_temp);
+	void* oldData = m_backup.createData();
+	if (!oldData)
+		return;
+	m_new_backup.save(m_col, 0, m_col->rowCount());
+	void* data = m_col->dataPointer();
+	m_col->replaceData(oldData);
+	ColumnRowsBackup::deleteData(m_col->columnMode(), data);
 }
 
 /** ***************************************************************************
@@ -264,30 +626,17 @@ void ColumnFullCopyCmd::undo() {
 
 /**
  * \var ColumnPartialCopyCmd::m_col_backup
- * \brief A backup of the original column
+ * \brief The rows of the destination column overwritten by the copy
  */
 
 /**
  * \var ColumnPartialCopyCmd::m_src_backup
- * \brief A backup of the source column
+ * \brief The copied rows of the source column
  */
 
 /**
- * \var ColumnPartialCopyCmd::m_col_backup_owner
- * \brief A dummy owner for the backup column
- *
- * This is needed because a ColumnPrivate must have an owner and
- * we must have a ColumnPrivate object as backup.
- * Using a Column object as backup would lead to an inifinite loop.
- */
-
-/**
- * \var ColumnPartialCopyCmd::m_src_backup_owner
- * \brief A dummy owner for the source backup column
- *
- * This is needed because a ColumnPrivate must have an owner and
- * we must have a ColumnPrivate object as backup.
- * Using a Column object as backup would lead to an inifinite loop.
+ * \var ColumnPartialCopyCmd::m_copied
+ * \brief Status flag
  */
 
 /**
@@ -314,42 +663,31 @@ void ColumnFullCopyCmd::undo() {
  * \brief Ctor
  */
 ColumnPartialCopyCmd::ColumnPartialCopyCmd(ColumnPrivate * col, const AbstractColumn * src, int src_start, int dest_start, int num_rows, QUndoCommand * parent )
-	: QUndoCommand( parent ), m_col(col), m_src(src), m_col_backup(0), m_src_backup(0), m_col_backup_owner(0), m_src_backup_owner(0), m_src_start(src_start), m_dest_start(dest_start), m_num_rows(num_rows) {
+	: QUndoCommand( parent ), m_col(col), m_src(src), m_copied(false), m_src_start(src_start), m_dest_start(dest_start), m_num_rows(num_rows) {
 	setText(i18n("%1: change cell values", col->name()));
 }
 
-/**
- * \brief Dtor
- */
-ColumnPartialCopyCmd::~ColumnPartialCopyCmd() {
-	delete m_src_backup;
-	delete m_col_backup;
-	delete m_src_backup_owner;
-	delete m_col_backup_owner;
-}
-
 /**
  * \brief Execute the command
  */
 void ColumnPartialCopyCmd::redo() {
-	if(m_src_backup == 0) {
-		// copy the relevant rows of source and destination column into backup columns
-		m_src_backup_owner = new Column("temp", m_col->columnMode());
-		m_src_backup = new ColumnPrivate(m_src_backup_owner, m_col->columnMode());
-		m_src_backup->copy(m_src, m_src_start, 0, m_num_rows);
-		m_col_backup_owner = new Column("temp", m_col->columnMode());
-		m_col_backup = new ColumnPrivate(m_col_backup_owner, m_col->columnMode());
-		m_col_backup->copy(m_col, m_dest_start, 0, m_num_rows);
+	if(!m_copied) {
+		// save the overwritten rows of the destination column, the source column might be changed or deleted later
+		m_col_backup.save(m_col, m_dest_start, m_num_rows);
 		m_old_row_count = m_col->rowCount();
-	}
-	m_col->copy(m_src_backup, 0, m_dest_start, m_num_rows);
+		m_col->copy(m_src, m_src_start, m_dest_start, m_num_rows);
+		m_src_backup.save(m_col, m_dest_start, m_num_rows);
+		m_copied = true;
+	} else
+		m_src_backup.restore(m_col, m_dest_start);
 }
 
 /**
  * \brief Undo the command
  */
 void ColumnPartialCopyCmd::undo() {
-	m_col->copy(m_col_backup, 0, m_dest_start, m_num_rows);
+	if (!m_col_backup.restore(m_col, m_dest_start))
+		return;
 	m_col->resizeTo(m_old_row_count);
 	m_col->replaceData(m_col->dataPointer());
 }
@@ -395,11 +733,6 @@ void ColumnInsertRowsCmd::undo() {
  * \brief The private column data to modify
  */
 
-/**
- * \var ColumnRemoveRowsCmd::m_data_row_count
- * \brief Number of removed rows actually containing data
- */
-
 /**
  * \var ColumnRemoveRowsCmd::m_old_size
  * \brief The number of rows before the removal
@@ -407,16 +740,12 @@ void ColumnInsertRowsCmd::undo() {
 
 /**
  * \var ColumnRemoveRowsCmd::m_backup
- * \brief Column saving the removed rows
+ * \brief The removed rows containing data
  */
 
 /**
- * \var ColumnRemoveRowsCmd::m_backup_owner
- * \brief A dummy owner for the backup column
- *
- * This is needed because a ColumnPrivate must have an owner. We want access
- * to the ColumnPrivate object to access its data pointer for fast data
- * replacement without too much copying.
+ * \var ColumnRemoveRowsCmd::m_copied
+ * \brief Status flag
  */
 
 /**
@@ -428,34 +757,18 @@ void ColumnInsertRowsCmd::undo() {
  * \brief Ctor
  */
 ColumnRemoveRowsCmd::ColumnRemoveRowsCmd(ColumnPrivate * col, int first, int count, QUndoCommand * parent )
-	: QUndoCommand(parent), m_col(col), m_first(first), m_count(count), m_backup(0) {
-}
-
-/**
- * \brief Dtor
- */
-ColumnRemoveRowsCmd::~ColumnRemoveRowsCmd() {
-	delete m_backup;
-	delete m_backup_owner;
+	: QUndoCommand(parent), m_col(col), m_first(first), m_count(count), m_copied(false) {
 }
 
 /**
  * \brief Execute the command
  */
 void ColumnRemoveRowsCmd::redo() {
-	if(m_backup == 0) {
-		if(m_first >= m_col->rowCount())
-			m_data_row_count = 0;
-		else if(m_first + m_count > m_col->rowCount())
-			m_data_row_count = m_col->rowCount() - m_first;
-		else
-			m_data_row_count = m_count;
-
+	if(!m_copied) {
 		m_old_size = m_col->rowCount();
-		m_backup_owner = new Column("temp", m_col->columnMode());
-		m_backup = new ColumnPrivate(m_backup_owner, m_col->columnMode());
-		m_backup->copy(m_col, m_first, 0, m_data_row_count);
+		m_backup.save(m_col, m_first, m_count);
 		m_formulas = m_col->formulaAttribute();
+		m_copied = true;
 	}
 	m_col->removeRows(m_first, m_count);
 }
@@ -465,7 +778,10 @@ void ColumnRemoveRowsCmd::redo() {
  */
 void ColumnRemoveRowsCmd::undo() {
 	m_col->insertRows(m_first, m_count);
-	m_col->copy(m_backup, 0, m_first, m_data_row_count);
+	if (!m_backup.restore(m_col, m_first)) {
+		m_col->removeRows(m_first, m_count);
+		return;
+	}
 	m_col->resizeTo(m_old_size);
 	m_col->replaceFormulas(m_formulas);
 }
@@ -524,17 +840,12 @@ void ColumnSetPlotDesignationCmd::undo() {
  */
 
 /**
- * \var ColumnClearCmd::m_data
- * \brief Pointer to the old data pointer
- */
-
-/**
- * \var ColumnClearCmd::m_empty_data
- * \brief Pointer to an empty data vector
+ * \var ColumnClearCmd::m_backup
+ * \brief The data of the column before clearing
  */
 
 /**
- * \var ColumnClearCmd::m_undone
+ * \var ColumnClearCmd::m_copied
  * \brief Status flag
  */
 
@@ -542,92 +853,54 @@ void ColumnSetPlotDesignationCmd::undo() {
  * \brief Ctor
  */
 ColumnClearCmd::ColumnClearCmd(ColumnPrivate * col, QUndoCommand * parent )
-	: QUndoCommand( parent ), m_col(col) {
+	: QUndoCommand( parent ), m_col(col), m_copied(false) {
 	setText(i18n("%1: clear column", col->name()));
-	m_empty_data = 0;
-	m_data = 0;
-	m_undone = false;
-}
-
-/**
- * \brief Dtor
- */
-ColumnClearCmd::~ColumnClearCmd() {
-	if(m_undone) {
-		if (!m_empty_data) return;
-		switch(m_col->columnMode()) {
-		case AbstractColumn::Numeric:
-			delete static_cast< QVector<double>* >(m_empty_data);
-			break;
-		case AbstractColumn::Text:
-			delete static_cast< QStringList* >(m_empty_data);
-			break;
-		case AbstractColumn::DateTime:
-		case AbstractColumn::Month:
-		case AbstractColumn::Day:
-			delete static_cast< QList<QDateTime>* >(m_empty_data);
-			break;
-		}
-	} else {
-		if (!m_data) return;
-		switch(m_col->columnMode()) {
-		case AbstractColumn::Numeric:
-			delete static_cast< QVector<double>* >(m_data);
-			break;
-		case AbstractColumn::Text:
-			delete static_cast< QStringList* >(m_data);
-			break;
-		case AbstractColumn::DateTime:
-		case AbstractColumn::Month:
-		case AbstractColumn::Day:
-			delete static_cast< QList<QDateTime>* >(m_data);
-			break;
-		}
-	}
 }
 
 /**
  * \brief Execute the command
  */
 void ColumnClearCmd::redo() {
-	if(!m_empty_data) {
-		const int rowCount = m_col->rowCount();
-		switch(m_col->columnMode()) {
-		case AbstractColumn::Numeric: {
-				QVector<double>* vec = new QVector<double>(rowCount);
-				m_empty_data = vec;
-				for (int i=0; i<rowCount; i++)
-					vec->operator[](i) = NAN;
-				break;
-			}
-		case AbstractColumn::DateTime:
-		case AbstractColumn::Month:
-		case AbstractColumn::Day:
-			m_empty_data = new QList<QDateTime>();
-			for(int i=0; i<rowCount; i++)
-				static_cast< QList<QDateTime> *>(m_empty_data)->append(QDateTime());
-			break;
-		case AbstractColumn::Text:
-			m_empty_data = new QStringList();
-			for(int i=0; i<rowCount; i++)
-				static_cast< QStringList *>(m_empty_data)->append(QString());
-			break;
-		}
-		m_data = m_col->dataPointer();
+	if(!m_copied) {
+		m_backup.save(m_col, 0, m_col->rowCount());
+		m_copied = true;
 	}
-	m_col->replaceData(m_empty_data);
-	m_undone = false;
+
+	const int rowCount = m_backup.rowCount();
+	void* empty_data = 0;
+	switch(m_col->columnMode()) {
+	case AbstractColumn::Numeric:
+		empty_data = new QVector<double>(rowCount, NAN);
+		break;
+	case AbstractColumn::DateTime:
+	case AbstractColumn::Month:
+	case AbstractColumn::Day:
+		empty_data = new QVector<qint64>(rowCount, PackedDateTime::invalid());
+		break;
+	case AbstractColumn::Text:
+		empty_data = new QStringList();
+		for(int i=0; i<rowCount; i++)
+			static_cast< QStringList *>(empty_data)->append(QString());
+		break;
+	}
+
+	void* data = m_col->dataPointer();
+	m_col->replaceData(empty_data);
+	ColumnRowsBackup::deleteData(m_col->columnMode(), data);
 }
 
 /**
  * \brief Undo the command
  */
 void ColumnClearCmd::undo() {
-	m_col->replaceData(m_data);
-	m_undone = true;
+	void* oldData = m_backup.createData();
+	if (!oldData)
+		return;
+	void* data = m_col->dataPointer();
+	m_col->replaceData(oldData);
+	ColumnRowsBackup::deleteData(m_col->columnMode(), data);
 }
 
-
 /** ***************************************************************************
  * \class ColumSetGlobalFormulaCmd
  * \brief Set the formula for the entire column (global formula)
@@ -1090,7 +1363,7 @@ void ColumnReplaceValuesCmd::undo() {
  * \brief Ctor
  */
 ColumnReplaceDateTimesCmd::ColumnReplaceDateTimesCmd(ColumnPrivate * col, int first, const QList<QDateTime>& new_values, QUndoCommand * parent )
-	: QUndoCommand( parent ), m_col(col), m_first(first), m_new_values(new_values) {
+	: QUndoCommand( parent ), m_col(col), m_first(first), m_new_values(PackedDateTime::pack(new_values)) {
 	setText(i18n("%1: replace the values for rows %2 to %3", col->name(), first, first + new_values.count() -1));
 	m_copied = false;
 }
@@ -1100,7 +1373,7 @@ ColumnReplaceDateTimesCmd::ColumnReplaceDateTimesCmd(ColumnPrivate * col, int fi
  */
 void ColumnReplaceDateTimesCmd::redo() {
 	if(!m_copied) {
-		m_old_values = static_cast< QList<QDateTime>* >(m_col->dataPointer())->mid(m_first, m_new_values.count());
+		m_old_values = static_cast< QVector<qint64>* >(m_col->dataPointer())->mid(m_first, m_new_values.count());
 		m_row_count = m_col->rowCount();
 		m_copied = true;
 	}
@@ -1116,3 +1389,46 @@ void ColumnReplaceDateTimesCmd::undo() {
 	m_col->resizeTo(m_row_count);
 }
 
+
+/** ***************************************************************************
+ * \class ColumnPermuteRowsCmd
+ * \brief Reorder the rows of a column
+ ** ***************************************************************************/
+
+/**
+ * \var ColumnPermuteRowsCmd::m_col
+ * \brief The private column data to modify
+ */
+
+/**
+ * \var ColumnPermuteRowsCmd::m_permutation
+ * \brief Row i gets the value of row m_permutation[i]
+ *
+ * Only the permutation is stored, not the data. When several columns are sorted
+ * with the same leading column, the commands share one permutation (implicit sharing).
+ */
+
+/**
+ * \brief Ctor
+ */
+ColumnPermuteRowsCmd::ColumnPermuteRowsCmd(ColumnPrivate* col, const QVector<int>& permutation, QUndoCommand* parent)
+	: QUndoCommand(parent), m_col(col), m_permutation(permutation) {
+	setText(i18n("%1: reorder rows", col->name()));
+}
+
+/**
+ * \brief Execute the command
+ */
+void ColumnPermuteRowsCmd::redo() {
+	m_col->permuteRows(m_permutation);
+}
+
+/**
+ * \brief Undo the command
+ */
+void ColumnPermuteRowsCmd::undo() {
+	QVector<int> inverse(m_permutation.size());
+	for (int i = 0; i < m_permutation.size(); ++i)
+		inverse[m_permutation.at(i)] = i;
+	m_col->permuteRows(inverse);
+}
@@ -39,6 +39,48 @@
 #include <QDateTime>
 
 class AbstractSimpleFilter;
+class QTemporaryFile;
+
+class ColumnRowsBackup {
+public:
+	ColumnRowsBackup();
+	~ColumnRowsBackup();
+
+	void save(const ColumnPrivate* col, int first, int count);
+	bool restore(ColumnPrivate* col, int dest) const;
+	void* createData() const;
+	int rowCount() const;
+	qint64 memoryUsage() const;
+
+	static void deleteData(AbstractColumn::ColumnMode mode, void* data);
+	static void setMemoryLimit(qint64 bytes);
+	static qint64 memoryLimit();
+
+private:
+	Q_DISABLE_COPY(ColumnRowsBackup)
+
+	void clear();
+	void compress();
+	bool spill();
+	bool isCompressed() const;
+	bool uncompress(QVector<double>& values, QStringList& texts, QVector<qint64>& dateTimes) const;
+	qint64 uncompressedSize() const;
+	void setMemoryUsage(qint64 bytes);
+	static void applyMemoryLimit();
+
+	AbstractColumn::ColumnMode m_mode;
+	int m_row_count;
+	QVector<double> m_values;
+	QStringList m_texts;
+	QVector<qint64> m_date_times;
+	QByteArray m_compressed;
+	QTemporaryFile* m_file;	//compressed data written to disk, see spill()
+	qint64 m_memory_usage;
+
+	static QList<ColumnRowsBackup*> s_backups;
+	static qint64 s_memory_limit;
+	static qint64 s_memory_usage;	//sum of memoryUsage() of all backups
+};
 
 class ColumnSetModeCmd : public QUndoCommand {
 public:
@@ -65,7 +107,6 @@ private:
 class ColumnFullCopyCmd : public QUndoCommand {
 public:
 	explicit ColumnFullCopyCmd(ColumnPrivate* col, const AbstractColumn* src, QUndoCommand* parent = 0);
-	~ColumnFullCopyCmd();
 
 	virtual void redo();
 	virtual void undo();
@@ -73,14 +114,14 @@ public:
 private:
 	ColumnPrivate* m_col;
 	const AbstractColumn* m_src;
-	ColumnPrivate* m_backup;
-	Column* m_backup_owner;
+	ColumnRowsBackup m_backup;
+	ColumnRowsBackup m_new_backup;
+	bool m_copied;
 };
 
 class ColumnPartialCopyCmd : public QUndoCommand {
 public:
 	explicit ColumnPartialCopyCmd(ColumnPrivate* col, const AbstractColumn* src, int src_start, int dest_start, int num_rows, QUndoCommand* parent = 0);
-	~ColumnPartialCopyCmd();
 
 	virtual void redo();
 	virtual void undo();
@@ -88,10 +129,9 @@ public:
 private:
 	ColumnPrivate* m_col;
 	const AbstractColumn * m_src;
-	ColumnPrivate* m_col_backup;
-	ColumnPrivate* m_src_backup;
-	Column* m_col_backup_owner;
-	Column* m_src_backup_owner;
+	ColumnRowsBackup m_col_backup;
+	ColumnRowsBackup m_src_backup;
+	bool m_copied;
 	int m_src_start;
 	int m_dest_start;
 	int m_num_rows;
@@ -113,7 +153,6 @@ private:
 class ColumnRemoveRowsCmd : public QUndoCommand {
 public:
 	explicit ColumnRemoveRowsCmd(ColumnPrivate* col, int first, int count, QUndoCommand* parent = 0);
-	~ColumnRemoveRowsCmd();
 
 	virtual void redo();
 	virtual void undo();
@@ -121,10 +160,9 @@ public:
 private:
 	ColumnPrivate* m_col;
 	int m_first, m_count;
-	int m_data_row_count;
 	int m_old_size;
-	ColumnPrivate* m_backup;
-	Column* m_backup_owner;
+	ColumnRowsBackup m_backup;
+	bool m_copied;
 	IntervalAttribute<QString> m_formulas;
 };
 
@@ -144,17 +182,14 @@ private:
 class ColumnClearCmd : public QUndoCommand {
 public:
 	explicit ColumnClearCmd(ColumnPrivate* col, QUndoCommand* parent = 0);
-	~ColumnClearCmd();
 
 	virtual void redo();
 	virtual void undo();
 
 private:
 	ColumnPrivate* m_col;
-	void* m_data;
-	void* m_empty_data;
-	bool m_undone;
-
+	ColumnRowsBackup m_backup;
+	bool m_copied;
 };
 
 class ColumnSetGlobalFormulaCmd : public QUndoCommand {
@@ -291,10 +326,22 @@ public:
 private:
 	ColumnPrivate* m_col;
 	int m_first;
-	QList<QDateTime> m_new_values;
-	QList<QDateTime> m_old_values;
+	QVector<qint64> m_new_values;
+	QVector<qint64> m_old_values;
 	bool m_copied;
 	int m_row_count;
 };
 
+class ColumnPermuteRowsCmd : public QUndoCommand {
+public:
+	explicit ColumnPermuteRowsCmd(ColumnPrivate* col, const QVector<int>& permutation, QUndoCommand* parent = 0);
+
+	virtual void redo();
+	virtual void undo();
+
+private:
+	ColumnPrivate* m_col;
+	QVector<int> m_permutation;
+};
+
 #endif
@@ -29,6 +29,7 @@
 
 #include "DateTime2StringFilter.h"
 #include "backend/lib/XmlStreamReader.h"
+#include "backend/core/column/Column.h"
 #include <QDateTime>
 #include <QRegExp>
 #include <QUndoCommand>
@@ -55,6 +56,14 @@ void DateTime2StringFilter::setFormat(const QString& format)
 
 QString DateTime2StringFilter::textAt(int row) const {
 	if (!m_inputs.value(0)) return QString();
+#if QT_VERSION >= 0x040302
+	// format the packed values of columns directly
+	const Column* column = dynamic_cast<const Column*>(m_inputs.value(0));
+	if (column && column->columnMode() != AbstractColumn::Numeric && column->columnMode() != AbstractColumn::Text) {
+		const QVector<qint64>* values = static_cast< QVector<qint64>* >(column->data());
+		return m_formatter.toString(values->value(row, PackedDateTime::invalid()));
+	}
+#endif
 	QDateTime input_value = m_inputs.value(0)->dateTimeAt(row);
 	if (!input_value.isValid()) return QString();
 #if QT_VERSION < 0x040302 // the bug seems to be fixed in Qt 4.3.2
@@ -92,6 +101,7 @@ void DateTime2StringFilterSetFormatCmd::redo()
 {
 	QString tmp = m_target->m_format;
 	m_target->m_format = m_other_format;
+	m_target->m_formatter = PackedDateTime::Formatter(m_target->m_format);
 	m_other_format = tmp;
 	emit m_target->formatChanged();
 }
@@ -30,6 +30,7 @@
 #define DATE_TIME2STRING_FILTER_H
 
 #include "backend/core/AbstractSimpleFilter.h"
+#include "backend/lib/PackedDateTime.h"
 
 class DateTime2StringFilterSetFormatCmd;
 
@@ -40,7 +41,7 @@ class DateTime2StringFilter : public AbstractSimpleFilter
 
 	public:
 		//! Standard constructor.
-		explicit DateTime2StringFilter(QString format="yyyy-MM-dd hh:mm:ss.zzz") : m_format(format) {}
+		explicit DateTime2StringFilter(QString format="yyyy-MM-dd hh:mm:ss.zzz") : m_format(format), m_formatter(format) {}
 		//! Set the format string to be used for conversion.
 		void setFormat(const QString& format);
 
@@ -61,6 +62,8 @@ class DateTime2StringFilter : public AbstractSimpleFilter
 		friend class DateTime2StringFilterSetFormatCmd;
 		//! The format string.
 		QString m_format;
+		//! The parsed format string used for columns with packed date times.
+		PackedDateTime::Formatter m_formatter;
 
 	public:
 		virtual QString textAt(int row) const;
@@ -42,6 +42,7 @@ class String2DoubleFilter : public AbstractSimpleFilter
 		String2DoubleFilter() : m_use_default_locale(true) {}
 		void setNumericLocale(QLocale locale) { m_numeric_locale = locale; m_use_default_locale = false; }
 		void setNumericLocaleToDefault() { m_use_default_locale = true; }
+		QLocale numericLocale() const { return m_use_default_locale ? QLocale() : m_numeric_locale; }
 
 		virtual double valueAt(int row) const {
 			if (!m_inputs.value(0)) return 0;
@@ -28,6 +28,7 @@ Copyright	: (C) 2009-2015 Alexander Semke (alexander.semke@web.de)
 
 #include "backend/datasources/FileDataSource.h"
 #include "backend/datasources/filters/AsciiFilter.h"
+#include "backend/datasources/filters/ColumnarBinaryFilter.h"
 #include "commonfrontend/spreadsheet/SpreadsheetView.h"
 #include "backend/core/Project.h"
 
@@ -95,6 +96,7 @@ QStringList FileDataSource::fileTypes(){
 		<< i18n("Network Common Data Format (NetCDF)")
 //		<< "CDF"
         << i18n("Flexible Image Transport System Data Format (FITS)")
+		<< i18n("LabPlot columnar binary data")
 //		<< i18n("Sound")
 		);
 }
@@ -156,7 +158,7 @@ QIcon FileDataSource::icon() const{
 	QIcon icon;
 	if (m_fileType == FileDataSource::Ascii)
 		icon = KIcon("text-plain");
-	else if (m_fileType == FileDataSource::Binary)
+	else if (m_fileType == FileDataSource::Binary || m_fileType == FileDataSource::ColumnarBinary)
 		icon = KIcon("application-octet-stream");
 	else if (m_fileType == FileDataSource::Image)
 		icon = KIcon("image-x-generic");
@@ -409,6 +411,10 @@ bool FileDataSource::load(XmlStreamReader* reader) {
 			m_filter = new AsciiFilter();
 			if (!m_filter->load(reader))
 				return false;
+		} else if (reader->name() == "columnarBinaryFilter") {
+			m_filter = new ColumnarBinaryFilter();
+			if (!m_filter->load(reader))
+				return false;
 		} else if(reader->name() == "column") {
 			Column* column = new Column("", AbstractColumn::Text);
 			if (!column->load(reader)) {
@@ -43,7 +43,7 @@ class FileDataSource : public Spreadsheet {
 		FileDataSource(AbstractScriptingEngine* engine,  const QString& name, bool loading = false);
 		~FileDataSource();
 
-		enum FileType{Ascii, Binary, Image, HDF, NETCDF, FITS};
+		enum FileType{Ascii, Binary, Image, HDF, NETCDF, FITS, ColumnarBinary};
 
 		static QStringList fileTypes();
 		static QString fileInfoString(const QString&);
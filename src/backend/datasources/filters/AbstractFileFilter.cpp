@@ -26,3 +26,26 @@ Copyright            : (C) 2009-2013 Alexander Semke (alexander.semke@web.de)
  ***************************************************************************/
 
 #include "backend/datasources/filters/AbstractFileFilter.h"
+
+/*!
+  returns the first \c lines records of the file \c fileName as strings for the preview in the import dialog.
+  In contrast to the read functions, the implementations are required to access only the beginning of the file
+  (or the first \c lines records of the selected data set) and must not touch the rest of the data.
+
+  The default implementation returns an empty list, meaning that the filter doesn't provide a preview.
+*/
+QList<QStringList> AbstractFileFilter::preview(const QString& fileName, int lines) {
+	Q_UNUSED(fileName);
+	Q_UNUSED(lines);
+	return QList<QStringList>();
+}
+
+/*!
+  returns the (estimated) number of rows the import of \c fileName will create.
+  The estimate is determined without reading the whole file, e.g. from the file size.
+  Returns -1, if no cheap estimate is possible.
+*/
+int AbstractFileFilter::estimatedRowCount(const QString& fileName) {
+	Q_UNUSED(fileName);
+	return -1;
+}
@@ -29,6 +29,7 @@ Copyright            : (C) 2009-2013 Alexander Semke (alexander.semke@web.de)
 #define ABSTRACTFILEFILTER_H
 
 #include <QObject>
+#include <QStringList>
 
 class AbstractDataSource;
 class XmlStreamReader;
@@ -45,6 +46,9 @@ class AbstractFileFilter : public QObject {
 		virtual void read(const QString& fileName, AbstractDataSource* dataSource, ImportMode mode = Replace) = 0;
 		virtual void write(const QString& fileName, AbstractDataSource* dataSource) = 0;
 
+		virtual QList<QStringList> preview(const QString& fileName, int lines);
+		virtual int estimatedRowCount(const QString& fileName);
+
 		virtual void loadFilterSettings(const QString& filterName) = 0;
 		virtual void saveFilterSettings(const QString& filterName) const = 0;
 
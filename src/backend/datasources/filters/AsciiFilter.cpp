@@ -30,13 +30,24 @@ Copyright            : (C) 2009-2015 Alexander Semke (alexander.semke@web.de)
 #include "backend/datasources/filters/AsciiFilterPrivate.h"
 #include "backend/datasources/FileDataSource.h"
 #include "backend/core/column/Column.h"
+#include "backend/core/datatypes/Double2StringFilter.h"
 #include "backend/lib/macros.h"
 
 #include <QTextStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QLocale>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
 #include <KLocale>
 #include <KFilterDev>
 
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
 
  /*!
 	\class AsciiFilter
@@ -68,6 +79,31 @@ void AsciiFilter::read(const QString & fileName, AbstractDataSource* dataSource,
 }
 
 
+/*!
+  returns the first \c lines rows of the file \c fileName parsed with the current settings.
+  Only the beginning of the file is read.
+*/
+QList<QStringList> AsciiFilter::preview(const QString& fileName, int lines) {
+	return d->preview(fileName, lines);
+}
+
+/*!
+  returns the number of lines in the file \c fileName estimated from the file size
+  and the length of the lines at the beginning of the file.
+*/
+int AsciiFilter::estimatedRowCount(const QString& fileName) {
+	return d->estimatedRowCount(fileName);
+}
+
+/*!
+  reads the content of the file \c fileName to \c vectors without accessing any data source.
+  Used for the parallel import of several files, the column names are returned in \c columnNames.
+  The reading is stopped when \c canceled is set.
+*/
+bool AsciiFilter::readVectors(const QString& fileName, QVector<QVector<double> >& vectors, QStringList& columnNames, const QAtomicInt* canceled) {
+	return d->readVectors(fileName, vectors, columnNames, canceled);
+}
+
 /*!
 writes the content of the data source \c dataSource to the file \c fileName.
 */
@@ -76,6 +112,13 @@ void AsciiFilter::write(const QString & fileName, AbstractDataSource* dataSource
 // 	emit()
 }
 
+/*!
+  returns the description of the error that occurred in the last call of write(), an empty string if the file was written.
+*/
+QString AsciiFilter::errorString() const {
+	return d->errorString;
+}
+
 /*!
   loads the predefined filter settings for \c filterName
 */
@@ -190,6 +233,18 @@ bool AsciiFilter::isHeaderEnabled() const{
 	return d->headerEnabled;
 }
 
+/*!
+  if \c b is true, numerical values are exported with all digits required to read back the same values.
+  Otherwise the numeric format and the number of digits of the exported column or matrix are used (default).
+*/
+void AsciiFilter::setFullPrecisionEnabled(const bool b) {
+	d->fullPrecisionEnabled = b;
+}
+
+bool AsciiFilter::isFullPrecisionEnabled() const {
+	return d->fullPrecisionEnabled;
+}
+
 void AsciiFilter::setVectorNames(const QString s) {
 	d->vectorNames = s.simplified();
 }
@@ -249,18 +304,69 @@ int AsciiFilter::endColumn() const{
 //#####################################################################
 //################### Private implementation ##########################
 //#####################################################################
+namespace {
+//number of lines used to estimate the total number of lines in a file
+const int previewSampleLines = 1000;
+
+//the beginning of the last previewed file
+struct AsciiFileHead {
+	AsciiFileHead() : fileSize(0), lines(0), complete(false), uncompressed(false) {}
+
+	QString fileName;
+	QDateTime lastModified;
+	qint64 fileSize;
+	QByteArray data;	//the first lines of the file
+	int lines;		//number of lines in data
+	bool complete;		//true, if data contains the whole file
+	bool uncompressed;
+};
+
+/*!
+  returns (at least) the first \c lines lines of the file \c fileName.
+  The file is only read again if it was changed or if more lines are requested than cached.
+*/
+const AsciiFileHead& asciiFileHead(const QString& fileName, int lines) {
+	static AsciiFileHead head;
+
+	const QFileInfo fileInfo(fileName);
+	if (head.fileName == fileName && head.fileSize == fileInfo.size() && head.lastModified == fileInfo.lastModified()
+		&& (head.complete || head.lines >= lines))
+		return head;
+
+	head = AsciiFileHead();
+	head.fileName = fileName;
+	head.fileSize = fileInfo.size();
+	head.lastModified = fileInfo.lastModified();
+
+	QIODevice* device = KFilterDev::deviceForFile(fileName);
+	head.uncompressed = (dynamic_cast<QFile*>(device) != 0);
+	if (device->open(QIODevice::ReadOnly)) {
+		while (head.lines < qMax(lines, previewSampleLines) && !device->atEnd()) {
+			head.data += device->readLine();
+			head.lines++;
+		}
+		head.complete = device->atEnd();
+	}
+	delete device;
+
+	return head;
+}
+}
+
 AsciiFilterPrivate::AsciiFilterPrivate(AsciiFilter* owner) : q(owner),
 	commentCharacter("#"),
 	separatingCharacter("auto"),
 	autoModeEnabled(true),
 	headerEnabled(true),
+	fullPrecisionEnabled(false),
 	skipEmptyParts(false),
 	simplifyWhitespacesEnabled(true),
 	transposed(false),
 	startRow(1),
 	endRow(-1),
 	startColumn(1),
-	endColumn(-1) {
+	endColumn(-1),
+	m_canceled(0) {
 }
 
 /*!
@@ -268,12 +374,32 @@ AsciiFilterPrivate::AsciiFilterPrivate(AsciiFilter* owner) : q(owner),
     Uses the settings defined in the data source.
 */
 QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode mode, int lines) {
+	//for the preview only the first lines of the file are required, don't touch the rest
+	if (dataSource == NULL && lines != -1)
+		return preview(fileName, lines);
+
 	QIODevice *device = KFilterDev::deviceForFile(fileName);
-	QList<QStringList> dataStrings;
-	if (!device->open(QIODevice::ReadOnly))
-		return dataStrings << (QStringList() << QString());
+	if (!device->open(QIODevice::ReadOnly)) {
+		delete device;
+		return QList<QStringList>() << (QStringList() << QString());
+	}
 
+	const int totalLines = AsciiFilter::lineNumber(fileName);
 	QTextStream in(device);
+	QList<QStringList> dataStrings = readFromStream(in, totalLines, dataSource, mode, lines);
+	delete device;
+
+	return dataStrings;
+}
+
+/*!
+    parses the content of the stream \c in containing \c totalLines lines.
+    The data is written to the data source \c dataSource or to \c vectors, if provided.
+    Otherwise the data is returned as strings.
+*/
+QList<QStringList> AsciiFilterPrivate::readFromStream(QTextStream& in, int totalLines, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode mode, int lines,
+		QVector<QVector<double> >* vectors, QStringList* columnNames) {
+	QList<QStringList> dataStrings;
 
 	//TODO implement
 	// if (transposed)
@@ -351,7 +477,11 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 
 	//qDebug()<<"	vector names ="<<vectorNameList;
 
-	int actualRows = AsciiFilter::lineNumber(fileName);	// data rows
+	//the number of lines is unknown (-1) if the file is read only once into vectors,
+	//the vectors grow while reading then
+	const bool growing = (totalLines < 0);
+	Q_ASSERT(!growing || dataSource == NULL);
+	int actualRows = growing ? std::numeric_limits<int>::max() / 2 : totalLines;	// data rows
 	int actualEndRow;
 	if (endRow == -1)
 		actualEndRow = actualRows;
@@ -379,6 +509,16 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 
 	if (dataSource != NULL)
 		columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols, vectorNameList);
+	else if (vectors != NULL) {
+		vectors->resize(actualCols);
+		dataPointers.resize(actualCols);
+		for (int n = 0; n < actualCols; n++) {
+			(*vectors)[n].resize(growing ? qMin(actualRows, 65536) : actualRows);
+			dataPointers[n] = &(*vectors)[n];
+		}
+		if (columnNames != NULL)
+			*columnNames = vectorNameList;
+	}
 
 	//header: import the values in the first line, if they were not used as the header (as the names for the columns)
 	bool isNumber;
@@ -387,23 +527,27 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 		for (int n=0; n < actualCols; n++) {
 			if (n < lineStringList.size()) {
 				const double value = lineStringList.at(n).toDouble(&isNumber);
-				if (dataSource != NULL)
+				if (!dataPointers.isEmpty())
 					isNumber ? dataPointers[n]->operator[](0) = value : dataPointers[n]->operator[](0) = NAN;
 				else
 					isNumber ? lineString << QString::number(value) : lineString << QLatin1String("NAN");
 			} else {
-				if (dataSource != NULL)
+				if (!dataPointers.isEmpty())
 					dataPointers[n]->operator[](0) = NAN;
 				else
 					lineString << QLatin1String("NAN");
 			}
 		}
-		dataStrings << lineString;
+		if (dataPointers.isEmpty())
+			dataStrings << lineString;
 		currentRow++;
 	}
 
 	//Read the remainder of the file.
 	for (int i=currentRow; i < qMin(lines,actualRows); i++) {
+		if (in.atEnd() || (m_canceled && *m_canceled))
+			break;
+
 		line = in.readLine();
 
 		if (simplifyWhitespacesEnabled)
@@ -420,30 +564,43 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 
 		lineStringList = line.split(separator, QString::SplitBehavior(skipEmptyParts));
 
+		if (growing && !dataPointers.isEmpty() && currentRow >= dataPointers.first()->size()) {
+			for (int n = 0; n < actualCols; n++)
+				dataPointers[n]->resize(2*currentRow);
+		}
+
 		// TODO : read strings (comments) or datetime too
 		QStringList lineString;
 		for (int n = 0; n < actualCols; n++) {
 			if (n < lineStringList.size()) {
 				const double value = lineStringList.at(n).toDouble(&isNumber);
-				if (dataSource != NULL)
+				if (!dataPointers.isEmpty())
 					isNumber ? dataPointers[n]->operator[](currentRow) = value : dataPointers[n]->operator[](currentRow) = NAN;
 				else
 					isNumber ? lineString += QString::number(value) : lineString += QString("NAN");
 			} else {
-				if (dataSource != NULL)
+				if (!dataPointers.isEmpty())
 					dataPointers[n]->operator[](currentRow) = NAN;
 				else
 					lineString += QLatin1String("NAN");
 			}
 		}
 
-		dataStrings << lineString;
+		if (dataPointers.isEmpty())
+			dataStrings << lineString;
 		currentRow++;
-		emit q->completed(100*currentRow/actualRows);
+		if (!growing)
+			emit q->completed(100*currentRow/actualRows);
 	}
 
-	if (!dataSource)
+	if (!dataSource) {
+		//remove the rows that were not filled (empty lines, comments)
+		if (vectors != NULL) {
+			for (int n = 0; n < vectors->size(); n++)
+				(*vectors)[n].resize(currentRow);
+		}
 		return dataStrings;
+	}
 
 	//make everything undo/redo-able again
 	//set the comments for each of the columns
@@ -475,6 +632,58 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 	return dataStrings;
 }
 
+/*!
+    returns the first \c lines rows of the file \c fileName as strings.
+    The beginning of the file is cached, changing the filter settings
+    (separator, header, etc.) while the file is unchanged doesn't require to read it again.
+*/
+QList<QStringList> AsciiFilterPrivate::preview(const QString& fileName, int lines) {
+	//one more line is required if the first line is used as the header
+	const AsciiFileHead& head = asciiFileHead(fileName, startRow + lines);
+	QByteArray data = head.data;
+	QTextStream in(&data, QIODevice::ReadOnly);
+
+	return readFromStream(in, head.lines, NULL, AbstractFileFilter::Replace, lines);
+}
+
+int AsciiFilterPrivate::estimatedRowCount(const QString& fileName) {
+	const AsciiFileHead& head = asciiFileHead(fileName, previewSampleLines);
+	if (head.complete)
+		return head.lines;
+
+	//the file size doesn't tell anything about the number of lines in compressed files
+	if (!head.uncompressed || head.data.isEmpty())
+		return -1;
+
+	return qRound((double)head.lines * head.fileSize / head.data.size());
+}
+
+/*!
+    reads the content of the file \c fileName to \c vectors, the column names are returned in \c columnNames.
+    No data source is accessed, this function can be called in a separate thread (with one filter per thread).
+    The file is read only once, the lines are counted while parsing. The reading is stopped when \c canceled is set.
+*/
+bool AsciiFilterPrivate::readVectors(const QString& fileName, QVector<QVector<double> >& vectors, QStringList& columnNames, const QAtomicInt* canceled) {
+	vectors.clear();
+	QIODevice* device = KFilterDev::deviceForFile(fileName);
+	if (!device->open(QIODevice::ReadOnly)) {
+		delete device;
+		return false;
+	}
+
+	m_canceled = canceled;
+	QTextStream in(device);
+	readFromStream(in, -1, NULL, AbstractFileFilter::Replace, -1, &vectors, &columnNames);
+	delete device;
+	m_canceled = 0;
+
+	if (canceled && *canceled) {
+		vectors.clear();
+		return false;
+	}
+	return !vectors.isEmpty();
+}
+
 /*!
     reads the content of the file \c fileName to the data source \c dataSource.
 */
@@ -482,13 +691,193 @@ void AsciiFilterPrivate::read(const QString & fileName, AbstractDataSource* data
 	readData(fileName, dataSource, mode);
 }
 
+namespace {
+//number of rows formatted in one export task
+const int exportBlockRows = 65536;
+
+//the data of one column to be exported
+struct AsciiExportColumn {
+	AsciiExportColumn() : values(0), format('g'), digits(6), rows(0) {}
+
+	const double* values;	//numeric data
+	char format;		//numeric format and number of digits of the numeric data
+	int digits;
+	QStringList texts;	//text representation of non-numeric data
+	int rows;
+};
+
+/*!
+  appends the shortest representation of \c value to \c buffer that is converted back to the same double.
+  The decimal point is always '.', independent of the current locale.
+*/
+void appendDouble(QByteArray& buffer, double value) {
+	if (std::isnan(value))
+		return;
+
+	char str[32];
+	int length = 0;
+	for (int precision = 15; precision <= 17; ++precision) {
+		length = snprintf(str, sizeof(str), "%.*g", precision, value);
+		if (strtod(str, NULL) == value)
+			break;
+	}
+
+	for (int i = 0; i < length; ++i) {
+		if (str[i] == ',')
+			str[i] = '.';
+	}
+	buffer.append(str, length);
+}
+
+/*!
+  formats the rows \c startRow to \c endRow (exclusive) of the columns to be exported into \c buffer.
+*/
+class AsciiExportTask : public QRunnable {
+	public:
+		AsciiExportTask(const QVector<AsciiExportColumn>& columns, int startRow, int endRow, const QByteArray& separator,
+				bool fullPrecision, QByteArray& buffer) :
+			m_columns(columns), m_startRow(startRow), m_endRow(endRow), m_separator(separator),
+			m_fullPrecision(fullPrecision), m_buffer(buffer) {
+		}
+
+		void run() {
+			const QLocale locale;
+			const int cols = m_columns.size();
+			m_buffer.clear();
+			m_buffer.reserve((m_endRow - m_startRow)*cols*24);
+			for (int row = m_startRow; row < m_endRow; ++row) {
+				for (int col = 0; col < cols; ++col) {
+					const AsciiExportColumn& column = m_columns.at(col);
+					if (row < column.rows) {
+						if (column.values && m_fullPrecision)
+							appendDouble(m_buffer, column.values[row]);
+						else if (column.values) {
+							//same as in Double2StringFilter::textAt()
+							const double value = column.values[row];
+							if (!std::isnan(value))
+								m_buffer.append(locale.toString(value, column.format, column.digits).toUtf8());
+						} else
+							m_buffer.append(column.texts.at(row).toUtf8());
+					}
+					if (col != cols - 1)
+						m_buffer.append(m_separator);
+				}
+				m_buffer.append('\n');
+			}
+		}
+
+	private:
+		const QVector<AsciiExportColumn>& m_columns;
+		const int m_startRow;
+		const int m_endRow;
+		const QByteArray& m_separator;
+		const bool m_fullPrecision;
+		QByteArray& m_buffer;
+};
+}
+
 /*!
     writes the content of \c dataSource to the file \c fileName.
+    Numerical values are written in the numeric format of the column (matrix) or, if full precision is enabled,
+    with the shortest representation that is read back to the same value.
+    The rows are formatted in blocks in parallel, the blocks are written in large chunks.
+    The file is compressed, if the file name has the extension of a supported compression format (.gz, .bz2, .xz).
+    If the file cannot be written completely, the export is stopped, the incomplete file is removed
+    and the error is provided by errorString.
 */
 void AsciiFilterPrivate::write(const QString & fileName, AbstractDataSource* dataSource) {
-	Q_UNUSED(fileName);
-	Q_UNUSED(dataSource);
-	//TODO
+	errorString.clear();
+	QVector<AsciiExportColumn> columns;
+	QStringList columnNames;
+	int rows = 0;
+
+	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
+	Matrix* matrix = dynamic_cast<Matrix*>(dataSource);
+	if (spreadsheet) {
+		rows = spreadsheet->rowCount();
+		for (int i = 0; i < spreadsheet->columnCount(); ++i) {
+			Column* column = spreadsheet->column(i);
+			AsciiExportColumn exportColumn;
+			exportColumn.rows = qMin(rows, column->rowCount());
+			if (column->columnMode() == AbstractColumn::Numeric) {
+				exportColumn.values = static_cast<QVector<double>*>(column->data())->constData();
+				const Double2StringFilter* filter = static_cast<Double2StringFilter*>(column->outputFilter());
+				exportColumn.format = filter->numericFormat();
+				exportColumn.digits = filter->numDigits();
+			} else if (column->columnMode() == AbstractColumn::Text)
+				exportColumn.texts = *static_cast<QStringList*>(column->data());
+			else {
+				//the conversion of date and time values is not thread-safe, convert them here
+				for (int row = 0; row < exportColumn.rows; ++row)
+					exportColumn.texts << column->asStringColumn()->textAt(row);
+			}
+			columns << exportColumn;
+			columnNames << column->name();
+		}
+	} else if (matrix) {
+		rows = matrix->rowCount();
+		const QVector<QVector<double> >& matrixData = matrix->data();
+		for (int i = 0; i < matrix->columnCount(); ++i) {
+			AsciiExportColumn exportColumn;
+			exportColumn.rows = qMin(rows, matrixData.at(i).size());
+			exportColumn.values = matrixData.at(i).constData();
+			exportColumn.format = matrix->numericFormat();
+			exportColumn.digits = matrix->precision();
+			columns << exportColumn;
+		}
+	} else
+		return;
+
+	QIODevice* device = KFilterDev::deviceForFile(fileName);
+	if (!device->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		errorString = device->errorString();
+		delete device;
+		return;
+	}
+
+	//no separator can be determined automatically on export, use TAB in this case
+	QString separatorString = (separatingCharacter == QLatin1String("auto")) ? QLatin1String("TAB") : separatingCharacter;
+	separatorString.replace(QLatin1String("TAB"), QLatin1String("\t"), Qt::CaseInsensitive);
+	separatorString.replace(QLatin1String("SPACE"), QLatin1String(" "), Qt::CaseInsensitive);
+	const QByteArray separator = separatorString.toUtf8();
+
+	//header (column names)
+	bool ok = true;
+	if (headerEnabled && !columnNames.isEmpty()) {
+		const QByteArray header = columnNames.join(separatorString).toUtf8() + '\n';
+		ok = (device->write(header) == header.size());
+	}
+
+	//format one block of rows per thread, write the blocks in the original order
+	const int threads = qMax(QThread::idealThreadCount(), 1);
+	QVector<QByteArray> buffers(threads);
+	QThreadPool pool;
+	for (int startRow = 0; ok && startRow < rows; startRow += threads*exportBlockRows) {
+		int tasks = 0;
+		for (int i = 0; i < threads; ++i) {
+			const int blockStart = startRow + i*exportBlockRows;
+			if (blockStart >= rows)
+				break;
+			const int blockEnd = qMin(blockStart + exportBlockRows, rows);
+			pool.start(new AsciiExportTask(columns, blockStart, blockEnd, separator, fullPrecisionEnabled, buffers[i]));
+			tasks++;
+		}
+		pool.waitForDone();
+
+		for (int i = 0; ok && i < tasks; ++i)
+			ok = (device->write(buffers.at(i)) == buffers.at(i).size());
+
+		const qint64 writtenRows = qMin((qint64)startRow + threads*exportBlockRows, (qint64)rows);
+		emit q->completed((int)(100*writtenRows/rows));
+	}
+
+	if (!ok)
+		errorString = device->errorString();
+	device->close();
+	delete device;
+
+	if (!ok)
+		QFile::remove(fileName);
 }
 
 //##############################################################################
@@ -28,7 +28,9 @@ Email (use @ for *)  : alexander.semke*web.de
 #ifndef ASCIIFILTER_H
 #define ASCIIFILTER_H
 
+#include <QAtomicInt>
 #include <QStringList>
+#include <QVector>
 #include "backend/datasources/filters/AbstractFileFilter.h"
 
 class AsciiFilterPrivate;
@@ -51,6 +53,11 @@ class AsciiFilter : public AbstractFileFilter{
 	QList<QStringList> readData(const QString & fileName, AbstractDataSource* dataSource,
 			AbstractFileFilter::ImportMode importMode = AbstractFileFilter::Replace, int lines = -1);
 	void write(const QString & fileName, AbstractDataSource* dataSource);
+	QString errorString() const;
+
+	QList<QStringList> preview(const QString& fileName, int lines);
+	int estimatedRowCount(const QString& fileName);
+	bool readVectors(const QString& fileName, QVector<QVector<double> >& vectors, QStringList& columnNames, const QAtomicInt* canceled = 0);
 
 	void loadFilterSettings(const QString&);
 	void saveFilterSettings(const QString&) const;
@@ -70,6 +77,9 @@ class AsciiFilter : public AbstractFileFilter{
 	void setHeaderEnabled(const bool);
 	bool isHeaderEnabled() const;
 
+	void setFullPrecisionEnabled(const bool);
+	bool isFullPrecisionEnabled() const;
+
 	void setVectorNames(const QString);
 	QString vectorNames() const;
 
@@ -30,6 +30,7 @@
 #define ASCIIFILTERPRIVATE_H
 
 class AbstractDataSource;
+class QTextStream;
 
 class AsciiFilterPrivate {
 
@@ -39,6 +40,9 @@ class AsciiFilterPrivate {
 		void read(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode = AbstractFileFilter::Replace);
 		QList <QStringList> readData(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace, int lines=-1);
 		void write(const QString & fileName, AbstractDataSource* dataSource);
+		QList<QStringList> preview(const QString& fileName, int lines);
+		int estimatedRowCount(const QString& fileName);
+		bool readVectors(const QString& fileName, QVector<QVector<double> >& vectors, QStringList& columnNames, const QAtomicInt* canceled);
 
 		const AsciiFilter* q;
 
@@ -46,6 +50,7 @@ class AsciiFilterPrivate {
 		QString separatingCharacter;
 		bool autoModeEnabled;
 		bool headerEnabled;
+		bool fullPrecisionEnabled;
 		QString vectorNames;
 		bool skipEmptyParts;
 		bool simplifyWhitespacesEnabled;
@@ -56,8 +61,14 @@ class AsciiFilterPrivate {
 		int startColumn;
 		int endColumn;
 
+		QString errorString;	//error of the last write()
+
 	private:
+		const QAtomicInt* m_canceled;	//checked while reading in readVectors()
+
 		void clearDataSource(AbstractDataSource*) const;
+		QList<QStringList> readFromStream(QTextStream&, int totalLines, AbstractDataSource*, AbstractFileFilter::ImportMode, int lines,
+				QVector<QVector<double> >* vectors = 0, QStringList* columnNames = 0);
 };
 
 #endif
@@ -30,6 +30,8 @@ Copyright            : (C) 2015-2017 by Stefan Gerlach (stefan.gerlach@uni.kn)
 #include "backend/core/column/Column.h"
 
 #include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
 #include <QDebug>
 #include <KLocale>
 #include <KFilterDev>
@@ -97,28 +99,61 @@ int BinaryFilter::dataSize(BinaryFilter::DataType type) {
 
 /*!
   returns the number of rows (length of vectors) in the file \c fileName.
+  If \c maxRows is not -1, the counting stops after \c maxRows rows.
 */
-long BinaryFilter::rowNumber(const QString & fileName, const int vectors, const BinaryFilter::DataType type) {
+long BinaryFilter::rowNumber(const QString & fileName, const int vectors, const BinaryFilter::DataType type, const long maxRows) {
 	QIODevice *device = KFilterDev::deviceForFile(fileName);
-	if (!device->open(QIODevice::ReadOnly))
+	const int rowBytes = vectors*BinaryFilter::dataSize(type);
+
+	//the size of an uncompressed file determines the number of rows, no need to read it
+	if (dynamic_cast<QFile*>(device)) {
+		delete device;
+		const qint64 size = QFileInfo(fileName).size();
+		long rows = (size + rowBytes - 1)/rowBytes;
+		if (maxRows != -1 && rows > maxRows)
+			rows = maxRows;
+		return rows;
+	}
+
+	if (!device->open(QIODevice::ReadOnly)) {
+		delete device;
 		return 0;
+	}
 
 	QDataStream in(device);
 	long rows=0;
-	while (!in.atEnd()) {
+	while (!in.atEnd() && (maxRows == -1 || rows < maxRows)) {
 		// one row
-		for (int i=0; i < vectors; ++i) {
-			for (int j=0; j < BinaryFilter::dataSize(type); ++j) {
-				qint8 tmp;
-				in >> tmp;
-			}
-		}
+		in.skipRawData(rowBytes);
 		rows++;
 	}
+	delete device;
 
 	return rows;
 }
 
+/*!
+  returns the first \c lines rows of the file \c fileName as strings.
+  Only the beginning of the file is read.
+*/
+QList<QStringList> BinaryFilter::preview(const QString& fileName, int lines) {
+	return d->readData(fileName, NULL, AbstractFileFilter::Replace, lines);
+}
+
+/*!
+  returns the number of rows in the file \c fileName.
+  The number is only determined for uncompressed files where it follows from the file size.
+*/
+int BinaryFilter::estimatedRowCount(const QString& fileName) {
+	QIODevice* device = KFilterDev::deviceForFile(fileName);
+	const bool uncompressed = (dynamic_cast<QFile*>(device) != 0);
+	delete device;
+	if (!uncompressed)
+		return -1;
+
+	return rowNumber(fileName, d->vectors, d->dataType);
+}
+
 ///////////////////////////////////////////////////////////////////////
 /*!
   loads the predefined filter settings for \c filterName
@@ -226,7 +261,11 @@ QList<QStringList> BinaryFilterPrivate::readData(const QString & fileName, Abstr
 	else if (byteOrder == BinaryFilter::LittleEndian)
 		in.setByteOrder(QDataStream::LittleEndian);
 
-	int numRows=BinaryFilter::rowNumber(fileName,vectors,dataType);
+	//for the preview it's sufficient to know whether the file contains the rows to be shown
+	long maxRows = -1;
+	if (dataSource == NULL && lines != -1)
+		maxRows = skipStartBytes/(BinaryFilter::dataSize(dataType)*vectors) + startRow + lines;
+	int numRows = BinaryFilter::rowNumber(fileName, vectors, dataType, maxRows);
 
 	// catch case that skipStartBytes or startRow is bigger than file
 	if (skipStartBytes >= BinaryFilter::dataSize(dataType)*vectors*numRows || startRow > numRows) {
@@ -44,12 +44,15 @@ class BinaryFilter : public AbstractFileFilter{
 	static QStringList dataTypes();
 	static QStringList byteOrders();
 	static int dataSize(BinaryFilter::DataType);
-	static long rowNumber(const QString & fileName, const int vectors, const BinaryFilter::DataType type);
+	static long rowNumber(const QString & fileName, const int vectors, const BinaryFilter::DataType type, const long maxRows = -1);
 
 	void read(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace);
 	QList <QStringList> readData(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace, int lines=-1);
 	void write(const QString & fileName, AbstractDataSource* dataSource);
 
+	QList<QStringList> preview(const QString& fileName, int lines);
+	int estimatedRowCount(const QString& fileName);
+
 	void loadFilterSettings(const QString&);
 	void saveFilterSettings(const QString&) const;
 
@@ -0,0 +1,919 @@
+/***************************************************************************
+File                 : ColumnarBinaryFilter.cpp
+Project              : LabPlot
+Description          : I/O-filter for the self-describing columnar binary format
+--------------------------------------------------------------------
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*  This program is free software; you can redistribute it and/or modify   *
+*  it under the terms of the GNU General Public License as published by   *
+*  the Free Software Foundation; either version 2 of the License, or      *
+*  (at your option) any later version.                                    *
+*                                                                         *
+*  This program is distributed in the hope that it will be useful,        *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+*  GNU General Public License for more details.                           *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program; if not, write to the Free Software           *
+*   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+*   Boston, MA  02110-1301  USA                                           *
+*                                                                         *
+***************************************************************************/
+#include "backend/datasources/filters/ColumnarBinaryFilter.h"
+#include "backend/datasources/filters/ColumnarBinaryFilterPrivate.h"
+#include "backend/datasources/FileDataSource.h"
+#include "backend/core/column/Column.h"
+#include "backend/core/datatypes/Double2StringFilter.h"
+#include "backend/core/datatypes/DateTime2StringFilter.h"
+#include "backend/matrix/Matrix.h"
+#include "backend/lib/macros.h"
+#include "backend/lib/PackedDateTime.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QtEndian>
+#include <KLocale>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+/*!
+	\class ColumnarBinaryFilter
+	\brief Manages the import/export of spreadsheets from/to the self-describing columnar binary format of LabPlot.
+
+	The file consists of
+	\li a header with the magic "LPCB", the format version, flags, the number of columns and rows, the number of rows per block
+	and the schema of each column (name, column mode, plot designation, width, comment, output format, formulas and masked rows),
+	\li the column data, stored in blocks of rows. Each block contains one typed chunk per column that is optionally zlib-compressed,
+	\li a footer with the index of all chunks (offset, stored and uncompressed size, compression flag),
+	followed by the offset of the index and the magic "LPCE".
+
+	The header and the footer are written with QDataStream, the chunks contain little-endian doubles for numeric columns,
+	milliseconds since epoch (qint64) for date and time columns and length-prefixed UTF-8 strings for text columns.
+	The date and time values are stored as UTC, i.e. the wall-clock time of the column is restored independently
+	of the time zone (files of version 1 stored the local time).
+	The index allows to read only the blocks and columns that are requested.
+
+	\ingroup datasources
+ */
+ColumnarBinaryFilter::ColumnarBinaryFilter() : AbstractFileFilter(), d(new ColumnarBinaryFilterPrivate(this)) {
+}
+
+ColumnarBinaryFilter::~ColumnarBinaryFilter() {
+	delete d;
+}
+
+/*!
+  returns the default file extension of the columnar binary format.
+*/
+QString ColumnarBinaryFilter::fileExtension() {
+	return QLatin1String("lcb");
+}
+
+/*!
+  reads the content of the file \c fileName to the data source \c dataSource.
+*/
+void ColumnarBinaryFilter::read(const QString& fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode) {
+	d->read(fileName, dataSource, importMode);
+}
+
+/*!
+  writes the content of the data source \c dataSource to the file \c fileName.
+*/
+void ColumnarBinaryFilter::write(const QString& fileName, AbstractDataSource* dataSource) {
+	d->write(fileName, dataSource);
+}
+
+/*!
+  returns the description of the error that occurred in the last call of write(), an empty string if the file was written.
+*/
+QString ColumnarBinaryFilter::errorString() const {
+	return d->errorString;
+}
+
+/*!
+  returns the first \c lines rows of the file \c fileName as strings.
+  Only the blocks containing these rows are read.
+*/
+QList<QStringList> ColumnarBinaryFilter::preview(const QString& fileName, int lines) {
+	return d->preview(fileName, lines);
+}
+
+/*!
+  returns the number of rows in the file \c fileName. The number is stored in the header, the data is not read.
+*/
+int ColumnarBinaryFilter::estimatedRowCount(const QString& fileName) {
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return -1;
+
+	ColumnarBinaryFilterPrivate::FileInfo info;
+	if (!d->readFileInfo(file, info))
+		return -1;
+
+	return info.rows;
+}
+
+///////////////////////////////////////////////////////////////////////
+/*!
+  loads the predefined filter settings for \c filterName
+*/
+void ColumnarBinaryFilter::loadFilterSettings(const QString& filterName) {
+	Q_UNUSED(filterName);
+}
+
+/*!
+  saves the current settings as a new filter with the name \c filterName
+*/
+void ColumnarBinaryFilter::saveFilterSettings(const QString& filterName) const {
+	Q_UNUSED(filterName);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+/*!
+  enables the zlib-compression of the chunks on export.
+*/
+void ColumnarBinaryFilter::setCompressionEnabled(const bool b) {
+	d->compressionEnabled = b;
+}
+
+bool ColumnarBinaryFilter::isCompressionEnabled() const {
+	return d->compressionEnabled;
+}
+
+void ColumnarBinaryFilter::setStartRow(const int s) {
+	d->startRow = s;
+}
+
+int ColumnarBinaryFilter::startRow() const {
+	return d->startRow;
+}
+
+void ColumnarBinaryFilter::setEndRow(const int e) {
+	d->endRow = e;
+}
+
+int ColumnarBinaryFilter::endRow() const {
+	return d->endRow;
+}
+
+void ColumnarBinaryFilter::setStartColumn(const int c) {
+	d->startColumn = c;
+}
+
+int ColumnarBinaryFilter::startColumn() const {
+	return d->startColumn;
+}
+
+void ColumnarBinaryFilter::setEndColumn(const int c) {
+	d->endColumn = c;
+}
+
+int ColumnarBinaryFilter::endColumn() const {
+	return d->endColumn;
+}
+
+//#####################################################################
+//################### Private implementation ##########################
+//#####################################################################
+
+namespace {
+const char fileMagic[] = "LPCB";
+const char footerMagic[] = "LPCE";
+const quint16 formatVersion = 2;
+const quint16 compressedFlag = 0x1;
+
+//number of rows stored in one chunk
+const qint32 blockRows = 65536;
+
+//size of the offset of the index and the footer magic at the end of the file
+const int trailerSize = 12;
+
+//size of the entry of one chunk in the index (offset, stored size, raw size, compression flag)
+const int indexEntrySize = 17;
+
+//smallest size of the schema of one column in the header (empty strings and lists)
+const int minSchemaSize = 53;
+
+//date and time values that are not valid are stored with this value
+const qint64 invalidDateTime = std::numeric_limits<qint64>::min();
+
+//the data of one column to be exported
+struct ColumnarColumnData {
+	ColumnarColumnData() : mode(AbstractColumn::Numeric), values(0), texts(0), dateTimes(0), rows(0) {}
+
+	AbstractColumn::ColumnMode mode;
+	const double* values;
+	const QStringList* texts;
+	const QVector<qint64>* dateTimes;	//packed, see PackedDateTime
+	int rows;	//number of available values, the missing rows are written as NaN, empty strings or invalid dates
+};
+
+void writeSchema(QDataStream& out, const ColumnarBinaryFilterPrivate::ColumnSchema& schema) {
+	out << schema.name << schema.mode << schema.plotDesignation << schema.width << schema.comment
+		<< (qint8)schema.numericFormat << schema.numDigits << schema.dateTimeFormat
+		<< schema.formula << schema.formulaVariableNames << schema.formulaVariableColumnPathes;
+
+	out << (qint32)schema.maskedIntervals.size();
+	foreach (const Interval<int>& interval, schema.maskedIntervals)
+		out << (qint32)interval.start() << (qint32)interval.end();
+
+	out << (qint32)schema.rowFormulas.size();
+	for (int i = 0; i < schema.rowFormulas.size(); ++i) {
+		const Interval<int>& interval = schema.rowFormulas.at(i).first;
+		out << (qint32)interval.start() << (qint32)interval.end() << schema.rowFormulas.at(i).second;
+	}
+}
+
+void readSchema(QDataStream& in, ColumnarBinaryFilterPrivate::ColumnSchema& schema) {
+	qint8 numericFormat;
+	in >> schema.name >> schema.mode >> schema.plotDesignation >> schema.width >> schema.comment
+		>> numericFormat >> schema.numDigits >> schema.dateTimeFormat
+		>> schema.formula >> schema.formulaVariableNames >> schema.formulaVariableColumnPathes;
+	schema.numericFormat = numericFormat;
+
+	qint32 count;
+	in >> count;
+	for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+		qint32 start, end;
+		in >> start >> end;
+		schema.maskedIntervals << Interval<int>(start, end);
+	}
+
+	in >> count;
+	for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+		qint32 start, end;
+		QString formula;
+		in >> start >> end >> formula;
+		schema.rowFormulas << qMakePair(Interval<int>(start, end), formula);
+	}
+}
+
+/*!
+  serializes the rows \c first to \c last (exclusive) of \c column into one chunk.
+*/
+QByteArray encodeChunk(const ColumnarColumnData& column, int first, int last) {
+	QByteArray raw;
+	switch (column.mode) {
+	case AbstractColumn::Numeric: {
+		raw.resize(8*(last - first));
+		uchar* dest = reinterpret_cast<uchar*>(raw.data());
+		const double nan = std::numeric_limits<double>::quiet_NaN();
+		for (int row = first; row < last; ++row, dest += 8) {
+			const double value = (row < column.rows) ? column.values[row] : nan;
+			quint64 bits;
+			memcpy(&bits, &value, sizeof(bits));
+			qToLittleEndian<quint64>(bits, dest);
+		}
+		break;
+	}
+	case AbstractColumn::Text: {
+		uchar length[4];
+		for (int row = first; row < last; ++row) {
+			const QByteArray text = (row < column.rows) ? column.texts->at(row).toUtf8() : QByteArray();
+			qToLittleEndian<quint32>(text.size(), length);
+			raw.append(reinterpret_cast<const char*>(length), 4);
+			raw.append(text);
+		}
+		break;
+	}
+	case AbstractColumn::DateTime:
+	case AbstractColumn::Month:
+	case AbstractColumn::Day: {
+		raw.resize(8*(last - first));
+		uchar* dest = reinterpret_cast<uchar*>(raw.data());
+		for (int row = first; row < last; ++row, dest += 8) {
+			qint64 msecs = invalidDateTime;
+			if (row < column.rows && PackedDateTime::isValid(column.dateTimes->at(row))) {
+				//the wall-clock time is stored as UTC, independent of the time zone and of daylight saving time
+				const QDateTime dateTime = PackedDateTime::unpack(column.dateTimes->at(row));
+				msecs = QDateTime(dateTime.date(), dateTime.time(), Qt::UTC).toMSecsSinceEpoch();
+			}
+			qToLittleEndian<qint64>(msecs, dest);
+		}
+		break;
+	}
+	}
+
+	return raw;
+}
+
+/*!
+  serializes and compresses one chunk of a column.
+*/
+class ChunkEncodeTask : public QRunnable {
+	public:
+		ChunkEncodeTask(const ColumnarColumnData& column, int first, int last, bool compress,
+						QByteArray& chunk, ColumnarBinaryFilterPrivate::ChunkIndex& index) :
+			m_column(column), m_first(first), m_last(last), m_compress(compress), m_chunk(chunk), m_index(index) {
+		}
+
+		void run() {
+			m_chunk = encodeChunk(m_column, m_first, m_last);
+			m_index.rawSize = m_chunk.size();
+			m_index.compressed = false;
+			if (m_compress) {
+				//the fastest compression level, the file size is dominated by the numeric data anyhow.
+				//the chunk is stored uncompressed, if nothing is gained.
+				const QByteArray compressed = qCompress(m_chunk, 1);
+				if (compressed.size() < m_chunk.size()) {
+					m_chunk = compressed;
+					m_index.compressed = true;
+				}
+			}
+			m_index.storedSize = m_chunk.size();
+		}
+
+	private:
+		const ColumnarColumnData& m_column;
+		const int m_first;
+		const int m_last;
+		const bool m_compress;
+		QByteArray& m_chunk;
+		ColumnarBinaryFilterPrivate::ChunkIndex& m_index;
+};
+
+/*!
+  uncompresses one chunk and deserializes the \c count rows starting at the row \c skip within the chunk.
+  Numeric values are written to \c values, texts and date time values are appended to \c texts and \c dateTimes, respectively.
+*/
+class ChunkDecodeTask : public QRunnable {
+	public:
+		ChunkDecodeTask(const QByteArray& chunk, bool compressed, int mode, int skip, int count, bool utc,
+						double* values, QStringList& texts, QList<QDateTime>& dateTimes) :
+			m_chunk(chunk), m_compressed(compressed), m_mode(mode), m_skip(skip), m_count(count), m_utc(utc),
+			m_values(values), m_texts(texts), m_dateTimes(dateTimes) {
+		}
+
+		void run() {
+			const QByteArray raw = m_compressed ? qUncompress(m_chunk) : m_chunk;
+			const uchar* src = reinterpret_cast<const uchar*>(raw.constData());
+			const uchar* const end = src + raw.size();
+
+			switch (m_mode) {
+			case AbstractColumn::Numeric: {
+				const bool complete = (raw.size() >= 8*(m_skip + m_count));
+				src += 8*m_skip;
+				for (int i = 0; i < m_count; ++i, src += 8) {
+					if (!complete) {
+						m_values[i] = std::numeric_limits<double>::quiet_NaN();
+						continue;
+					}
+					const quint64 bits = qFromLittleEndian<quint64>(src);
+					memcpy(&m_values[i], &bits, sizeof(double));
+				}
+				break;
+			}
+			case AbstractColumn::Text: {
+				m_texts.reserve(m_count);
+				for (int row = 0; row < m_skip + m_count && end - src >= 4; ++row) {
+					const quint32 length = qFromLittleEndian<quint32>(src);
+					src += 4;
+					if (length > (quint32)(end - src))
+						break;
+					if (row >= m_skip)
+						m_texts << QString::fromUtf8(reinterpret_cast<const char*>(src), length);
+					src += length;
+				}
+				while (m_texts.size() < m_count)
+					m_texts << QString();
+				break;
+			}
+			default: {
+				m_dateTimes.reserve(m_count);
+				const bool complete = (raw.size() >= 8*(m_skip + m_count));
+				src += 8*m_skip;
+				for (int i = 0; i < m_count; ++i, src += 8) {
+					const qint64 msecs = complete ? qFromLittleEndian<qint64>(src) : invalidDateTime;
+					if (msecs == invalidDateTime)
+						m_dateTimes << QDateTime();
+					else if (m_utc)
+						m_dateTimes << QDateTime::fromMSecsSinceEpoch(msecs).toUTC();
+					else
+						m_dateTimes << QDateTime::fromMSecsSinceEpoch(msecs);
+				}
+			}
+			}
+		}
+
+	private:
+		const QByteArray m_chunk;
+		const bool m_compressed;
+		const int m_mode;
+		const int m_skip;
+		const int m_count;
+		const bool m_utc;	//date and time values stored as UTC (format version 2 and later)
+		double* m_values;
+		QStringList& m_texts;
+		QList<QDateTime>& m_dateTimes;
+};
+
+bool isNumericMode(int mode) {
+	return (mode == AbstractColumn::Numeric);
+}
+
+bool isDateTimeMode(int mode) {
+	return (mode == AbstractColumn::DateTime || mode == AbstractColumn::Month || mode == AbstractColumn::Day);
+}
+
+/*!
+  returns the intervals of \c intervals within the rows \c first to \c last (exclusive), shifted by \c first.
+*/
+QList< Interval<int> > shiftedIntervals(const QList< Interval<int> >& intervals, int first, int last) {
+	QList< Interval<int> > result;
+	const Interval<int> range(first, last - 1);
+	foreach (const Interval<int>& interval, intervals) {
+		const Interval<int> intersection = Interval<int>::intersection(interval, range);
+		if (intersection.isValid())
+			result << Interval<int>(intersection.start() - first, intersection.end() - first);
+	}
+	return result;
+}
+}
+
+ColumnarBinaryFilterPrivate::ColumnarBinaryFilterPrivate(ColumnarBinaryFilter* owner) :
+	q(owner), compressionEnabled(true), startRow(1), endRow(-1), startColumn(1), endColumn(-1) {
+}
+
+/*!
+  returns \c true if the file \c fileName starts with the magic of the columnar binary format.
+*/
+bool ColumnarBinaryFilter::isColumnarBinaryFile(const QString& fileName) {
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	return (file.read(4) == QByteArray(fileMagic));
+}
+
+/*!
+  reads the header with the schema of the columns and the chunk index of the opened file \c file into \c info.
+  Returns \c false if the file is not a valid columnar binary file.
+*/
+bool ColumnarBinaryFilterPrivate::readFileInfo(QFile& file, FileInfo& info) const {
+	const qint64 size = file.size();
+	if (size < 4 + trailerSize)
+		return false;
+
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_4_8);
+
+	char magic[4];
+	if (in.readRawData(magic, 4) != 4 || memcmp(magic, fileMagic, 4) != 0)
+		return false;
+
+	quint16 version, flags;
+	qint32 cols;
+	in >> version >> flags >> cols >> info.rows >> info.blockRows;
+	if (in.status() != QDataStream::Ok || version > formatVersion || cols < 0 || info.rows < 0 || info.blockRows <= 0)
+		return false;
+	info.version = version;
+
+	//the values in the header are not trusted, check them against the size of the file before allocating anything
+	if ((qint64)cols*minSchemaSize > size - trailerSize - file.pos())
+		return false;
+
+	info.columns.resize(cols);
+	for (int i = 0; i < cols && in.status() == QDataStream::Ok; ++i)
+		readSchema(in, info.columns[i]);
+	if (in.status() != QDataStream::Ok)
+		return false;
+	const qint64 dataStart = file.pos();
+
+	//footer: the chunk index
+	qint64 indexOffset;
+	file.seek(size - trailerSize);
+	in >> indexOffset;
+	if (in.readRawData(magic, 4) != 4 || memcmp(magic, footerMagic, 4) != 0)
+		return false;
+	if (indexOffset < dataStart || indexOffset > size - trailerSize)
+		return false;
+
+	const qint64 blocks = ((qint64)info.rows + info.blockRows - 1)/info.blockRows;
+	if (blocks*cols*indexEntrySize != size - trailerSize - indexOffset)
+		return false;
+
+	file.seek(indexOffset);
+	info.chunks.resize(blocks);
+	for (int b = 0; b < blocks; ++b) {
+		info.chunks[b].resize(cols);
+		for (int c = 0; c < cols; ++c) {
+			ChunkIndex& chunk = info.chunks[b][c];
+			quint8 compressed;
+			in >> chunk.offset >> chunk.storedSize >> chunk.rawSize >> compressed;
+			chunk.compressed = compressed;
+			if (chunk.offset < dataStart || chunk.storedSize < 0 || chunk.offset + chunk.storedSize > indexOffset)
+				return false;
+		}
+	}
+
+	return (in.status() == QDataStream::Ok);
+}
+
+/*!
+    reads the content of the file \c fileName to the data source \c dataSource.
+    Only the chunks of the selected rows and columns are read, the chunks are decoded in parallel.
+    For spreadsheets the column modes, the formulas and the masked rows are restored,
+    only numeric columns are imported into matrices.
+*/
+void ColumnarBinaryFilterPrivate::read(const QString& fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode mode) {
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+
+	FileInfo info;
+	if (!readFileInfo(file, info)) {
+		DEBUG("not a valid columnar binary file");
+		return;
+	}
+
+	//the data portion to import
+	const int firstRow = qMax(startRow, 1) - 1;
+	const int lastRow = (endRow == -1 || endRow > info.rows) ? info.rows : endRow;
+	const int firstColumn = qMax(startColumn, 1) - 1;
+	const int lastColumn = (endColumn == -1 || endColumn > info.columns.size()) ? info.columns.size() : endColumn;
+
+	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
+	QVector<int> columns;
+	QStringList names;
+	for (int c = firstColumn; c < lastColumn; ++c) {
+		if (spreadsheet || isNumericMode(info.columns.at(c).mode)) {
+			columns << c;
+			names << info.columns.at(c).name;
+		}
+	}
+
+	if (firstRow >= lastRow || columns.isEmpty()) {
+		dataSource->clear();
+		return;
+	}
+
+	const int actualRows = lastRow - firstRow;
+	const int actualCols = columns.size();
+	QVector<QVector<double>*> dataPointers;
+	const int columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols, names);
+
+	//read the chunks of several blocks, decode them in parallel
+	const int firstBlock = firstRow/info.blockRows;
+	const int lastBlock = (lastRow - 1)/info.blockRows;
+	const int blocks = lastBlock - firstBlock + 1;
+	QVector<QStringList> texts(blocks*actualCols);
+	QVector<QList<QDateTime> > dateTimes(blocks*actualCols);
+	const int threads = qMax(QThread::idealThreadCount(), 1);
+	QThreadPool pool;
+	for (int b = firstBlock; b <= lastBlock; b += threads) {
+		for (int block = b; block < qMin(b + threads, lastBlock + 1); ++block) {
+			const int blockStart = block*info.blockRows;
+			const int skip = qMax(firstRow - blockStart, 0);
+			const int count = qMin(blockStart + info.blockRows, lastRow) - blockStart - skip;
+			for (int i = 0; i < actualCols; ++i) {
+				const int c = columns.at(i);
+				const ChunkIndex& index = info.chunks.at(block).at(c);
+				file.seek(index.offset);
+				const QByteArray chunk = file.read(index.storedSize);
+				double* values = isNumericMode(info.columns.at(c).mode) ? dataPointers[i]->data() + (blockStart + skip - firstRow) : 0;
+				const int result = (block - firstBlock)*actualCols + i;
+				pool.start(new ChunkDecodeTask(chunk, index.compressed, info.columns.at(c).mode, skip, count, info.version >= 2,
+											   values, texts[result], dateTimes[result]));
+			}
+		}
+		pool.waitForDone();
+		emit q->completed(100*(qMin(b + threads, lastBlock + 1) - firstBlock)/blocks);
+	}
+
+	Matrix* matrix = dynamic_cast<Matrix*>(dataSource);
+	if (matrix) {
+		matrix->setSuppressDataChangedSignal(false);
+		matrix->setChanged();
+		matrix->setUndoAware(true);
+		return;
+	}
+
+	if (!spreadsheet)
+		return;
+
+	for (int i = 0; i < actualCols; ++i) {
+		const ColumnSchema& schema = info.columns.at(columns.at(i));
+		Column* column = spreadsheet->column(columnOffset + i);
+
+		//non-numeric data
+		if (!isNumericMode(schema.mode)) {
+			dataPointers[i]->clear();
+			column->setColumnMode((AbstractColumn::ColumnMode)schema.mode);
+			if (schema.mode == AbstractColumn::Text) {
+				QStringList columnTexts;
+				columnTexts.reserve(actualRows);
+				for (int block = 0; block < blocks; ++block)
+					columnTexts << texts.at(block*actualCols + i);
+				column->replaceTexts(0, columnTexts);
+			} else if (isDateTimeMode(schema.mode)) {
+				QList<QDateTime> columnDateTimes;
+				columnDateTimes.reserve(actualRows);
+				for (int block = 0; block < blocks; ++block)
+					columnDateTimes << dateTimes.at(block*actualCols + i);
+				column->replaceDateTimes(0, columnDateTimes);
+			}
+		}
+
+		//output format
+		AbstractSimpleFilter* outputFilter = column->outputFilter();
+		outputFilter->setUndoAware(false);
+		if (isNumericMode(schema.mode)) {
+			Double2StringFilter* filter = static_cast<Double2StringFilter*>(outputFilter);
+			filter->setNumericFormat(schema.numericFormat);
+			filter->setNumDigits(schema.numDigits);
+		} else if (isDateTimeMode(schema.mode) && !schema.dateTimeFormat.isEmpty())
+			static_cast<DateTime2StringFilter*>(outputFilter)->setFormat(schema.dateTimeFormat);
+		outputFilter->setUndoAware(true);
+
+		//properties, formulas and masked rows
+		column->setPlotDesignation((AbstractColumn::PlotDesignation)schema.plotDesignation);
+		if (schema.width > 0)
+			column->setWidth(schema.width);
+		column->setComment(schema.comment);
+		if (!schema.formula.isEmpty())
+			column->setFormula(schema.formula, schema.formulaVariableNames, schema.formulaVariableColumnPathes);
+		for (int f = 0; f < schema.rowFormulas.size(); ++f) {
+			const QList< Interval<int> > intervals = shiftedIntervals(QList< Interval<int> >() << schema.rowFormulas.at(f).first, firstRow, lastRow);
+			if (!intervals.isEmpty())
+				column->setFormula(intervals.first(), schema.rowFormulas.at(f).second);
+		}
+		foreach (const Interval<int>& interval, shiftedIntervals(schema.maskedIntervals, firstRow, lastRow))
+			column->setMasked(interval);
+
+		//make everything undo/redo-able again
+		column->setUndoAware(true);
+		if (mode == AbstractFileFilter::Replace) {
+			column->setSuppressDataChangedSignal(false);
+			column->setChanged();
+		}
+	}
+	spreadsheet->setUndoAware(true);
+}
+
+/*!
+    writes the content of \c dataSource to the file \c fileName.
+    The chunks are encoded and compressed in parallel and written in the order of the blocks.
+    If the file cannot be written completely, the incomplete file is removed and the error is provided by errorString.
+*/
+void ColumnarBinaryFilterPrivate::write(const QString& fileName, AbstractDataSource* dataSource) {
+	errorString.clear();
+	QVector<ColumnarColumnData> columns;
+	QVector<ColumnSchema> schemas;
+	int rows = 0;
+
+	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
+	Matrix* matrix = dynamic_cast<Matrix*>(dataSource);
+	if (spreadsheet) {
+		rows = spreadsheet->rowCount();
+		for (int i = 0; i < spreadsheet->columnCount(); ++i) {
+			const Column* column = spreadsheet->column(i);
+			ColumnarColumnData data;
+			data.mode = column->columnMode();
+			data.rows = qMin(rows, column->rowCount());
+
+			ColumnSchema schema;
+			schema.name = column->name();
+			schema.mode = column->columnMode();
+			schema.plotDesignation = column->plotDesignation();
+			schema.width = column->width();
+			schema.comment = column->comment();
+			schema.formula = column->formula();
+			schema.formulaVariableNames = column->formulaVariableNames();
+			schema.formulaVariableColumnPathes = column->formulaVariableColumnPathes();
+			schema.maskedIntervals = column->maskedIntervals();
+			foreach (const Interval<int>& interval, column->formulaIntervals())
+				schema.rowFormulas << qMakePair(interval, column->formula(interval.start()));
+
+			if (isNumericMode(data.mode)) {
+				data.values = static_cast<QVector<double>*>(column->data())->constData();
+				const Double2StringFilter* filter = static_cast<Double2StringFilter*>(column->outputFilter());
+				schema.numericFormat = filter->numericFormat();
+				schema.numDigits = filter->numDigits();
+			} else if (data.mode == AbstractColumn::Text)
+				data.texts = static_cast<QStringList*>(column->data());
+			else {
+				data.dateTimes = static_cast<QVector<qint64>*>(column->data());
+				schema.dateTimeFormat = static_cast<DateTime2StringFilter*>(column->outputFilter())->format();
+			}
+
+			columns << data;
+			schemas << schema;
+		}
+	} else if (matrix) {
+		rows = matrix->rowCount();
+		const QVector<QVector<double> >& matrixData = matrix->data();
+		for (int i = 0; i < matrix->columnCount(); ++i) {
+			ColumnarColumnData data;
+			data.rows = qMin(rows, matrixData.at(i).size());
+			data.values = matrixData.at(i).constData();
+			columns << data;
+
+			ColumnSchema schema;
+			schema.name = QString::number(i + 1);
+			schemas << schema;
+		}
+	} else
+		return;
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		errorString = file.errorString();
+		return;
+	}
+
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_4_8);
+
+	//header
+	const int cols = columns.size();
+	out.writeRawData(fileMagic, 4);
+	out << formatVersion << (quint16)(compressionEnabled ? compressedFlag : 0) << (qint32)cols << (qint32)rows << blockRows;
+	for (int i = 0; i < cols; ++i)
+		writeSchema(out, schemas.at(i));
+	bool ok = (file.error() == QFile::NoError);
+
+	//encode the chunks of one block per thread, write the blocks in the original order
+	const int blocks = (rows + blockRows - 1)/blockRows;
+	QVector<QVector<ChunkIndex> > index(blocks, QVector<ChunkIndex>(cols));
+	const int threads = qMax(QThread::idealThreadCount(), 1);
+	QVector<QByteArray> chunks(threads*cols);
+	QThreadPool pool;
+	for (int b = 0; b < blocks && ok; b += threads) {
+		const int lastBlock = qMin(b + threads, blocks);
+		for (int block = b; block < lastBlock; ++block) {
+			const int first = block*blockRows;
+			const int last = qMin(first + blockRows, rows);
+			for (int c = 0; c < cols; ++c)
+				pool.start(new ChunkEncodeTask(columns.at(c), first, last, compressionEnabled, chunks[(block - b)*cols + c], index[block][c]));
+		}
+		pool.waitForDone();
+
+		for (int block = b; block < lastBlock && ok; ++block) {
+			for (int c = 0; c < cols && ok; ++c) {
+				index[block][c].offset = file.pos();
+				const QByteArray& chunk = chunks.at((block - b)*cols + c);
+				ok = (file.write(chunk) == chunk.size());
+			}
+		}
+
+		emit q->completed(100*lastBlock/blocks);
+	}
+
+	//footer
+	const qint64 indexOffset = file.pos();
+	for (int block = 0; block < blocks; ++block) {
+		for (int c = 0; c < cols; ++c) {
+			const ChunkIndex& chunk = index.at(block).at(c);
+			out << chunk.offset << chunk.storedSize << chunk.rawSize << (quint8)chunk.compressed;
+		}
+	}
+	out << indexOffset;
+	out.writeRawData(footerMagic, 4);
+	file.flush();
+
+	if (!ok || file.error() != QFile::NoError) {
+		errorString = file.errorString();
+		file.close();
+		file.remove();
+		return;
+	}
+
+	file.close();
+}
+
+/*!
+    returns the first \c lines of the selected rows and columns of the file \c fileName as strings.
+    The values are formatted with the output format stored for each column.
+*/
+QList<QStringList> ColumnarBinaryFilterPrivate::preview(const QString& fileName, int lines) {
+	QList<QStringList> dataStrings;
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return dataStrings << (QStringList() << i18n("could not open device"));
+
+	FileInfo info;
+	if (!readFileInfo(file, info))
+		return dataStrings << (QStringList() << i18n("not a valid columnar binary file"));
+
+	const int firstRow = qMax(startRow, 1) - 1;
+	int lastRow = (endRow == -1 || endRow > info.rows) ? info.rows : endRow;
+	if (lines != -1)
+		lastRow = qMin(lastRow, firstRow + lines);
+	const int firstColumn = qMax(startColumn, 1) - 1;
+	const int lastColumn = (endColumn == -1 || endColumn > info.columns.size()) ? info.columns.size() : endColumn;
+	if (firstRow >= lastRow || firstColumn >= lastColumn)
+		return dataStrings << (QStringList() << i18n("data selection empty"));
+
+	//decode the required chunks column by column
+	const int rows = lastRow - firstRow;
+	QVector<QStringList> columnStrings(lastColumn - firstColumn);
+	for (int c = firstColumn; c < lastColumn; ++c) {
+		const ColumnSchema& schema = info.columns.at(c);
+		QStringList& strings = columnStrings[c - firstColumn];
+		for (int block = firstRow/info.blockRows; block <= (lastRow - 1)/info.blockRows; ++block) {
+			const int blockStart = block*info.blockRows;
+			const int skip = qMax(firstRow - blockStart, 0);
+			const int count = qMin(blockStart + info.blockRows, lastRow) - blockStart - skip;
+			const ChunkIndex& index = info.chunks.at(block).at(c);
+			file.seek(index.offset);
+			QVector<double> values(count);
+			QStringList texts;
+			QList<QDateTime> dateTimes;
+			ChunkDecodeTask task(file.read(index.storedSize), index.compressed, schema.mode, skip, count, info.version >= 2,
+								 values.data(), texts, dateTimes);
+			task.run();
+
+			if (isNumericMode(schema.mode)) {
+				foreach (double value, values)
+					strings << (std::isnan(value) ? QString() : QString::number(value, schema.numericFormat, schema.numDigits));
+			} else if (isDateTimeMode(schema.mode)) {
+				foreach (const QDateTime& dateTime, dateTimes)
+					strings << dateTime.toString(schema.dateTimeFormat);
+			} else
+				strings << texts;
+		}
+	}
+
+	for (int row = 0; row < rows; ++row) {
+		QStringList lineString;
+		for (int c = 0; c < columnStrings.size(); ++c)
+			lineString << columnStrings.at(c).at(row);
+		dataStrings << lineString;
+	}
+
+	return dataStrings;
+}
+
+//##############################################################################
+//##################  Serialization/Deserialization  ###########################
+//##############################################################################
+
+/*!
+  Saves as XML.
+ */
+void ColumnarBinaryFilter::save(QXmlStreamWriter* writer) const {
+	writer->writeStartElement("columnarBinaryFilter");
+	writer->writeAttribute("compression", QString::number(d->compressionEnabled));
+	writer->writeAttribute("startRow", QString::number(d->startRow));
+	writer->writeAttribute("endRow", QString::number(d->endRow));
+	writer->writeAttribute("startColumn", QString::number(d->startColumn));
+	writer->writeAttribute("endColumn", QString::number(d->endColumn));
+	writer->writeEndElement();
+}
+
+/*!
+  Loads from XML.
+*/
+bool ColumnarBinaryFilter::load(XmlStreamReader* reader) {
+	if (!reader->isStartElement() || reader->name() != "columnarBinaryFilter") {
+		reader->raiseError(i18n("no columnar binary filter element found"));
+		return false;
+	}
+
+	QString attributeWarning = i18n("Attribute '%1' missing or empty, default value is used");
+	QXmlStreamAttributes attribs = reader->attributes();
+
+	QString str = attribs.value("compression").toString();
+	if (str.isEmpty())
+		reader->raiseWarning(attributeWarning.arg("'compression'"));
+	else
+		d->compressionEnabled = str.toInt();
+
+	str = attribs.value("startRow").toString();
+	if (str.isEmpty())
+		reader->raiseWarning(attributeWarning.arg("'startRow'"));
+	else
+		d->startRow = str.toInt();
+
+	str = attribs.value("endRow").toString();
+	if (str.isEmpty())
+		reader->raiseWarning(attributeWarning.arg("'endRow'"));
+	else
+		d->endRow = str.toInt();
+
+	str = attribs.value("startColumn").toString();
+	if (str.isEmpty())
+		reader->raiseWarning(attributeWarning.arg("'startColumn'"));
+	else
+		d->startColumn = str.toInt();
+
+	str = attribs.value("endColumn").toString();
+	if (str.isEmpty())
+		reader->raiseWarning(attributeWarning.arg("'endColumn'"));
+	else
+		d->endColumn = str.toInt();
+
+	return true;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+File                 : ColumnarBinaryFilter.h
+Project              : LabPlot
+Description          : I/O-filter for the self-describing columnar binary format
+--------------------------------------------------------------------
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*  This program is free software; you can redistribute it and/or modify   *
+*  it under the terms of the GNU General Public License as published by   *
+*  the Free Software Foundation; either version 2 of the License, or      *
+*  (at your option) any later version.                                    *
+*                                                                         *
+*  This program is distributed in the hope that it will be useful,        *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+*  GNU General Public License for more details.                           *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program; if not, write to the Free Software           *
+*   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+*   Boston, MA  02110-1301  USA                                           *
+*                                                                         *
+***************************************************************************/
+#ifndef COLUMNARBINARYFILTER_H
+#define COLUMNARBINARYFILTER_H
+
+#include <QStringList>
+#include "backend/datasources/filters/AbstractFileFilter.h"
+
+class ColumnarBinaryFilterPrivate;
+class ColumnarBinaryFilter : public AbstractFileFilter {
+	Q_OBJECT
+
+  public:
+	ColumnarBinaryFilter();
+	~ColumnarBinaryFilter();
+
+	static QString fileExtension();
+	static bool isColumnarBinaryFile(const QString& fileName);
+
+	void read(const QString& fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace);
+	void write(const QString& fileName, AbstractDataSource* dataSource);
+	QString errorString() const;
+
+	QList<QStringList> preview(const QString& fileName, int lines);
+	int estimatedRowCount(const QString& fileName);
+
+	void loadFilterSettings(const QString&);
+	void saveFilterSettings(const QString&) const;
+
+	void setCompressionEnabled(const bool);
+	bool isCompressionEnabled() const;
+
+	void setStartRow(const int);
+	int startRow() const;
+	void setEndRow(const int);
+	int endRow() const;
+	void setStartColumn(const int);
+	int startColumn() const;
+	void setEndColumn(const int);
+	int endColumn() const;
+
+	virtual void save(QXmlStreamWriter*) const;
+	virtual bool load(XmlStreamReader*);
+
+  private:
+	ColumnarBinaryFilterPrivate* const d;
+	friend class ColumnarBinaryFilterPrivate;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/***************************************************************************
+File                 : ColumnarBinaryFilterPrivate.h
+Project              : LabPlot
+Description          : Private implementation class for ColumnarBinaryFilter.
+--------------------------------------------------------------------
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef COLUMNARBINARYFILTERPRIVATE_H
+#define COLUMNARBINARYFILTERPRIVATE_H
+
+#include "backend/lib/Interval.h"
+#include <QPair>
+#include <QVector>
+
+class AbstractDataSource;
+class QFile;
+
+class ColumnarBinaryFilterPrivate {
+
+	public:
+		//the schema of one column as stored in the file header
+		struct ColumnSchema {
+			ColumnSchema() : mode(0), plotDesignation(0), width(0), numericFormat('g'), numDigits(6) {}
+
+			QString name;
+			qint32 mode;
+			qint32 plotDesignation;
+			qint32 width;
+			QString comment;
+			char numericFormat;
+			qint32 numDigits;
+			QString dateTimeFormat;
+			QString formula;
+			QStringList formulaVariableNames;
+			QStringList formulaVariableColumnPathes;
+			QList< Interval<int> > maskedIntervals;
+			QList< QPair<Interval<int>, QString> > rowFormulas;
+		};
+
+		//the position of one chunk (one column in one block of rows) in the file
+		struct ChunkIndex {
+			ChunkIndex() : offset(0), storedSize(0), rawSize(0), compressed(false) {}
+
+			qint64 offset;
+			qint32 storedSize;
+			qint32 rawSize;
+			bool compressed;
+		};
+
+		//header and footer of a file, everything but the column data
+		struct FileInfo {
+			FileInfo() : version(0), rows(0), blockRows(0) {}
+
+			quint16 version;
+			qint32 rows;
+			qint32 blockRows;
+			QVector<ColumnSchema> columns;
+			QVector<QVector<ChunkIndex> > chunks;	//chunks[block][column]
+		};
+
+		explicit ColumnarBinaryFilterPrivate(ColumnarBinaryFilter*);
+
+		void read(const QString& fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode = AbstractFileFilter::Replace);
+		void write(const QString& fileName, AbstractDataSource* dataSource);
+		QList<QStringList> preview(const QString& fileName, int lines);
+		bool readFileInfo(QFile& file, FileInfo& info) const;
+
+		const ColumnarBinaryFilter* q;
+
+		bool compressionEnabled;
+		int startRow;
+		int endRow;
+		int startColumn;
+		int endColumn;
+		QString errorString;	//error of the last write()
+};
+
+#endif
@@ -299,16 +299,31 @@ QStringList HDFFilterPrivate::readHDFData1D(hid_t dataset, hid_t type, int rows,
 	DEBUG("readHDFData1D() rows =" << rows << "lines =" << lines);
 	QStringList dataString;
 
-	// we read all rows of data
-	T* data = (T*) malloc(rows*sizeof(T));
+	// we only read the selected rows of data (the first lines for the preview)
+	const int firstRow = startRow-1;
+	const int count = qMin(qMin(endRow, rows), lines+startRow-1) - firstRow;
+	if (count <= 0)
+		return dataString;
+	T* data = (T*) malloc(count*sizeof(T));
 
-	status = H5Dread(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+	hid_t dataspace = H5Dget_space(dataset);
+	handleError((int)dataspace, "H5Dget_space");
+	hsize_t offset[1] = {(hsize_t)firstRow}, counts[1] = {(hsize_t)count};
+	status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, NULL, counts, NULL);
+	handleError(status, "H5Sselect_hyperslab");
+	hid_t memspace = H5Screate_simple(1, counts, NULL);
+	handleError((int)memspace, "H5Screate_simple");
+
+	status = H5Dread(dataset, type, memspace, dataspace, H5P_DEFAULT, data);
 	handleError(status, "H5Dread");
+	H5Sclose(memspace);
+	H5Sclose(dataspace);
+
 	DEBUG(" startRow =" << startRow << "endRow =" << endRow);
 	DEBUG("dataPointer =" << dataPointer);
-	for (int i = startRow-1; i < qMin(endRow, lines+startRow-1); i++) {
+	for (int i = 0; i < count; i++) {
 		if (dataPointer != NULL)	// read to data source
-			dataPointer->operator[](i-startRow+1) = data[i];
+			dataPointer->operator[](i) = data[i];
 		else				// for preview
 			dataString << QString::number(static_cast<double>(data[i]));
 	}
@@ -435,15 +450,29 @@ QList<QStringList> HDFFilterPrivate::readHDFData2D(hid_t dataset, hid_t type, in
 	DEBUG("readHDFData2D() rows =" << rows << "cols =" << cols << "lines =" << lines);
 	QList<QStringList> dataStrings;
 
-	T** data = (T**) malloc(rows*sizeof(T*));
-	data[0] = (T*) malloc(cols*rows*sizeof(T));
-	for (int i = 1; i < rows; i++)
+	// we only read the required rows of data (the first lines for the preview)
+	const int count = qMin(rows, lines);
+	if (count <= 0)
+		return dataStrings;
+	T** data = (T**) malloc(count*sizeof(T*));
+	data[0] = (T*) malloc(cols*count*sizeof(T));
+	for (int i = 1; i < count; i++)
 		data[i] = data[0]+i*cols;
 
-	status = H5Dread(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, &data[0][0]);
+	hid_t dataspace = H5Dget_space(dataset);
+	handleError((int)dataspace, "H5Dget_space");
+	hsize_t offset[2] = {0, 0}, counts[2] = {(hsize_t)count, (hsize_t)cols};
+	status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, NULL, counts, NULL);
+	handleError(status, "H5Sselect_hyperslab");
+	hid_t memspace = H5Screate_simple(2, counts, NULL);
+	handleError((int)memspace, "H5Screate_simple");
+
+	status = H5Dread(dataset, type, memspace, dataspace, H5P_DEFAULT, &data[0][0]);
 	handleError(status,"H5Dread");
+	H5Sclose(memspace);
+	H5Sclose(dataspace);
 
-	for (int i = 0; i < qMin(rows, lines); i++) {
+	for (int i = 0; i < count; i++) {
 		QStringList line;
 		line.reserve(cols);
 		for (int j = 0; j < cols; j++) {
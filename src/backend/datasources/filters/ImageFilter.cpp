@@ -30,11 +30,16 @@ Copyright            : (C) 2015 by Stefan Gerlach (stefan.gerlach@uni.kn)
 #include "backend/core/column/Column.h"
 
 #include <QFile>
+#include <QImage>
 #include <QTextStream>
+#include <QThreadPool>
+#include <QRunnable>
 #include <QDebug>
 #include <KLocale>
 
+#include <cctype>
 #include <cmath>
+#include <cstring>
 
  /*!
 	\class ImageFilter
@@ -135,48 +140,262 @@ ImageFilterPrivate::ImageFilterPrivate(ImageFilter* owner) :
 	q(owner),importFormat(ImageFilter::MATRIX),startRow(1),endRow(-1),startColumn(1),endColumn(-1) {
 }
 
+namespace {
+//number of image rows converted in one task
+const int importBlockRows = 256;
+
+//the pixels of an image: either a QImage or the big-endian samples of a 16-bit grayscale image
+struct ImagePixels {
+	ImagePixels() : width(0), height(0), bytesPerLine(0) {}
+
+	QImage image;
+	QByteArray samples16;
+	int width;
+	int height;
+	int bytesPerLine;
+
+	//gray and color values of the entries of the color table of an indexed image
+	QVector<double> grayTable;
+	QVector<double> redTable;
+	QVector<double> greenTable;
+	QVector<double> blueTable;
+};
+
+/*!
+  reads the binary PGM-image (P5) \c fileName with more than 8 bits per sample.
+  QImage reduces all images to 8 bits per channel, the 16-bit samples are kept here.
+  Returns \c false if the file is not such an image.
+*/
+bool readGrayscale16(const QString& fileName, ImagePixels& pixels) {
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly) || file.read(2) != "P5")
+		return false;
+
+	//header: width, height and maximal value, separated by whitespace, comments start with '#'
+	int values[3];
+	char c;
+	for (int i = 0; i < 3; ++i) {
+		QByteArray number;
+		while (file.getChar(&c)) {
+			if (c == '#') {
+				while (file.getChar(&c) && c != '\n')
+					;
+			} else if (isspace((unsigned char)c)) {
+				if (!number.isEmpty())
+					break;
+			} else if (isdigit((unsigned char)c))
+				number += c;
+			else
+				return false;
+		}
+		bool ok;
+		values[i] = number.toInt(&ok);
+		if (!ok || values[i] <= 0)
+			return false;
+	}
+
+	//images with 8 bits per sample are read with QImage
+	if (values[2] < 256 || values[2] > 65535)
+		return false;
+
+	pixels.width = values[0];
+	pixels.height = values[1];
+	pixels.bytesPerLine = 2*pixels.width;
+	pixels.samples16 = file.read((qint64)pixels.bytesPerLine*pixels.height);
+	return (pixels.samples16.size() == pixels.bytesPerLine*pixels.height);
+}
+
+/*!
+  converts the pixels \c firstColumn to \c lastColumn (exclusive) of the image row \c row
+  to gray values and, if \c red is not null, to RGB values.
+*/
+void readLine(const ImagePixels& pixels, int row, int firstColumn, int lastColumn,
+			  double* gray, double* red, double* green, double* blue) {
+	const int count = lastColumn - firstColumn;
+	if (!pixels.samples16.isEmpty()) {
+		const uchar* line = reinterpret_cast<const uchar*>(pixels.samples16.constData()) + row*pixels.bytesPerLine + 2*firstColumn;
+		for (int k = 0; k < count; ++k, line += 2)
+			gray[k] = (line[0] << 8) | line[1];
+		if (red) {
+			memcpy(red, gray, count*sizeof(double));
+			memcpy(green, gray, count*sizeof(double));
+			memcpy(blue, gray, count*sizeof(double));
+		}
+		return;
+	}
+
+	if (pixels.image.format() == QImage::Format_Indexed8) {
+		const uchar* line = pixels.image.constScanLine(row) + firstColumn;
+		for (int k = 0; k < count; ++k)
+			gray[k] = pixels.grayTable.at(line[k]);
+		if (red) {
+			for (int k = 0; k < count; ++k) {
+				red[k] = pixels.redTable.at(line[k]);
+				green[k] = pixels.greenTable.at(line[k]);
+				blue[k] = pixels.blueTable.at(line[k]);
+			}
+		}
+		return;
+	}
+
+	//32-bit formats, all other formats were converted before
+	const QRgb* line = reinterpret_cast<const QRgb*>(pixels.image.constScanLine(row)) + firstColumn;
+	for (int k = 0; k < count; ++k)
+		gray[k] = qGray(line[k]);
+	if (red) {
+		for (int k = 0; k < count; ++k) {
+			red[k] = qRed(line[k]);
+			green[k] = qGreen(line[k]);
+			blue[k] = qBlue(line[k]);
+		}
+	}
+}
+
+/*!
+  converts the image rows \c firstRow to \c lastRow (exclusive) and writes the values
+  directly into the data vectors \c columns of the data source.
+  \c top and \c left are the first row and column of the image to be imported.
+*/
+class ImageReadTask : public QRunnable {
+	public:
+		ImageReadTask(const ImagePixels& pixels, ImageFilter::ImportFormat format, int top, int left, int right,
+					  int firstRow, int lastRow, const QVector<double*>& columns, QAtomicInt& finishedRows) :
+			m_pixels(pixels), m_format(format), m_top(top), m_left(left), m_right(right),
+			m_firstRow(firstRow), m_lastRow(lastRow), m_columns(columns), m_finishedRows(finishedRows) {
+		}
+
+		void run() {
+			const int width = m_right - m_left;
+			const bool rgb = (m_format == ImageFilter::XYRGB);
+			QVector<double> gray(width), red(rgb ? width : 0), green(rgb ? width : 0), blue(rgb ? width : 0);
+
+			for (int row = m_firstRow; row < m_lastRow; ++row) {
+				readLine(m_pixels, row, m_left, m_right, gray.data(),
+						 rgb ? red.data() : 0, rgb ? green.data() : 0, rgb ? blue.data() : 0);
+
+				const int i = row - m_top;
+				switch (m_format) {
+				case ImageFilter::MATRIX:
+					for (int j = 0; j < width; ++j)
+						m_columns[j][i] = gray[j];
+					break;
+				case ImageFilter::XYZ: {
+					double* x = m_columns[0] + i*width;
+					double* y = m_columns[1] + i*width;
+					double* z = m_columns[2] + i*width;
+					for (int j = 0; j < width; ++j) {
+						x[j] = row + 1;
+						y[j] = m_left + j + 1;
+						z[j] = gray[j];
+					}
+					break;
+				}
+				case ImageFilter::XYRGB: {
+					const int offset = i*width;
+					for (int j = 0; j < width; ++j) {
+						m_columns[0][offset + j] = row + 1;
+						m_columns[1][offset + j] = m_left + j + 1;
+					}
+					memcpy(m_columns[2] + offset, red.constData(), width*sizeof(double));
+					memcpy(m_columns[3] + offset, green.constData(), width*sizeof(double));
+					memcpy(m_columns[4] + offset, blue.constData(), width*sizeof(double));
+					break;
+				}
+				}
+			}
+
+			m_finishedRows.fetchAndAddOrdered(m_lastRow - m_firstRow);
+		}
+
+	private:
+		const ImagePixels& m_pixels;
+		const ImageFilter::ImportFormat m_format;
+		const int m_top;
+		const int m_left;
+		const int m_right;
+		const int m_firstRow;
+		const int m_lastRow;
+		const QVector<double*>& m_columns;
+		QAtomicInt& m_finishedRows;
+};
+}
+
 /*!
     reads the content of the file \c fileName to the data source \c dataSource.
     Uses the settings defined in the data source.
+    The image is converted scanline by scanline, blocks of rows are converted in parallel.
+    Binary PGM-images with 16 bits per sample are read without reducing the sample depth.
 */
 void ImageFilterPrivate::read(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode mode) {
-	QImage image = QImage(fileName);
-	if (image.isNull() || image.format() == QImage::Format_Invalid) {
-		qDebug()<<"failed to read image"<<fileName<<"or invalid image format";
-		return;
+	ImagePixels pixels;
+	if (!readGrayscale16(fileName, pixels)) {
+		pixels.samples16.clear();
+		pixels.image = QImage(fileName);
+		if (pixels.image.isNull() || pixels.image.format() == QImage::Format_Invalid) {
+			qDebug()<<"failed to read image"<<fileName<<"or invalid image format";
+			return;
+		}
+
+		//the scanlines are accessed directly for indexed and 32-bit images, convert all other formats once
+		switch (pixels.image.format()) {
+		case QImage::Format_Indexed8: {
+			const QVector<QRgb> colors = pixels.image.colorTable();
+			pixels.grayTable.fill(0, 256);
+			pixels.redTable.fill(0, 256);
+			pixels.greenTable.fill(0, 256);
+			pixels.blueTable.fill(0, 256);
+			for (int i = 0; i < qMin(colors.size(), 256); ++i) {
+				pixels.grayTable[i] = qGray(colors.at(i));
+				pixels.redTable[i] = qRed(colors.at(i));
+				pixels.greenTable[i] = qGreen(colors.at(i));
+				pixels.blueTable[i] = qBlue(colors.at(i));
+			}
+			break;
+		}
+		case QImage::Format_RGB32:
+		case QImage::Format_ARGB32:
+		case QImage::Format_ARGB32_Premultiplied:
+			break;
+		default:
+			pixels.image = pixels.image.convertToFormat(QImage::Format_ARGB32);
+		}
+
+		pixels.width = pixels.image.width();
+		pixels.height = pixels.image.height();
 	}
 
-	int cols = image.width();
-	int rows = image.height();
+	// set range of rows and columns
+	const int top = qMax(startRow, 1) - 1;
+	const int bottom = (endRow == -1 || endRow > pixels.height) ? pixels.height : endRow;
+	const int left = qMax(startColumn, 1) - 1;
+	const int right = (endColumn == -1 || endColumn > pixels.width) ? pixels.width : endColumn;
+	if (top >= bottom || left >= right) {
+		qDebug()<<"data selection empty";
+		return;
+	}
 
-	// set range of rows
-	if (endColumn == -1)
-		endColumn = cols;
-	if (endRow == -1)
-		endRow = rows;
 	int actualCols=0, actualRows=0;
-
 	switch (importFormat) {
 	case ImageFilter::MATRIX: {
-		actualCols = endColumn-startColumn+1;
-		actualRows = endRow-startRow+1;
+		actualCols = right-left;
+		actualRows = bottom-top;
 		break;
 	}
 	case ImageFilter::XYZ: {
 		actualCols = 3;
-		actualRows = (endColumn-startColumn+1)*(endRow-startRow+1);
+		actualRows = (right-left)*(bottom-top);
 		break;
 	}
 	case ImageFilter::XYRGB: {
 		actualCols = 5;
-		actualRows = (endColumn-startColumn+1)*(endRow-startRow+1);
+		actualRows = (right-left)*(bottom-top);
 		break;
 	}
 	}
 
 #ifdef QT_DEBUG
-	qDebug()<<"image format ="<<image.format();
-	qDebug()<<"image w/h ="<<cols<<rows;
+	qDebug()<<"image format ="<<pixels.image.format()<<"16-bit ="<<!pixels.samples16.isEmpty();
+	qDebug()<<"image w/h ="<<pixels.width<<pixels.height;
 	qDebug()<<"actual rows/cols ="<<actualRows<<actualCols;
 #endif
 
@@ -190,53 +409,22 @@ void ImageFilterPrivate::read(const QString & fileName, AbstractDataSource* data
 		return;
 	}
 
-	// read data
-	switch (importFormat) {
-	case ImageFilter::MATRIX: {
-		for (int i=0; i<actualRows; i++) {
-			for ( int j=0; j<actualCols; j++ ) {
-				double value=qGray(image.pixel(j+startColumn-1,i+startRow-1));
-				dataPointers[j]->operator[](i) = value;
-			}
-			emit q->completed(100*i/actualRows);
-		}
-		break;
-	}
-	case ImageFilter::XYZ: {
-		int currentRow=0;
-		for (int i=startRow-1; i<endRow; i++) {
-			for ( int j=startColumn-1; j<endColumn; j++ ) {
-				QRgb color=image.pixel(j, i);
-				dataPointers[0]->operator[](currentRow) = i+1;
-				dataPointers[1]->operator[](currentRow) = j+1;
-				dataPointers[2]->operator[](currentRow) = qGray(color);
-				currentRow++;
-			}
-			emit q->completed(100*i/actualRows);
-		}
-		break;
-	}
-	case ImageFilter::XYRGB: {
-		int currentRow=0;
-		for (int i=startRow-1; i<endRow; i++) {
-			for ( int j=startColumn-1; j<endColumn; j++ ) {
-				QRgb color=image.pixel(j, i);
-				dataPointers[0]->operator[](currentRow) = i+1;
-				dataPointers[1]->operator[](currentRow) = j+1;
-				dataPointers[2]->operator[](currentRow) = qRed(color);
-				dataPointers[3]->operator[](currentRow) = qGreen(color);
-				dataPointers[4]->operator[](currentRow) = qBlue(color);
-				currentRow++;
-			}
-			emit q->completed(100*i/actualRows);
-		}
-		break;
-	}
-	}
+	// read data: the tasks write directly into the column vectors (matrix columns or spreadsheet columns)
+	QVector<double*> columns(actualCols);
+	for (int n = 0; n < actualCols; ++n)
+		columns[n] = dataPointers[n]->data();
+
+	QAtomicInt finishedRows(0);
+	QThreadPool pool;
+	for (int row = top; row < bottom; row += importBlockRows)
+		pool.start(new ImageReadTask(pixels, importFormat, top, left, right, row, qMin(row + importBlockRows, bottom), columns, finishedRows));
+	while (!pool.waitForDone(100))
+		emit q->completed(100*finishedRows/(bottom - top));
+	emit q->completed(100);
 
 	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
 	if (spreadsheet) {
-		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", rows);
+		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", actualRows);
 		for ( int n=0; n<actualCols; n++ ) {
 			Column* column = spreadsheet->column(columnOffset+n);
 			column->setComment(comment);
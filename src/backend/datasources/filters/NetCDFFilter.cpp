@@ -70,6 +70,14 @@ QList <QStringList> NetCDFFilter::readCurrentVar(const QString & fileName, Abstr
 	return d->readCurrentVar(fileName, dataSource, importMode, lines);
 }
 
+/*!
+  returns the first \c lines rows of the current variable in the file \c fileName.
+  Only these rows are read from the file.
+*/
+QList<QStringList> NetCDFFilter::preview(const QString& fileName, int lines) {
+	return d->readCurrentVar(fileName, NULL, AbstractFileFilter::Replace, lines);
+}
+
 /*!
   reads the content of the file \c fileName to the data source \c dataSource.
 */
@@ -547,18 +555,19 @@ QList<QStringList> NetCDFFilterPrivate::readCurrentVar(const QString & fileName,
 			if (dataSource != NULL)
 				columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols);
 
+			// for the preview only the first lines are read
+			size_t start = startRow-1, count = dataSource ? actualRows : qMin(actualRows, lines);
 			double* data = 0;
 			if (dataSource)
 				data = dataPointers[0]->data();
 			else
-				data = (double *)malloc(actualRows * sizeof(double));
+				data = (double *)malloc(count * sizeof(double));
 
-			size_t start = startRow-1, count = actualRows;
 			status = nc_get_vara_double(ncid, varid, &start, &count, data);
 			handleError(status, "nc_get_vara_double");
 
 			if (!dataSource) {
-				for (int i = 0; i < qMin(actualRows, lines); i++)
+				for (size_t i = 0; i < count; i++)
 					dataStrings << (QStringList() << QString::number(data[i]));
 				free(data);
 			}
@@ -589,13 +598,16 @@ QList<QStringList> NetCDFFilterPrivate::readCurrentVar(const QString & fileName,
 			if (dataSource != NULL)
 				columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols);
 
-			double** data = (double**) malloc(rows * sizeof(double*));
-			data[0] = (double*)malloc( cols * rows * sizeof(double) );
-			for (unsigned int i = 1; i < rows; i++) data[i] = data[0] + i*cols;
+			// only read the required rows (the first lines for the preview)
+			const int readRows = qMin((int)rows, lines);
+			double** data = (double**) malloc(readRows * sizeof(double*));
+			data[0] = (double*)malloc( cols * readRows * sizeof(double) );
+			for (int i = 1; i < readRows; i++) data[i] = data[0] + i*cols;
 
-			status = nc_get_var_double(ncid, varid, &data[0][0]);
-			handleError(status, "nc_get_var_double");
-			for (int i = 0; i < qMin((int)rows, lines); i++) {
+			size_t start[2] = {0, 0}, count[2] = {(size_t)readRows, cols};
+			status = nc_get_vara_double(ncid, varid, start, count, &data[0][0]);
+			handleError(status, "nc_get_vara_double");
+			for (int i = 0; i < readRows; i++) {
 				QStringList line;
 				for (unsigned int j = 0; j < cols; j++) {
 					if (!dataPointers.isEmpty())
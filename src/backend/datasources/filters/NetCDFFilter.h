@@ -45,6 +45,7 @@ class NetCDFFilter : public AbstractFileFilter{
 	QString readAttribute(const QString & fileName, const QString & name, const QString & varName);
 	QList<QStringList> readCurrentVar(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace, int lines=-1);
 	void write(const QString & fileName, AbstractDataSource* dataSource);
+	QList<QStringList> preview(const QString& fileName, int lines);
 
 	void loadFilterSettings(const QString&);
 	void saveFilterSettings(const QString&) const;
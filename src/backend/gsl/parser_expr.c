@@ -0,0 +1,942 @@
+/***************************************************************************
+    File                 : parser_expr.c
+    Project              : LabPlot
+    Description          : Compiled mathematical expressions with symbolic derivatives
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <ctype.h>
+#include <locale.h>
+#include <gsl/gsl_math.h>
+#include "parser.h"
+#include "parser_expr.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* number of points evaluated together by one pass over the program */
+#define PARSER_EXPR_BLOCK 256
+/* maximum number of function arguments (as in parse()) */
+#define PARSER_EXPR_MAX_ARGS 4
+
+typedef enum {expr_num, expr_var, expr_neg, expr_add, expr_sub, expr_mul, expr_div, expr_pow,
+	expr_func, expr_func_diff, expr_pow_const} expr_type;
+
+/* node of the expression tree.
+	expr_func_diff is the numerical derivative of function fnct with respect to argument var */
+typedef struct expr_node {
+	expr_type type;
+	double value;
+	int var;
+	const char* name;
+	func_t fnct;
+	int nargs;
+	struct expr_node* arg[PARSER_EXPR_MAX_ARGS];
+} expr_node;
+
+/* instruction of the stack program (postfix order of the tree) */
+typedef struct {
+	expr_type type;
+	double value;
+	int var;
+	func_t fnct;
+	int nargs;
+} expr_instr;
+
+struct parser_expr {
+	expr_node* root;
+	int nvars;
+	expr_instr* code;
+	size_t ncode;
+	int depth;	/* maximum stack size */
+};
+
+/******************** expression tree ********************/
+
+static void expr_node_free(expr_node* n) {
+	int i;
+	if (!n)
+		return;
+	for (i = 0; i < n->nargs; i++)
+		expr_node_free(n->arg[i]);
+	free(n);
+}
+
+static expr_node* expr_node_new(expr_type type, int nargs) {
+	expr_node* n = (expr_node*)calloc(1, sizeof(expr_node));
+	if (n) {
+		n->type = type;
+		n->nargs = nargs;
+	}
+	return n;
+}
+
+static expr_node* expr_node_copy(const expr_node* n) {
+	int i;
+	expr_node* c;
+	if (!n)
+		return 0;
+	c = (expr_node*)malloc(sizeof(expr_node));
+	if (!c)
+		return 0;
+	*c = *n;
+	for (i = 0; i < n->nargs; i++) {
+		c->arg[i] = expr_node_copy(n->arg[i]);
+		if (!c->arg[i]) {
+			c->nargs = i;
+			expr_node_free(c);
+			return 0;
+		}
+	}
+	return c;
+}
+
+static int expr_node_depends(const expr_node* n, int var) {
+	int i;
+	if (n->type == expr_var)
+		return n->var == var;
+	for (i = 0; i < n->nargs; i++)
+		if (expr_node_depends(n->arg[i], var))
+			return 1;
+	return 0;
+}
+
+static int expr_is_num(const expr_node* n, double value) {
+	return n->type == expr_num && n->value == value;
+}
+
+static expr_node* expr_num_new(double value) {
+	expr_node* n = expr_node_new(expr_num, 0);
+	if (n)
+		n->value = value;
+	return n;
+}
+
+/* The constructors take the ownership of their arguments and free them on errors.
+	Constant subexpressions are folded and trivial operations (+0, *1, ...) removed. */
+
+static expr_node* expr_neg_new(expr_node* a) {
+	expr_node* n;
+	if (!a)
+		return 0;
+	if (a->type == expr_num) {
+		a->value = -a->value;
+		return a;
+	}
+	if (a->type == expr_neg) {
+		n = a->arg[0];
+		free(a);
+		return n;
+	}
+	n = expr_node_new(expr_neg, 1);
+	if (!n) {
+		expr_node_free(a);
+		return 0;
+	}
+	n->arg[0] = a;
+	return n;
+}
+
+static expr_node* expr_binary_new(expr_type type, expr_node* a, expr_node* b) {
+	expr_node* n;
+	if (!a || !b) {
+		expr_node_free(a);
+		expr_node_free(b);
+		return 0;
+	}
+	if (a->type == expr_num && b->type == expr_num) {
+		switch (type) {
+		case expr_add:
+			a->value += b->value;
+			break;
+		case expr_sub:
+			a->value -= b->value;
+			break;
+		case expr_mul:
+			a->value *= b->value;
+			break;
+		case expr_div:
+			a->value /= b->value;
+			break;
+		case expr_pow:
+			a->value = pow(a->value, b->value);
+			break;
+		case expr_num:
+		case expr_var:
+		case expr_neg:
+		case expr_func:
+		case expr_func_diff:
+		case expr_pow_const:
+			break;
+		}
+		free(b);
+		return a;
+	}
+	n = expr_node_new(type, 2);
+	if (!n) {
+		expr_node_free(a);
+		expr_node_free(b);
+		return 0;
+	}
+	n->arg[0] = a;
+	n->arg[1] = b;
+	return n;
+}
+
+/* the simplifications are only used for derivatives, parsed expressions are kept as they are written */
+static expr_node* expr_add_new(expr_node* a, expr_node* b) {
+	if (a && expr_is_num(a, 0.)) {
+		free(a);
+		return b;
+	}
+	if (b && expr_is_num(b, 0.)) {
+		free(b);
+		return a;
+	}
+	return expr_binary_new(expr_add, a, b);
+}
+
+static expr_node* expr_sub_new(expr_node* a, expr_node* b) {
+	if (b && expr_is_num(b, 0.)) {
+		free(b);
+		return a;
+	}
+	if (a && expr_is_num(a, 0.)) {
+		free(a);
+		return expr_neg_new(b);
+	}
+	return expr_binary_new(expr_sub, a, b);
+}
+
+static expr_node* expr_mul_new(expr_node* a, expr_node* b) {
+	if (a && b && (expr_is_num(a, 0.) || expr_is_num(b, 0.))) {
+		expr_node_free(a);
+		expr_node_free(b);
+		return expr_num_new(0.);
+	}
+	if (a && expr_is_num(a, 1.)) {
+		free(a);
+		return b;
+	}
+	if (b && expr_is_num(b, 1.)) {
+		free(b);
+		return a;
+	}
+	if (a && expr_is_num(a, -1.)) {
+		free(a);
+		return expr_neg_new(b);
+	}
+	return expr_binary_new(expr_mul, a, b);
+}
+
+static expr_node* expr_div_new(expr_node* a, expr_node* b) {
+	if (a && b && expr_is_num(a, 0.)) {
+		expr_node_free(a);
+		expr_node_free(b);
+		return expr_num_new(0.);
+	}
+	if (b && expr_is_num(b, 1.)) {
+		free(b);
+		return a;
+	}
+	return expr_binary_new(expr_div, a, b);
+}
+
+static expr_node* expr_pow_new(expr_node* a, expr_node* b) {
+	if (a && b && expr_is_num(b, 1.)) {
+		free(b);
+		return a;
+	}
+	if (a && b && expr_is_num(b, 0.)) {
+		expr_node_free(a);
+		b->value = 1.;
+		return b;
+	}
+	return expr_binary_new(expr_pow, a, b);
+}
+
+static expr_node* expr_call_new(const char* name, func_t fnct, expr_node* a) {
+	expr_node* n;
+	if (!a)
+		return 0;
+	n = expr_node_new(expr_func, 1);
+	if (!n) {
+		expr_node_free(a);
+		return 0;
+	}
+	n->name = name;
+	n->fnct = fnct;
+	n->arg[0] = a;
+	return n;
+}
+
+/******************** parser ********************/
+
+/* recursive descent parser with the precedences of parser.y:
+	sum:     product (('+'|'-') product)*
+	product: unary (('*'|'/'|'**') unary)*	("**" is pow() with the precedence of '*' as in parse())
+	unary:   '-' unary | power
+	power:   primary ('^' unary)?		(right associative, binds stronger than the unary minus)
+	primary: NUM | VAR | CONSTANT | FNCT '(' [sum (',' sum)*] ')' | '(' sum ')'
+ */
+typedef struct {
+	const char* str;
+	size_t pos;
+	const char* const* names;
+	int nvars;
+} expr_parser;
+
+static expr_node* expr_parse_sum(expr_parser* p);
+static expr_node* expr_parse_unary(expr_parser* p);
+
+static char expr_peek(expr_parser* p) {
+	while (p->str[p->pos] == ' ' || p->str[p->pos] == '\t')
+		p->pos++;
+	return p->str[p->pos];
+}
+
+/* the symbol tables are searched from the end, later entries hide earlier ones like in the symbol table of parse() */
+static const struct con* expr_find_constant(const char* name) {
+	const struct con* result = 0;
+	int i;
+	for (i = 0; _constants[i].name != 0; i++)
+		if (strcmp(_constants[i].name, name) == 0)
+			result = &_constants[i];
+	return result;
+}
+
+static const struct func* expr_find_function(const char* name) {
+	const struct func* result = 0;
+	int i;
+	for (i = 0; _functions[i].name != 0; i++)
+		if (strcmp(_functions[i].name, name) == 0)
+			result = &_functions[i];
+	return result;
+}
+
+static expr_node* expr_parse_number(expr_parser* p) {
+	const char* s = p->str + p->pos;
+	char* remain;
+#if defined(_WIN32) || defined(__APPLE__)
+	double value = strtod(s, &remain);
+#else
+	/* use same locale for all languages: '.' as decimal point */
+	locale_t locale = newlocale(LC_NUMERIC_MASK, "C", NULL);
+	double value = strtod_l(s, &remain, locale);
+	freelocale(locale);
+#endif
+	if (remain == s)
+		return 0;
+	p->pos += remain - s;
+	return expr_num_new(value);
+}
+
+static expr_node* expr_parse_function(expr_parser* p, const struct func* f) {
+	expr_node* n = expr_node_new(expr_func, 0);
+	if (!n)
+		return 0;
+	n->name = f->name;
+	n->fnct = f->fnct;
+
+	p->pos++;	/* '(' */
+	while (expr_peek(p) != ')') {
+		if (n->nargs == PARSER_EXPR_MAX_ARGS || (n->nargs > 0 && expr_peek(p) != ',')) {
+			expr_node_free(n);
+			return 0;
+		}
+		if (n->nargs > 0)
+			p->pos++;	/* ',' */
+		n->arg[n->nargs] = expr_parse_sum(p);
+		if (!n->arg[n->nargs]) {
+			expr_node_free(n);
+			return 0;
+		}
+		n->nargs++;
+	}
+	if (expr_peek(p) != ')') {
+		expr_node_free(n);
+		return 0;
+	}
+	p->pos++;
+
+	/* pow(a, b) is the same as a^b */
+	if (n->nargs == 2 && f->fnct == (func_t)pow) {
+		expr_node* a = n->arg[0], *b = n->arg[1];
+		free(n);
+		return expr_binary_new(expr_pow, a, b);
+	}
+
+	return n;
+}
+
+static expr_node* expr_parse_primary(expr_parser* p) {
+	char c = expr_peek(p);
+
+	if (c == '(') {
+		expr_node* n;
+		p->pos++;
+		n = expr_parse_sum(p);
+		if (!n || expr_peek(p) != ')') {
+			expr_node_free(n);
+			return 0;
+		}
+		p->pos++;
+		return n;
+	}
+
+	if (isdigit((unsigned char)c))
+		return expr_parse_number(p);
+
+	if (isalpha((unsigned char)c) || c == '.') {
+		const struct con* constant;
+		const struct func* f;
+		char* name;
+		size_t start = p->pos, length;
+		int i;
+
+		do
+			p->pos++;
+		while (isalnum((unsigned char)p->str[p->pos]) || p->str[p->pos] == '_' || p->str[p->pos] == '.');
+		length = p->pos - start;
+		name = (char*)malloc(length + 1);
+		if (!name)
+			return 0;
+		memcpy(name, p->str + start, length);
+		name[length] = '\0';
+
+		/* variables hide constants, constants hide functions */
+		for (i = p->nvars - 1; i >= 0; i--) {
+			if (strcmp(p->names[i], name) == 0) {
+				expr_node* n = expr_node_new(expr_var, 0);
+				if (n)
+					n->var = i;
+				free(name);
+				return n;
+			}
+		}
+		constant = expr_find_constant(name);
+		f = constant ? 0 : expr_find_function(name);
+		free(name);
+
+		if (constant)
+			return expr_num_new(constant->value);
+		if (f && expr_peek(p) == '(')
+			return expr_parse_function(p, f);
+		return 0;
+	}
+
+	return 0;
+}
+
+static expr_node* expr_parse_power(expr_parser* p) {
+	expr_node* n = expr_parse_primary(p);
+	if (n && expr_peek(p) == '^') {
+		p->pos++;
+		return expr_binary_new(expr_pow, n, expr_parse_unary(p));
+	}
+	return n;
+}
+
+static expr_node* expr_parse_unary(expr_parser* p) {
+	if (expr_peek(p) == '-') {
+		p->pos++;
+		return expr_neg_new(expr_parse_unary(p));
+	}
+	return expr_parse_power(p);
+}
+
+static expr_node* expr_parse_product(expr_parser* p) {
+	expr_node* n = expr_parse_unary(p);
+	while (n) {
+		expr_type type;
+		char c = expr_peek(p);
+		if (c == '*') {
+			p->pos++;
+			if (expr_peek(p) == '*') {
+				p->pos++;
+				type = expr_pow;
+			} else
+				type = expr_mul;
+		} else if (c == '/') {
+			p->pos++;
+			type = expr_div;
+		} else
+			break;
+		n = expr_binary_new(type, n, expr_parse_unary(p));
+	}
+	return n;
+}
+
+static expr_node* expr_parse_sum(expr_parser* p) {
+	expr_node* n = expr_parse_product(p);
+	while (n) {
+		char c = expr_peek(p);
+		if (c != '+' && c != '-')
+			break;
+		p->pos++;
+		n = expr_binary_new(c == '+' ? expr_add : expr_sub, n, expr_parse_product(p));
+	}
+	return n;
+}
+
+/******************** derivatives ********************/
+
+static double expr_sgn(double x) {
+	if (x > 0)
+		return 1.;
+	if (x < 0)
+		return -1.;
+	return 0.;
+}
+
+#define EXPR_CALL(name, a) expr_call_new(#name, (func_t)name, a)
+
+/* derivative of the one argument function n with respect to its argument or 0 if not known */
+static expr_node* expr_func_derivative(const expr_node* n, int* known) {
+	const char* name = n->name;
+	expr_node* a = n->arg[0];
+
+	*known = 1;
+	if (strcmp(name, "exp") == 0 || strcmp(name, "expm1") == 0)
+		return EXPR_CALL(exp, expr_node_copy(a));
+	if (strcmp(name, "log") == 0 || strcmp(name, "ln") == 0)
+		return expr_div_new(expr_num_new(1.), expr_node_copy(a));
+	if (strcmp(name, "log1p") == 0)
+		return expr_div_new(expr_num_new(1.), expr_add_new(expr_num_new(1.), expr_node_copy(a)));
+	if (strcmp(name, "log10") == 0)
+		return expr_div_new(expr_num_new(1./M_LN10), expr_node_copy(a));
+	if (strcmp(name, "sqrt") == 0)
+		return expr_div_new(expr_num_new(0.5), EXPR_CALL(sqrt, expr_node_copy(a)));
+	if (strcmp(name, "cbrt") == 0)
+		return expr_div_new(expr_num_new(1./3.), expr_pow_new(EXPR_CALL(cbrt, expr_node_copy(a)), expr_num_new(2.)));
+	if (strcmp(name, "sin") == 0)
+		return EXPR_CALL(cos, expr_node_copy(a));
+	if (strcmp(name, "cos") == 0)
+		return expr_neg_new(EXPR_CALL(sin, expr_node_copy(a)));
+	if (strcmp(name, "tan") == 0)
+		return expr_add_new(expr_num_new(1.), expr_pow_new(EXPR_CALL(tan, expr_node_copy(a)), expr_num_new(2.)));
+	if (strcmp(name, "asin") == 0 || strcmp(name, "acos") == 0) {
+		expr_node* d = expr_div_new(expr_num_new(1.),
+			EXPR_CALL(sqrt, expr_sub_new(expr_num_new(1.), expr_pow_new(expr_node_copy(a), expr_num_new(2.)))));
+		return name[1] == 'c' ? expr_neg_new(d) : d;
+	}
+	if (strcmp(name, "atan") == 0)
+		return expr_div_new(expr_num_new(1.), expr_add_new(expr_num_new(1.), expr_pow_new(expr_node_copy(a), expr_num_new(2.))));
+	if (strcmp(name, "sinh") == 0)
+		return EXPR_CALL(cosh, expr_node_copy(a));
+	if (strcmp(name, "cosh") == 0)
+		return EXPR_CALL(sinh, expr_node_copy(a));
+	if (strcmp(name, "tanh") == 0)
+		return expr_sub_new(expr_num_new(1.), expr_pow_new(EXPR_CALL(tanh, expr_node_copy(a)), expr_num_new(2.)));
+	if (strcmp(name, "asinh") == 0)
+		return expr_div_new(expr_num_new(1.), EXPR_CALL(sqrt, expr_add_new(expr_pow_new(expr_node_copy(a), expr_num_new(2.)), expr_num_new(1.))));
+	if (strcmp(name, "acosh") == 0)
+		return expr_div_new(expr_num_new(1.), EXPR_CALL(sqrt, expr_sub_new(expr_pow_new(expr_node_copy(a), expr_num_new(2.)), expr_num_new(1.))));
+	if (strcmp(name, "atanh") == 0)
+		return expr_div_new(expr_num_new(1.), expr_sub_new(expr_num_new(1.), expr_pow_new(expr_node_copy(a), expr_num_new(2.))));
+	if (strcmp(name, "erf") == 0 || strcmp(name, "erfc") == 0) {
+		expr_node* d = expr_mul_new(expr_num_new(M_2_SQRTPI), EXPR_CALL(exp, expr_neg_new(expr_pow_new(expr_node_copy(a), expr_num_new(2.)))));
+		return name[3] == 'c' ? expr_neg_new(d) : d;
+	}
+	if (strcmp(name, "fabs") == 0)
+		return expr_call_new("sgn", (func_t)expr_sgn, expr_node_copy(a));
+	if (strcmp(name, "sgn") == 0)
+		return expr_num_new(0.);
+	if (strncmp(name, "pow", 3) == 0 && name[3] >= '2' && name[3] <= '9' && name[4] == '\0') {
+		double k = name[3] - '0';
+		return expr_mul_new(expr_num_new(k), expr_pow_new(expr_node_copy(a), expr_num_new(k - 1.)));
+	}
+
+	*known = 0;
+	return 0;
+}
+
+static expr_node* expr_derivative(const expr_node* n, int var) {
+	if (!expr_node_depends(n, var))
+		return expr_num_new(0.);
+
+	switch (n->type) {
+	case expr_num:
+		return expr_num_new(0.);
+	case expr_var:
+		return expr_num_new(1.);
+	case expr_neg:
+		return expr_neg_new(expr_derivative(n->arg[0], var));
+	case expr_add:
+		return expr_add_new(expr_derivative(n->arg[0], var), expr_derivative(n->arg[1], var));
+	case expr_sub:
+		return expr_sub_new(expr_derivative(n->arg[0], var), expr_derivative(n->arg[1], var));
+	case expr_mul:	/* a'b + ab' */
+		return expr_add_new(expr_mul_new(expr_derivative(n->arg[0], var), expr_node_copy(n->arg[1])),
+			expr_mul_new(expr_node_copy(n->arg[0]), expr_derivative(n->arg[1], var)));
+	case expr_div:	/* a'/b - ab'/b^2 */
+		if (!expr_node_depends(n->arg[1], var))
+			return expr_div_new(expr_derivative(n->arg[0], var), expr_node_copy(n->arg[1]));
+		return expr_sub_new(expr_div_new(expr_derivative(n->arg[0], var), expr_node_copy(n->arg[1])),
+			expr_div_new(expr_mul_new(expr_node_copy(n->arg[0]), expr_derivative(n->arg[1], var)),
+				expr_pow_new(expr_node_copy(n->arg[1]), expr_num_new(2.))));
+	case expr_pow:
+	case expr_pow_const:
+		if (!expr_node_depends(n->arg[1], var))	/* b a^(b-1) a' */
+			return expr_mul_new(expr_mul_new(expr_node_copy(n->arg[1]),
+				expr_pow_new(expr_node_copy(n->arg[0]), expr_sub_new(expr_node_copy(n->arg[1]), expr_num_new(1.)))),
+				expr_derivative(n->arg[0], var));
+		/* a^b (b' log(a) + b a'/a) */
+		return expr_mul_new(expr_node_copy(n),
+			expr_add_new(expr_mul_new(expr_derivative(n->arg[1], var), EXPR_CALL(log, expr_node_copy(n->arg[0]))),
+				expr_div_new(expr_mul_new(expr_node_copy(n->arg[1]), expr_derivative(n->arg[0], var)), expr_node_copy(n->arg[0]))));
+	case expr_func: {
+		/* chain rule: sum over all arguments of df/da_k * a_k' */
+		expr_node* result = expr_num_new(0.);
+		int k;
+		for (k = 0; k < n->nargs && result; k++) {
+			expr_node* outer = 0;
+			int known = 0;
+			if (!expr_node_depends(n->arg[k], var))
+				continue;
+			if (n->nargs == 1)
+				outer = expr_func_derivative(n, &known);
+			if (!known) {
+				/* numerical derivative with respect to argument k */
+				outer = expr_node_copy(n);
+				if (outer) {
+					outer->type = expr_func_diff;
+					outer->var = k;
+				}
+			}
+			if (!outer) {
+				expr_node_free(result);
+				return 0;
+			}
+			result = expr_add_new(result, expr_mul_new(outer, expr_derivative(n->arg[k], var)));
+		}
+		return result;
+	}
+	case expr_func_diff:
+		/* no higher numerical derivatives */
+		return 0;
+	}
+
+	return 0;
+}
+
+/******************** evaluation ********************/
+
+static double expr_call(func_t f, int nargs, const double a[]) {
+	switch (nargs) {
+	case 0:
+		return f();
+	case 1:
+		return f(a[0]);
+	case 2:
+		return f(a[0], a[1]);
+	case 3:
+		return f(a[0], a[1], a[2]);
+	default:
+		return f(a[0], a[1], a[2], a[3]);
+	}
+}
+
+/* central difference with a step size adapted to the argument */
+static double expr_call_diff(func_t f, int nargs, int k, const double a[]) {
+	double b[PARSER_EXPR_MAX_ARGS];
+	volatile double t;
+	double h = cbrt(DBL_EPSILON) * fmax(fabs(a[k]), 1.), fp, fm;
+
+	/* use an exactly representable step */
+	t = a[k] + h;
+	h = t - a[k];
+
+	memcpy(b, a, nargs * sizeof(double));
+	b[k] = a[k] + h;
+	fp = expr_call(f, nargs, b);
+	b[k] = a[k] - h;
+	fm = expr_call(f, nargs, b);
+
+	return (fp - fm)/(2. * h);
+}
+
+static double expr_node_eval(const expr_node* n, const double vars[]) {
+	double a[PARSER_EXPR_MAX_ARGS];
+	int i;
+
+	switch (n->type) {
+	case expr_num:
+		return n->value;
+	case expr_var:
+		return vars[n->var];
+	case expr_neg:
+		return -expr_node_eval(n->arg[0], vars);
+	case expr_add:
+		return expr_node_eval(n->arg[0], vars) + expr_node_eval(n->arg[1], vars);
+	case expr_sub:
+		return expr_node_eval(n->arg[0], vars) - expr_node_eval(n->arg[1], vars);
+	case expr_mul:
+		return expr_node_eval(n->arg[0], vars) * expr_node_eval(n->arg[1], vars);
+	case expr_div:
+		return expr_node_eval(n->arg[0], vars) / expr_node_eval(n->arg[1], vars);
+	case expr_pow:
+	case expr_pow_const:
+		if (expr_is_num(n->arg[1], 2.)) {	/* as in the stack program */
+			a[0] = expr_node_eval(n->arg[0], vars);
+			return a[0] * a[0];
+		}
+		return pow(expr_node_eval(n->arg[0], vars), expr_node_eval(n->arg[1], vars));
+	case expr_func:
+	case expr_func_diff:
+		for (i = 0; i < n->nargs; i++)
+			a[i] = expr_node_eval(n->arg[i], vars);
+		if (n->type == expr_func)
+			return expr_call(n->fnct, n->nargs, a);
+		return expr_call_diff(n->fnct, n->nargs, n->var, a);
+	}
+
+	return NAN;
+}
+
+/* emit the program for n in postfix order, returns the stack size needed */
+static int expr_emit(parser_expr* e, const expr_node* n, int depth) {
+	expr_instr* instr;
+	int i, max = depth + 1;
+
+	if ((n->type == expr_pow) && n->arg[1]->type == expr_num) {
+		/* a^c with a constant exponent */
+		max = expr_emit(e, n->arg[0], depth);
+		instr = &e->code[e->ncode++];
+		instr->type = expr_pow_const;
+		instr->value = n->arg[1]->value;
+		return max;
+	}
+
+	for (i = 0; i < n->nargs; i++) {
+		int d = expr_emit(e, n->arg[i], depth + i);
+		if (d > max)
+			max = d;
+	}
+
+	instr = &e->code[e->ncode++];
+	instr->type = n->type;
+	instr->value = n->value;
+	instr->var = n->var;
+	instr->fnct = n->fnct;
+	instr->nargs = n->nargs;
+
+	return max;
+}
+
+static size_t expr_node_count(const expr_node* n) {
+	size_t count = 1;
+	int i;
+	for (i = 0; i < n->nargs; i++)
+		count += expr_node_count(n->arg[i]);
+	return count;
+}
+
+static parser_expr* expr_new(expr_node* root, int nvars) {
+	parser_expr* e;
+	if (!root)
+		return 0;
+	e = (parser_expr*)malloc(sizeof(parser_expr));
+	if (e)
+		e->code = (expr_instr*)malloc(expr_node_count(root) * sizeof(expr_instr));
+	if (!e || !e->code) {
+		free(e);
+		expr_node_free(root);
+		return 0;
+	}
+	e->root = root;
+	e->nvars = nvars;
+	e->ncode = 0;
+	e->depth = expr_emit(e, root, 0);
+	return e;
+}
+
+/* run the program for the m points start..start+m-1: variable i is taken from x[i] (from vars[i] if x[i] is 0),
+	the stack holds blocks of PARSER_EXPR_BLOCK values */
+static void expr_eval_block(const parser_expr* e, const double vars[], const double* const x[], size_t start, size_t m, double* stack) {
+	double* top = stack - PARSER_EXPR_BLOCK;
+	const double* a[PARSER_EXPR_MAX_ARGS];
+	double args[PARSER_EXPR_MAX_ARGS];
+	size_t c, i;
+	int k;
+
+	for (c = 0; c < e->ncode; c++) {
+		const expr_instr* instr = &e->code[c];
+		double* next = top + PARSER_EXPR_BLOCK;
+		switch (instr->type) {
+		case expr_num:
+			for (i = 0; i < m; i++)
+				next[i] = instr->value;
+			top = next;
+			break;
+		case expr_var:
+			if (x[instr->var])
+				memcpy(next, x[instr->var] + start, m * sizeof(double));
+			else
+				for (i = 0; i < m; i++)
+					next[i] = vars[instr->var];
+			top = next;
+			break;
+		case expr_neg:
+			for (i = 0; i < m; i++)
+				top[i] = -top[i];
+			break;
+		case expr_add:
+			top -= PARSER_EXPR_BLOCK;
+			for (i = 0; i < m; i++)
+				top[i] += top[i + PARSER_EXPR_BLOCK];
+			break;
+		case expr_sub:
+			top -= PARSER_EXPR_BLOCK;
+			for (i = 0; i < m; i++)
+				top[i] -= top[i + PARSER_EXPR_BLOCK];
+			break;
+		case expr_mul:
+			top -= PARSER_EXPR_BLOCK;
+			for (i = 0; i < m; i++)
+				top[i] *= top[i + PARSER_EXPR_BLOCK];
+			break;
+		case expr_div:
+			top -= PARSER_EXPR_BLOCK;
+			for (i = 0; i < m; i++)
+				top[i] /= top[i + PARSER_EXPR_BLOCK];
+			break;
+		case expr_pow:
+			top -= PARSER_EXPR_BLOCK;
+			for (i = 0; i < m; i++)
+				top[i] = pow(top[i], top[i + PARSER_EXPR_BLOCK]);
+			break;
+		case expr_pow_const:
+			if (instr->value == 2.)
+				for (i = 0; i < m; i++)
+					top[i] *= top[i];
+			else
+				for (i = 0; i < m; i++)
+					top[i] = pow(top[i], instr->value);
+			break;
+		case expr_func:
+		case expr_func_diff:
+			/* the arguments are the topmost nargs blocks, the result replaces the first one */
+			top = next - instr->nargs * PARSER_EXPR_BLOCK;
+			for (k = 0; k < instr->nargs; k++)
+				a[k] = top + k * PARSER_EXPR_BLOCK;
+			for (i = 0; i < m; i++) {
+				for (k = 0; k < instr->nargs; k++)
+					args[k] = a[k][i];
+				if (instr->type == expr_func)
+					top[i] = expr_call(instr->fnct, instr->nargs, args);
+				else
+					top[i] = expr_call_diff(instr->fnct, instr->nargs, instr->var, args);
+			}
+			break;
+		}
+	}
+}
+
+/******************** public API ********************/
+
+parser_expr* parser_expr_compile(const char* str, const char* const names[], int nvars) {
+	expr_parser p;
+	expr_node* root;
+
+	p.str = str;
+	p.pos = 0;
+	p.names = names;
+	p.nvars = nvars;
+
+	root = expr_parse_sum(&p);
+	/* parse() accepts a trailing newline */
+	if (root && expr_peek(&p) == '\n')
+		p.pos++;
+	if (root && expr_peek(&p) != '\0') {
+		expr_node_free(root);
+		return 0;
+	}
+
+	return expr_new(root, nvars);
+}
+
+parser_expr* parser_expr_derivative(const parser_expr* e, int var) {
+	return expr_new(expr_derivative(e->root, var), e->nvars);
+}
+
+void parser_expr_free(parser_expr* e) {
+	if (!e)
+		return;
+	expr_node_free(e->root);
+	free(e->code);
+	free(e);
+}
+
+double parser_expr_eval(const parser_expr* e, const double vars[]) {
+	return expr_node_eval(e->root, vars);
+}
+
+int parser_expr_eval_vector(const parser_expr* e, const double vars[], int var, const double x[], size_t n, double result[], int parallel) {
+	const double** xs = (const double**)calloc(e->nvars, sizeof(const double*));
+	int status;
+	if (!xs)
+		return -1;
+
+	xs[var] = x;
+	status = parser_expr_eval_columns(e, vars, xs, n, result, parallel);
+	free(xs);
+
+	return status;
+}
+
+int parser_expr_eval_columns(const parser_expr* e, const double vars[], const double* const x[], size_t n, double result[], int parallel) {
+	const long nblocks = (long)((n + PARSER_EXPR_BLOCK - 1)/PARSER_EXPR_BLOCK);
+	int status = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(|:status) if(parallel && nblocks > 1)
+#else
+	(void)parallel;
+#endif
+	{
+		double* stack = (double*)malloc(e->depth * PARSER_EXPR_BLOCK * sizeof(double));
+		long b;
+		if (!stack)
+			status = -1;
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+		for (b = 0; b < nblocks; b++) {
+			const size_t start = (size_t)b * PARSER_EXPR_BLOCK;
+			const size_t m = n - start < PARSER_EXPR_BLOCK ? n - start : PARSER_EXPR_BLOCK;
+			if (!stack)
+				continue;
+			expr_eval_block(e, vars, x, start, m, stack);
+			memcpy(result + start, stack, m * sizeof(double));
+		}
+
+		free(stack);
+	}
+
+	return status;
+}
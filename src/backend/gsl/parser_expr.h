@@ -0,0 +1,56 @@
+/***************************************************************************
+    File                 : parser_expr.h
+    Project              : LabPlot
+    Description          : Compiled mathematical expressions with symbolic derivatives
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PARSER_EXPR_H
+#define PARSER_EXPR_H
+
+#include <stdlib.h>
+
+/* An expression in the syntax of parse() (without assignments) compiled once into a stack program.
+	Symbols are resolved like in parse(): the given variables first, then the constants and functions of the parser.
+ */
+typedef struct parser_expr parser_expr;
+
+/* compile str with the variables names[0..nvars-1]. Returns 0 on syntax errors and unknown symbols */
+parser_expr* parser_expr_compile(const char* str, const char* const names[], int nvars);
+/* symbolic derivative of e with respect to variable var.
+	Functions without a known derivative are differentiated numerically (central difference),
+	these numerical derivatives can't be differentiated again (returns 0) */
+parser_expr* parser_expr_derivative(const parser_expr* e, int var);
+void parser_expr_free(parser_expr* e);
+
+/* value of e for the variable values vars[0..nvars-1] */
+double parser_expr_eval(const parser_expr* e, const double vars[]);
+/* values of e for the n values x[] of variable var (the other variables are taken from vars[]).
+	Points are evaluated in blocks, the blocks in parallel if parallel != 0
+	(use 0 when called from several threads at once). Returns -1 if out of memory */
+int parser_expr_eval_vector(const parser_expr* e, const double vars[], int var, const double x[], size_t n, double result[], int parallel);
+/* values of e for n points, variable i is taken from x[i][0..n-1] (from vars[i] if x[i] is 0).
+	Blocks as in parser_expr_eval_vector(). Returns -1 if out of memory */
+int parser_expr_eval_columns(const parser_expr* e, const double vars[], const double* const x[], size_t n, double result[], int parallel);
+
+#endif /* PARSER_EXPR_H */
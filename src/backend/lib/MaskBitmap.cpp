@@ -0,0 +1,383 @@
+/***************************************************************************
+    File                 : MaskBitmap.cpp
+    Project              : LabPlot
+    Description          : Compressed bitmap of the masked rows of a column
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "MaskBitmap.h"
+
+/*!
+  \class MaskBitmap
+  \brief Compressed bitmap of the masked rows of a column.
+
+  The rows are divided into chunks of 65536 rows (like in roaring bitmaps). A chunk is either empty,
+  full or stores one bit per row in 1024 words, so isSet() is O(1) and long masked intervals
+  need no memory. The words are implicitly shared, copies of the bitmap (e.g. for undo) are cheap.
+  Rows behind the last chunk are not masked.
+
+  The masking is saved as list of intervals, see intervals() and MaskBitmap(const QList< Interval<int> >&).
+
+  \ingroup backend
+*/
+
+static const quint64 allBits = ~Q_UINT64_C(0);
+
+static inline int trailingZeros(quint64 word) {
+#ifdef __GNUC__
+	return __builtin_ctzll(word);
+#else
+	int n = 0;
+	while (!(word & 1)) {
+		word >>= 1;
+		++n;
+	}
+	return n;
+#endif
+}
+
+static inline int bitCount(quint64 word) {
+#ifdef __GNUC__
+	return __builtin_popcountll(word);
+#else
+	int n = 0;
+	for (; word; ++n)
+		word &= word - 1;
+	return n;
+#endif
+}
+
+MaskBitmap::MaskBitmap() {
+}
+
+/*!
+  creates the bitmap with the rows of \c intervals set
+*/
+MaskBitmap::MaskBitmap(const QList< Interval<int> >& intervals) {
+	foreach (const Interval<int>& iv, intervals)
+		setValue(iv, true);
+}
+
+/*!
+  returns \c true if all rows of the interval \c i are set
+*/
+bool MaskBitmap::isSet(Interval<int> i) const {
+	if (i.start() < 0 || i.end() < i.start())
+		return false;
+
+	const int first = i.start() >> 6;
+	const int last = i.end() >> 6;
+	for (int w = first; w <= last; ++w) {
+		quint64 mask = allBits;
+		if (w == first)
+			mask &= allBits << (i.start() & 63);
+		if (w == last)
+			mask &= allBits >> (63 - (i.end() & 63));
+		if ((word(w) & mask) != mask)
+			return false;
+	}
+	return true;
+}
+
+/*!
+  number of set rows
+*/
+int MaskBitmap::count() const {
+	int n = 0;
+	foreach (const Chunk& chunk, m_chunks) {
+		if (chunk.type == Full)
+			n += ChunkSize;
+		else if (chunk.type == Bits) {
+			for (int w = 0; w < ChunkWords; ++w)
+				n += bitCount(chunk.words.at(w));
+		}
+	}
+	return n;
+}
+
+void MaskBitmap::setValue(Interval<int> i, bool value) {
+	if (i.end() < 0 || i.end() < i.start())
+		return;
+
+	setRange(qMax(i.start(), 0), i.end(), value);
+}
+
+void MaskBitmap::setValue(int row, bool value) {
+	setValue(Interval<int>(row, row), value);
+}
+
+/*!
+  inserts \c count unset rows before the row \c before
+*/
+void MaskBitmap::insertRows(int before, int count) {
+	if (count <= 0 || before >= m_chunks.size() * ChunkSize)
+		return;
+
+	const QList< Interval<int> > list = intervals();
+	m_chunks.clear();
+	foreach (const Interval<int>& iv, list) {
+		if (iv.end() < before)
+			setRange(iv.start(), iv.end(), true);
+		else if (iv.start() >= before)
+			setRange(iv.start() + count, iv.end() + count, true);
+		else {
+			setRange(iv.start(), before - 1, true);
+			setRange(before + count, iv.end() + count, true);
+		}
+	}
+}
+
+/*!
+  removes the \c count rows starting at row \c first
+*/
+void MaskBitmap::removeRows(int first, int count) {
+	if (count <= 0 || first >= m_chunks.size() * ChunkSize)
+		return;
+
+	const int last = first + count - 1;
+	const QList< Interval<int> > list = intervals();
+	m_chunks.clear();
+	foreach (const Interval<int>& iv, list) {
+		if (iv.start() < first)
+			setRange(iv.start(), qMin(iv.end(), first - 1), true);
+		if (iv.end() > last)
+			setRange(qMax(iv.start(), last + 1) - count, iv.end() - count, true);
+	}
+}
+
+/*!
+  the bits of the rows 64*\c index to 64*\c index + 63, used to process the masking word-wise
+*/
+quint64 MaskBitmap::word(int index) const {
+	const int c = index / ChunkWords;
+	if (index < 0 || c >= m_chunks.size())
+		return 0;
+
+	const Chunk& chunk = m_chunks.at(c);
+	if (chunk.type != Bits)
+		return chunk.type == Full ? allBits : 0;
+	return chunk.words.at(index % ChunkWords);
+}
+
+/*!
+  the set rows as list of disjoint, sorted intervals
+*/
+QList< Interval<int> > MaskBitmap::intervals() const {
+	QList< Interval<int> > result;
+	int start = -1;
+	for (int c = 0; c < m_chunks.size(); ++c) {
+		const Chunk& chunk = m_chunks.at(c);
+		const int base = c * ChunkSize;
+		if (chunk.type == Empty) {
+			if (start != -1) {
+				result << Interval<int>(start, base - 1);
+				start = -1;
+			}
+			continue;
+		}
+		if (chunk.type == Full) {
+			if (start == -1)
+				start = base;
+			continue;
+		}
+
+		for (int w = 0; w < ChunkWords; ++w) {
+			const quint64 word = chunk.words.at(w);
+			const int row = base + w * 64;
+			int pos = 0;
+			while (pos < 64) {
+				if (start == -1) {
+					const quint64 rest = word >> pos;
+					if (!rest)
+						break;
+					pos += trailingZeros(rest);
+					start = row + pos;
+				} else {
+					const quint64 rest = ~word >> pos;
+					if (!rest)
+						break;
+					pos += trailingZeros(rest);
+					result << Interval<int>(start, row + pos - 1);
+					start = -1;
+				}
+			}
+		}
+	}
+	if (start != -1)
+		result << Interval<int>(start, m_chunks.size() * ChunkSize - 1);
+
+	return result;
+}
+
+MaskBitmap& MaskBitmap::operator|=(const MaskBitmap& other) {
+	if (m_chunks.size() < other.m_chunks.size())
+		m_chunks.resize(other.m_chunks.size());
+
+	for (int c = 0; c < other.m_chunks.size(); ++c) {
+		const Chunk& o = other.m_chunks.at(c);
+		Chunk& chunk = m_chunks[c];
+		if (o.type == Empty || chunk.type == Full)
+			continue;
+		if (o.type == Full || chunk.type == Empty) {
+			chunk = o;
+			continue;
+		}
+
+		quint64* words = chunk.words.data();
+		for (int w = 0; w < ChunkWords; ++w)
+			words[w] |= o.words.at(w);
+		normalize(chunk);
+	}
+	return *this;
+}
+
+MaskBitmap& MaskBitmap::operator&=(const MaskBitmap& other) {
+	if (m_chunks.size() > other.m_chunks.size())
+		m_chunks.resize(other.m_chunks.size());
+
+	for (int c = 0; c < m_chunks.size(); ++c) {
+		const Chunk& o = other.m_chunks.at(c);
+		Chunk& chunk = m_chunks[c];
+		if (o.type == Full || chunk.type == Empty)
+			continue;
+		if (o.type == Empty || chunk.type == Full) {
+			chunk = o;
+			continue;
+		}
+
+		quint64* words = chunk.words.data();
+		for (int w = 0; w < ChunkWords; ++w)
+			words[w] &= o.words.at(w);
+		normalize(chunk);
+	}
+	trim();
+	return *this;
+}
+
+MaskBitmap& MaskBitmap::operator-=(const MaskBitmap& other) {
+	const int n = qMin(m_chunks.size(), other.m_chunks.size());
+	for (int c = 0; c < n; ++c) {
+		const Chunk& o = other.m_chunks.at(c);
+		Chunk& chunk = m_chunks[c];
+		if (o.type == Empty || chunk.type == Empty)
+			continue;
+		if (o.type == Full) {
+			chunk = Chunk();
+			continue;
+		}
+
+		if (chunk.type == Full) {
+			chunk.type = Bits;
+			chunk.words.fill(allBits, ChunkWords);
+		}
+		quint64* words = chunk.words.data();
+		for (int w = 0; w < ChunkWords; ++w)
+			words[w] &= ~o.words.at(w);
+		normalize(chunk);
+	}
+	trim();
+	return *this;
+}
+
+bool MaskBitmap::operator==(const MaskBitmap& other) const {
+	return m_chunks == other.m_chunks;
+}
+
+/*!
+  sets (\c value = true) or unsets the rows \c first to \c last, whole chunks and words at once
+*/
+void MaskBitmap::setRange(int first, int last, bool value) {
+	const int lastChunk = last >> ChunkBits;
+	if (value && m_chunks.size() <= lastChunk)
+		m_chunks.resize(lastChunk + 1);
+
+	for (int c = first >> ChunkBits; c <= lastChunk && c < m_chunks.size(); ++c) {
+		Chunk& chunk = m_chunks[c];
+		const int base = c * ChunkSize;
+		const int lo = qMax(first, base) - base;
+		const int hi = qMin(last, base + ChunkMask) - base;
+		if (lo == 0 && hi == ChunkMask) {
+			chunk.type = value ? Full : Empty;
+			chunk.words.clear();
+			continue;
+		}
+		if (chunk.type == (value ? Full : Empty))
+			continue;
+
+		if (chunk.type != Bits) {
+			chunk.words.fill(chunk.type == Full ? allBits : 0, ChunkWords);
+			chunk.type = Bits;
+		}
+
+		quint64* words = chunk.words.data();
+		const int w1 = lo >> 6;
+		const int w2 = hi >> 6;
+		for (int w = w1; w <= w2; ++w) {
+			quint64 mask = allBits;
+			if (w == w1)
+				mask &= allBits << (lo & 63);
+			if (w == w2)
+				mask &= allBits >> (63 - (hi & 63));
+			if (value)
+				words[w] |= mask;
+			else
+				words[w] &= ~mask;
+		}
+		normalize(chunk);
+	}
+
+	if (!value)
+		trim();
+}
+
+/*!
+  converts a chunk with bits into an empty or a full chunk if possible
+*/
+void MaskBitmap::normalize(Chunk& chunk) {
+	if (chunk.type != Bits)
+		return;
+
+	const quint64* words = chunk.words.constData();
+	bool empty = true;
+	bool full = true;
+	for (int w = 0; w < ChunkWords && (empty || full); ++w) {
+		empty = empty && words[w] == 0;
+		full = full && words[w] == allBits;
+	}
+
+	if (empty || full) {
+		chunk.type = empty ? Empty : Full;
+		chunk.words.clear();
+	}
+}
+
+/*!
+  removes the empty chunks at the end
+*/
+void MaskBitmap::trim() {
+	int n = m_chunks.size();
+	while (n > 0 && m_chunks.at(n - 1).type == Empty)
+		--n;
+	if (n != m_chunks.size())
+		m_chunks.resize(n);
+}
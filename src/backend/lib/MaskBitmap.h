@@ -0,0 +1,88 @@
+/***************************************************************************
+    File                 : MaskBitmap.h
+    Project              : LabPlot
+    Description          : Compressed bitmap of the masked rows of a column
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef MASKBITMAP_H
+#define MASKBITMAP_H
+
+#include "backend/lib/Interval.h"
+#include <QList>
+#include <QVector>
+
+class MaskBitmap {
+	public:
+		MaskBitmap();
+		explicit MaskBitmap(const QList< Interval<int> >& intervals);
+
+		bool isSet(int row) const {
+			const int c = row >> ChunkBits;
+			if (row < 0 || c >= m_chunks.size())
+				return false;
+			const Chunk& chunk = m_chunks.at(c);
+			if (chunk.type != Bits)
+				return chunk.type == Full;
+			return (chunk.words.at((row & ChunkMask) >> 6) >> (row & 63)) & 1;
+		}
+		bool isSet(Interval<int> i) const;
+		bool isEmpty() const { return m_chunks.isEmpty(); }
+		int count() const;
+
+		void setValue(Interval<int> i, bool value = true);
+		void setValue(int row, bool value);
+		void insertRows(int before, int count);
+		void removeRows(int first, int count);
+		void clear() { m_chunks.clear(); }
+
+		int wordCount() const { return m_chunks.size() * ChunkWords; }
+		quint64 word(int index) const;
+
+		QList< Interval<int> > intervals() const;
+
+		MaskBitmap& operator|=(const MaskBitmap& other);
+		MaskBitmap& operator&=(const MaskBitmap& other);
+		MaskBitmap& operator-=(const MaskBitmap& other);
+		bool operator==(const MaskBitmap& other) const;
+		bool operator!=(const MaskBitmap& other) const { return !(*this == other); }
+
+	private:
+		enum { ChunkBits = 16, ChunkSize = 1 << ChunkBits, ChunkMask = ChunkSize - 1, ChunkWords = ChunkSize / 64 };
+		enum ChunkType { Empty, Full, Bits };
+		struct Chunk {
+			Chunk() : type(Empty) {}
+			bool operator==(const Chunk& other) const { return type == other.type && words == other.words; }
+
+			ChunkType type;
+			QVector<quint64> words;	//only used for Bits
+		};
+
+		void setRange(int first, int last, bool value);
+		void normalize(Chunk& chunk);
+		void trim();
+
+		QVector<Chunk> m_chunks;
+};
+
+#endif
@@ -0,0 +1,295 @@
+/***************************************************************************
+    File                 : PackedDateTime.cpp
+    Project              : LabPlot
+    Description          : Date and time values packed into 64 bit integers
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PackedDateTime.h"
+
+/*!
+  \class PackedDateTime
+  \brief Date and time values packed into 64 bit integers.
+
+  The columns of the modes DateTime, Month and Day store their values as QVector<qint64> instead of QList<QDateTime>.
+  A value is the number of milliseconds since the begin of the Julian day 0, i.e.
+  Julian day * 86400000 + milliseconds since midnight, of the date and the time (wall-clock time, no time zone).
+  The order of the packed values is the order of the date times. Invalid values are stored as invalid().
+  A valid time without a date (e.g. set with Column::setTimeAt() in an empty row) is kept in the range
+  above invalid(), isValid() is false for it.
+
+  The Julian day conversion to and from double is the same as in DateTime2DoubleFilter and Double2DateTimeFilter
+  and is done without creating QDateTime objects.
+
+  \ingroup backend
+*/
+
+static inline QTime timeOfDay(int msecs) {
+	return QTime(msecs/3600000, msecs/60000 % 60, msecs/1000 % 60, msecs % 1000);
+}
+
+//splits a valid packed value into the Julian day and the milliseconds since midnight
+static inline void split(qint64 value, qint64& day, int& msecs) {
+	day = value / PackedDateTime::MSecsPerDay;
+	qint64 rest = value % PackedDateTime::MSecsPerDay;
+	if (rest < 0) {
+		--day;
+		rest += PackedDateTime::MSecsPerDay;
+	}
+	msecs = (int)rest;
+}
+
+qint64 PackedDateTime::pack(const QDateTime& dateTime) {
+	const QTime time = dateTime.time();
+	if (!time.isValid())
+		return invalid();
+
+	const qint64 msecs = QTime(0, 0).msecsTo(time);
+	const QDate date = dateTime.date();
+	if (!date.isValid())
+		return invalid() + 1 + msecs;
+
+	return (qint64)date.toJulianDay() * MSecsPerDay + msecs;
+}
+
+QDateTime PackedDateTime::unpack(qint64 value) {
+	if (value == invalid())
+		return QDateTime();
+	if (!isValid(value))
+		return QDateTime(QDate(), timeOfDay(int(value - invalid() - 1)));
+
+	qint64 day;
+	int msecs;
+	split(value, day, msecs);
+	return QDateTime(QDate::fromJulianDay(day), timeOfDay(msecs));
+}
+
+QVector<qint64> PackedDateTime::pack(const QList<QDateTime>& dateTimes) {
+	QVector<qint64> values(dateTimes.size());
+	qint64* ptr = values.data();
+	for (int i = 0; i < dateTimes.size(); ++i)
+		ptr[i] = pack(dateTimes.at(i));
+	return values;
+}
+
+QList<QDateTime> PackedDateTime::unpack(const QVector<qint64>& values) {
+	QList<QDateTime> dateTimes;
+	dateTimes.reserve(values.size());
+	for (int i = 0; i < values.size(); ++i)
+		dateTimes << unpack(values.at(i));
+	return dateTimes;
+}
+
+/*!
+  packed value of the Julian day \c value (rounded to milliseconds), invalid() for NaN and infinite values
+*/
+qint64 PackedDateTime::fromJulianDay(double value) {
+	const double msecs = value * MSecsPerDay + MSecsPerDay/2;
+	//the range check is false for NaN
+	if (!(msecs > -9.0e18 && msecs < 9.0e18))
+		return invalid();
+	return qRound64(msecs);
+}
+
+/*!
+  converts \c count packed values into Julian days (NaN for invalid values).
+  The loop has no function calls and only a select for the invalid values and can be vectorized by the compiler.
+*/
+void PackedDateTime::toJulianDays(const qint64* values, double* days, int count) {
+	const qint64 limit = invalid() + MSecsPerDay;
+	for (int i = 0; i < count; ++i) {
+		const double day = double(values[i] - MSecsPerDay/2) / double(MSecsPerDay);
+		days[i] = values[i] > limit ? day : NAN;
+	}
+}
+
+/*!
+  converts \c count Julian days into packed values, see fromJulianDay()
+*/
+void PackedDateTime::fromJulianDays(const double* days, qint64* values, int count) {
+	for (int i = 0; i < count; ++i)
+		values[i] = fromJulianDay(days[i]);
+}
+
+/*!
+  \class PackedDateTime::Formatter
+  \brief Formatting of packed values with a format string as used by QDateTime::toString().
+
+  The format is parsed once. Formats consisting of the numerical elements (d, dd, M, MM, yy, yyyy, h, hh,
+  m, mm, s, ss, z, zzz), the names of days and months (ddd, dddd, MMM, MMMM) and non-letter separators
+  are formatted directly from the packed value, other formats (AM/PM, quoted text, ...) and years outside
+  of 1000 to 9999 are formatted with QDateTime::toString().
+*/
+
+PackedDateTime::Formatter::Formatter(const QString& format) : m_format(format), m_compiled(true) {
+	int i = 0;
+	while (i < format.size()) {
+		const QChar c = format.at(i);
+		int n = 1;
+		while (i + n < format.size() && format.at(i + n) == c)
+			++n;
+
+		Token token;
+		token.field = Literal;
+		if (c == QLatin1Char('\'')) {
+			m_compiled = false;
+		} else if (c.isLetter()) {
+			switch (c.toLatin1()) {
+			case 'd': {
+					static const Field fields[] = {Day, Day2, DayName, LongDayName};
+					if (n <= 4)
+						token.field = fields[n - 1];
+					break;
+				}
+			case 'M': {
+					static const Field fields[] = {Month, Month2, MonthName, LongMonthName};
+					if (n <= 4)
+						token.field = fields[n - 1];
+					break;
+				}
+			case 'y':
+				if (n == 2 || n == 4)
+					token.field = (n == 2) ? Year2 : Year4;
+				break;
+			case 'h':
+				if (n <= 2)
+					token.field = (n == 1) ? Hour : Hour2;
+				break;
+			case 'm':
+				if (n <= 2)
+					token.field = (n == 1) ? Minute : Minute2;
+				break;
+			case 's':
+				if (n <= 2)
+					token.field = (n == 1) ? Second : Second2;
+				break;
+			case 'z':
+				if (n == 1 || n == 3)
+					token.field = (n == 1) ? MSec : MSec3;
+				break;
+			}
+			if (token.field == Literal)
+				m_compiled = false;
+		} else if (!m_tokens.isEmpty() && m_tokens.last().field == Literal) {
+			m_tokens.last().text += format.mid(i, n);
+			i += n;
+			continue;
+		} else
+			token.text = format.mid(i, n);
+
+		if (!m_compiled) {
+			m_tokens.clear();
+			return;
+		}
+		m_tokens << token;
+		i += n;
+	}
+}
+
+//appends the non-negative number \c value with at least \c width digits
+static inline void appendNumber(QString& result, int value, int width) {
+	QChar digits[10];
+	int n = 0;
+	do {
+		digits[n++] = QLatin1Char('0' + value % 10);
+		value /= 10;
+	} while (value);
+
+	for (int i = n; i < width; ++i)
+		result += QLatin1Char('0');
+	while (n)
+		result += digits[--n];
+}
+
+/*!
+  formats the packed \c value, returns an empty string for invalid values
+*/
+QString PackedDateTime::Formatter::toString(qint64 value) const {
+	if (!isValid(value))
+		return QString();
+	if (!m_compiled)
+		return unpack(value).toString(m_format);
+
+	qint64 day;
+	int msecs;
+	split(value, day, msecs);
+	const QDate date = QDate::fromJulianDay(day);
+	int year, month, dayOfMonth;
+	date.getDate(&year, &month, &dayOfMonth);
+	if (year < 1000 || year > 9999)
+		return unpack(value).toString(m_format);
+
+	QString result;
+	result.reserve(m_format.size() + 8);
+	foreach (const Token& token, m_tokens) {
+		switch (token.field) {
+		case Literal:
+			result += token.text;
+			break;
+		case Day:
+		case Day2:
+			appendNumber(result, dayOfMonth, token.field == Day2 ? 2 : 1);
+			break;
+		case DayName:
+			result += QDate::shortDayName(date.dayOfWeek());
+			break;
+		case LongDayName:
+			result += QDate::longDayName(date.dayOfWeek());
+			break;
+		case Month:
+		case Month2:
+			appendNumber(result, month, token.field == Month2 ? 2 : 1);
+			break;
+		case MonthName:
+			result += QDate::shortMonthName(month);
+			break;
+		case LongMonthName:
+			result += QDate::longMonthName(month);
+			break;
+		case Year2:
+			appendNumber(result, year % 100, 2);
+			break;
+		case Year4:
+			appendNumber(result, year, 4);
+			break;
+		case Hour:
+		case Hour2:
+			appendNumber(result, msecs/3600000, token.field == Hour2 ? 2 : 1);
+			break;
+		case Minute:
+		case Minute2:
+			appendNumber(result, msecs/60000 % 60, token.field == Minute2 ? 2 : 1);
+			break;
+		case Second:
+		case Second2:
+			appendNumber(result, msecs/1000 % 60, token.field == Second2 ? 2 : 1);
+			break;
+		case MSec:
+		case MSec3:
+			appendNumber(result, msecs % 1000, token.field == MSec3 ? 3 : 1);
+			break;
+		}
+	}
+	return result;
+}
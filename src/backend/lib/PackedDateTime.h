@@ -0,0 +1,77 @@
+/***************************************************************************
+    File                 : PackedDateTime.h
+    Project              : LabPlot
+    Description          : Date and time values packed into 64 bit integers
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PACKEDDATETIME_H
+#define PACKEDDATETIME_H
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include <cmath>
+
+class PackedDateTime {
+	public:
+		enum { MSecsPerDay = 86400000 };
+
+		static qint64 invalid() { return -Q_INT64_C(0x7fffffffffffffff) - 1; }
+		static bool isValid(qint64 value) { return value > invalid() + MSecsPerDay; }
+
+		static qint64 pack(const QDateTime& dateTime);
+		static QDateTime unpack(qint64 value);
+		static QVector<qint64> pack(const QList<QDateTime>& dateTimes);
+		static QList<QDateTime> unpack(const QVector<qint64>& values);
+
+		//conversion to and from the Julian day as used by DateTime2DoubleFilter and Double2DateTimeFilter
+		static double toJulianDay(qint64 value) {
+			return isValid(value) ? double(value - MSecsPerDay/2) / double(MSecsPerDay) : NAN;
+		}
+		static qint64 fromJulianDay(double value);
+		static void toJulianDays(const qint64* values, double* days, int count);
+		static void fromJulianDays(const double* days, qint64* values, int count);
+
+		class Formatter {
+			public:
+				explicit Formatter(const QString& format = QString());
+				QString toString(qint64 value) const;
+
+			private:
+				enum Field {Literal, Day, Day2, DayName, LongDayName, Month, Month2, MonthName, LongMonthName,
+					Year2, Year4, Hour, Hour2, Minute, Minute2, Second, Second2, MSec, MSec3};
+				struct Token {
+					Field field;
+					QString text;
+				};
+
+				QString m_format;
+				QVector<Token> m_tokens;
+				bool m_compiled;	//false if the format is only handled by QDateTime::toString()
+		};
+};
+
+#endif
@@ -0,0 +1,134 @@
+/***************************************************************************
+    File                 : TextDictionary.cpp
+    Project              : LabPlot
+    Description          : Dictionary of the distinct texts of a text column
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "TextDictionary.h"
+
+#include <QPair>
+
+/*!
+  \class TextDictionary
+  \brief Dictionary of the distinct texts of a text column.
+
+  Every distinct text gets a code, the index in strings(). intern() returns the copy of a text stored
+  in the dictionary, so equal texts of a column share their data (implicit sharing) and a column with
+  few distinct values (categories, states, device names, ...) needs one pointer per row only.
+
+  encode() determines the codes of all rows of a column (dictionary encoding). Equal codes mean equal texts,
+  grouping and comparing rows is done on the codes, e.g. when sorting or saving text columns.
+  Null strings get the code -1.
+
+  \ingroup backend
+*/
+
+TextDictionary::TextDictionary() {
+}
+
+/*!
+  creates the dictionary of the distinct \c strings
+*/
+TextDictionary::TextDictionary(const QStringList& strings) : m_strings(strings) {
+	for (int i = 0; i < m_strings.size(); ++i)
+		m_codes.insert(m_strings.at(i), i);
+}
+
+/*!
+  returns the copy of \c text in the dictionary, \c text is added if it is not in the dictionary yet.
+  Null strings are not added.
+*/
+QString TextDictionary::intern(const QString& text) {
+	if (text.isNull())
+		return text;
+
+	const QHash<QString, int>::const_iterator it = m_codes.constFind(text);
+	if (it != m_codes.constEnd())
+		return m_strings.at(it.value());
+
+	m_codes.insert(text, m_strings.size());
+	m_strings << text;
+	return text;
+}
+
+void TextDictionary::clear() {
+	m_strings.clear();
+	m_codes.clear();
+}
+
+/*!
+  determines the dictionary \c strings of the distinct texts in \c texts (in the order of their first appearance)
+  and the \c codes of all rows. Returns \c false if there are more than \c maxSize distinct texts.
+
+  Texts sharing their data (e.g. interned with intern()) are grouped by their data pointer,
+  the texts themselves are only hashed and compared for the first row of every shared copy.
+*/
+bool TextDictionary::encode(const QStringList& texts, int maxSize, QVector<int>& codes, QStringList& strings) {
+	typedef QPair<const QChar*, int> Data;
+	QHash<Data, int> dataCodes;
+	QHash<QString, int> textCodes;
+
+	strings.clear();
+	codes.resize(texts.size());
+	int* ptr = codes.data();
+	for (int i = 0; i < texts.size(); ++i) {
+		const QString& text = texts.at(i);
+		if (text.isNull()) {
+			ptr[i] = -1;
+			continue;
+		}
+
+		const Data data(text.constData(), text.size());
+		const QHash<Data, int>::const_iterator it = dataCodes.constFind(data);
+		if (it != dataCodes.constEnd()) {
+			ptr[i] = it.value();
+			continue;
+		}
+
+		int code = textCodes.value(text, -1);
+		if (code == -1) {
+			if (strings.size() >= maxSize)
+				return false;
+			code = strings.size();
+			strings << text;
+			textCodes.insert(text, code);
+		}
+		dataCodes.insert(data, code);
+		ptr[i] = code;
+	}
+
+	return true;
+}
+
+/*!
+  the texts of the rows with the \c codes, the texts share their data with \c strings
+*/
+QStringList TextDictionary::decode(const QVector<int>& codes, const QStringList& strings) {
+	QStringList texts;
+	texts.reserve(codes.size());
+	foreach (int code, codes)
+		texts << ((code >= 0 && code < strings.size()) ? strings.at(code) : QString());
+	return texts;
+}
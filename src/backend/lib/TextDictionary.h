@@ -0,0 +1,54 @@
+/***************************************************************************
+    File                 : TextDictionary.h
+    Project              : LabPlot
+    Description          : Dictionary of the distinct texts of a text column
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TEXTDICTIONARY_H
+#define TEXTDICTIONARY_H
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+class TextDictionary {
+	public:
+		TextDictionary();
+		explicit TextDictionary(const QStringList& strings);
+
+		QString intern(const QString& text);
+		int code(const QString& text) const { return m_codes.value(text, -1); }
+		const QStringList& strings() const { return m_strings; }
+		int size() const { return m_strings.size(); }
+		void clear();
+
+		static bool encode(const QStringList& texts, int maxSize, QVector<int>& codes, QStringList& strings);
+		static QStringList decode(const QVector<int>& codes, const QStringList& strings);
+
+	private:
+		QStringList m_strings;
+		QHash<QString, int> m_codes;
+};
+
+#endif
@@ -155,9 +155,13 @@ bool Matrix::exportView() const {
 		} else if (dlg->format() == ExportSpreadsheetDialog::FITS) {
 			const int exportTo = dlg->exportToFits();
 			view->exportToFits(path, exportTo );
+		} else if (dlg->format() == ExportSpreadsheetDialog::ColumnarBinary) {
+			const bool compression = dlg->compression();
+			view->exportToColumnarBinary(path, compression);
 		} else {
 			const QString separator = dlg->separator();
-			view->exportToFile(path, separator);
+			const bool fullPrecision = dlg->fullPrecision();
+			view->exportToFile(path, separator, fullPrecision);
 		}
 		RESET_CURSOR;
     	}
@@ -398,15 +402,12 @@ void Matrix::copy(Matrix* other) {
 		setRowHeight(i, other->rowHeight(i));
 	for (int i=0; i<columns; i++)
 		setColumnWidth(i, other->columnWidth(i));
-	d->suppressDataChange = true;
-	for (int i=0; i<columns; i++)
-		setColumnCells(i, 0, rows-1, other->columnCells(i, 0, rows-1));
+	//the data is shared with the other matrix and only copied when one of the matrices is changed
+	exec(new MatrixReplaceValuesCmd(d, other->data()));
 	setCoordinates(other->xStart(), other->xEnd(), other->yStart(), other->yEnd());
 	setNumericFormat(other->numericFormat());
 	setPrecision(other->precision());
 	d->formula = other->formula();
-	d->suppressDataChange = false;
-	emit dataChanged(0, 0, rows-1, columns-1);
 	if (m_view) reinterpret_cast<MatrixView*>(m_view)->adjustHeaders();
 	endMacro();
 	RESET_CURSOR;
@@ -637,10 +638,7 @@ QVector<double> MatrixPrivate::columnCells(int col, int first_row, int last_row)
 	if(first_row == 0 && last_row == rowCount-1)
 		return matrixData.at(col);
 
-	QVector<double> result;
-	for(int i=first_row; i<=last_row; i++)
-		result.append(matrixData.at(col).at(i));
-	return result;
+	return matrixData.at(col).mid(first_row, last_row - first_row + 1);
 }
 
 void MatrixPrivate::setColumnCells(int col, int first_row, int last_row, const QVector<double> & values) {
@@ -650,7 +648,8 @@ void MatrixPrivate::setColumnCells(int col, int first_row, int last_row, const Q
 
 	if(first_row == 0 && last_row == rowCount-1) {
 		matrixData[col] = values;
-		matrixData[col].resize(rowCount);  // values may be larger
+		if (values.size() != rowCount)
+			matrixData[col].resize(rowCount);  // values may be larger, resizing a shared vector would copy it
 		if (!suppressDataChange)
 			emit q->dataChanged(first_row, col, last_row, col);
 		return;
@@ -28,16 +28,449 @@
 
 #include "nsl_dft.h"
 #include "nsl_common.h"
+#include <string.h>
 #include <gsl/gsl_fft_real.h>
 #include <gsl/gsl_fft_halfcomplex.h>
 #ifdef HAVE_FFTW3
 #include <fftw3.h>
 #endif
+#ifdef HAVE_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 const char* nsl_dft_result_type_name[] = {i18n("Magnitude"), i18n("Amplitude"), i18n("real part"), i18n("imaginary part"), i18n("Power"), i18n("Phase"),
 		i18n("Amplitude in dB"), i18n("normalized amplitude in dB"), i18n("Magnitude squared"), i18n("Amplitude squared"), i18n("raw")};
 const char* nsl_dft_xscale_name[] = {i18n("Frequency"), i18n("Index"), i18n("Period")};
 
+/*********** plan cache *********/
+
+/* number of cached plans (FFTW) or wavetables (GSL) */
+#define NSL_DFT_CACHE_SIZE 8
+/* minimum size for multi-threaded FFTW transforms */
+#define NSL_DFT_THREADS_MIN_SIZE 65536
+/* maximum time in seconds spent to measure an FFTW plan */
+#define NSL_DFT_MEASURE_TIME_LIMIT 1.0
+
+/* the cache is protected by a lock that is only held for the lookup and the update of the cache.
+	The planner of FFTW is not thread-safe, all planner calls are serialized by a second lock.
+	The two locks are never held at the same time. */
+#ifdef HAVE_WINDOWS
+static SRWLOCK nsl_dft_cache_mutex = SRWLOCK_INIT;
+static SRWLOCK nsl_dft_planner_mutex = SRWLOCK_INIT;
+#define NSL_DFT_CACHE_LOCK AcquireSRWLockExclusive(&nsl_dft_cache_mutex)
+#define NSL_DFT_CACHE_UNLOCK ReleaseSRWLockExclusive(&nsl_dft_cache_mutex)
+#define NSL_DFT_PLANNER_LOCK AcquireSRWLockExclusive(&nsl_dft_planner_mutex)
+#define NSL_DFT_PLANNER_UNLOCK ReleaseSRWLockExclusive(&nsl_dft_planner_mutex)
+#else
+static pthread_mutex_t nsl_dft_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t nsl_dft_planner_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define NSL_DFT_CACHE_LOCK pthread_mutex_lock(&nsl_dft_cache_mutex)
+#define NSL_DFT_CACHE_UNLOCK pthread_mutex_unlock(&nsl_dft_cache_mutex)
+#define NSL_DFT_PLANNER_LOCK pthread_mutex_lock(&nsl_dft_planner_mutex)
+#define NSL_DFT_PLANNER_UNLOCK pthread_mutex_unlock(&nsl_dft_planner_mutex)
+#endif
+
+typedef struct {
+	size_t n;
+	int inverse;
+	int cached;		/* entry of the cache (else freed after use) */
+	unsigned int users;	/* number of running transforms using the plan */
+	unsigned long used;	/* time of last use (for replacement) */
+#ifdef HAVE_FFTW3
+	fftw_plan plan;
+	int measured;
+	int measuring;	/* a measured plan is being created */
+#else
+	gsl_fft_real_wavetable *real;
+	gsl_fft_halfcomplex_wavetable *hc;
+#endif
+} nsl_dft_plan;
+
+static nsl_dft_plan *nsl_dft_cache[NSL_DFT_CACHE_SIZE];
+static unsigned long nsl_dft_cache_time = 0;
+
+#ifdef HAVE_FFTW3
+static int nsl_dft_cpu_count(void) {
+#ifdef HAVE_WINDOWS
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (int)count : 1;
+#endif
+}
+
+/* creates the FFTW plan for size n (called without the cache lock, takes the planner lock).
+	measure: measure the fastest algorithm instead of estimating it. If wisdom is available, it is used in any case.
+*/
+static fftw_plan nsl_dft_fftw_plan(size_t n, int inverse, int measure, int *measured) {
+	fftw_plan plan;
+	/* FFTW_MEASURE overwrites the arrays, plans are created with temporary arrays of same alignment */
+	double *in = (double *)fftw_malloc(2*(n/2+1)*sizeof(double));
+	double *out = (double *)fftw_malloc(2*(n/2+1)*sizeof(double));
+	if (in == NULL || out == NULL) {
+		fftw_free(in);
+		fftw_free(out);
+		return NULL;
+	}
+
+	NSL_DFT_PLANNER_LOCK;
+#ifdef HAVE_FFTW3_THREADS
+	static int threads = 0;
+	if (!threads)
+		threads = fftw_init_threads() ? nsl_dft_cpu_count() : 1;
+	fftw_plan_with_nthreads(n >= NSL_DFT_THREADS_MIN_SIZE ? threads : 1);
+#endif
+
+	fftw_set_timelimit(NSL_DFT_MEASURE_TIME_LIMIT);
+	unsigned flags = FFTW_MEASURE;
+	if (!measure)
+		flags |= FFTW_WISDOM_ONLY;
+	if (inverse)
+		plan = fftw_plan_dft_c2r_1d((int)n, (fftw_complex *)in, out, flags | FFTW_DESTROY_INPUT);
+	else
+		plan = fftw_plan_dft_r2c_1d((int)n, in, (fftw_complex *)out, flags);
+	*measured = (plan != NULL);
+
+	if (plan == NULL) {	/* no wisdom */
+		if (inverse)
+			plan = fftw_plan_dft_c2r_1d((int)n, (fftw_complex *)in, out, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+		else
+			plan = fftw_plan_dft_r2c_1d((int)n, in, (fftw_complex *)out, FFTW_ESTIMATE);
+	}
+	NSL_DFT_PLANNER_UNLOCK;
+
+	fftw_free(in);
+	fftw_free(out);
+	return plan;
+}
+#endif
+
+/* frees the plan (called without the cache lock) */
+static void nsl_dft_plan_free(nsl_dft_plan *p) {
+#ifdef HAVE_FFTW3
+	if (p->plan != NULL) {
+		NSL_DFT_PLANNER_LOCK;
+		fftw_destroy_plan(p->plan);
+		NSL_DFT_PLANNER_UNLOCK;
+	}
+#else
+	if (p->real != NULL)
+		gsl_fft_real_wavetable_free(p->real);
+	if (p->hc != NULL)
+		gsl_fft_halfcomplex_wavetable_free(p->hc);
+#endif
+	free(p);
+}
+
+/* returns the cached plan for size n or NULL, called with the cache locked */
+static nsl_dft_plan* nsl_dft_plan_find(size_t n, int inverse) {
+	int i;
+	for (i = 0; i < NSL_DFT_CACHE_SIZE; i++) {
+		nsl_dft_plan *c = nsl_dft_cache[i];
+		if (c != NULL && c->n == n && c->inverse == inverse)
+			return c;
+	}
+	return NULL;
+}
+
+#ifdef HAVE_FFTW3
+/* replaces the estimated plan of p by a measured one. The caller is the only user of p and has set p->measuring.
+	The measurement is done without the cache lock, transforms of other sizes are not blocked. */
+static void nsl_dft_plan_measure(nsl_dft_plan *p) {
+	int measured;
+	fftw_plan plan = nsl_dft_fftw_plan(p->n, p->inverse, 1, &measured), old = NULL;
+
+	NSL_DFT_CACHE_LOCK;
+	/* other threads started to use the estimated plan meanwhile: keep it and measure again later */
+	if (plan != NULL && p->users == 1) {
+		old = p->plan;
+		p->plan = plan;
+		p->measured = 1;
+		plan = NULL;
+	}
+	p->measuring = 0;
+	NSL_DFT_CACHE_UNLOCK;
+
+	NSL_DFT_PLANNER_LOCK;
+	if (plan != NULL)
+		fftw_destroy_plan(plan);
+	if (old != NULL)
+		fftw_destroy_plan(old);
+	NSL_DFT_PLANNER_UNLOCK;
+}
+#endif
+
+/* returns the plan for a transform of size n from the cache or creates it.
+	Frequently used FFTW plans are measured. Must be released by nsl_dft_plan_release().
+	Plans are created and measured without the cache lock, so parallel callers don't wait for the planning of other sizes.
+*/
+static nsl_dft_plan* nsl_dft_plan_acquire(size_t n, int inverse) {
+	nsl_dft_plan *p, *evicted = NULL;
+	int i, slot = -1;
+
+	NSL_DFT_CACHE_LOCK;
+	p = nsl_dft_plan_find(n, inverse);
+	if (p != NULL) {
+#ifdef HAVE_FFTW3
+		/* repeated size: replace the estimated plan by a measured one if no other thread uses or measures it */
+		const int measure = (!p->measured && !p->measuring && p->users == 0);
+		if (measure)
+			p->measuring = 1;
+#endif
+		p->users++;
+		p->used = ++nsl_dft_cache_time;
+		NSL_DFT_CACHE_UNLOCK;
+#ifdef HAVE_FFTW3
+		if (measure)
+			nsl_dft_plan_measure(p);
+#endif
+		return p;
+	}
+	NSL_DFT_CACHE_UNLOCK;
+
+	p = (nsl_dft_plan *)calloc(1, sizeof(nsl_dft_plan));
+	if (p == NULL)
+		return NULL;
+	p->n = n;
+	p->inverse = inverse;
+#ifdef HAVE_FFTW3
+	p->plan = nsl_dft_fftw_plan(n, inverse, 0, &p->measured);
+	if (p->plan == NULL) {
+#else
+	if (inverse)
+		p->hc = gsl_fft_halfcomplex_wavetable_alloc(n);
+	else
+		p->real = gsl_fft_real_wavetable_alloc(n);
+	if (p->real == NULL && p->hc == NULL) {
+#endif
+		nsl_dft_plan_free(p);
+		return NULL;
+	}
+
+	NSL_DFT_CACHE_LOCK;
+	/* another thread created the plan meanwhile: use it */
+	nsl_dft_plan *c = nsl_dft_plan_find(n, inverse);
+	if (c != NULL) {
+		c->users++;
+		c->used = ++nsl_dft_cache_time;
+		NSL_DFT_CACHE_UNLOCK;
+		nsl_dft_plan_free(p);
+		return c;
+	}
+
+	/* put into cache if possible: free slot or least recently used unused plan */
+	for (i = 0; i < NSL_DFT_CACHE_SIZE; i++) {
+		c = nsl_dft_cache[i];
+		if (c == NULL)
+			slot = i;
+		else if (c->users == 0 && (slot == -1 || (nsl_dft_cache[slot] != NULL && c->used < nsl_dft_cache[slot]->used)))
+			slot = i;
+	}
+	if (slot != -1) {
+		evicted = nsl_dft_cache[slot];
+		nsl_dft_cache[slot] = p;
+		p->cached = 1;
+	}
+
+	p->users++;
+	p->used = ++nsl_dft_cache_time;
+	NSL_DFT_CACHE_UNLOCK;
+
+	if (evicted != NULL)
+		nsl_dft_plan_free(evicted);
+
+	return p;
+}
+
+static void nsl_dft_plan_release(nsl_dft_plan *p) {
+	int unused;
+
+	NSL_DFT_CACHE_LOCK;
+	p->users--;
+	unused = (!p->cached && p->users == 0);
+	NSL_DFT_CACHE_UNLOCK;
+
+	if (unused)
+		nsl_dft_plan_free(p);
+}
+
+void nsl_dft_cache_clear(void) {
+	nsl_dft_plan *unused[NSL_DFT_CACHE_SIZE];
+	int i, count = 0;
+
+	NSL_DFT_CACHE_LOCK;
+	for (i = 0; i < NSL_DFT_CACHE_SIZE; i++) {
+		nsl_dft_plan *p = nsl_dft_cache[i];
+		if (p == NULL)
+			continue;
+		if (p->users == 0)
+			unused[count++] = p;
+		else	/* still in use, freed on release */
+			p->cached = 0;
+		nsl_dft_cache[i] = NULL;
+	}
+	NSL_DFT_CACHE_UNLOCK;
+
+	for (i = 0; i < count; i++)
+		nsl_dft_plan_free(unused[i]);
+}
+
+int nsl_dft_load_wisdom(const char* filename) {
+#ifdef HAVE_FFTW3
+	FILE *file = fopen(filename, "r");
+	if (file == NULL)
+		return -1;
+
+	NSL_DFT_PLANNER_LOCK;
+	int status = fftw_import_wisdom_from_file(file) ? 0 : -1;
+	NSL_DFT_PLANNER_UNLOCK;
+
+	fclose(file);
+	return status;
+#else
+	(void)filename;
+	return -1;
+#endif
+}
+
+int nsl_dft_save_wisdom(const char* filename) {
+#ifdef HAVE_FFTW3
+	FILE *file = fopen(filename, "w");
+	if (file == NULL)
+		return -1;
+
+	NSL_DFT_PLANNER_LOCK;
+	fftw_export_wisdom_to_file(file);
+	NSL_DFT_PLANNER_UNLOCK;
+
+	return fclose(file) == 0 ? 0 : -1;
+#else
+	(void)filename;
+	return -1;
+#endif
+}
+
+/*********** transforms *********/
+
+int nsl_dft_forward(const double data[], size_t stride, size_t n, double result[]) {
+	size_t i;
+	if (n == 0)
+		return -1;
+
+	nsl_dft_plan *p = nsl_dft_plan_acquire(n, 0);
+	if (p == NULL)
+		return -1;
+
+#ifdef HAVE_FFTW3
+	/* the plan needs arrays with the alignment of fftw_malloc() */
+	double *in = (double *)fftw_malloc(n*sizeof(double));
+	double *out = result;
+	if (fftw_alignment_of(result) != 0)
+		out = (double *)fftw_malloc(2*(n/2+1)*sizeof(double));
+	if (in == NULL || out == NULL) {
+		fftw_free(in);
+		if (out != result)
+			fftw_free(out);
+		nsl_dft_plan_release(p);
+		return -1;
+	}
+
+	for (i = 0; i < n; i++)
+		in[i] = data[i*stride];
+	fftw_execute_dft_r2c(p->plan, in, (fftw_complex *)out);
+
+	fftw_free(in);
+	if (out != result) {
+		memcpy(result, out, 2*(n/2+1)*sizeof(double));
+		fftw_free(out);
+	}
+#else
+	gsl_fft_real_workspace *work = gsl_fft_real_workspace_alloc(n);
+	if (work == NULL) {
+		nsl_dft_plan_release(p);
+		return -1;
+	}
+
+	for (i = 0; i < n; i++)
+		result[i] = data[i*stride];
+	gsl_fft_real_transform(result, 1, n, p->real, work);
+	gsl_fft_real_workspace_free(work);
+
+	/* unpack halfcomplex (re0,re1,im1,re2,im2,...) in place, starting at the end */
+	for (i = n/2; i > 0; i--) {
+		double im = (2*i < n) ? result[2*i] : 0;
+		result[2*i] = result[2*i-1];
+		result[2*i+1] = im;
+	}
+	result[1] = 0;
+#endif
+
+	nsl_dft_plan_release(p);
+	return 0;
+}
+
+int nsl_dft_backward(double data[], size_t n, double result[]) {
+	if (n == 0)
+		return -1;
+
+	nsl_dft_plan *p = nsl_dft_plan_acquire(n, 1);
+	if (p == NULL)
+		return -1;
+
+#ifdef HAVE_FFTW3
+	double *in = data, *out = result;
+	if (fftw_alignment_of(data) != 0)
+		in = (double *)fftw_malloc(2*(n/2+1)*sizeof(double));
+	if (fftw_alignment_of(result) != 0)
+		out = (double *)fftw_malloc(n*sizeof(double));
+	if (in == NULL || out == NULL) {
+		if (in != data)
+			fftw_free(in);
+		if (out != result)
+			fftw_free(out);
+		nsl_dft_plan_release(p);
+		return -1;
+	}
+
+	if (in != data)
+		memcpy(in, data, 2*(n/2+1)*sizeof(double));
+	fftw_execute_dft_c2r(p->plan, (fftw_complex *)in, out);
+
+	if (in != data)
+		fftw_free(in);
+	if (out != result) {
+		memcpy(result, out, n*sizeof(double));
+		fftw_free(out);
+	}
+#else
+	gsl_fft_real_workspace *work = gsl_fft_real_workspace_alloc(n);
+	if (work == NULL) {
+		nsl_dft_plan_release(p);
+		return -1;
+	}
+
+	/* pack into halfcomplex in place */
+	size_t i;
+	for (i = 1; 2*i-1 < n; i++) {
+		data[2*i-1] = data[2*i];
+		if (2*i < n)
+			data[2*i] = data[2*i+1];
+	}
+	gsl_fft_halfcomplex_backward(data, 1, n, p->hc, work);
+	gsl_fft_real_workspace_free(work);
+
+	memcpy(result, data, n*sizeof(double));
+#endif
+
+	nsl_dft_plan_release(p);
+	return 0;
+}
+
 int nsl_dft_transform_window(double data[], size_t stride, size_t n, int two_sided, nsl_dft_result_type type, nsl_sf_window_type window_type) {
 	/* apply window function */
 	if (window_type != nsl_sf_window_uniform)
@@ -51,17 +484,19 @@ int nsl_dft_transform_window(double data[], size_t stride, size_t n, int two_sid
 
 int nsl_dft_transform(double data[], size_t stride, size_t n, int two_sided, nsl_dft_result_type type) {
 	size_t i;
-	double result[2*n];
 	size_t N=n/2;	/* number of resulting data points */
 	if(two_sided)
 		N=n;
-#ifdef HAVE_FFTW3
-	/* stride ignored */
-	(void)stride;
 
-	fftw_plan plan = fftw_plan_dft_r2c_1d(n, data, (fftw_complex *) result, FFTW_ESTIMATE);
-	fftw_execute(plan);
-	fftw_destroy_plan(plan);
+	/* 1. transform (result contains re0,im0,re1,im1,...) */
+	double *result = (double *)malloc(2*n*sizeof(double));
+	if (result == NULL)
+		return -1;
+	int status = nsl_dft_forward(data, stride, n, result);
+	if (status != 0) {
+		free(result);
+		return status;
+	}
 
 	/* 2. unpack data */
 	if(two_sided) {
@@ -69,23 +504,9 @@ int nsl_dft_transform(double data[], size_t stride, size_t n, int two_sided, nsl
 			result[2*(n - i)] = result[2*i];
 			result[2*(n - i)+1] = -result[2*i+1];
 		}
-		if (i == n - i) {
-			result[2*i] = result[2*(n-1)];
+		if (i == n - i)	/* Nyquist frequency */
 			result[2*i+1] = 0;
-		}
 	}
-#else
-	/* 1. transform */
-	gsl_fft_real_wavetable *real = gsl_fft_real_wavetable_alloc(n);
-	gsl_fft_real_workspace *work = gsl_fft_real_workspace_alloc(n);
-
-	gsl_fft_real_transform(data, stride, n, real, work);
-	gsl_fft_real_wavetable_free(real);
-	gsl_fft_real_workspace_free(work);
-
-	/* 2. unpack data */
-	gsl_fft_halfcomplex_unpack(data, result, stride, n);
-#endif
 
 	/* 3. write result */
 	switch(type) {
@@ -153,10 +574,17 @@ int nsl_dft_transform(double data[], size_t stride, size_t n, int two_sided, nsl
 				data[i] *= 4.;
 		}
 		break;
-	case nsl_dft_result_raw:
+	case nsl_dft_result_raw:	/* halfcomplex (re0,re1,im1,re2,im2,...) */
+		data[0] = result[0];
+		for (i = 1; 2*i-1 < n; i++) {
+			data[2*i-1] = result[2*i];
+			if (2*i < n)
+				data[2*i] = result[2*i+1];
+		}
 		break;
 	}
 
+	free(result);
 	return 0;
 }
 
@@ -43,7 +43,7 @@
 	normdB = dB - max(dB)
 	squaremagnitude = magnitude^2
 	squareamplitude = amplitude^2 aka MSA
-	raw = halfcomplex GSL output (TODO: FFTW)
+	raw = halfcomplex output (re0,re1,im1,re2,im2,...) as of GSL
 	TODO: PSD (aka TISA), normdB
  */
 #define NSL_DFT_RESULT_TYPE_COUNT 11
@@ -56,6 +56,21 @@ extern const char* nsl_dft_result_type_name[];
 typedef enum {nsl_dft_xscale_frequency, nsl_dft_xscale_index, nsl_dft_xscale_period} nsl_dft_xscale; 
 extern const char* nsl_dft_xscale_name[];
 
+/* forward FFT of n real values data[i*stride].
+	result (size 2*(n/2+1)) contains the non-negative frequencies re0,im0,re1,im1,...
+	Plans (FFTW) and wavetables (GSL) are cached and can be used from several threads.
+*/
+int nsl_dft_forward(const double data[], size_t stride, size_t n, double result[]);
+/* backward FFT (not normalized) of the n/2+1 complex values data as given by nsl_dft_forward() into n real values result.
+	data is destroyed
+*/
+int nsl_dft_backward(double data[], size_t n, double result[]);
+/* free all cached plans */
+void nsl_dft_cache_clear(void);
+/* import/export the FFTW wisdom of measured plans from/to filename (only with FFTW) */
+int nsl_dft_load_wisdom(const char* filename);
+int nsl_dft_save_wisdom(const char* filename);
+
 /* transform data of size n. result in data 
 	calculates the two-sided DFT
 */
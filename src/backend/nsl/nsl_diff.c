@@ -32,6 +32,10 @@
 #include "nsl_diff.h"
 #include "nsl_common.h"
 #include "nsl_sf_poly.h"
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 const char* nsl_diff_deriv_order_name[] = {i18n("first"), i18n("second"), i18n("third"), i18n("fourth"), i18n("fifth"), i18n("sixth")};
 
@@ -39,29 +43,128 @@ double nsl_diff_first_central(double xm, double fm, double xp, double fp) {
 	return (fp - fm)/(xp - xm);
 }
 
-int nsl_diff_deriv_first_equal(const double *x, double *y, const size_t n) {
+/* number of points processed in one block (original values are buffered on the stack) */
+#define NSL_DIFF_BLOCK_SIZE 2048
+/* minimum number of points processed by one thread */
+#define NSL_DIFF_CHUNK_SIZE 100000
+
+/* 3-point stencil: out[i] for the points x[i] (i=0..n-1) from the original values y[i-1], y[i], y[i+1].
+	scale is a constant of the stencil */
+typedef void (*nsl_diff_stencil)(const double * restrict x, const double * restrict y, double * restrict out, size_t n, double scale);
+
+/* applies the stencil to the inner points y[1..n-2] in place, y[0] and y[n-1] are not changed.
+	The points are divided into chunks processed in parallel. The values at the borders of the chunks are saved first,
+	inside a chunk the original values of a block are copied to a buffer before the block is overwritten.
+	So the stencil loops work on separate arrays and are vectorized. */
+static int nsl_diff_stencil_inplace(const double *x, double *y, const size_t n, nsl_diff_stencil stencil, double scale) {
 	if (n < 3)
 		return -1;
 
-	double dy=0, oldy=0, oldy2=0;
-	size_t i;
-	for (i=0; i < n; i++) {
-		if (i == 0)	/* forward */
-			dy = (-y[2] + 4.*y[1] - 3.*y[0])/(x[2]-x[0]);
-		else if (i == n-1) {	/* backward */
-			y[i] = (3.*y[i] - 4.*y[i-1] + y[i-2])/(x[i]-x[i-2]);
-			y[i-1] = oldy;
+	const size_t ninner = n - 2;
+	int c, nchunks = 1;
+#ifdef _OPENMP
+	nchunks = omp_get_max_threads();
+	if (ninner/NSL_DIFF_CHUNK_SIZE < (size_t)nchunks)
+		nchunks = (int)(ninner/NSL_DIFF_CHUNK_SIZE);
+	if (nchunks < 1)
+		nchunks = 1;
+#endif
+
+	/* original values left and right of the chunks (overwritten by the neighbour chunks) */
+	double *border = (double *)malloc(2*nchunks*sizeof(double));
+	if (border == NULL)
+		return -1;
+	for (c = 0; c < nchunks; c++) {
+		border[2*c] = y[c*ninner/nchunks];
+		border[2*c+1] = y[(c+1)*ninner/nchunks + 1];
+	}
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nchunks) if(nchunks > 1)
+#endif
+	for (c = 0; c < nchunks; c++) {
+		const size_t start = 1 + c*ninner/nchunks, end = 1 + (c+1)*ninner/nchunks;
+		double buf[NSL_DIFF_BLOCK_SIZE + 2];
+		double left = border[2*c];
+		size_t i;
+		for (i = start; i < end; i += NSL_DIFF_BLOCK_SIZE) {
+			const size_t len = (end - i < NSL_DIFF_BLOCK_SIZE) ? end - i : NSL_DIFF_BLOCK_SIZE;
+			buf[0] = left;
+			memcpy(buf + 1, y + i, len*sizeof(double));
+			buf[len + 1] = (i + len < end) ? y[i + len] : border[2*c+1];
+			left = buf[len];
+
+			stencil(x + i, buf + 1, y + i, len, scale);
 		}
-		else
-			dy = (y[i+1]-y[i-1])/(x[i+1]-x[i-1]);
+	}
+
+	free(border);
+	return 0;
+}
+
+/* first derivative, 3-point (second order) on a uniform grid. scale = 1/(2h) */
+static void nsl_diff_first_deriv_equal_stencil(const double * restrict x, const double * restrict y, double * restrict out, size_t n, double scale) {
+	size_t i;
+	(void)x;
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+	for (i = 0; i < n; i++)
+		out[i] = (y[i+1] - y[i-1])*scale;
+}
+
+/* first derivative, 3-point (second order) on a non-uniform grid (derivative of the Lagrange polynomial at the center) */
+static void nsl_diff_first_deriv_second_order_stencil(const double * restrict x, const double * restrict y, double * restrict out, size_t n, double scale) {
+	size_t i;
+	(void)scale;
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+	for (i = 0; i < n; i++) {
+		const double h1 = x[i] - x[i-1], h2 = x[i+1] - x[i];
+		const double h12 = h1 + h2;
+		out[i] = -y[i-1]*h2/(h1*h12) + y[i]*(h2 - h1)/(h1*h2) + y[i+1]*h1/(h12*h2);
+	}
+}
 
-		if (i > 1)
-			y[i-2] = oldy2;
-		if (i > 0 && i < n-1)
-			oldy2 = oldy;
+/* first derivative, average of left and right difference */
+static void nsl_diff_first_deriv_avg_stencil(const double * restrict x, const double * restrict y, double * restrict out, size_t n, double scale) {
+	size_t i;
+	(void)scale;
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+	for (i = 0; i < n; i++)
+		out[i] = ( (y[i+1] - y[i])/(x[i+1] - x[i]) + (y[i] - y[i-1])/(x[i] - x[i-1]) )/2.;
+}
 
-		oldy = dy;
+/* second derivative, 3-point (first order) on a non-uniform grid */
+static void nsl_diff_second_deriv_first_order_stencil(const double * restrict x, const double * restrict y, double * restrict out, size_t n, double scale) {
+	size_t i;
+	(void)scale;
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+	for (i = 0; i < n; i++) {
+		const double h1 = x[i] - x[i-1], h2 = x[i+1] - x[i];
+		const double h12 = h1 + h2;
+		out[i] = 2.*( y[i-1]/(h1*h12) - y[i]/(h1*h2) + y[i+1]/(h12*h2) );
 	}
+}
+
+int nsl_diff_first_deriv_equal(const double *x, double *y, const size_t n) {
+	if (n < 3)
+		return -1;
+
+	const double h = (x[n-1] - x[0])/(n - 1);
+	/* 3-point forward and backward */
+	const double dy0 = (-y[2] + 4.*y[1] - 3.*y[0])/(2.*h);
+	const double dyn = (3.*y[n-1] - 4.*y[n-2] + y[n-3])/(2.*h);
+
+	if (nsl_diff_stencil_inplace(x, y, n, nsl_diff_first_deriv_equal_stencil, 1./(2.*h)) != 0)
+		return -1;
+	y[0] = dy0;
+	y[n-1] = dyn;
 
 	return 0;
 }
@@ -85,32 +188,21 @@ int nsl_diff_first_deriv_second_order(const double *x, double *y, const size_t n
 	if (n < 3)
 		return -1;
 
-	double dy=0, oldy=0, oldy2=0, xdata[3], ydata[3];
-	size_t i, j;
-	for (i=0; i < n; i++) {
-		if (i == 0) {
-			/* 3-point forward */
-			for (j=0; j < 3; j++)
-				xdata[j]=x[j], ydata[j]=y[j];
-			dy = nsl_sf_poly_interp_lagrange_2_deriv(x[0], xdata, ydata);
-		} else if (i == n-1) {
-			/* 3-point backward */
-			y[i] = nsl_sf_poly_interp_lagrange_2_deriv(x[i], xdata, ydata);
-			y[i-1] = oldy;
-		} else {
-			/* 3-point center */
-			for (j=0; j < 3; j++)
-				xdata[j]=x[i-1+j], ydata[j]=y[i-1+j];
-			dy = nsl_sf_poly_interp_lagrange_2_deriv(x[i], xdata, ydata);
-		}
-
-		if (i > 1)
-			y[i-2] = oldy2;
-		if (i > 0 && i < n-1)
-			oldy2 = oldy;
-
-		oldy = dy;
-	}
+	/* 3-point forward and backward */
+	double xdata[3], ydata[3];
+	size_t j;
+	for (j=0; j < 3; j++)
+		xdata[j]=x[j], ydata[j]=y[j];
+	const double dy0 = nsl_sf_poly_interp_lagrange_2_deriv(x[0], xdata, ydata);
+	for (j=0; j < 3; j++)
+		xdata[j]=x[n-3+j], ydata[j]=y[n-3+j];
+	const double dyn = nsl_sf_poly_interp_lagrange_2_deriv(x[n-1], xdata, ydata);
+
+	/* 3-point center */
+	if (nsl_diff_stencil_inplace(x, y, n, nsl_diff_first_deriv_second_order_stencil, 0) != 0)
+		return -1;
+	y[0] = dy0;
+	y[n-1] = dyn;
 
 	return 0;
 }
@@ -147,24 +239,16 @@ int nsl_diff_first_deriv_fourth_order(const double *x, double *y, const size_t n
 }
 
 int nsl_diff_first_deriv_avg(const double *x, double *y, const size_t n) {
-	if (n < 1)
+	if (n < 2)
 		return -1;
 
-	size_t i;
-	double dy=0, oldy=0;
-	for (i=0; i<n; i++) {
-		if(i == 0)
-			dy = (y[1]-y[0])/(x[1]-x[0]);
-		else if (i == n-1)
-			y[i] = (y[i]-y[i-1])/(x[i]-x[i-1]);
-		else
-			dy = ( (y[i+1]-y[i])/(x[i+1]-x[i]) + (y[i]-y[i-1])/(x[i]-x[i-1]) )/2.;
-
-		if (i > 0)
-			y[i-1] = oldy;
+	const double dy0 = (y[1]-y[0])/(x[1]-x[0]);
+	const double dyn = (y[n-1]-y[n-2])/(x[n-1]-x[n-2]);
 
-		oldy = dy;
-	}
+	if (n > 2 && nsl_diff_stencil_inplace(x, y, n, nsl_diff_first_deriv_avg_stencil, 0) != 0)
+		return -1;
+	y[0] = dy0;
+	y[n-1] = dyn;
 
 	return 0;
 }
@@ -187,34 +271,11 @@ int nsl_diff_second_deriv(const double *x, double *y, const size_t n, int order)
 }
 
 int nsl_diff_second_deriv_first_order(const double *x, double *y, const size_t n) {
-	if (n < 3)
+	/* 3-point rule, constant for the three points: the boundary points get the value of their neighbour */
+	if (nsl_diff_stencil_inplace(x, y, n, nsl_diff_second_deriv_first_order_stencil, 0) != 0)
 		return -1;
-
-	double dy[3]={0}, xdata[3], ydata[3];
-	size_t i, j;
-	for (i=0; i<n; i++) {
-		if (i == 0)
-			for (j=0; j < 3; j++)
-				xdata[j]=x[j], ydata[j]=y[j];
-		else if (i > 1 && i < n-1)
-			for (j=0; j < 3; j++)
-				xdata[j]=x[i-1+j], ydata[j]=y[i-1+j];
-
-		/* 3-point rule */
-		dy[0] = nsl_sf_poly_interp_lagrange_2_deriv2(xdata, ydata);
-
-		if (i == n-1) {
-			y[i] = dy[0];
-			y[i-1] = dy[1];
-		}
-
-		if (i > 1)
-			y[i-2] = dy[2];
-		if (i > 0)
-			dy[2] = dy[1];
-
-		dy[1] = dy[0];
-	}
+	y[0] = y[1];
+	y[n-1] = y[n-2];
 
 	return 0;
 }
@@ -48,6 +48,9 @@ double nsl_diff_first_central(double xm, double fm, double xp, double fp);
 /* calculates derivative of n points of xy-data.
 	for equal/unequal spaced data.
 	result in y 
+	nsl_diff_first_deriv_equal() assumes a uniform grid, only the first and last x value are used.
+	The 3-point rules (first derivative second order and average, second derivative first order)
+	are vectorized and run in parallel (OpenMP) for large n.
 */
 int nsl_diff_first_deriv_equal(const double *x, double *y, const size_t n);
 int nsl_diff_first_deriv(const double *x, double *y, const size_t n, int order);
@@ -0,0 +1,129 @@
+/***************************************************************************
+    File                 : nsl_diff_int_bench.c
+    Project              : LabPlot
+    Description          : NSL differentiation and integration benchmark
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "nsl_diff.h"
+#include "nsl_int.h"
+
+/* default number of points, can be given as first argument */
+#define N 10000000
+
+static struct timeval time1;
+
+static void start() {
+	gettimeofday(&time1, NULL);
+}
+
+/* prints the run time and the memory bandwidth for nbytes bytes read and written per point */
+static void stop(const char *name, const size_t n, const int nbytes, const double y) {
+	struct timeval time2;
+	gettimeofday(&time2, NULL);
+
+	const unsigned long long ms = 1000ULL * (time2.tv_sec - time1.tv_sec) + (time2.tv_usec - time1.tv_usec) / 1000;
+	printf("%-35s run time : %6llu ms  (%6.2f GB/s, result = %g)\n", name, ms,
+		ms > 0 ? (double)n*nbytes/ms/1.e6 : 0., y);
+}
+
+int main(int argc, char *argv[]) {
+	size_t i, n = N;
+	if (argc > 1)
+		n = (size_t)atol(argv[1]);
+
+	double *xdata = (double *)malloc(n*sizeof(double));
+	double *xuniform = (double *)malloc(n*sizeof(double));
+	double *ydata = (double *)malloc(n*sizeof(double));
+	double *y = (double *)malloc(n*sizeof(double));
+	if (xdata == NULL || xuniform == NULL || ydata == NULL || y == NULL) {
+		printf("ERROR allocating %zu points. Giving up.\n", n);
+		return -1;
+	}
+
+	/* noisy signal on a non-uniform and on a uniform grid */
+	srand(0);
+	double x = 0;
+	for (i = 0; i < n; i++) {
+		x += (0.5 + rand()/(double)RAND_MAX)/1000.;
+		xdata[i] = x;
+		xuniform[i] = i/1000.;
+		ydata[i] = sin(x) + (rand()/(double)RAND_MAX - 0.5)/10.;
+	}
+
+	printf("n = %zu\n", n);
+
+	/* x and y read, y written */
+	memcpy(y, ydata, n*sizeof(double));
+	start();
+	nsl_diff_first_deriv_second_order(xdata, y, n);
+	stop("first derivative (second order)", n, 24, y[n/2]);
+
+	memcpy(y, ydata, n*sizeof(double));
+	start();
+	nsl_diff_first_deriv_equal(xuniform, y, n);
+	stop("first derivative (uniform grid)", n, 16, y[n/2]);
+
+	memcpy(y, ydata, n*sizeof(double));
+	start();
+	nsl_diff_first_deriv_avg(xdata, y, n);
+	stop("first derivative (average)", n, 24, y[n/2]);
+
+	memcpy(y, ydata, n*sizeof(double));
+	start();
+	nsl_diff_second_deriv_first_order(xdata, y, n);
+	stop("second derivative (first order)", n, 24, y[n/2]);
+
+	memcpy(y, ydata, n*sizeof(double));
+	start();
+	nsl_diff_first_deriv_fourth_order(xdata, y, n);
+	stop("first derivative (fourth order)", n, 24, y[n/2]);
+
+	memcpy(y, ydata, n*sizeof(double));
+	start();
+	nsl_int_rectangle(xdata, y, n, 0);
+	stop("integral (rectangle)", n, 24, y[n-1]);
+
+	memcpy(y, ydata, n*sizeof(double));
+	start();
+	nsl_int_trapezoid(xdata, y, n, 0);
+	stop("integral (trapezoid)", n, 24, y[n-1]);
+
+	memcpy(y, ydata, n*sizeof(double));
+	start();
+	nsl_int_trapezoid(xdata, y, n, 1);
+	stop("area (trapezoid)", n, 24, y[n-1]);
+
+	free(xdata);
+	free(xuniform);
+	free(ydata);
+	free(y);
+
+	return 0;
+}
@@ -40,7 +40,7 @@ int main() {
 
 	printf("expecting 2*x as derivative (second order):\n");
 	double ydata[]={1,4,16,64,256,1024,4096};
-	/*int status = nsl_diff_deriv_first_equal(xdata, ydata, n);*/
+	/*int status = nsl_diff_first_deriv_equal(xdata, ydata, n);*/
 	int status = nsl_diff_first_deriv(xdata, ydata, n, 2);
 
 	size_t i;
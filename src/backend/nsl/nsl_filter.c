@@ -29,12 +29,8 @@
 #include "nsl_filter.h"
 #include "nsl_common.h"
 #include "nsl_sf_poly.h"
+#include "nsl_dft.h"
 #include <gsl/gsl_sf_pow_int.h>
-#include <gsl/gsl_fft_real.h>
-#include <gsl/gsl_fft_halfcomplex.h>
-#ifdef HAVE_FFTW3
-#include <fftw3.h>
-#endif
 
 const char* nsl_filter_type_name[] = { i18n("Low pass"), i18n("High pass"), i18n("Band pass"), i18n("Band reject") };
 const char* nsl_filter_form_name[] = { i18n("Ideal"), i18n("Butterworth"), i18n("Chebyshev type I"), i18n("Chebyshev type II"), i18n("Legendre (Optimum L)"), i18n("Bessel (Thomson)") };
@@ -266,42 +262,31 @@ void print_fdata(double data[], size_t n) {
 }
 
 int nsl_filter_fourier(double data[], size_t n, nsl_filter_type type, nsl_filter_form form, int order, int cutindex, int bandwidth) {
-	/* 1. transform */
-	double fdata[2*n];	/* contains re0,im0,re1,im1,re2,im2,... */
-#ifdef HAVE_FFTW3
-        fftw_plan plan = fftw_plan_dft_r2c_1d(n, data, (fftw_complex *) fdata, FFTW_ESTIMATE);
-        fftw_execute(plan);
-	fftw_destroy_plan(plan);
-#else
-	gsl_fft_real_wavetable *real = gsl_fft_real_wavetable_alloc(n);
-	gsl_fft_real_workspace *work = gsl_fft_real_workspace_alloc(n);
-
-	gsl_fft_real_transform(data, 1, n, real, work);
-	gsl_fft_real_wavetable_free(real);
+	size_t i;
 
-	gsl_fft_halfcomplex_unpack(data, fdata, 1, n);
-#endif
+	/* 1. transform */
+	double *fdata = (double *)malloc(2*(n/2+1)*sizeof(double));	/* contains re0,im0,re1,im1,re2,im2,... */
+	if (fdata == NULL)
+		return -1;
+	int status = nsl_dft_forward(data, 1, n, fdata);
+	if (status != 0) {
+		free(fdata);
+		return status;
+	}
 
 	/* 2. apply filter */
 	/*print_fdata(fdata, n);*/
-	int status = nsl_filter_apply(fdata, n, type, form, order, cutindex, bandwidth);
+	status = nsl_filter_apply(fdata, n, type, form, order, cutindex, bandwidth);
 	/*print_fdata(fdata, n);*/
-	
+
 	/* 3. back transform */
-#ifdef HAVE_FFTW3
-        plan = fftw_plan_dft_c2r_1d(n, (fftw_complex *) fdata, data, FFTW_ESTIMATE);
-        fftw_execute(plan);
-	fftw_destroy_plan(plan);
+	if (nsl_dft_backward(fdata, n, data) != 0)
+		status = -1;
+	free(fdata);
+
 	/* normalize*/
-	size_t i;
 	for (i=0; i < n; i++)
 		data[i] /= n;
-#else
-	gsl_fft_halfcomplex_wavetable *hc = gsl_fft_halfcomplex_wavetable_alloc(n);
-	gsl_fft_halfcomplex_inverse(data, 1, n, hc, work);
-	gsl_fft_halfcomplex_wavetable_free(hc);
-	gsl_fft_real_workspace_free (work);
-#endif
 
 	return status;
 }
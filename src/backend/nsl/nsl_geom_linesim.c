@@ -29,7 +29,6 @@
 #include "nsl_geom_linesim.h"
 #include "nsl_geom.h"
 #include "nsl_common.h"
-#include "nsl_sort.h"
 #include "nsl_stats.h"
 
 const char* nsl_geom_linesim_type_name[] = {i18n("Douglas-Peucker (number)"), i18n("Douglas-Peucker (tolerance)"), i18n("Visvalingam-Whyatt"), i18n("Reumann-Witkam"), i18n("perpendicular distance"), i18n("n-th point"),
@@ -121,48 +120,100 @@ double nsl_geom_linesim_avg_dist_perpoint(const double xdata[], const double yda
 
 /*********** simplification algorithms *********/
 
-void nsl_geom_linesim_douglas_peucker_step(const double xdata[], const double ydata[], const size_t start, const size_t end, size_t *nout, const double tol, size_t index[]) {
-	/*printf("DP: %d - %d\n", start, end);*/
+/* minimum size of a segment processed by a separate (OpenMP) task in Douglas-Peucker */
+#define NSL_GEOM_LINESIM_TASK_SIZE 10000
 
+/* point between start and end with the biggest perpendicular distance (maxdist) to the line from start to end */
+static size_t nsl_geom_linesim_douglas_peucker_key(const double xdata[], const double ydata[], const size_t start, const size_t end, double *maxdist) {
 	size_t i, nkey = start;
-	double dist, maxdist = 0;
-	/* search for key (biggest perp. distance) */
+	double dist;
+
+	*maxdist = 0;
 	for (i = start+1; i < end; i++) {
 		dist = nsl_geom_point_line_dist(xdata[start], ydata[start], xdata[end], ydata[end], xdata[i], ydata[i]);
-		if (dist > maxdist) {
-			maxdist=dist;
-			nkey=i;
+		if (dist > *maxdist) {
+			*maxdist = dist;
+			nkey = i;
 		}
 	}
-	/*printf("maxdist = %g @ i = %zu\n", maxdist, nkey);*/
-
-	if (maxdist > tol) {
-		/*printf("take %d\n", nkey);*/
-		index[(*nout)++]=nkey;
-		if (nkey-start > 1)
-			nsl_geom_linesim_douglas_peucker_step(xdata, ydata, start, nkey, nout, tol, index);
-		if (end-nkey > 1)
-			nsl_geom_linesim_douglas_peucker_step(xdata, ydata, nkey, end, nout, tol, index);
+
+	return nkey;
+}
+
+/* marks all keys between start and end in keep[].
+	Works iteratively with a stack of pending segments. Big segments are handed over to other threads as tasks.
+*/
+static void nsl_geom_linesim_douglas_peucker_step(const double xdata[], const double ydata[], size_t start, size_t end, const double tol, unsigned char keep[]) {
+	size_t *stack = NULL, nstack = 0, stacksize = 0;
+
+	for (;;) {
+		if (end - start > 1) {
+			double maxdist;
+			size_t key = nsl_geom_linesim_douglas_peucker_key(xdata, ydata, start, end, &maxdist);
+			/*printf("maxdist = %g @ i = %zu\n", maxdist, key);*/
+
+			if (maxdist > tol) {
+				keep[key] = 1;
+
+				/* continue with the first part, the second part is done later or by another thread */
+				if (end - key > NSL_GEOM_LINESIM_TASK_SIZE) {
+#ifdef _OPENMP
+#pragma omp task firstprivate(key, end)
+#endif
+					nsl_geom_linesim_douglas_peucker_step(xdata, ydata, key, end, tol, keep);
+				} else if (end - key > 1) {
+					if (nstack + 2 > stacksize) {
+						size_t *tmp = (size_t *)realloc(stack, 2*(stacksize + 64)*sizeof(size_t));
+						if (tmp == NULL) {	/* continue recursively */
+							nsl_geom_linesim_douglas_peucker_step(xdata, ydata, key, end, tol, keep);
+							end = key;
+							continue;
+						}
+						stack = tmp;
+						stacksize = 2*(stacksize + 64);
+					}
+					stack[nstack++] = key;
+					stack[nstack++] = end;
+				}
+				end = key;
+				continue;
+			}
+		}
+
+		if (nstack == 0)
+			break;
+		end = stack[--nstack];
+		start = stack[--nstack];
 	}
 
-	/*printf("nout=%d\n", *nout);*/
+	free(stack);
 }
 
 size_t nsl_geom_linesim_douglas_peucker(const double xdata[], const double ydata[], const size_t n, const double tol, size_t index[]) {
-	size_t nout = 0;
+	size_t i, nout = 0;
 
-	/*first point*/
-	index[nout++] = 0;
+	if (n == 0)
+		return 0;
 
-	nsl_geom_linesim_douglas_peucker_step(xdata, ydata, 0, n-1, &nout, tol, index);
+	unsigned char *keep = (unsigned char *)calloc(n, sizeof(unsigned char));	/* keys found so far */
+	if (keep == NULL)
+		return 0;
 
-	/* last point */
-	if (index[nout-1] != n-1)
-		index[nout++] = n-1;
+	/* first and last point */
+	keep[0] = keep[n-1] = 1;
 
-	/* sort array index */
-	nsl_sort_size_t(index, nout);
+#ifdef _OPENMP
+#pragma omp parallel if(n > NSL_GEOM_LINESIM_TASK_SIZE)
+#pragma omp single nowait
+#endif
+	nsl_geom_linesim_douglas_peucker_step(xdata, ydata, 0, n-1, tol, keep);
 
+	/* index in ascending order */
+	for (i = 0; i < n; i++)
+		if (keep[i])
+			index[nout++] = i;
+
+	free(keep);
 	return nout;
 }
 size_t nsl_geom_linesim_douglas_peucker_auto(const double xdata[], const double ydata[], const size_t n, size_t index[]) {
@@ -409,76 +460,113 @@ size_t nsl_geom_linesim_interp_auto(const double xdata[], const double ydata[],
 	return nsl_geom_linesim_interp(xdata, ydata, n, tol, index);
 }
 
+/* min-heap of the points ordered by their effective area (first index on equal area).
+	The area is stored in the heap to avoid cache misses when sifting.
+*/
+typedef struct {
+	double area;
+	size_t point;
+} nsl_geom_linesim_area_heap_entry;
+
+typedef struct {
+	nsl_geom_linesim_area_heap_entry *entry;
+	size_t *pos;	/* heap position of point */
+	size_t size;
+} nsl_geom_linesim_area_heap;
+
+static int nsl_geom_linesim_area_heap_less(const nsl_geom_linesim_area_heap_entry *a, const nsl_geom_linesim_area_heap_entry *b) {
+	return a->area < b->area || (a->area == b->area && a->point < b->point);
+}
+
+/* move entry e down from heap position i to its place.
+	Four children per node keep the heap flat and the children in one cache line.
+*/
+static void nsl_geom_linesim_area_heap_down(nsl_geom_linesim_area_heap *h, size_t i, nsl_geom_linesim_area_heap_entry e) {
+	for (;;) {
+		size_t child = 4*i + 1, last = (child + 4 < h->size) ? child + 4 : h->size, min = child, c;
+		if (child >= h->size)
+			break;
+		for (c = child + 1; c < last; c++)
+			if (nsl_geom_linesim_area_heap_less(&h->entry[c], &h->entry[min]))
+				min = c;
+		if (!nsl_geom_linesim_area_heap_less(&h->entry[min], &e))
+			break;
+		h->entry[i] = h->entry[min];
+		h->pos[h->entry[i].point] = i;
+		i = min;
+	}
+	h->entry[i] = e;
+	h->pos[e.point] = i;
+}
+
 size_t nsl_geom_linesim_visvalingam_whyatt(const double xdata[], const double ydata[], const size_t n, const double tol, size_t index[]) {
 	size_t i, nout = n;
 
-	double *area = (double *) malloc((n-2)*sizeof(double));	/* area associated with every point */
-	for (i = 0; i < n; i++)
-		index[i] = i;
-	for (i = 1; i < n-1; i++)
-		area[i-1] = nsl_geom_three_point_area(xdata[i-1], ydata[i-1], xdata[i], ydata[i], xdata[i+1], ydata[i+1]);
-
-	double minarea;
-	size_t minindex;
-	while ( (minarea = nsl_stats_minimum(area, n-2, &minindex)) < tol && nout > 2) {
-		/*for (i=0; i < n-2; i++)
-			if (area[i]<DBL_MAX)
-				printf("area[%zu] = %g\n", i, area[i]);
-		*/
-		/* remove point minindex */
-		/*printf("removing point %zu (minindex = %zu, minarea = %g) nout=%zu\n", minindex+1, minindex, minarea, nout-1);*/
-		index[minindex+1] = 0;
-		area[minindex] = DBL_MAX;
-		double tmparea;
-		/* update area of neigbor points */
-		size_t before = minindex, after = minindex+2;	/* find index before and after */
-		while (index[before] == 0 && before > 0)
-			before--;
-		while (index[after] == 0 && after < n-1)
-			after++;
-		if (minindex > 0) {	/*before */
-			if (before > 0) {
-				size_t beforebefore=before-1;
-				while (index[beforebefore] == 0 && beforebefore > 0)
-					beforebefore--;
-				/*printf("recalculate area[%zu] from %zu %zu %zu\n", before-1, beforebefore, before, after);*/
-				tmparea = nsl_geom_three_point_area(xdata[beforebefore], ydata[beforebefore], xdata[before], ydata[before], xdata[after], ydata[after]);
-				if (tmparea > area[before-1])	/* take largest value of new and old area */
-					area[before-1] = tmparea;
-			}
+	if (n < 3) {
+		for (i = 0; i < n; i++)
+			index[i] = i;
+		return n;
+	}
+
+	/* heap of the areas associated with every point and neighbors of the remaining points */
+	nsl_geom_linesim_area_heap heap;
+	heap.entry = (nsl_geom_linesim_area_heap_entry *)malloc((n-2)*sizeof(nsl_geom_linesim_area_heap_entry));
+	heap.pos = (size_t *)malloc(3*n*sizeof(size_t));
+	heap.size = n-2;
+	if (heap.entry == NULL || heap.pos == NULL) {
+		free(heap.entry);
+		free(heap.pos);
+		return 0;
+	}
+	size_t *prev = heap.pos + n, *next = heap.pos + 2*n;
+
+	for (i = 0; i < n; i++) {
+		prev[i] = (i > 0) ? i-1 : 0;
+		next[i] = (i < n-1) ? i+1 : n-1;
+	}
+	for (i = 1; i < n-1; i++) {
+		heap.entry[i-1].area = nsl_geom_three_point_area(xdata[i-1], ydata[i-1], xdata[i], ydata[i], xdata[i+1], ydata[i+1]);
+		heap.entry[i-1].point = i;
+		heap.pos[i] = i-1;
+	}
+	for (i = (heap.size+2)/4; i > 0; i--)
+		nsl_geom_linesim_area_heap_down(&heap, i-1, heap.entry[i-1]);
+
+	while (nout > 2 && heap.entry[0].area < tol) {
+		/* remove point with minimum area */
+		size_t point = heap.entry[0].point;
+		/*printf("removing point %zu (area = %g) nout=%zu\n", point, heap.entry[0].area, nout-1);*/
+		heap.size--;
+		nsl_geom_linesim_area_heap_down(&heap, 0, heap.entry[heap.size]);
+
+		size_t before = prev[point], after = next[point];
+		next[before] = after;
+		prev[after] = before;
+
+		/* update area of neighbor points (take largest value of new and old area) */
+		nsl_geom_linesim_area_heap_entry e;
+		if (before > 0) {
+			e = heap.entry[heap.pos[before]];
+			e.area = nsl_geom_three_point_area(xdata[prev[before]], ydata[prev[before]], xdata[before], ydata[before], xdata[after], ydata[after]);
+			if (e.area > heap.entry[heap.pos[before]].area)
+				nsl_geom_linesim_area_heap_down(&heap, heap.pos[before], e);
 		}
-		if (minindex < n-3) {	/* after */
-			if (after < n-1) {
-				size_t afterafter = after+1;
-				while (index[afterafter] == 0 && afterafter < n-1)
-					afterafter++;
-				/*printf("recalculate area[%zu] from %zu %zu %zu\n",after-1, before, after, afterafter);*/
-				tmparea = nsl_geom_three_point_area(xdata[before], ydata[before], xdata[after], ydata[after], xdata[afterafter], ydata[afterafter]);
-				if (tmparea > area[after-1])	/* take largest value of new and old area */
-					area[after-1] = tmparea;
-			}
+		if (after < n-1) {
+			e = heap.entry[heap.pos[after]];
+			e.area = nsl_geom_three_point_area(xdata[before], ydata[before], xdata[after], ydata[after], xdata[next[after]], ydata[next[after]]);
+			if (e.area > heap.entry[heap.pos[after]].area)
+				nsl_geom_linesim_area_heap_down(&heap, heap.pos[after], e);
 		}
 		nout--;
-	};
-
-	/*for(i=0;i<n;i++)
-		printf("INDEX = %d\n", index[i]);
-	*/
-
-	/* condens index */
-	i = 1;
-	size_t newi = 1;
-	while (newi < n-1) {
-		while (index[newi] == 0)
-			newi++;
-		index[i++] = index[newi++];
-	};
-
-	/*for(i=0;i<nout;i++)
-		printf("INDEX2 = %d\n", index[i]);
-	*/
-
-	free(area);
+	}
+
+	/* remaining points */
+	for (i = 0, nout = 0; i < n-1; i = next[i])
+		index[nout++] = i;
+	index[nout++] = n-1;
+
+	free(heap.entry);
+	free(heap.pos);
 	return nout;
 }
 size_t nsl_geom_linesim_visvalingam_whyatt_auto(const double xdata[], const double ydata[], const size_t n, size_t index[]) {
@@ -0,0 +1,125 @@
+/***************************************************************************
+    File                 : nsl_geom_linesim_bench.c
+    Project              : LabPlot
+    Description          : NSL line simplification benchmark
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+#include "nsl_geom_linesim.h"
+
+/* default number of points, can be given as first argument */
+#define N 1000000
+#define NOUT 1000
+
+static struct timeval time1;
+
+static void start() {
+	gettimeofday(&time1, NULL);
+}
+
+static void stop(const char *name, const double xdata[], const double ydata[], const size_t n, const size_t nout, const size_t index[]) {
+	struct timeval time2;
+	gettimeofday(&time2, NULL);
+
+	printf("%-30s nout = %8zu  run time : %6llu ms  (pos. error = %g, area error = %g)\n", name, nout,
+		1000ULL * (time2.tv_sec - time1.tv_sec) + (time2.tv_usec - time1.tv_usec) / 1000,
+		nsl_geom_linesim_positional_squared_error(xdata, ydata, n, index), nsl_geom_linesim_area_error(xdata, ydata, n, index));
+}
+
+int main(int argc, char *argv[]) {
+	size_t i, nout, n = N;
+	if (argc > 1)
+		n = (size_t)atol(argv[1]);
+
+	double *xdata = (double *)malloc(n*sizeof(double));
+	double *ydata = (double *)malloc(n*sizeof(double));
+	size_t *index = (size_t *)malloc(n*sizeof(size_t));
+	if (xdata == NULL || ydata == NULL || index == NULL) {
+		printf("ERROR allocating %zu points. Giving up.\n", n);
+		return -1;
+	}
+
+	/* noisy signal: oscillation with random walk */
+	srand(0);
+	double walk = 0;
+	for (i = 0; i < n; i++) {
+		walk += (rand()/(double)RAND_MAX - 0.5)/10.;
+		xdata[i] = i/1000.;
+		ydata[i] = sin(xdata[i]) + walk;
+	}
+
+	printf("n = %zu\n", n);
+	printf("automatic tol clip_diag_perpoint = %g\n", nsl_geom_linesim_clip_diag_perpoint(xdata, ydata, n));
+	printf("automatic tol clip_area_perpoint = %g\n", nsl_geom_linesim_clip_area_perpoint(xdata, ydata, n));
+	printf("automatic tol avg_dist = %g\n", nsl_geom_linesim_avg_dist_perpoint(xdata, ydata, n));
+
+	start();
+	nout = nsl_geom_linesim_douglas_peucker_auto(xdata, ydata, n, index);
+	stop("Douglas-Peucker", xdata, ydata, n, nout, index);
+
+	start();
+	nsl_geom_linesim_douglas_peucker_variant(xdata, ydata, n, NOUT, index);
+	stop("Douglas-Peucker (number)", xdata, ydata, n, NOUT, index);
+
+	start();
+	nout = nsl_geom_linesim_visvalingam_whyatt_auto(xdata, ydata, n, index);
+	stop("Visvalingam-Whyatt", xdata, ydata, n, nout, index);
+
+	start();
+	nout = nsl_geom_linesim_reumann_witkam_auto(xdata, ydata, n, index);
+	stop("Reumann-Witkam", xdata, ydata, n, nout, index);
+
+	start();
+	nout = nsl_geom_linesim_perpdist_auto(xdata, ydata, n, index);
+	stop("perpendicular distance", xdata, ydata, n, nout, index);
+
+	start();
+	nout = nsl_geom_linesim_nthpoint(n, 10, index);
+	stop("n-th point", xdata, ydata, n, nout, index);
+
+	start();
+	nout = nsl_geom_linesim_raddist_auto(xdata, ydata, n, index);
+	stop("radial distance", xdata, ydata, n, nout, index);
+
+	start();
+	nout = nsl_geom_linesim_interp_auto(xdata, ydata, n, index);
+	stop("Interpolation", xdata, ydata, n, nout, index);
+
+	start();
+	nout = nsl_geom_linesim_opheim_auto(xdata, ydata, n, index);
+	stop("Opheim", xdata, ydata, n, nout, index);
+
+	start();
+	nout = nsl_geom_linesim_lang(xdata, ydata, n, nsl_geom_linesim_clip_diag_perpoint(xdata, ydata, n), 10, index);
+	stop("Lang", xdata, ydata, n, nout, index);
+
+	free(xdata);
+	free(ydata);
+	free(index);
+
+	return 0;
+}
@@ -32,50 +32,133 @@
 #include "nsl_int.h"
 #include "nsl_common.h"
 #include "nsl_sf_poly.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 const char* nsl_int_method_name[] = {i18n("rectangle (1-point)"), i18n("trapezoid (2-point)"), i18n("Simpson's (3-point)"), i18n("Simpson's 3/8 (4-point)")};
 
-int nsl_int_rectangle(const double *x, double *y, const size_t n, int abs) {
-	if (n == 0)
-		return -1;
+/* number of segments processed in one block */
+#define NSL_INT_BLOCK_SIZE 2048
+/* minimum number of points processed by one thread */
+#define NSL_INT_CHUNK_SIZE 100000
+
+/* area of the trapezoid with the width dx and the values y0, y1 (absolute area if abs != 0, see nsl_sf_poly_interp_lagrange_1_absint()) */
+static inline double nsl_int_trapezoid_area(double dx, double y0, double y1, int abs) {
+	if (abs && y0*y1 < 0)	/* sign change */
+		return dx*( (fabs(y0)-fabs(y1))/(fabs(y1/y0)+1) + fabs(y1) )/2.;
+	if (abs && y0 < 0 && y1 < 0)
+		return dx*(fabs(y0)+fabs(y1))/2.;
+	return dx*(y0+y1)/2.;
+}
 
-	size_t i, j;
-	double s, sum=0, xdata[2];
-	for (i = 0; i < n-1; i++) {
-		for (j=0; j < 2; j++)
-			xdata[j] = x[i+j];
-		s = nsl_sf_poly_interp_lagrange_0_int(xdata, y[i]);
+/* areas of the n segments [x[i],x[i+1]] (i=0..n-1) with the values y[0..n-1] and ylast = y[n] */
+static void nsl_int_areas(const double * restrict x, const double * restrict y, double ylast, double * restrict area, size_t n, nsl_int_method_type method, int abs) {
+	size_t i;
+	if (method == nsl_int_method_rectangle) {
 		if (abs)
-			s = fabs(s);
-		y[i] = sum;
-		sum += s;
+			for (i = 0; i < n; i++)
+				area[i] = fabs((x[i+1] - x[i])*y[i]);
+		else
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+			for (i = 0; i < n; i++)
+				area[i] = (x[i+1] - x[i])*y[i];
+		return;
 	}
-	y[n-1] = sum;
 
-	return 0;
+	/* trapezoid */
+	if (abs)
+		for (i = 0; i < n - 1; i++)
+			area[i] = nsl_int_trapezoid_area(x[i+1] - x[i], y[i], y[i+1], 1);
+	else
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+		for (i = 0; i < n - 1; i++)
+			area[i] = (x[i+1] - x[i])*(y[i] + y[i+1])/2.;
+	area[n-1] = nsl_int_trapezoid_area(x[n] - x[n-1], y[n-1], ylast, abs);
 }
 
-int nsl_int_trapezoid(const double *x, double *y, const size_t n, int abs) {
-	if (n < 2)
+/* cumulative integral (rectangle or trapezoid rule) in place: y[i] = sum of the areas of the segments before x[i].
+	Parallel prefix sum: the chunks are integrated in parallel starting at 0, then the sum of the preceding chunks is added.
+	Inside a chunk the areas of a block are calculated (vectorized) before the block is overwritten. */
+static int nsl_int_cumulative(const double *x, double *y, const size_t n, nsl_int_method_type method, int abs) {
+	const size_t nseg = n - 1;
+	int c, nchunks = 1;
+#ifdef _OPENMP
+	nchunks = omp_get_max_threads();
+	if (nseg/NSL_INT_CHUNK_SIZE < (size_t)nchunks)
+		nchunks = (int)(nseg/NSL_INT_CHUNK_SIZE);
+	if (nchunks < 1)
+		nchunks = 1;
+#endif
+
+	/* original first value of the following chunk and sum of each chunk */
+	double *border = (double *)malloc(2*nchunks*sizeof(double));
+	if (border == NULL)
 		return -1;
+	for (c = 0; c < nchunks; c++)
+		border[2*c] = y[(c+1)*nseg/nchunks];
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nchunks) if(nchunks > 1)
+#endif
+	for (c = 0; c < nchunks; c++) {
+		const size_t start = c*nseg/nchunks, end = (c+1)*nseg/nchunks;
+		double area[NSL_INT_BLOCK_SIZE];
+		double sum = 0;
+		size_t i, j;
+		for (i = start; i < end; i += NSL_INT_BLOCK_SIZE) {
+			const size_t len = (end - i < NSL_INT_BLOCK_SIZE) ? end - i : NSL_INT_BLOCK_SIZE;
+			nsl_int_areas(x + i, y + i, (i + len < end) ? y[i + len] : border[2*c], area, len, method, abs);
+			for (j = 0; j < len; j++) {
+				y[i + j] = sum;
+				sum += area[j];
+			}
+		}
+		border[2*c+1] = sum;
+	}
 
-	size_t i, j;
-	double sum=0, xdata[2], ydata[2];
-	for (i = 0; i < n-1; i++) {
-		for (j=0; j < 2; j++)
-			xdata[j] = x[i+j], ydata[j] = y[i+j];
-		y[i] = sum;
-		if (abs)
-			sum += nsl_sf_poly_interp_lagrange_1_absint(xdata, ydata);
-		else
-			sum += nsl_sf_poly_interp_lagrange_1_int(xdata, ydata);
+	/* add the sums of the preceding chunks */
+	for (c = 1; c < nchunks; c++)
+		border[2*c+1] += border[2*c-1];
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nchunks) if(nchunks > 1)
+#endif
+	for (c = 1; c < nchunks; c++) {
+		const size_t start = c*nseg/nchunks, end = (c+1)*nseg/nchunks;
+		const double offset = border[2*c-1];
+		size_t i;
+		for (i = start; i < end; i++)
+			y[i] += offset;
 	}
-	y[n-1] = sum;
+	y[n-1] = border[2*nchunks-1];
 
+	free(border);
 	return 0;
 }
 
+int nsl_int_rectangle(const double *x, double *y, const size_t n, int abs) {
+	if (n == 0)
+		return -1;
+	if (n == 1) {
+		y[0] = 0;
+		return 0;
+	}
+
+	return nsl_int_cumulative(x, y, n, nsl_int_method_rectangle, abs);
+}
+
+int nsl_int_trapezoid(const double *x, double *y, const size_t n, int abs) {
+	if (n < 2)
+		return -1;
+
+	return nsl_int_cumulative(x, y, n, nsl_int_method_trapezoid, abs);
+}
+
 size_t nsl_int_simpson(double *x, double *y, const size_t n, int abs) {
 	if (n < 3)
 		return 0;
@@ -42,6 +42,7 @@ extern const char* nsl_int_method_name[];
 	Simpson-1/3 rule (3-point)	returns number of points, abs not supported yet
 	Simpson-3/8 rule (4-point)	returns number of points, abs not supported yet
 	abs - 0:return mathem. area, 1: return absolute area
+	rectangle and trapezoid rule are calculated as parallel prefix sum (OpenMP) for large n
 */
 int nsl_int_rectangle(const double *x, double *y, const size_t n, int abs);
 int nsl_int_trapezoid(const double *x, double *y, const size_t n, int abs);
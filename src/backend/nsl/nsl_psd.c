@@ -0,0 +1,197 @@
+/***************************************************************************
+    File                 : nsl_psd.c
+    Project              : LabPlot
+    Description          : NSL power spectral density (Welch) and short-time Fourier transform
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "nsl_psd.h"
+#include "nsl_common.h"
+#include "nsl_dft.h"
+#include <gsl/gsl_math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+const char* nsl_psd_scaling_name[] = {i18n("density"), i18n("spectrum")};
+
+size_t nsl_psd_segment_count(size_t n, size_t segment, size_t overlap) {
+	if (segment == 0 || overlap >= segment || n < segment)
+		return 0;
+
+	return (n-segment)/(segment-overlap) + 1;
+}
+
+/* returns the window values (size segment) and the scale factor of the periodogram. free() the result */
+static double* nsl_psd_window(size_t segment, nsl_sf_window_type window, double fs, nsl_psd_scaling scaling, double *scale) {
+	double *w = (double *)malloc(segment*sizeof(double));
+	if (w == NULL)
+		return NULL;
+
+	size_t i;
+	for (i = 0; i < segment; i++)
+		w[i] = 1.;
+	nsl_sf_apply_window(w, segment, window);
+
+	double sum = 0, sum2 = 0;
+	for (i = 0; i < segment; i++) {
+		sum += w[i];
+		sum2 += w[i]*w[i];
+	}
+	if (scaling == nsl_psd_scaling_density)
+		*scale = 1./(fs*sum2);
+	else
+		*scale = 1./(sum*sum);
+
+	return w;
+}
+
+/* one-sided modified periodogram of the segment x into p (size segment/2+1).
+	buffer has size segment+2*(segment/2+1)
+*/
+static int nsl_psd_periodogram(const double x[], size_t segment, const double w[], double scale, double buffer[], double p[]) {
+	double *y = buffer, *X = buffer+segment;
+	size_t i;
+
+	for (i = 0; i < segment; i++)
+		y[i] = w[i]*x[i];
+	int status = nsl_dft_forward(y, 1, segment, X);
+	if (status != 0)
+		return status;
+
+	for (i = 0; i <= segment/2; i++) {
+		p[i] = scale*(gsl_pow_2(X[2*i]) + gsl_pow_2(X[2*i+1]));
+		/* add the negative frequencies (all but DC and Nyquist) */
+		if (i > 0 && 2*i != segment)
+			p[i] *= 2.;
+	}
+
+	return 0;
+}
+
+int nsl_psd_welch(const double data[], size_t n, size_t segment, size_t overlap, nsl_sf_window_type window, double fs,
+		nsl_psd_scaling scaling, double result[]) {
+	const size_t count = nsl_psd_segment_count(n, segment, overlap), m = segment/2+1, step = segment-overlap;
+	if (segment < 2 || count == 0 || fs <= 0)
+		return -1;
+
+	double scale;
+	double *w = nsl_psd_window(segment, window, fs, scaling, &scale);
+	if (w == NULL)
+		return -1;
+
+	/* every thread sums up the periodograms of its (statically scheduled) segments into its own accumulator,
+	 * the accumulators are added in a fixed order afterwards */
+	int nthreads = 1;
+#ifdef _OPENMP
+	nthreads = omp_get_max_threads();
+	if ((size_t)nthreads > count)
+		nthreads = (int)count;
+#endif
+	double *acc = (double *)calloc(nthreads*m, sizeof(double));
+	if (acc == NULL) {
+		free(w);
+		return -1;
+	}
+
+	int status = 0;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) reduction(|:status)
+#endif
+	{
+		int t = 0;
+#ifdef _OPENMP
+		t = omp_get_thread_num();
+#endif
+		double *sum = acc + t*m;
+		double *buffer = (double *)malloc((segment+3*m)*sizeof(double));
+		double *p = buffer + segment+2*m;
+		long k;
+
+		if (buffer == NULL)
+			status = -1;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+		for (k = 0; k < (long)count; k++) {
+			size_t i;
+			if (status != 0)
+				continue;
+			status = nsl_psd_periodogram(data + k*step, segment, w, scale, buffer, p);
+			for (i = 0; i < m; i++)
+				sum[i] += p[i];
+		}
+		free(buffer);
+	}
+
+	if (status == 0) {
+		size_t i;
+		int t;
+		for (i = 0; i < m; i++) {
+			double s = 0;
+			for (t = 0; t < nthreads; t++)
+				s += acc[t*m+i];
+			result[i] = s/count;
+		}
+	}
+
+	free(acc);
+	free(w);
+	return status;
+}
+
+int nsl_psd_stft(const double data[], size_t n, size_t segment, size_t overlap, nsl_sf_window_type window, double fs,
+		nsl_psd_scaling scaling, double* result[]) {
+	const size_t count = nsl_psd_segment_count(n, segment, overlap), m = segment/2+1, step = segment-overlap;
+	if (segment < 2 || count == 0 || fs <= 0)
+		return -1;
+
+	double scale;
+	double *w = nsl_psd_window(segment, window, fs, scaling, &scale);
+	if (w == NULL)
+		return -1;
+
+	int status = 0;
+#ifdef _OPENMP
+#pragma omp parallel reduction(|:status) if(count > 1)
+#endif
+	{
+		double *buffer = (double *)malloc((segment+2*m)*sizeof(double));
+		long k;
+
+		if (buffer == NULL)
+			status = -1;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+		for (k = 0; k < (long)count; k++) {
+			if (status != 0)
+				continue;
+			status = nsl_psd_periodogram(data + k*step, segment, w, scale, buffer, result[k]);
+		}
+		free(buffer);
+	}
+
+	free(w);
+	return status;
+}
@@ -0,0 +1,57 @@
+/***************************************************************************
+    File                 : nsl_psd.h
+    Project              : LabPlot
+    Description          : NSL power spectral density (Welch) and short-time Fourier transform
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef NSL_PSD_H
+#define NSL_PSD_H
+
+#include <stdlib.h>
+#include "nsl_sf_window.h"
+
+/* scaling of the spectrum:
+	density = power spectral density (PSD, unit^2/Hz)
+	spectrum = power spectrum (unit^2)
+ */
+#define NSL_PSD_SCALING_COUNT 2
+typedef enum {nsl_psd_scaling_density, nsl_psd_scaling_spectrum} nsl_psd_scaling;
+extern const char* nsl_psd_scaling_name[];
+
+/* number of segments of size segment overlapping by overlap points in n points (remaining points at the end are not used) */
+size_t nsl_psd_segment_count(size_t n, size_t segment, size_t overlap);
+
+/* Welch's method: average of the one-sided modified periodograms of all windowed segments of data (size n, sample frequency fs).
+	result (size segment/2+1) contains the frequencies i*fs/segment.
+	Segments are transformed in parallel, the memory used does not depend on n.
+*/
+int nsl_psd_welch(const double data[], size_t n, size_t segment, size_t overlap, nsl_sf_window_type window, double fs,
+	nsl_psd_scaling scaling, double result[]);
+/* short-time Fourier transform: one-sided modified periodogram of every segment as in nsl_psd_welch()
+	result[k] (size segment/2+1) is filled for segment k=0..nsl_psd_segment_count()-1
+*/
+int nsl_psd_stft(const double data[], size_t n, size_t segment, size_t overlap, nsl_sf_window_type window, double fs,
+	nsl_psd_scaling scaling, double* result[]);
+
+#endif /* NSL_PSD_H */
@@ -0,0 +1,70 @@
+/***************************************************************************
+    File                 : nsl_psd_test.c
+    Project              : LabPlot
+    Description          : NSL PSD (Welch) and STFT test
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include "nsl_psd.h"
+
+int main() {
+	const size_t N=4096, segment=256, overlap=128, M=segment/2+1;
+	const double fs=1000.;
+	double data[N], result[M];
+	size_t i, k;
+
+	/* sine with amplitude 2 at frequency 10*fs/segment (bin 10) */
+	for (i=0; i < N; i++)
+		data[i] = 2.*sin(2.*M_PI*10*i/segment);
+
+	size_t count = nsl_psd_segment_count(N, segment, overlap);
+	printf("segments: %zu\n", count);
+
+	/* power spectrum: peak is A^2/2 = 2 for the uniform window */
+	nsl_psd_welch(data, N, segment, overlap, nsl_sf_window_uniform, fs, nsl_psd_scaling_spectrum, result);
+	printf("spectrum (uniform): P[9]=%g P[10]=%g P[11]=%g\n", result[9], result[10], result[11]);
+
+	/* density: sum P*df is the variance A^2/2 = 2 */
+	nsl_psd_welch(data, N, segment, overlap, nsl_sf_window_hann, fs, nsl_psd_scaling_density, result);
+	double var=0;
+	for (i=0; i < M; i++)
+		var += result[i]*fs/segment;
+	printf("density (Hann): P[10]=%g variance=%g\n", result[10], var);
+
+	/* STFT: every segment shows the same spectrum */
+	double *stft[count];
+	for (k=0; k < count; k++)
+		stft[k] = malloc(M*sizeof(double));
+	nsl_psd_stft(data, N, segment, overlap, nsl_sf_window_hann, fs, nsl_psd_scaling_density, stft);
+	double mean=0;
+	for (k=0; k < count; k++)
+		mean += stft[k][10];
+	printf("STFT (Hann): S[0][10]=%g S[%zu][10]=%g mean=%g\n", stft[0][10], count-1, stft[count-1][10], mean/count);
+
+	for (k=0; k < count; k++)
+		free(stft[k]);
+
+	return 0;
+}
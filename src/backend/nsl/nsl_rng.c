@@ -0,0 +1,125 @@
+/***************************************************************************
+    File                 : nsl_rng.c
+    Project              : LabPlot
+    Description          : NSL random number generation
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "nsl_rng.h"
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+typedef struct {
+	uint32_t key[2];
+	uint32_t counter[4];
+	uint32_t out[4];
+	unsigned int index;	/* next value of out[], 4 if out[] has to be calculated */
+} nsl_rng_philox_state;
+
+/* 10 rounds of Philox4x32 on the counter of state */
+static void nsl_rng_philox_generate(nsl_rng_philox_state* state) {
+	uint32_t c0 = state->counter[0], c1 = state->counter[1], c2 = state->counter[2], c3 = state->counter[3];
+	uint32_t k0 = state->key[0], k1 = state->key[1];
+	int round;
+	for (round = 0; round < 10; round++) {
+		const uint64_t p0 = (uint64_t)PHILOX_M0 * c0, p1 = (uint64_t)PHILOX_M1 * c2;
+		c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+		c1 = (uint32_t)p1;
+		c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+		c3 = (uint32_t)p0;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+	state->out[0] = c0;
+	state->out[1] = c1;
+	state->out[2] = c2;
+	state->out[3] = c3;
+}
+
+static void nsl_rng_philox_set(void* vstate, unsigned long seed) {
+	nsl_rng_philox_state* state = (nsl_rng_philox_state*)vstate;
+	state->key[0] = (uint32_t)seed;
+	state->key[1] = (uint32_t)((uint64_t)seed >> 32);
+	state->counter[0] = state->counter[1] = state->counter[2] = state->counter[3] = 0;
+	state->index = 4;
+}
+
+static unsigned long nsl_rng_philox_get(void* vstate) {
+	nsl_rng_philox_state* state = (nsl_rng_philox_state*)vstate;
+	if (state->index == 4) {
+		nsl_rng_philox_generate(state);
+		state->counter[0]++;
+		state->index = 0;
+	}
+	return state->out[state->index++];
+}
+
+static double nsl_rng_philox_get_double(void* vstate) {
+	return nsl_rng_philox_get(vstate) / 4294967296.0;
+}
+
+static const gsl_rng_type nsl_rng_philox_type = {"philox4x32", 0xffffffffUL, 0, sizeof(nsl_rng_philox_state),
+	&nsl_rng_philox_set, &nsl_rng_philox_get, &nsl_rng_philox_get_double};
+
+const gsl_rng_type* nsl_rng_philox = &nsl_rng_philox_type;
+
+void nsl_rng_philox_set_stream(const gsl_rng* r, unsigned long stream, unsigned long block) {
+	nsl_rng_philox_state* state = (nsl_rng_philox_state*)r->state;
+	state->counter[0] = 0;
+	state->counter[1] = (uint32_t)block;
+	state->counter[2] = (uint32_t)stream;
+	state->counter[3] = (uint32_t)((uint64_t)stream >> 32);
+	state->index = 4;
+}
+
+void nsl_rng_fill(double data[], const size_t n, unsigned long seed, unsigned long stream, nsl_rng_sampler sample, const void* param) {
+	const long nblocks = (long)((n + NSL_RNG_BLOCK_SIZE - 1)/NSL_RNG_BLOCK_SIZE);
+	long b;
+
+	/* generators on the stack, no allocation in the threads.
+		dynamic scheduling since the costs of rejection methods differ between the blocks */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(nblocks > 1)
+#endif
+	for (b = 0; b < nblocks; b++) {
+		nsl_rng_philox_state state;
+		gsl_rng r;
+		r.type = nsl_rng_philox;
+		r.state = &state;
+		nsl_rng_philox_set(&state, seed);
+		nsl_rng_philox_set_stream(&r, stream, (unsigned long)b);
+
+		const size_t start = (size_t)b*NSL_RNG_BLOCK_SIZE;
+		const size_t end = (start + NSL_RNG_BLOCK_SIZE < n) ? start + NSL_RNG_BLOCK_SIZE : n;
+		size_t i;
+		for (i = start; i < end; i++)
+			data[i] = sample(&r, param);
+	}
+}
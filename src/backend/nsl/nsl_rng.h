@@ -0,0 +1,54 @@
+/***************************************************************************
+    File                 : nsl_rng.h
+    Project              : LabPlot
+    Description          : NSL random number generation
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef NSL_RNG_H
+#define NSL_RNG_H
+
+#include <stdlib.h>
+#include <gsl/gsl_rng.h>
+
+/* number of values of one block in nsl_rng_fill() */
+#define NSL_RNG_BLOCK_SIZE 65536
+
+/* counter-based generator Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC'11) as GSL generator.
+	The 32 bit numbers are the encrypted values of a 128 bit counter with the seed as key, so any part of the sequence
+	can be calculated directly. gsl_rng_set() sets the key and starts with stream 0, block 0 */
+extern const gsl_rng_type* nsl_rng_philox;
+/* continues the generator r (nsl_rng_philox) at the start of block of stream (counter = (0, block, stream, 0)).
+	The sequences of different blocks and streams don't overlap for less than 2^34 numbers per block */
+void nsl_rng_philox_set_stream(const gsl_rng* r, unsigned long stream, unsigned long block);
+
+/* random value using the generator r and the parameters param */
+typedef double (*nsl_rng_sampler)(const gsl_rng* r, const void* param);
+
+/* fills data[0..n-1] with values of sample() using the generator nsl_rng_philox with seed.
+	The values are calculated in blocks of NSL_RNG_BLOCK_SIZE values in parallel (OpenMP), each block uses its own block of stream.
+	So the result only depends on seed and stream and not on the number of threads.
+	sample() has to be thread-safe */
+void nsl_rng_fill(double data[], const size_t n, unsigned long seed, unsigned long stream, nsl_rng_sampler sample, const void* param);
+
+#endif /* NSL_RNG_H */
@@ -0,0 +1,97 @@
+/***************************************************************************
+    File                 : nsl_rng_test.c
+    Project              : LabPlot
+    Description          : NSL sorting functions
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include <stdio.h>
+#include <math.h>
+#include "nsl_rng.h"
+#include "nsl_sf_stats.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* known answer of Philox4x32-10 for counter 0 and key 0 (Random123) */
+static const unsigned long kat[4] = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+
+int main() {
+	int i, j, errors = 0;
+
+	printf("Philox4x32-10 known answer:\n");
+	gsl_rng *r = gsl_rng_alloc(nsl_rng_philox);
+	gsl_rng_set(r, 0);
+	for (i = 0; i < 4; i++) {
+		unsigned long v = gsl_rng_get(r);
+		printf("%08lx ", v);
+		if (v != kat[i])
+			errors++;
+	}
+	puts("");
+
+	printf("\nstream 3, block 2 continued after 1000 values:\n");
+	double first = 0;
+	for (i = 0; i < 2; i++) {
+		nsl_rng_philox_set_stream(r, 3, 2);
+		for (j = 0; j < 1000; j++)
+			gsl_rng_uniform(r);
+		const double v = gsl_rng_uniform(r);
+		printf("%.10f ", v);
+		if (i == 0)
+			first = v;
+		else if (v != first)
+			errors++;
+	}
+	puts("");
+	gsl_rng_free(r);
+
+	printf("\nuniform values of stream 1 independent of the number of threads:\n");
+	const size_t n = 5*NSL_RNG_BLOCK_SIZE + 123;
+	double *data1 = (double *)malloc(n*sizeof(double));
+	double *data2 = (double *)malloc(n*sizeof(double));
+	const double p[] = {0., 1., 0.};
+	nsl_sf_stats_random_fill(nsl_sf_stats_flat, p, data1, n, 0, 1);
+#ifdef _OPENMP
+	omp_set_num_threads(1);
+#endif
+	nsl_sf_stats_random_fill(nsl_sf_stats_flat, p, data2, n, 0, 1);
+
+	size_t k;
+	double mean = 0;
+	for (k = 0; k < n; k++) {
+		if (data1[k] != data2[k])
+			errors++;
+		mean += data1[k];
+	}
+	printf("mean = %g (0.5)\n", mean/n);
+	if (fabs(mean/n - 0.5) > 0.01)
+		errors++;
+
+	free(data1);
+	free(data2);
+
+	printf("\n%d errors\n", errors);
+	return errors;
+}
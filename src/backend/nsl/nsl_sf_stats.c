@@ -28,6 +28,9 @@
 
 #include "nsl_sf_stats.h"
 #include "nsl_common.h"
+#include "nsl_rng.h"
+#include <math.h>
+#include <gsl/gsl_randist.h>
 
 const char* nsl_sf_stats_distribution_name[] = {i18n("Gaussian (Normal)"), i18n("Gaussian Tail"), i18n("Exponential"), i18n("Laplace"),
 	i18n("Exponential Power"), i18n("Cauchy-Lorentz (Breit-Wigner)"), i18n("Rayleigh"), i18n("Rayleigh Tail"), i18n("Landau"), i18n("Levy alpha-stable"),
@@ -54,3 +57,102 @@ const char* nsl_sf_stats_distribution_equation[] = {
 	"Logarithmic", "a*sqrt(2/pi) * x^2/s^3 * exp(-(x/s)^2/2)", "a/2/s * sech(pi/2*(x-mu)/s)",
 	"a * sqrt(g/(2*pi))/pow(x-mu, 1.5) * exp(-g/2./(x-mu))", "a * g/s*((x-mu)/s)^(-g-1) * exp(-((x-mu)/s)^(-g))"};
 
+
+double nsl_sf_stats_random(const gsl_rng* r, nsl_sf_stats_distribution dist, const double p[]) {
+	switch (dist) {
+	case nsl_sf_stats_gaussian:
+		return gsl_ran_gaussian(r, p[1]) + p[0];
+	case nsl_sf_stats_gaussian_tail:
+		return gsl_ran_gaussian_tail(r, p[2], p[1]) + p[0];
+	case nsl_sf_stats_exponential:
+		/* p[0] is the rate lambda as in the random values dialog, GSL expects the mean 1/lambda */
+		return gsl_ran_exponential(r, 1./p[0]);
+	case nsl_sf_stats_laplace:
+		return gsl_ran_laplace(r, p[0]) + p[1];
+	case nsl_sf_stats_exponential_power:
+		return gsl_ran_exppow(r, p[1], p[2]) + p[0];
+	case nsl_sf_stats_cauchy_lorentz:
+		return gsl_ran_cauchy(r, p[0]) + p[1];
+	case nsl_sf_stats_rayleigh:
+		return gsl_ran_rayleigh(r, p[0]);
+	case nsl_sf_stats_rayleigh_tail:
+		return gsl_ran_rayleigh_tail(r, p[1], p[0]);
+	case nsl_sf_stats_landau:
+		return gsl_ran_landau(r);
+	case nsl_sf_stats_levy_alpha_stable:
+		return gsl_ran_levy(r, p[0], p[1]);
+	case nsl_sf_stats_levy_skew_alpha_stable:
+		return gsl_ran_levy_skew(r, p[0], p[1], p[2]);
+	case nsl_sf_stats_gamma:
+		return gsl_ran_gamma(r, p[0], p[1]);
+	case nsl_sf_stats_flat:
+		return gsl_ran_flat(r, p[0], p[1]);
+	case nsl_sf_stats_lognormal:
+		return gsl_ran_lognormal(r, p[1], p[0]);
+	case nsl_sf_stats_chi_squared:
+		return gsl_ran_chisq(r, p[0]);
+	case nsl_sf_stats_fdist:
+		return gsl_ran_fdist(r, p[0], p[1]);
+	case nsl_sf_stats_tdist:
+		return gsl_ran_tdist(r, p[0]);
+	case nsl_sf_stats_beta:
+		return gsl_ran_beta(r, p[0], p[1]);
+	case nsl_sf_stats_logistic:
+		return gsl_ran_logistic(r, p[0]) + p[1];
+	case nsl_sf_stats_pareto:
+		return gsl_ran_pareto(r, p[0], p[1]);
+	case nsl_sf_stats_weibull:
+		return gsl_ran_weibull(r, p[1], p[0]) + p[2];
+	case nsl_sf_stats_gumbel1:
+		return gsl_ran_gumbel1(r, 1./p[0], p[1]) + p[2];
+	case nsl_sf_stats_gumbel2:
+		return gsl_ran_gumbel2(r, p[0], p[1]);
+	case nsl_sf_stats_poisson:
+		return gsl_ran_poisson(r, p[0]);
+	case nsl_sf_stats_bernoulli:
+		return gsl_ran_bernoulli(r, p[0]);
+	case nsl_sf_stats_binomial:
+		return gsl_ran_binomial(r, p[0], (unsigned int)p[1]);
+	case nsl_sf_stats_negative_bionomial:
+		return gsl_ran_negative_binomial(r, p[0], p[1]);
+	case nsl_sf_stats_pascal:
+		return gsl_ran_pascal(r, p[0], (unsigned int)p[1]);
+	case nsl_sf_stats_geometric:
+		return gsl_ran_geometric(r, p[0]);
+	case nsl_sf_stats_hypergeometric:
+		return gsl_ran_hypergeometric(r, (unsigned int)p[0], (unsigned int)p[1], (unsigned int)p[2]);
+	case nsl_sf_stats_logarithmic:
+		return gsl_ran_logarithmic(r, p[0]);
+	case nsl_sf_stats_maxwell_boltzmann:	/* additional non-GSL distros */
+	case nsl_sf_stats_sech:
+	case nsl_sf_stats_levy:
+	case nsl_sf_stats_frechet:
+		break;
+	}
+
+	return NAN;
+}
+
+/* distribution and parameters passed to nsl_rng_fill() */
+typedef struct {
+	nsl_sf_stats_distribution dist;
+	const double* p;
+} nsl_sf_stats_random_param;
+
+static double nsl_sf_stats_random_sample(const gsl_rng* r, const void* param) {
+	const nsl_sf_stats_random_param* rp = (const nsl_sf_stats_random_param*)param;
+	return nsl_sf_stats_random(r, rp->dist, rp->p);
+}
+
+int nsl_sf_stats_random_fill(nsl_sf_stats_distribution dist, const double p[], double data[], const size_t n,
+		unsigned long seed, unsigned long stream) {
+	if (dist >= NSL_SF_STATS_DISTRIBUTION_RNG_COUNT)
+		return -1;
+
+	nsl_sf_stats_random_param param;
+	param.dist = dist;
+	param.p = p;
+	nsl_rng_fill(data, n, seed, stream, &nsl_sf_stats_random_sample, &param);
+
+	return 0;
+}
@@ -29,6 +29,9 @@
 #ifndef NSL_SF_STATS_H
 #define NSL_SF_STATS_H
 
+#include <stdlib.h>
+#include <gsl/gsl_rng.h>
+
 #define NSL_SF_STATS_DISTRIBUTION_COUNT 35
 #define NSL_SF_STATS_DISTRIBUTION_RNG_COUNT 31	/* GSL RNG distributions */
 /* ordered as defined in GSL random number distributions */
@@ -45,4 +48,14 @@ extern const char* nsl_sf_stats_distribution_name[];
 extern const char* nsl_sf_stats_distribution_pic_name[];
 extern const char* nsl_sf_stats_distribution_equation[];
 
+/* random value of the GSL distribution dist (dist < NSL_SF_STATS_DISTRIBUTION_RNG_COUNT) using the generator r.
+	p[0..2] are the parameters in the order of the random values dialog, a location parameter mu is added to the value of GSL.
+	returns NAN for the other distributions */
+double nsl_sf_stats_random(const gsl_rng* r, nsl_sf_stats_distribution dist, const double p[]);
+/* fills data[0..n-1] with random values of dist in parallel, see nsl_rng_fill().
+	The values only depend on seed and stream (e.g. the index of the column), not on the number of threads.
+	returns -1 if dist is not a GSL distribution */
+int nsl_sf_stats_random_fill(nsl_sf_stats_distribution dist, const double p[], double data[], const size_t n,
+		unsigned long seed, unsigned long stream);
+
 #endif /* NSL_SF_STATS_H */
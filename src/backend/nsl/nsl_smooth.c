@@ -30,10 +30,13 @@
 #include "nsl_common.h"
 #include "nsl_sf_kernel.h"
 #include "nsl_stats.h"
+#include <string.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_linalg.h>
 #include <gsl/gsl_blas.h>
-#include <gsl/gsl_sf_gamma.h>   /* gsl_sf_choose */
+#include <gsl/gsl_sf_gamma.h>   /* gsl_sf_lnchoose */
+#include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_fft_halfcomplex.h>
 
 const char* nsl_smooth_type_name[] = { i18n("moving average (central)"), i18n("moving average (lagged)"), i18n("percentile"), i18n("Savitzky-Golay") };
 const char* nsl_smooth_pad_mode_name[] = { i18n("none"), i18n("interpolating"), i18n("mirror"), i18n("nearest"), i18n("constant"), i18n("periodic") };
@@ -41,318 +44,533 @@ const char* nsl_smooth_weight_type_name[] = { i18n("uniform (rectangular)"), i18
 		i18n("quartic (biweight)"), i18n("triweight"), i18n("tricube"), i18n("cosine")  };
 double nsl_smooth_pad_constant_lvalue = 0.0, nsl_smooth_pad_constant_rvalue = 0.0;
 
-int nsl_smooth_moving_average(double *data, unsigned int n, unsigned int points, nsl_smooth_weight_type weight, nsl_smooth_pad_mode mode) {
-	unsigned int i,j;
-	double *result = (double *)malloc(n*sizeof(double));
-	for (i=0; i<n; i++)
-		result[i]=0;
+/* value of the signal padded according to mode at index (index may be outside [0,n-1]) */
+static double nsl_smooth_pad_value(const double *data, unsigned int n, long index, nsl_smooth_pad_mode mode) {
+	if (index >= 0 && index < (long)n)
+		return data[index];
+
+	switch(mode) {
+	case nsl_smooth_pad_mirror:
+		index = (index < 0) ? -index : 2*((long)n-1)-index;
+		break;
+	case nsl_smooth_pad_constant:
+		return (index < 0) ? nsl_smooth_pad_constant_lvalue : nsl_smooth_pad_constant_rvalue;
+	case nsl_smooth_pad_periodic:
+		index %= (long)n;
+		if (index < 0)
+			index += n;
+		break;
+	default:	/* nearest */
+		break;
+	}
 
-	for(i=0;i<n;i++) {
-		unsigned int np=points;
-		unsigned int half=(points-1)/2;
-		if(mode == nsl_smooth_pad_none) { /* reduce points */
-			half = GSL_MIN(GSL_MIN((points-1)/2,i),n-i-1);
-			np = 2*half+1;
-		}
+	return data[GSL_MIN((long)n-1,GSL_MAX(0,index))];
+}
+
+/* number of results computed together. Running sums are restarted for every chunk, which limits the accumulated rounding error
+ * and makes the chunks independent of each other */
+#define NSL_SMOOTH_CHUNK_SIZE 16384
+/* general kernels with at least this number of points are applied by FFT convolution */
+#define NSL_SMOOTH_FFT_MIN_POINTS 64
+
+/* shape of the weights used to select the algorithm of the weighted sum */
+typedef enum {nsl_smooth_shape_general, nsl_smooth_shape_uniform, nsl_smooth_shape_triangular, nsl_smooth_shape_ramp} nsl_smooth_shape;
 
-		/* weight */
-		double sum=0.0, *w = (double *)malloc(np*sizeof(double));
-		switch(weight) {
-		case nsl_smooth_weight_uniform:
+/* weights w[0..np-1] of a central or lagged moving average over np points */
+static void nsl_smooth_weights(double *w, unsigned int np, nsl_smooth_weight_type weight, int lagged) {
+	unsigned int j;
+	double sum = 0.0, (*kernel)(double) = nsl_sf_kernel_parabolic;
+
+	switch(weight) {
+	case nsl_smooth_weight_uniform:
+		for(j=0;j<np;j++)
+			w[j]=1./np;
+		return;
+	case nsl_smooth_weight_triangular:
+		if(lagged) {
+			sum = np*(np+1)/2;
 			for(j=0;j<np;j++)
-				w[j]=1./np;
-			break;
-		case nsl_smooth_weight_triangular:
+				w[j]=(j+1)/sum;
+		} else {
 			sum = gsl_pow_2((np+1)/2);
 			for(j=0;j<np;j++)
 				w[j]=GSL_MIN(j+1,np-j)/sum;
-			break;
-		case nsl_smooth_weight_binomial:
-			sum = (np-1)/2.;
-			for(j=0;j<np;j++)
-				w[j]=gsl_sf_choose(2*sum,sum+fabs(j-sum))/pow(4.,sum);
-			break;
-		case nsl_smooth_weight_parabolic:
+		}
+		return;
+	case nsl_smooth_weight_binomial:
+		/* logarithms of the binomial coefficients do not overflow for large windows */
+		if(lagged) {
 			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_parabolic(2.*(j-(np-1)/2.)/(np+1));
+				w[j]=exp(gsl_sf_lnchoose(2*(np-1),j)-gsl_sf_lnchoose(2*(np-1),np-1));
 				sum += w[j];
 			}
 			for(j=0;j<np;j++)
 				w[j] /= sum;
-			break;
-		case nsl_smooth_weight_quartic:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_quartic(2.*(j-(np-1)/2.)/(np+1));
-				sum += w[j];
-			}
+		} else {
+			sum = (np-1)/2.;
 			for(j=0;j<np;j++)
-				w[j] /= sum;
-			break;
-		case nsl_smooth_weight_triweight:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_triweight(2.*(j-(np-1)/2.)/(np+1));
-				sum += w[j];
+				w[j]=exp(gsl_sf_lnchoose(np-1,(unsigned int)(sum+fabs(j-sum)))-sum*log(4.));
+		}
+		return;
+	case nsl_smooth_weight_parabolic:
+		kernel = nsl_sf_kernel_parabolic;
+		break;
+	case nsl_smooth_weight_quartic:
+		kernel = nsl_sf_kernel_quartic;
+		break;
+	case nsl_smooth_weight_triweight:
+		kernel = nsl_sf_kernel_triweight;
+		break;
+	case nsl_smooth_weight_tricube:
+		kernel = nsl_sf_kernel_tricube;
+		break;
+	case nsl_smooth_weight_cosine:
+		kernel = nsl_sf_kernel_cosine;
+		break;
+	}
+
+	for(j=0;j<np;j++) {
+		w[j]=kernel(lagged ? 1.-(1+j)/(double)np : 2.*(j-(np-1)/2.)/(np+1));
+		sum += w[j];
+	}
+	for(j=0;j<np;j++)
+		w[j] /= sum;
+}
+
+/* shape of the weights of a moving average over np points (see nsl_smooth_weights()) */
+static nsl_smooth_shape nsl_smooth_weight_shape(unsigned int np, nsl_smooth_weight_type weight, int lagged) {
+	if(weight == nsl_smooth_weight_uniform)
+		return nsl_smooth_shape_uniform;
+	if(weight == nsl_smooth_weight_triangular) {
+		if(lagged)
+			return nsl_smooth_shape_ramp;
+		if(np%2 == 1)
+			return nsl_smooth_shape_triangular;
+	}
+	return nsl_smooth_shape_general;
+}
+
+/* running sum with compensation of the rounding error (Neumaier) */
+typedef struct {
+	double sum, c;
+} nsl_smooth_running_sum;
+
+static void nsl_smooth_running_sum_add(nsl_smooth_running_sum *r, double value) {
+	double t = r->sum+value;
+	if(fabs(r->sum) >= fabs(value))
+		r->c += (r->sum-t)+value;
+	else
+		r->c += (value-t)+r->sum;
+	r->sum = t;
+}
+
+/* weighted sum out[i] = sum_j w[j]*x[i+j] of np points for one chunk of results i = first..last-1 */
+static int nsl_smooth_correlate_chunk(double *out, const double *x, const double *w, unsigned int np, nsl_smooth_shape shape,
+		size_t first, size_t last) {
+	size_t i, j;
+	nsl_smooth_running_sum s = {0, 0}, t = {0, 0};
+
+	switch(shape) {
+	case nsl_smooth_shape_uniform:
+		for(j=0;j<np;j++)
+			nsl_smooth_running_sum_add(&s, x[first+j]);
+		for(i=first;i<last;i++) {
+			out[i] = w[0]*(s.sum+s.c);
+			if(i+1 < last) {
+				nsl_smooth_running_sum_add(&s, x[i+np]);
+				nsl_smooth_running_sum_add(&s, -x[i]);
 			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
-			break;
-		case nsl_smooth_weight_tricube:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_tricube(2.*(j-(np-1)/2.)/(np+1));
-				sum += w[j];
+		}
+		break;
+	case nsl_smooth_shape_triangular: {
+		/* a triangle of np = 2m-1 points is the convolution of two boxes of m points: box sums of box sums */
+		size_t m = (np+1)/2, nb = last-first+m-1;
+		double *b = (double *)malloc(nb*sizeof(double));
+		if(b == NULL)
+			return -1;
+		for(j=0;j<m;j++)
+			nsl_smooth_running_sum_add(&s, x[first+j]);
+		for(j=0;j<nb;j++) {
+			b[j] = s.sum+s.c;
+			if(j+1 < nb) {
+				nsl_smooth_running_sum_add(&s, x[first+j+m]);
+				nsl_smooth_running_sum_add(&s, -x[first+j]);
 			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
-			break;
-		case nsl_smooth_weight_cosine:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_cosine((j-(np-1)/2.)/((np+1)/2.));
-				sum += w[j];
+		}
+		for(j=0;j<m;j++)
+			nsl_smooth_running_sum_add(&t, b[j]);
+		for(i=first;i<last;i++) {
+			out[i] = w[0]*(t.sum+t.c);
+			if(i+1 < last) {
+				nsl_smooth_running_sum_add(&t, b[i-first+m]);
+				nsl_smooth_running_sum_add(&t, -b[i-first]);
 			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
-			break;
 		}
-
-		/*printf("(%d) w:",i);
-		for(j=0;j<np;j++)
-			printf(" %g",w[j]);
-		printf(" (half=%d) index = ",half);*/
-
-		/* calculate weighted average */
+		free(b);
+		break;
+	}
+	case nsl_smooth_shape_ramp:
+		/* weights 1,2,...,np: running sum s of the window and running sum t of s */
 		for(j=0;j<np;j++) {
-			int index=i-half+j;
-			switch(mode) {
-			case nsl_smooth_pad_none:
-				result[i] += w[j]*data[index];
-				break;
-			case nsl_smooth_pad_interp:
-				printf("not implemented yet\n");
-				break;
-			case nsl_smooth_pad_mirror:
-				index=abs((int)(i-half+j));
-				/*printf(" %d",GSL_MIN(index,2*(n-1)-index));*/
-				result[i] += w[j]*data[GSL_MIN(index,2*((int)n-1)-index)];
-				break;
-			case nsl_smooth_pad_nearest:
-				/*printf(" %d",GSL_MIN(n-1,GSL_MAX(0,index)));*/
-				result[i] += w[j]*data[GSL_MIN((int)n-1,GSL_MAX(0,index))];
-				break;
-			case nsl_smooth_pad_constant:
-				if(index<0)
-					result[i] += w[j]*nsl_smooth_pad_constant_lvalue;
-				else if(index>(int)n-1)
-					result[i] += w[j]*nsl_smooth_pad_constant_rvalue;
-				else
-					result[i] += w[j]*data[index];
-				break;
-			case nsl_smooth_pad_periodic:
-				if(index<0)
-					index = n+index;
-				else if(index>(int)n-1)
-					index = index-n;
-				result[i] += w[j]*data[index];
-				break;
+			nsl_smooth_running_sum_add(&s, x[first+j]);
+			nsl_smooth_running_sum_add(&t, (j+1)*x[first+j]);
+		}
+		for(i=first;i<last;i++) {
+			out[i] = w[0]*(t.sum+t.c);
+			if(i+1 < last) {
+				nsl_smooth_running_sum_add(&t, np*x[i+np]);
+				nsl_smooth_running_sum_add(&t, -(s.sum+s.c));
+				nsl_smooth_running_sum_add(&s, x[i+np]);
+				nsl_smooth_running_sum_add(&s, -x[i]);
+			}
+		}
+		break;
+	case nsl_smooth_shape_general:
+		for(i=first;i<last;i++) {
+			/* independent partial sums allow the compiler to vectorize the dot product */
+			const double *xi = x+i;
+			double s0=0, s1=0, s2=0, s3=0;
+			for(j=0;j+4<=np;j+=4) {
+				s0 += w[j]*xi[j];
+				s1 += w[j+1]*xi[j+1];
+				s2 += w[j+2]*xi[j+2];
+				s3 += w[j+3]*xi[j+3];
 			}
+			for(;j<np;j++)
+				s0 += w[j]*xi[j];
+			out[i] = (s0+s1)+(s2+s3);
 		}
-		/*puts("");*/
-		free(w);
+		break;
 	}
-	
-	for (i=0; i<n; i++)
-		data[i]=result[i];
-	free(result);
 
 	return 0;
 }
 
+/* multiply the half-complex arrays a and b (as returned by gsl_fft_real_radix2_transform()) and store the product into a */
+static void nsl_smooth_halfcomplex_multiply(double *a, const double *b, size_t size) {
+	size_t k;
+
+	a[0] *= b[0];
+	a[size/2] *= b[size/2];
+	for(k=1;k<size/2;k++) {
+		double re = a[k], im = a[size-k];
+		a[k] = re*b[k]-im*b[size-k];
+		a[size-k] = re*b[size-k]+im*b[k];
+	}
+}
+
+/* weighted sum out[i] = sum_j w[j]*x[i+j] of np points for i = 0..m-1 by FFT convolution of blocks (overlap-save) */
+static int nsl_smooth_correlate_fft(double *out, const double *x, size_t m, const double *w, unsigned int np) {
+	size_t size = 1, step, j;
+	int b, nblocks, status = 0;
+	double *h;
+
+	while(size < 4*(size_t)np)
+		size *= 2;
+	step = size-np+1;
+	nblocks = (int)((m+step-1)/step);
+
+	/* reversed weights: the circular convolution of a block with them yields the weighted sums behind the first np-1 values */
+	h = (double *)malloc(size*sizeof(double));
+	if(h == NULL)
+		return -1;
+	for(j=0;j<size;j++)
+		h[j] = (j<np) ? w[np-1-j] : 0;
+	gsl_fft_real_radix2_transform(h, 1, size);
+
+#ifdef _OPENMP
+#pragma omp parallel for reduction(|:status) if(nblocks > 1)
+#endif
+	for(b=0;b<nblocks;b++) {
+		size_t first = b*step, count = GSL_MIN(step, m-first), available = count+np-1, t;
+		double *block = (double *)malloc(size*sizeof(double));
+		if(block == NULL) {
+			status |= -1;
+			continue;
+		}
+
+		for(t=0;t<size;t++)
+			block[t] = (t<available) ? x[first+t] : 0;
+		gsl_fft_real_radix2_transform(block, 1, size);
+		nsl_smooth_halfcomplex_multiply(block, h, size);
+		gsl_fft_halfcomplex_radix2_inverse(block, 1, size);
+		for(t=0;t<count;t++)
+			out[first+t] = block[np-1+t];
+
+		free(block);
+	}
+
+	free(h);
+	return status;
+}
+
+/* weighted sum out[i] = sum_j w[j]*x[i+j] of np points for i = 0..m-1 (x holds m+np-1 values) */
+static int nsl_smooth_correlate(double *out, const double *x, size_t m, const double *w, unsigned int np, nsl_smooth_shape shape) {
+	int c, nchunks, status = 0;
+
+	if(shape == nsl_smooth_shape_general && np >= NSL_SMOOTH_FFT_MIN_POINTS && m > np)
+		return nsl_smooth_correlate_fft(out, x, m, w, np);
+
+	nchunks = (int)((m+NSL_SMOOTH_CHUNK_SIZE-1)/NSL_SMOOTH_CHUNK_SIZE);
+#ifdef _OPENMP
+#pragma omp parallel for reduction(|:status) if(nchunks > 1)
+#endif
+	for(c=0;c<nchunks;c++) {
+		size_t first = (size_t)c*NSL_SMOOTH_CHUNK_SIZE;
+		status |= nsl_smooth_correlate_chunk(out, x, w, np, shape, first, GSL_MIN(first+NSL_SMOOTH_CHUNK_SIZE, m));
+	}
+
+	return status;
+}
+
+/* weighted sum of the np values x[0..np-1] */
+static double nsl_smooth_dot(const double *x, const double *w, unsigned int np) {
+	unsigned int j;
+	double s = 0;
+
+	for(j=0;j<np;j++)
+		s += w[j]*x[j];
+
+	return s;
+}
+
+int nsl_smooth_moving_average(double *data, unsigned int n, unsigned int points, nsl_smooth_weight_type weight, nsl_smooth_pad_mode mode) {
+	unsigned int i, half = (points-1)/2;
+	size_t k, m;
+	int status;
+	double *x, *w;
+
+	if(points == 0 || mode == nsl_smooth_pad_interp)	/* interp not implemented yet */
+		return -1;
+	if(n == 0)
+		return 0;
+
+	m = (size_t)n+points-1;
+	x = (double *)malloc((m+points)*sizeof(double));
+	if(x == NULL)
+		return -1;
+	w = x+m;
+
+	if(mode == nsl_smooth_pad_none) {	/* reduce points at the edges */
+		unsigned int np = 2*half+1;
+		memcpy(x, data, n*sizeof(double));
+
+		status = 0;
+		if(n > 2*half) {
+			nsl_smooth_weights(w, np, weight, 0);
+			status = nsl_smooth_correlate(data+half, x, n-2*half, w, np, nsl_smooth_weight_shape(np, weight, 0));
+		}
+		for(i=0;i<n;i++) {
+			unsigned int h = GSL_MIN(GSL_MIN(half,i),n-i-1);
+			if(h == half && n > 2*half)
+				continue;
+			nsl_smooth_weights(w, 2*h+1, weight, 0);
+			data[i] = nsl_smooth_dot(x+i-h, w, 2*h+1);
+		}
+	} else {
+		for(k=0;k<m;k++)
+			x[k] = nsl_smooth_pad_value(data, n, (long)k-(long)half, mode);
+		nsl_smooth_weights(w, points, weight, 0);
+		status = nsl_smooth_correlate(data, x, n, w, points, nsl_smooth_weight_shape(points, weight, 0));
+	}
+
+	free(x);
+	return status;
+}
+
 int nsl_smooth_moving_average_lagged(double *data, unsigned int n, unsigned int points, nsl_smooth_weight_type weight, nsl_smooth_pad_mode mode) {
-	unsigned int i,j;
-	double *result = (double *)malloc(n*sizeof(double));
-	for (i=0; i<n; i++)
-		result[i]=0;
+	unsigned int i;
+	size_t k, m;
+	int status;
+	double *x, *w;
 
-	for(i=0;i<n;i++) {
-		unsigned int np=points;
-		unsigned int half=(points-1)/2;
-		if(mode == nsl_smooth_pad_none) { /* reduce points */
-			np = GSL_MIN(points,i+1);
-			half = np-1;
+	if(points == 0 || mode == nsl_smooth_pad_interp)	/* interp not implemented yet */
+		return -1;
+	if(n == 0)
+		return 0;
+
+	m = (size_t)n+points-1;
+	x = (double *)malloc((m+points)*sizeof(double));
+	if(x == NULL)
+		return -1;
+	w = x+m;
+
+	if(mode == nsl_smooth_pad_none) {	/* reduce points at the beginning */
+		memcpy(x, data, n*sizeof(double));
+
+		status = 0;
+		if(n >= points) {
+			nsl_smooth_weights(w, points, weight, 1);
+			status = nsl_smooth_correlate(data+points-1, x, n-points+1, w, points, nsl_smooth_weight_shape(points, weight, 1));
+		}
+		for(i=0;i<GSL_MIN(n,points-1);i++) {
+			nsl_smooth_weights(w, i+1, weight, 1);
+			data[i] = nsl_smooth_dot(x, w, i+1);
 		}
+	} else {
+		for(k=0;k<m;k++)
+			x[k] = nsl_smooth_pad_value(data, n, (long)k-(long)(points-1), mode);
+		nsl_smooth_weights(w, points, weight, 1);
+		status = nsl_smooth_correlate(data, x, n, w, points, nsl_smooth_weight_shape(points, weight, 1));
+	}
 
-		/* weight */
-		double sum=0.0, *w = (double *)malloc(np*sizeof(double));
-		switch(weight) {
-		case nsl_smooth_weight_uniform:
-			for(j=0;j<np;j++)
-				w[j]=1./np;
-			break;
-		case nsl_smooth_weight_triangular:
-			sum = np*(np+1)/2;
-			for(j=0;j<np;j++)
-				w[j]=(j+1)/sum;
-			break;
-		case nsl_smooth_weight_binomial:
-			for(j=0;j<np;j++) {
-				w[j]=gsl_sf_choose(2*(np-1),j);
-				sum += w[j];
-			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
-			break;
-		case nsl_smooth_weight_parabolic:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_parabolic(1.-(1+j)/(double)np);
-				sum += w[j];
-			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
-			break;
-		case nsl_smooth_weight_quartic:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_quartic(1.-(1+j)/(double)np);
-				sum += w[j];
-			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
-			break;
-		case nsl_smooth_weight_triweight:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_triweight(1.-(1+j)/(double)np);
-				sum += w[j];
-			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
-			break;
-		case nsl_smooth_weight_tricube:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_tricube(1.-(1+j)/(double)np);
-				sum += w[j];
-			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
+	free(x);
+	return status;
+}
+
+/* sliding window for order statistics:
+ * the values of the window are split into a max-heap "low" containing the smallest values and a min-heap "high" containing the rest.
+ * Each value is stored in a slot of a ring buffer. pos and in_low locate the slot in the heaps, so that any value can be removed in O(log w).
+ */
+typedef struct {
+	double *value;
+	unsigned int *low, *high, *pos;
+	unsigned char *in_low;
+	unsigned int nlow, nhigh;
+} nsl_smooth_window;
+
+static int nsl_smooth_window_before(const nsl_smooth_window *w, int low, unsigned int a, unsigned int b) {
+	return low ? w->value[a] > w->value[b] : w->value[a] < w->value[b];
+}
+
+static void nsl_smooth_window_sift(nsl_smooth_window *w, int low, unsigned int i) {
+	unsigned int *heap = low ? w->low : w->high;
+	const unsigned int size = low ? w->nlow : w->nhigh;
+	const unsigned int slot = heap[i];
+
+	/* up */
+	while (i > 0 && nsl_smooth_window_before(w, low, slot, heap[(i-1)/2])) {
+		heap[i] = heap[(i-1)/2];
+		w->pos[heap[i]] = i;
+		i = (i-1)/2;
+	}
+	/* down */
+	for (;;) {
+		unsigned int child = 2*i+1;
+		if (child >= size)
 			break;
-		case nsl_smooth_weight_cosine:
-			for(j=0;j<np;j++) {
-				w[j]=nsl_sf_kernel_cosine((np-1-j)/(double)np);
-				sum += w[j];
-			}
-			for(j=0;j<np;j++)
-				w[j] /= sum;
+		if (child+1 < size && nsl_smooth_window_before(w, low, heap[child+1], heap[child]))
+			child++;
+		if (!nsl_smooth_window_before(w, low, heap[child], slot))
 			break;
-		}
+		heap[i] = heap[child];
+		w->pos[heap[i]] = i;
+		i = child;
+	}
+	heap[i] = slot;
+	w->pos[slot] = i;
+}
 
-		/*printf("(%d) w:",i);
-		for(j=0;j<np;j++)
-			printf(" %g",w[j]);
-		printf(" (half=%d) index = ",half);*/
+static void nsl_smooth_window_push(nsl_smooth_window *w, int low, unsigned int slot) {
+	unsigned int i;
+	if (low) {
+		i = w->nlow++;
+		w->low[i] = slot;
+	} else {
+		i = w->nhigh++;
+		w->high[i] = slot;
+	}
+	w->in_low[slot] = (unsigned char)low;
+	nsl_smooth_window_sift(w, low, i);
+}
 
-		/* calculate weighted average */
-		for(j=0;j<np;j++) {
-			int index=i-np+1+j;
-			switch(mode) {
-			case nsl_smooth_pad_none:
-				result[i] += w[j]*data[i-half+j];
-				/*printf(" %d",index);*/
-				break;
-			case nsl_smooth_pad_interp:
-				printf("not implemented yet\n");
-				break;
-			case nsl_smooth_pad_mirror:
-				index=abs(index);
-				/*printf(" %d",index);*/
-				result[i] += w[j]*data[index];
-				break;
-			case nsl_smooth_pad_nearest:
-				/*printf(" %d",GSL_MAX(0,index));*/
-				result[i] += w[j]*data[index];
-				break;
-			case nsl_smooth_pad_constant:
-				if(index < 0)
-					result[i] += w[j]*nsl_smooth_pad_constant_lvalue;
-				else
-					result[i] += w[j]*data[index];
-
-				break;
-			case nsl_smooth_pad_periodic:
-				if(index < 0)
-					index += n;
-				/*printf(" %d",index);*/
-				result[i] += w[j]*data[index];
-				break;
-			}
-		}
-		/*puts("");*/
-		free(w);
+static void nsl_smooth_window_remove(nsl_smooth_window *w, unsigned int slot) {
+	const int low = w->in_low[slot];
+	unsigned int *heap = low ? w->low : w->high;
+	const unsigned int i = w->pos[slot], last = low ? --w->nlow : --w->nhigh;
+
+	if (i != last) {
+		heap[i] = heap[last];
+		w->pos[heap[i]] = i;
+		nsl_smooth_window_sift(w, low, i);
 	}
+}
 
-	for (i=0; i<n; i++)
-		data[i]=result[i];
-	free(result);
+static void nsl_smooth_window_insert(nsl_smooth_window *w, unsigned int slot, double value) {
+	w->value[slot] = value;
+	nsl_smooth_window_push(w, w->nlow > 0 && value <= w->value[w->low[0]], slot);
+}
 
-	return 0;
+/* move values between the heaps until "low" contains the nlow smallest values */
+static void nsl_smooth_window_balance(nsl_smooth_window *w, unsigned int nlow) {
+	while (w->nlow > nlow) {
+		const unsigned int slot = w->low[0];
+		nsl_smooth_window_remove(w, slot);
+		nsl_smooth_window_push(w, 0, slot);
+	}
+	while (w->nlow < nlow && w->nhigh > 0) {
+		const unsigned int slot = w->high[0];
+		nsl_smooth_window_remove(w, slot);
+		nsl_smooth_window_push(w, 1, slot);
+	}
 }
 
+/* sliding window percentile (quantile type 4) in O(n log(points)) using one allocation */
 int nsl_smooth_percentile(double *data, unsigned int n, unsigned int points, double percentile, nsl_smooth_pad_mode mode) {
-	unsigned int i,j;
-	double *result = (double *)malloc(n*sizeof(double));
+	unsigned int i;
+	long k;
+
+	if (n == 0)
+		return 0;
+	if (points == 0)
+		return -1;
+	if (mode == nsl_smooth_pad_interp) {
+		printf("not implemented yet\n");
+		return -1;
+	}
 
+	const unsigned int half = (points-1)/2;
+	const unsigned int cap = points;
+	char *memory = (char *)malloc(n*sizeof(double) + cap*sizeof(double) + 3*cap*sizeof(unsigned int) + cap);
+	if (memory == NULL)
+		return -1;
+	double *result = (double *)memory;
+	nsl_smooth_window w;
+	w.value = result + n;
+	w.low = (unsigned int *)(w.value + cap);
+	w.high = w.low + cap;
+	w.pos = w.high + cap;
+	w.in_low = (unsigned char *)(w.pos + cap);
+	w.nlow = w.nhigh = 0;
+
+	/* the window [left,right] of (padded) indices moves monotonically */
+	long left = (mode == nsl_smooth_pad_none) ? 0 : -(long)half, right = left-1;
 	for(i=0;i<n;i++) {
-		unsigned int np=points;
-		unsigned int half=(points-1)/2;
+		long l, r;
 		if(mode == nsl_smooth_pad_none) { /* reduce points */
-			half = GSL_MIN(GSL_MIN((points-1)/2,i),n-i-1);
-			np = 2*half+1;
+			const unsigned int h = GSL_MIN(GSL_MIN(half,i),n-i-1);
+			l = (long)i-h;
+			r = (long)i+h;
+		} else {
+			l = (long)i-half;
+			r = l+points-1;
 		}
-
-		double *values = (double *)malloc(np*sizeof(double));
-		for(j=0;j<np;j++) {
-			int index = i-half+j;
-			switch(mode) {
-			case nsl_smooth_pad_none:
-				/*printf(" %d",index);*/
-				values[j] = data[index];
-				break;
-			case nsl_smooth_pad_interp:
-				printf("not implemented yet\n");
-				break;
-			case nsl_smooth_pad_mirror:
-				index=abs(index);
-				/*printf(" %d",GSL_MIN(index,2*(n-1)-index));*/
-				values[j] = data[GSL_MIN(index,2*((int)n-1)-index)];
-				break;
-			case nsl_smooth_pad_nearest:
-				/*printf(" %d",GSL_MIN(n-1,GSL_MAX(0,index)));*/
-				values[j] = data[GSL_MIN((int)n-1,GSL_MAX(0,index))];
-				break;
-			case nsl_smooth_pad_constant:
-				if(index<0)
-					values[j] = nsl_smooth_pad_constant_lvalue;
-				else if(index>(int)n-1)
-					values[j] = nsl_smooth_pad_constant_rvalue;
-				else
-					values[j] = data[index];
-				break;
-			case nsl_smooth_pad_periodic:
-				if(index<0)
-					index = n+index;
-				else if(index>(int)n-1)
-					index = index-n;
-				/*printf(" %d",index);*/
-				values[j] = data[index];
-				break;
-			}
+		for (k = left; k < l && k <= right; k++)
+			nsl_smooth_window_remove(&w, (unsigned int)((k+half)%cap));
+		for (k = GSL_MAX(right+1,l); k <= r; k++)
+			nsl_smooth_window_insert(&w, (unsigned int)((k+half)%cap), nsl_smooth_pad_value(data, n, k, mode));
+		left = l;
+		right = r;
+
+		/* type 4: linear interpolation between the order statistics floor(np*p) and floor(np*p)+1 */
+		const unsigned int np = (unsigned int)(r-l+1);
+		if (percentile < 1./np) {
+			nsl_smooth_window_balance(&w, 0);
+			result[i] = w.value[w.high[0]];
+		} else if (percentile >= 1.0) {
+			nsl_smooth_window_balance(&w, np);
+			result[i] = w.value[w.low[0]];
+		} else {
+			const unsigned int index = (unsigned int)floor(np*percentile);
+			nsl_smooth_window_balance(&w, index);
+			const double lower = w.value[w.low[0]];
+			result[i] = lower + (np*percentile-index)*(w.value[w.high[0]]-lower);
 		}
-		/*puts("");*/
-
-		/*using type 4 as default */
-		result[i] = nsl_stats_quantile(values, 1, np, percentile, nsl_stats_quantile_type4);
-		free(values);
 	}
 
 	for (i=0; i<n; i++)
 		data[i]=result[i];
-	free(result);
+	free(memory);
 
 	return 0;
 }
@@ -28,6 +28,17 @@
 
 #include "nsl_sort.h"
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* number of bits per digit of the radix sort */
+#define NSL_SORT_RADIX_BITS 11
+#define NSL_SORT_RADIX_SIZE (1 << NSL_SORT_RADIX_BITS)
+/* minimum number of keys processed by one thread */
+#define NSL_SORT_CHUNK_SIZE 100000
 
 int nsl_sort_compare_size_t(const void* a, const void* b) {
 	size_t _a = * ( (size_t*) a );
@@ -41,3 +52,126 @@ void nsl_sort_size_t(size_t array[], const size_t n) {
 	qsort(array, n, sizeof(size_t), nsl_sort_compare_size_t);
 }
 
+
+int nsl_sort_radix_index(const uint64_t keys[], const size_t n, size_t index[]) {
+	size_t i;
+	int t, nthreads = 1;
+#ifdef _OPENMP
+	nthreads = omp_get_max_threads();
+	if (n/NSL_SORT_CHUNK_SIZE < (size_t)nthreads)
+		nthreads = (int)(n/NSL_SORT_CHUNK_SIZE);
+	if (nthreads < 1)
+		nthreads = 1;
+#endif
+
+	uint64_t *key1 = (uint64_t *)malloc(n*sizeof(uint64_t));
+	uint64_t *key2 = (uint64_t *)malloc(n*sizeof(uint64_t));
+	size_t *index2 = (size_t *)malloc(n*sizeof(size_t));
+	/* count[t*NSL_SORT_RADIX_SIZE + d]: number of keys with digit d in the chunk of thread t, later its first position */
+	size_t *count = (size_t *)malloc(nthreads*NSL_SORT_RADIX_SIZE*sizeof(size_t));
+	if (key1 == NULL || key2 == NULL || index2 == NULL || count == NULL) {
+		free(key1);
+		free(key2);
+		free(index2);
+		free(count);
+		return -1;
+	}
+
+	memcpy(key1, keys, n*sizeof(uint64_t));
+	for (i = 0; i < n; i++)
+		index[i] = i;
+
+	uint64_t *keyin = key1, *keyout = key2, *ktmp;
+	size_t *indexin = index, *indexout = index2, *itmp;
+	unsigned int shift;
+	for (shift = 0; shift < 64; shift += NSL_SORT_RADIX_BITS) {
+		memset(count, 0, nthreads*NSL_SORT_RADIX_SIZE*sizeof(size_t));
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if(nthreads > 1)
+#endif
+		for (t = 0; t < nthreads; t++) {
+			const size_t start = t*n/nthreads, end = (t+1)*n/nthreads;
+			size_t *c = count + t*NSL_SORT_RADIX_SIZE, j;
+			for (j = start; j < end; j++)
+				c[(keyin[j] >> shift) & (NSL_SORT_RADIX_SIZE - 1)]++;
+		}
+
+		/* first position of every digit in every chunk. The pass is skipped if all keys have the same digit */
+		size_t d, sum = 0;
+		int skip = 0;
+		for (d = 0; d < NSL_SORT_RADIX_SIZE; d++) {
+			size_t total = 0;
+			for (t = 0; t < nthreads; t++) {
+				const size_t tmp = count[t*NSL_SORT_RADIX_SIZE + d];
+				count[t*NSL_SORT_RADIX_SIZE + d] = sum + total;
+				total += tmp;
+			}
+			if (total == n)
+				skip = 1;
+			sum += total;
+		}
+		if (skip)
+			continue;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if(nthreads > 1)
+#endif
+		for (t = 0; t < nthreads; t++) {
+			const size_t start = t*n/nthreads, end = (t+1)*n/nthreads;
+			size_t *c = count + t*NSL_SORT_RADIX_SIZE, j;
+			for (j = start; j < end; j++) {
+				const size_t pos = c[(keyin[j] >> shift) & (NSL_SORT_RADIX_SIZE - 1)]++;
+				keyout[pos] = keyin[j];
+				indexout[pos] = indexin[j];
+			}
+		}
+
+		ktmp = keyin, keyin = keyout, keyout = ktmp;
+		itmp = indexin, indexin = indexout, indexout = itmp;
+	}
+
+	if (indexin != index)
+		memcpy(index, indexin, n*sizeof(size_t));
+
+	free(key1);
+	free(key2);
+	free(index2);
+	free(count);
+
+	return 0;
+}
+
+uint64_t nsl_sort_double_key(double value) {
+	if (value == 0)
+		value = 0.;	/* -0 */
+
+	uint64_t u;
+	memcpy(&u, &value, sizeof(u));
+	/* negative numbers: reverse the order, positive numbers: put behind the negative ones */
+	return (u >> 63) ? ~u : (u | ((uint64_t)1 << 63));
+}
+
+int nsl_sort_double_index(const double data[], const size_t n, int ascending, size_t index[]) {
+	uint64_t *keys = (uint64_t *)malloc(n*sizeof(uint64_t));
+	if (keys == NULL)
+		return -1;
+
+	size_t i;
+#ifdef _OPENMP
+#pragma omp parallel for if(n > NSL_SORT_CHUNK_SIZE)
+#endif
+	for (i = 0; i < n; i++) {
+		if (isnan(data[i]))
+			keys[i] = UINT64_MAX;
+		else if (ascending)
+			keys[i] = nsl_sort_double_key(data[i]);
+		else
+			keys[i] = ~nsl_sort_double_key(data[i]);
+	}
+
+	int status = nsl_sort_radix_index(keys, n, index);
+	free(keys);
+
+	return status;
+}
@@ -30,6 +30,7 @@
 #define NSL_SORT_H
 
 #include <stdlib.h>
+#include <stdint.h>
 
 /* compare size_t objects */
 int nsl_sort_compare_size_t(const void* a, const void* b); 
@@ -37,4 +38,14 @@ int nsl_sort_compare_size_t(const void* a, const void* b);
 /* sort size_t array of size n */
 void nsl_sort_size_t(size_t array[], const size_t n);
 
+/* stable sort of the n keys: index[] is set to the permutation with keys[index[0]] <= keys[index[1]] <= ...
+	LSD radix sort (11 bit digits), histograms and scattering of the digits run in parallel (OpenMP) for large n.
+	returns -1 if out of memory */
+int nsl_sort_radix_index(const uint64_t keys[], const size_t n, size_t index[]);
+/* key of value with the same order as value (-0 and 0 are equal). Apply ~ for descending order */
+uint64_t nsl_sort_double_key(double value);
+/* stable sort permutation of the n values of data (ascending if ascending != 0, else descending), NaN are put last.
+	returns -1 if out of memory */
+int nsl_sort_double_index(const double data[], const size_t n, int ascending, size_t index[]);
+
 #endif /* NSL_SORT_H */
@@ -0,0 +1,71 @@
+/***************************************************************************
+    File                 : nsl_sort_test.c
+    Project              : LabPlot
+    Description          : NSL sorting functions
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include "nsl_sort.h"
+
+int main() {
+	double data[]={3, -1, NAN, 2, -0., -1, 0, 5, -7.5, 2};
+	const size_t n=10;
+	size_t index[10];
+
+	printf("data:\n");
+	size_t i;
+	for (i=0; i < n; i++)
+		printf("%g ", data[i]);
+	puts("\n");
+
+	printf("ascending (stable, NaN last):\n");
+	int status = nsl_sort_double_index(data, n, 1, index);
+	for (i=0; i < n; i++)
+		printf("%g(%zu) ", data[index[i]], index[i]);
+	puts("\n");
+
+	printf("descending (stable, NaN last):\n");
+	status = nsl_sort_double_index(data, n, 0, index);
+	for (i=0; i < n; i++)
+		printf("%g(%zu) ", data[index[i]], index[i]);
+	puts("\n");
+
+	printf("check with large random data:\n");
+	const size_t m=1000000;
+	double *rdata = (double *)malloc(m*sizeof(double));
+	size_t *rindex = (size_t *)malloc(m*sizeof(size_t));
+	for (i=0; i < m; i++)
+		rdata[i] = (rand() % 20001 - 10000)/3.;
+	status = nsl_sort_double_index(rdata, m, 1, rindex);
+	size_t errors = 0;
+	for (i=1; i < m; i++)
+		if (rdata[rindex[i-1]] > rdata[rindex[i]] || (rdata[rindex[i-1]] == rdata[rindex[i]] && rindex[i-1] > rindex[i]))
+			errors++;
+	printf("status = %d, errors = %zu\n", status, errors);
+	free(rdata);
+	free(rindex);
+
+	return 0;
+}
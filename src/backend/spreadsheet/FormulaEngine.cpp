@@ -0,0 +1,379 @@
+/***************************************************************************
+    File                 : FormulaEngine.cpp
+    Project              : LabPlot
+    Description          : Dependency-ordered recalculation of formula columns
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "FormulaEngine.h"
+#include "backend/core/Project.h"
+#include "backend/core/column/Column.h"
+#include "backend/lib/macros.h"
+
+#include <QTimer>
+#include <QVector>
+#include <QtConcurrentMap>
+#include <KLocale>
+
+#include <cmath>
+
+extern "C" {
+#include "backend/gsl/parser_expr.h"
+}
+
+/*!
+  \class FormulaEngine
+  \brief Recalculation of the formula columns of a project in the order of their dependencies.
+
+  A column with a formula (see Column::setFormula()) depends on the columns given by the pathes of its variables,
+  also on columns of other spreadsheets. The engine keeps the graph of these dependencies and recalculates
+  the formula columns depending directly or indirectly on a column when the data of the column was changed.
+  The formula columns are calculated in waves, the columns of a wave only depend on columns of earlier waves.
+  The columns of a wave and blocks of their rows are evaluated in parallel.
+
+  Formula columns on a cycle of dependencies and the columns depending on them are not recalculated,
+  see cyclicColumns().
+
+  The automatic recalculation after a change of the data is not undoable, undoing the change recalculates
+  the formula columns again. recalculate() is part of the current undo macro.
+
+  \ingroup backend
+*/
+
+//formula of a column with the data of its variables, the result is calculated in blocks of rows
+struct FormulaJob {
+	Column* column;
+	parser_expr* expr;
+	QVector< QVector<double> > inputs;
+	QVector<const double*> x;
+	QVector<double> result;
+	double* data;
+	QAtomicInt failed;
+};
+
+struct FormulaBlock {
+	FormulaJob* job;
+	int start;
+	int count;
+};
+
+static void evaluateBlock(FormulaBlock& block) {
+	FormulaJob* job = block.job;
+	QVector<const double*> x(job->x.size());
+	for (int i = 0; i < x.size(); ++i)
+		x[i] = job->x.at(i) + block.start;
+
+	double* result = job->data + block.start;
+	if (parser_expr_eval_columns(job->expr, 0, x.constData(), block.count, result, 0) != 0) {
+		job->failed.ref();
+		return;
+	}
+
+	for (int i = 0; i < block.count; ++i)
+		if (!std::isfinite(result[i]))
+			result[i] = NAN;
+}
+
+FormulaEngine::FormulaEngine(Project* project) : QObject(project), m_project(project), m_graphValid(false),
+	m_recalculating(false), m_recalculationScheduled(false) {
+
+	connect(project, SIGNAL(aspectAdded(const AbstractAspect*)), this, SLOT(handleAspectAdded(const AbstractAspect*)));
+	connect(project, SIGNAL(aspectAboutToBeRemoved(const AbstractAspect*)), this, SLOT(invalidateGraph()));
+	connect(project, SIGNAL(aspectDescriptionChanged(const AbstractAspect*)), this, SLOT(invalidateGraph()));
+	connectColumns(project);
+}
+
+/*!
+  recalculates the formula \c columns and all formula columns depending on them now.
+  The new values are part of the current undo macro.
+*/
+void FormulaEngine::recalculate(const QList<Column*>& columns) {
+	recalculate(columns.toSet(), true);
+}
+
+/*!
+  formula columns on a cycle of dependencies or depending on such a cycle, these columns are not recalculated
+*/
+QList<Column*> FormulaEngine::cyclicColumns() {
+	updateGraph();
+	return m_cyclic;
+}
+
+/*!
+  returns \c true while the formula columns are written
+*/
+bool FormulaEngine::isRecalculating() const {
+	return m_recalculating;
+}
+
+void FormulaEngine::handleAspectAdded(const AbstractAspect* aspect) {
+	connectColumns(aspect);
+	invalidateGraph();
+}
+
+void FormulaEngine::invalidateGraph() {
+	m_graphValid = false;
+}
+
+/*!
+  remembers the changed column, the formula columns depending on it are recalculated
+  when the control returns to the event loop, so several changes are handled together.
+*/
+void FormulaEngine::handleDataChanged(const AbstractColumn* source) {
+	if (m_recalculating || m_project->isLoading())
+		return;
+
+	updateGraph();
+	Column* column = const_cast<Column*>(qobject_cast<const Column*>(source));
+	if (!m_dependents.contains(column))
+		return;
+
+	m_dirty << column;
+	if (!m_recalculationScheduled) {
+		m_recalculationScheduled = true;
+		QTimer::singleShot(0, this, SLOT(recalculateDirty()));
+	}
+}
+
+void FormulaEngine::recalculateDirty() {
+	m_recalculationScheduled = false;
+	updateGraph();
+
+	QSet<Column*> columns;
+	foreach (Column* column, m_dirty)
+		columns += m_dependents.value(column).toSet();
+	m_dirty.clear();
+
+	recalculate(columns, false);
+}
+
+void FormulaEngine::connectColumns(const AbstractAspect* aspect) {
+	QList<Column*> columns = aspect->children<Column>(AbstractAspect::Recursive | AbstractAspect::IncludeHidden);
+	const Column* column = qobject_cast<const Column*>(aspect);
+	if (column)
+		columns << const_cast<Column*>(column);
+
+	foreach (Column* col, columns) {
+		connect(col, SIGNAL(dataChanged(const AbstractColumn*)), this, SLOT(handleDataChanged(const AbstractColumn*)), Qt::UniqueConnection);
+		connect(col, SIGNAL(formulaChanged(const Column*)), this, SLOT(invalidateGraph()), Qt::UniqueConnection);
+	}
+}
+
+/*!
+  determines the input columns of the formula columns from the pathes of the variables
+  and the formula columns on cycles
+*/
+void FormulaEngine::updateGraph() {
+	if (m_graphValid)
+		return;
+
+	m_inputs.clear();
+	m_dependents.clear();
+
+	const QList<Column*> columns = m_project->children<Column>(AbstractAspect::Recursive | AbstractAspect::IncludeHidden);
+	QHash<QString, Column*> pathes;
+	foreach (Column* column, columns)
+		pathes[column->path()] = column;
+
+	foreach (Column* column, columns) {
+		if (column->formula().isEmpty())
+			continue;
+
+		//unknown pathes are kept as 0, such formulas can't be evaluated
+		QList<Column*> inputs;
+		foreach (const QString& path, column->formulaVariableColumnPathes()) {
+			Column* input = pathes.value(path);
+			inputs << input;
+			if (input && !m_dependents.value(input).contains(column))
+				m_dependents[input] << column;
+		}
+		m_inputs[column] = inputs;
+	}
+
+	//forget the changes of removed columns
+	m_dirty.intersect(columns.toSet());
+
+	m_cyclic.clear();
+	waves(m_inputs.keys().toSet(), m_cyclic);
+	m_graphValid = true;
+}
+
+/*!
+  divides the formula \c columns into waves, the columns of a wave only depend on columns of earlier waves
+  or on columns not contained in \c columns. The columns on cycles and behind them are returned in \c cyclic.
+*/
+QList< QList<Column*> > FormulaEngine::waves(const QSet<Column*>& columns, QList<Column*>& cyclic) const {
+	QHash<Column*, int> pending;
+	QList<Column*> wave;
+	foreach (Column* column, columns) {
+		QSet<Column*> inputs = m_inputs.value(column).toSet();
+		inputs.intersect(columns);
+		pending[column] = inputs.size();
+		if (inputs.isEmpty())
+			wave << column;
+	}
+
+	QList< QList<Column*> > result;
+	QSet<Column*> done;
+	while (!wave.isEmpty()) {
+		result << wave;
+		QList<Column*> next;
+		foreach (Column* column, wave) {
+			done << column;
+			foreach (Column* dependent, m_dependents.value(column)) {
+				if (columns.contains(dependent) && --pending[dependent] == 0)
+					next << dependent;
+			}
+		}
+		wave = next;
+	}
+
+	foreach (Column* column, columns) {
+		if (!done.contains(column))
+			cyclic << column;
+	}
+
+	return result;
+}
+
+/*!
+  recalculates the formula \c columns and all formula columns depending on them.
+  The values are written undoable if \c undoable is \c true.
+*/
+void FormulaEngine::recalculate(const QSet<Column*>& columns, bool undoable) {
+	if (m_recalculating)
+		return;
+
+	updateGraph();
+
+	//the formula columns depending directly or indirectly on columns
+	QSet<Column*> affected;
+	QList<Column*> queue = columns.toList();
+	while (!queue.isEmpty()) {
+		Column* column = queue.takeLast();
+		if (!m_inputs.contains(column) || affected.contains(column))
+			continue;
+		affected << column;
+		queue << m_dependents.value(column);
+	}
+	if (affected.isEmpty())
+		return;
+
+	QList<Column*> cyclic;
+	const QList< QList<Column*> > order = waves(affected, cyclic);
+	if (!cyclic.isEmpty()) {
+		QStringList names;
+		foreach (Column* column, cyclic)
+			names << column->name();
+		emit statusInfo(i18n("Circular dependency of the formulas, the columns %1 were not recalculated", names.join(", ")));
+	}
+
+	WAIT_CURSOR;
+	m_recalculating = true;
+	foreach (const QList<Column*>& wave, order)
+		evaluate(wave, undoable);
+	m_recalculating = false;
+	RESET_CURSOR;
+}
+
+/*!
+  evaluates the formulas of \c columns, which don't depend on each other, and writes the results into the columns
+*/
+void FormulaEngine::evaluate(const QList<Column*>& columns, bool undoable) {
+	//the rows of the columns are evaluated in blocks in the thread pool
+	const int BlockSize = 32768;
+
+	QList<FormulaJob*> jobs;
+	QVector<FormulaBlock> blocks;
+	foreach (Column* column, columns) {
+		if (column->columnMode() != AbstractColumn::Numeric)
+			continue;
+
+		const QList<Column*>& inputs = m_inputs.value(column);
+		const QStringList& names = column->formulaVariableNames();
+		if (inputs.size() != names.size() || inputs.contains(0)) {
+			emit statusInfo(i18n("The formula of the column %1 uses unknown columns", column->name()));
+			continue;
+		}
+
+		QList<QByteArray> nameData;
+		QVector<const char*> namePointers;
+		foreach (const QString& name, names) {
+			nameData << name.toLocal8Bit();
+			namePointers << nameData.last().constData();
+		}
+		parser_expr* expr = parser_expr_compile(column->formula().toLocal8Bit().constData(), namePointers.constData(), names.size());
+		if (!expr) {
+			emit statusInfo(i18n("The formula of the column %1 is invalid", column->name()));
+			continue;
+		}
+
+		FormulaJob* job = new FormulaJob;
+		job->column = column;
+		job->expr = expr;
+
+		//values of the variables, the result is NaN in the rows behind the shortest input
+		int rows = column->rowCount();
+		foreach (Column* input, inputs) {
+			QVector<double> values;
+			if (input->columnMode() == AbstractColumn::Numeric)
+				values = *static_cast<QVector<double>*>(input->data());
+			else {
+				values.resize(input->rowCount());
+				for (int row = 0; row < values.size(); ++row)
+					values[row] = input->valueAt(row);
+			}
+			rows = qMin(rows, values.size());
+			job->inputs << values;
+			job->x << job->inputs.last().constData();
+		}
+
+		job->result = QVector<double>(column->rowCount(), NAN);
+		job->data = job->result.data();
+		jobs << job;
+
+		for (int start = 0; start < rows; start += BlockSize) {
+			FormulaBlock block;
+			block.job = job;
+			block.start = start;
+			block.count = qMin(BlockSize, rows - start);
+			blocks << block;
+		}
+	}
+
+	QtConcurrent::blockingMap(blocks, evaluateBlock);
+
+	foreach (FormulaJob* job, jobs) {
+		if (job->failed == 0) {
+			if (!undoable)
+				job->column->setUndoAware(false);
+			job->column->replaceValues(0, job->result);
+			if (!undoable)
+				job->column->setUndoAware(true);
+		}
+
+		parser_expr_free(job->expr);
+		delete job;
+	}
+}
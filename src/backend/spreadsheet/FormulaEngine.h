@@ -0,0 +1,78 @@
+/***************************************************************************
+    File                 : FormulaEngine.h
+    Project              : LabPlot
+    Description          : Dependency-ordered recalculation of formula columns
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef FORMULAENGINE_H
+#define FORMULAENGINE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+
+class AbstractAspect;
+class AbstractColumn;
+class Column;
+class Project;
+
+class FormulaEngine : public QObject {
+	Q_OBJECT
+
+	public:
+		explicit FormulaEngine(Project* project);
+
+		void recalculate(const QList<Column*>& columns);
+		QList<Column*> cyclicColumns();
+		bool isRecalculating() const;
+
+	signals:
+		void statusInfo(const QString&);
+
+	private slots:
+		void handleAspectAdded(const AbstractAspect*);
+		void invalidateGraph();
+		void handleDataChanged(const AbstractColumn*);
+		void recalculateDirty();
+
+	private:
+		void connectColumns(const AbstractAspect*);
+		void updateGraph();
+		QList< QList<Column*> > waves(const QSet<Column*>& columns, QList<Column*>& cyclic) const;
+		void recalculate(const QSet<Column*>& columns, bool undoable);
+		void evaluate(const QList<Column*>& columns, bool undoable);
+
+		Project* m_project;
+		bool m_graphValid;
+		bool m_recalculating;
+		bool m_recalculationScheduled;
+		QHash<Column*, QList<Column*> > m_inputs;	//input columns of the formula columns
+		QHash<Column*, QList<Column*> > m_dependents;	//formula columns using a column
+		QList<Column*> m_cyclic;
+		QSet<Column*> m_dirty;	//columns whose data was changed since the last recalculation
+};
+
+#endif
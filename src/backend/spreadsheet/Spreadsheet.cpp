@@ -32,15 +32,26 @@
 #include "backend/core/AbstractAspect.h"
 #include "commonfrontend/spreadsheet/SpreadsheetView.h"
 #include "kdefrontend/spreadsheet/ExportSpreadsheetDialog.h"
+#include "backend/lib/PackedDateTime.h"
+#include "backend/lib/TextDictionary.h"
 
 #include <QPrinter>
 #include <QPrintDialog>
 #include <QPrintPreviewDialog>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include <KIcon>
 #include <KConfigGroup>
 #include <KLocale>
 
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "backend/nsl/nsl_sort.h"
+}
+
 /*!
   \class Spreadsheet
   \brief Aspect providing a spreadsheet table with column logic.
@@ -134,9 +145,13 @@ bool Spreadsheet::exportView() const {
 			const int exportTo = dlg->exportToFits();
 			const bool commentsAsUnits = dlg->commentsAsUnitsFits();
 			view->exportToFits(path, exportTo, commentsAsUnits);
+		} else if (dlg->format() == ExportSpreadsheetDialog::ColumnarBinary) {
+			const bool compression = dlg->compression();
+			view->exportToColumnarBinary(path, compression);
 		} else {
 			const QString separator = dlg->separator();
-			view->exportToFile(path, exportHeader, separator);
+			const bool fullPrecision = dlg->fullPrecision();
+			view->exportToFile(path, exportHeader, separator, fullPrecision);
 		}
 		RESET_CURSOR;
 	}
@@ -430,233 +445,170 @@ int Spreadsheet::colY(int col)
 	return -1;
 }
 
-/*! Sorts the given list of column.
-  If 'leading' is a null pointer, each column is sorted separately.
+/*!
+  stable sort of the chunks [begin, end) of the row indices \c index by the texts of the rows.
+  Used by sortPermutation() to sort the chunks in parallel.
 */
-void Spreadsheet::sortColumns(Column *leading, QList<Column*> cols, bool ascending)
-{
-	if(cols.isEmpty()) return;
+class TextSortChunk {
+	public:
+		TextSortChunk(const QStringList& texts, QVector<int>& index, bool ascending) : m_texts(texts), m_index(index), m_ascending(ascending) {}
+		typedef void result_type;
+
+		void operator()(const QPair<int, int>& range) const {
+			if (m_ascending)
+				std::stable_sort(m_index.begin() + range.first, m_index.begin() + range.second, Less(m_texts));
+			else
+				std::stable_sort(m_index.begin() + range.first, m_index.begin() + range.second, Greater(m_texts));
+		}
 
-	// the normal QPair comparison does not work properly with descending sorting
-	// thefore we use our own compare functions
-	class CompareFunctions {
-		public:
-			static bool doubleLess(const QPair<double, int>& a, const QPair<double, int>& b)
-			{
-				return a.first < b.first;
-			}
-			static bool doubleGreater(const QPair<double, int>& a, const QPair<double, int>& b)
-			{
-				return a.first > b.first;
-			}
-			static bool QStringLess(const QPair<QString, int>& a, const QPair<QString, int>& b)
-			{
-				return a < b;
-			}
-			static bool QStringGreater(const QPair<QString, int>& a, const QPair<QString, int>& b)
-			{
-				return a > b;
-			}
-			static bool QDateTimeLess(const QPair<QDateTime, int>& a, const QPair<QDateTime, int>& b)
-			{
-				return a < b;
-			}
-			static bool QDateTimeGreater(const QPair<QDateTime, int>& a, const QPair<QDateTime, int>& b)
-			{
-				return a > b;
-			}
-	};
+		void merge(int begin, int middle, int end, int* out) const {
+			if (m_ascending)
+				std::merge(m_index.constBegin() + begin, m_index.constBegin() + middle,
+						m_index.constBegin() + middle, m_index.constBegin() + end, out, Less(m_texts));
+			else
+				std::merge(m_index.constBegin() + begin, m_index.constBegin() + middle,
+						m_index.constBegin() + middle, m_index.constBegin() + end, out, Greater(m_texts));
+		}
 
-	WAIT_CURSOR;
-	beginMacro(i18n("%1: sort columns", name()));
+	private:
+		struct Less {
+			explicit Less(const QStringList& texts) : t(texts) {}
+			bool operator()(int a, int b) const { return t.at(a) < t.at(b); }
+			const QStringList& t;
+		};
+		struct Greater {
+			explicit Greater(const QStringList& texts) : t(texts) {}
+			bool operator()(int a, int b) const { return t.at(a) > t.at(b); }
+			const QStringList& t;
+		};
+
+		const QStringList& m_texts;
+		QVector<int>& m_index;
+		bool m_ascending;
+};
 
-	if(leading == 0) { // sort separately
-		foreach(Column *col, cols) {
-			switch (col->columnMode()) {
-				case AbstractColumn::Numeric:
-					{
-						int rows = col->rowCount();
-						QList< QPair<double, int> > map;
-
-						for(int j=0; j<rows; j++)
-							map.append(QPair<double, int>(col->valueAt(j), j));
-
-						if(ascending)
-							qStableSort(map.begin(), map.end(), CompareFunctions::doubleLess);
-						else
-							qStableSort(map.begin(), map.end(), CompareFunctions::doubleGreater);
-
-						QListIterator< QPair<double, int> > it(map);
-						Column *temp_col = new Column("temp", col->columnMode());
-
-						int k=0;
-						// put the values in the right order into temp_col
-						while(it.hasNext()) {
-							temp_col->copy(col, it.peekNext().second, k, 1);
-							temp_col->setMasked(col->isMasked(it.next().second));
-							k++;
-						}
-						// copy the sorted column
-						col->copy(temp_col, 0, 0, rows);
-						delete temp_col;
-						break;
-					}
-				case AbstractColumn::Text:
-					{
-						int rows = col->rowCount();
-						QList< QPair<QString, int> > map;
-
-						for(int j=0; j<rows; j++)
-							map.append(QPair<QString, int>(col->textAt(j), j));
-
-						if(ascending)
-							qStableSort(map.begin(), map.end(), CompareFunctions::QStringLess);
-						else
-							qStableSort(map.begin(), map.end(), CompareFunctions::QStringGreater);
-
-						QListIterator< QPair<QString, int> > it(map);
-						Column *temp_col = new Column("temp", col->columnMode());
-
-						int k=0;
-						// put the values in the right order into temp_col
-						while(it.hasNext()) {
-							temp_col->copy(col, it.peekNext().second, k, 1);
-							temp_col->setMasked(col->isMasked(it.next().second));
-							k++;
-						}
-						// copy the sorted column
-						col->copy(temp_col, 0, 0, rows);
-						delete temp_col;
-						break;
-					}
-				case AbstractColumn::DateTime:
-				case AbstractColumn::Month:
-				case AbstractColumn::Day:
-					{
-						int rows = col->rowCount();
-						QList< QPair<QDateTime, int> > map;
-
-						for(int j=0; j<rows; j++)
-							map.append(QPair<QDateTime, int>(col->dateTimeAt(j), j));
-
-						if(ascending)
-							qStableSort(map.begin(), map.end(), CompareFunctions::QDateTimeLess);
-						else
-							qStableSort(map.begin(), map.end(), CompareFunctions::QDateTimeGreater);
-
-						QListIterator< QPair<QDateTime, int> > it(map);
-						Column *temp_col = new Column("temp", col->columnMode());
-
-						int k=0;
-						// put the values in the right order into temp_col
-						while(it.hasNext()) {
-							temp_col->copy(col, it.peekNext().second, k, 1);
-							temp_col->setMasked(col->isMasked(it.next().second));
-							k++;
-						}
-						// copy the sorted column
-						col->copy(temp_col, 0, 0, rows);
-						delete temp_col;
-						break;
-					}
+/*!
+  returns the permutation of the rows sorting the column \c col (stable, NaN and invalid dates last).
+  Numeric and date-time columns are sorted with the radix sort of nsl, text columns
+  with few distinct texts by the ranks of their dictionary codes with the radix sort, too,
+  other text columns with a merge sort running on all available threads.
+*/
+static QVector<int> sortPermutation(const Column* col, bool ascending) {
+	const int rows = col->rowCount();
+	QVector<int> permutation(rows);
+	if (rows == 0)
+		return permutation;
+
+	std::vector<size_t> index(rows);
+	switch (col->columnMode()) {
+		case AbstractColumn::Numeric: {
+				const QVector<double>* data = static_cast<QVector<double>* >(col->data());
+				if (nsl_sort_double_index(data->constData(), rows, ascending, &index[0]) != 0)
+					return QVector<int>();
+				break;
 			}
-		}
-	} else { // sort with leading column
-		switch (leading->columnMode()) {
-			case AbstractColumn::Numeric:
-				{
-					QList< QPair<double, int> > map;
-					int rows = leading->rowCount();
-
-					for(int i=0; i<rows; i++)
-						map.append(QPair<double, int>(leading->valueAt(i), i));
-
-					if(ascending)
-						qStableSort(map.begin(), map.end(), CompareFunctions::doubleLess);
-					else
-						qStableSort(map.begin(), map.end(), CompareFunctions::doubleGreater);
-					QListIterator< QPair<double, int> > it(map);
-
-					foreach (Column *col, cols) {
-						Column *temp_col = new Column("temp", col->columnMode());
-						it.toFront();
-						int j=0;
-						// put the values in the right order into temp_col
-						while(it.hasNext()) {
-							temp_col->copy(col, it.peekNext().second, j, 1);
-							temp_col->setMasked(col->isMasked(it.next().second));
-							j++;
-						}
-						// copy the sorted column
-						col->copy(temp_col, 0, 0, rows);
-						delete temp_col;
+		case AbstractColumn::DateTime:
+		case AbstractColumn::Month:
+		case AbstractColumn::Day: {
+				const qint64* data = static_cast<QVector<qint64>* >(col->data())->constData();
+				std::vector<uint64_t> keys(rows);
+				for (int i = 0; i < rows; ++i) {
+					if (!PackedDateTime::isValid(data[i])) {
+						keys[i] = ~(uint64_t)0;
+						continue;
 					}
-					break;
+					//flip the sign bit to get the order of the signed packed values for unsigned keys, ~ for descending order
+					const uint64_t key = (uint64_t)data[i] ^ ((uint64_t)1 << 63);
+					keys[i] = ascending ? key : ~key;
 				}
-			case AbstractColumn::Text:
-				{
-					QList< QPair<QString, int> > map;
-					int rows = leading->rowCount();
-
-					for(int i=0; i<rows; i++)
-						map.append(QPair<QString, int>(leading->textAt(i), i));
-
-					if(ascending)
-						qStableSort(map.begin(), map.end(), CompareFunctions::QStringLess);
-					else
-						qStableSort(map.begin(), map.end(), CompareFunctions::QStringGreater);
-					QListIterator< QPair<QString, int> > it(map);
-
-					foreach (Column *col, cols) {
-						Column *temp_col = new Column("temp", col->columnMode());
-						it.toFront();
-						int j=0;
-						// put the values in the right order into temp_col
-						while(it.hasNext()) {
-							temp_col->copy(col, it.peekNext().second, j, 1);
-							temp_col->setMasked(col->isMasked(it.next().second));
-							j++;
-						}
-						// copy the sorted column
-						col->copy(temp_col, 0, 0, rows);
-						delete temp_col;
+				if (nsl_sort_radix_index(&keys[0], rows, &index[0]) != 0)
+					return QVector<int>();
+				break;
+			}
+		case AbstractColumn::Text: {
+				const QStringList* texts = static_cast<QStringList*>(col->data());
+
+				//columns with few distinct texts are sorted by the rank of the codes of their texts
+				QVector<int> codes;
+				QStringList dictionary;
+				if (TextDictionary::encode(*texts, qMin(rows/4, 65536), codes, dictionary)) {
+					QStringList sorted = dictionary;
+					qSort(sorted);
+					const TextDictionary sortedCodes(sorted);
+					QVector<uint64_t> ranks(dictionary.size());
+					for (int c = 0; c < dictionary.size(); ++c)
+						ranks[c] = sortedCodes.code(dictionary.at(c)) + 1;
+
+					//null strings are equal to empty strings, which are smaller than all other texts
+					const uint64_t nullRank = (!sorted.isEmpty() && sorted.first().isEmpty()) ? 1 : 0;
+					std::vector<uint64_t> keys(rows);
+					for (int i = 0; i < rows; ++i) {
+						const uint64_t key = (codes.at(i) < 0) ? nullRank : ranks.at(codes.at(i));
+						keys[i] = ascending ? key : ~key;
 					}
+					if (nsl_sort_radix_index(&keys[0], rows, &index[0]) != 0)
+						return QVector<int>();
 					break;
 				}
-			case AbstractColumn::DateTime:
-			case AbstractColumn::Month:
-			case AbstractColumn::Day:
-				{
-					QList< QPair<QDateTime, int> > map;
-					int rows = leading->rowCount();
-
-					for(int i=0; i<rows; i++)
-						map.append(QPair<QDateTime, int>(leading->dateTimeAt(i), i));
-
-					if(ascending)
-						qStableSort(map.begin(), map.end(), CompareFunctions::QDateTimeLess);
-					else
-						qStableSort(map.begin(), map.end(), CompareFunctions::QDateTimeGreater);
-					QListIterator< QPair<QDateTime, int> > it(map);
-
-					foreach (Column *col, cols) {
-						Column *temp_col = new Column("temp", col->columnMode());
-						it.toFront();
-						int j=0;
-						// put the values in the right order into temp_col
-						while(it.hasNext()) {
-							temp_col->copy(col, it.peekNext().second, j, 1);
-							temp_col->setMasked(col->isMasked(it.next().second));
-							j++;
-						}
-						// copy the sorted column
-						col->copy(temp_col, 0, 0, rows);
-						delete temp_col;
+
+				for (int i = 0; i < rows; ++i)
+					permutation[i] = i;
+
+				//sort chunks of the rows in parallel and merge neighbouring chunks until one chunk is left
+				const int chunks = qBound(1, qMin(QThread::idealThreadCount(), rows/10000), 64);
+				QList< QPair<int, int> > ranges;
+				for (int c = 0; c < chunks; ++c)
+					ranges << qMakePair(c*rows/chunks, (c + 1)*rows/chunks);
+
+				TextSortChunk sorter(*texts, permutation, ascending);
+				QtConcurrent::blockingMap(ranges, sorter);
+
+				QVector<int> merged(rows);
+				while (ranges.size() > 1) {
+					QList< QPair<int, int> > mergedRanges;
+					for (int r = 0; r + 1 < ranges.size(); r += 2) {
+						sorter.merge(ranges.at(r).first, ranges.at(r).second, ranges.at(r + 1).second, merged.data() + ranges.at(r).first);
+						mergedRanges << qMakePair(ranges.at(r).first, ranges.at(r + 1).second);
 					}
-					break;
+					if (ranges.size() % 2) {
+						const QPair<int, int>& last = ranges.last();
+						qCopy(permutation.constBegin() + last.first, permutation.constBegin() + last.second, merged.begin() + last.first);
+						mergedRanges << last;
+					}
+					permutation.swap(merged);
+					ranges = mergedRanges;
 				}
-		}
+				return permutation;
+			}
 	}
+
+	for (int i = 0; i < rows; ++i)
+		permutation[i] = (int)index[i];
+	return permutation;
+}
+
+/*! Sorts the given list of column.
+  If 'leading' is a null pointer, each column is sorted separately.
+
+  The permutation sorting the rows is determined once (for the leading column or for every column)
+  and applied to the data and the masks of the columns in one pass, see Column::permuteRows().
+*/
+void Spreadsheet::sortColumns(Column *leading, QList<Column*> cols, bool ascending)
+{
+	if(cols.isEmpty()) return;
+
+	WAIT_CURSOR;
+	beginMacro(i18n("%1: sort columns", name()));
+
+	if(leading == 0) { // sort separately
+		foreach(Column *col, cols)
+			col->permuteRows(sortPermutation(col, ascending));
+	} else { // sort with leading column
+		const QVector<int> permutation = sortPermutation(leading, ascending);
+		foreach(Column *col, cols)
+			col->permuteRows(permutation);
+	}
+
 	endMacro();
 	RESET_CURSOR;
 } // end of sortColumns()
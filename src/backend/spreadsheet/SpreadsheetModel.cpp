@@ -29,15 +29,19 @@
  ***************************************************************************/
 
 #include "backend/core/column/Column.h"
+#include "backend/core/datatypes/Double2StringFilter.h"
 #include "backend/spreadsheet/Spreadsheet.h"
 #include "backend/spreadsheet/SpreadsheetModel.h"
 
 #include <QBrush>
 #include <QIcon>
 #include <QFontMetrics>
+#include <QLocale>
 
 #include <KLocale>
 
+#include <cmath>
+
 /*!
 	\class SpreadsheetModel
 	\brief  Model for the access to a Spreadsheet
@@ -50,10 +54,18 @@
 	is obtained by calling Spreadsheet::column() and the manipulation is done using the
 	public API of column.
 
+	The texts of the cells are formatted in blocks of rows and kept in a LRU cache, so scrolling and
+	repainting only format the rows of blocks that became visible. The blocks of a column are
+	invalidated when its data, its format or its rows are changed.
+
 	\ingroup backend
 */
+
+const int SpreadsheetModel::TextBlockSize;
+
 SpreadsheetModel::SpreadsheetModel(Spreadsheet* spreadsheet)
-	: QAbstractItemModel(0), m_spreadsheet(spreadsheet), m_formula_mode(false) {
+	: QAbstractItemModel(0), m_spreadsheet(spreadsheet), m_formula_mode(false), m_vertical_header_count(0),
+	m_text_cache(512) {
 	updateVerticalHeader();
 	updateHorizontalHeader();
 
@@ -99,11 +111,13 @@ QVariant SpreadsheetModel::data(const QModelIndex& index, int role) const {
 
 	switch(role) {
 		case Qt::ToolTipRole: {
-			if(col_ptr->isValid(row)) {
+			const TextBlock* block = textBlock(col_ptr, row);
+			const int i = row % TextBlockSize;
+			if(block->valid.testBit(i)) {
 				if(col_ptr->isMasked(row))
-					return QVariant(col_ptr->asStringColumn()->textAt(row) + i18n(", masked (ignored in all operations)"));
+					return QVariant(block->texts.at(i) + i18n(", masked (ignored in all operations)"));
 				else
-					return QVariant(col_ptr->asStringColumn()->textAt(row));
+					return QVariant(block->texts.at(i));
 			} else {
 				if(col_ptr->isMasked(row))
 					return QVariant(i18n("invalid cell, masked (ignored in all operations)"));
@@ -112,8 +126,9 @@ QVariant SpreadsheetModel::data(const QModelIndex& index, int role) const {
 			}
 		}
 		case Qt::EditRole: {
-			if(col_ptr->isValid(row))
-				return QVariant(col_ptr->asStringColumn()->textAt(row));
+			const TextBlock* block = textBlock(col_ptr, row);
+			if(block->valid.testBit(row % TextBlockSize))
+				return QVariant(block->texts.at(row % TextBlockSize));
 
 			//m_formula_mode is not used at the moment
 			//if(m_formula_mode)
@@ -122,17 +137,18 @@ QVariant SpreadsheetModel::data(const QModelIndex& index, int role) const {
 			return QVariant();
 		}
 		case Qt::DisplayRole: {
-			if(!col_ptr->isValid(row))
+			const TextBlock* block = textBlock(col_ptr, row);
+			if(!block->valid.testBit(row % TextBlockSize))
 				return QVariant("-");
 
 			//m_formula_mode is not used at the moment
 			//if(m_formula_mode)
 			//	return QVariant(col_ptr->formula(row));
 
-			return QVariant(col_ptr->asStringColumn()->textAt(row));
+			return QVariant(block->texts.at(row % TextBlockSize));
 		}
 		case Qt::ForegroundRole: {
-			if(!col_ptr->isValid(index.row()))
+			if(!textBlock(col_ptr, row)->valid.testBit(row % TextBlockSize))
 				return QVariant(QBrush(QColor(Qt::red)));
 		}
 		case MaskingRole:
@@ -170,7 +186,7 @@ QVariant SpreadsheetModel::headerData(int section, Qt::Orientation orientation,
 			switch(role) {
 				case Qt::DisplayRole:
 				case Qt::ToolTipRole:
-					return m_vertical_header_data.at(section);
+					return section + 1;
 			}
 	}
 
@@ -295,6 +311,7 @@ void SpreadsheetModel::handleAspectRemoved(const AbstractAspect* parent, const A
 	if (!col || parent != static_cast<AbstractAspect*>(m_spreadsheet))
 		return;
 
+	invalidateTexts(col);
 	updateVerticalHeader();
 	updateHorizontalHeader();
 
@@ -317,6 +334,7 @@ void SpreadsheetModel::handleDescriptionChange(const AbstractAspect* aspect) {
 }
 
 void SpreadsheetModel::handleModeChange(const AbstractColumn* col) {
+	invalidateTexts(col);
 	updateHorizontalHeader();
 	int index = m_spreadsheet->indexOfChild<Column>(col);
 	emit headerDataChanged(Qt::Horizontal, index, index);
@@ -329,12 +347,14 @@ void SpreadsheetModel::handlePlotDesignationChange(const AbstractColumn* col) {
 }
 
 void SpreadsheetModel::handleDataChange(const AbstractColumn* col) {
+	invalidateTexts(col);
 	int i = m_spreadsheet->indexOfChild<Column>(col);
 	emit dataChanged(index(0, i), index(col->rowCount()-1, i));
 }
 
 void SpreadsheetModel::handleRowsInserted(const AbstractColumn* col, int before, int count) {
-	Q_UNUSED(before) Q_UNUSED(count)
+	Q_UNUSED(count)
+	invalidateTexts(col, before);
 	updateVerticalHeader();
 	int i = m_spreadsheet->indexOfChild<Column>(col);
 	emit dataChanged(index(0, i), index(col->rowCount()-1, i));
@@ -342,7 +362,8 @@ void SpreadsheetModel::handleRowsInserted(const AbstractColumn* col, int before,
 }
 
 void SpreadsheetModel::handleRowsRemoved(const AbstractColumn* col, int first, int count) {
-	Q_UNUSED(first) Q_UNUSED(count)
+	Q_UNUSED(count)
+	invalidateTexts(col, first);
 	updateVerticalHeader();
 	int i = m_spreadsheet->indexOfChild<Column>(col);
 	emit dataChanged(index(0, i), index(col->rowCount()-1, i));
@@ -350,26 +371,18 @@ void SpreadsheetModel::handleRowsRemoved(const AbstractColumn* col, int first, i
 }
 
 void SpreadsheetModel::updateVerticalHeader() {
-	int old_rows = m_vertical_header_data.size();
+	int old_rows = m_vertical_header_count;
 	int new_rows = m_spreadsheet->rowCount();
 
 	if (new_rows > old_rows) {
 		beginInsertRows(QModelIndex(), old_rows, new_rows-1);
-
-		for(int i=old_rows+1; i<=new_rows; i++)
-			m_vertical_header_data << i;
-
+		m_vertical_header_count = new_rows;
 		endInsertRows();
 	} else if (new_rows < old_rows) {
 		beginRemoveRows(QModelIndex(), new_rows, old_rows-1);
-
-		while (m_vertical_header_data.size() > new_rows)
-			m_vertical_header_data.removeLast();
-
+		m_vertical_header_count = new_rows;
 		endRemoveRows();
 	}
-
-	Q_ASSERT(m_vertical_header_data.size() == m_spreadsheet->rowCount());
 }
 
 void SpreadsheetModel::updateHorizontalHeader() {
@@ -452,3 +465,56 @@ void SpreadsheetModel::activateFormulaMode(bool on) {
 bool SpreadsheetModel::formulaModeActive() const {
 	return m_formula_mode;
 }
+
+/*!
+	returns the block of formatted texts containing the row \c row of the column \c col.
+	If the block is not cached, the texts of all rows of the block are formatted at once.
+*/
+const SpreadsheetModel::TextBlock* SpreadsheetModel::textBlock(const Column* col, int row) const {
+	const TextBlockKey key(col, row / TextBlockSize);
+	const TextBlock* cached = m_text_cache.object(key);
+	if (cached)
+		return cached;
+
+	const int first = key.second * TextBlockSize;
+	const int count = qMax(qMin(TextBlockSize, col->rowCount() - first), 0);
+	TextBlock* block = new TextBlock;
+	block->texts.resize(TextBlockSize);
+	block->valid.resize(TextBlockSize);
+
+	if (col->columnMode() == AbstractColumn::Numeric) {
+		//format the values directly like Double2StringFilter, but with one locale object for the whole block
+		const Double2StringFilter* filter = static_cast<const Double2StringFilter*>(col->outputFilter());
+		const QVector<double>* values = static_cast<QVector<double>* >(col->data());
+		const QLocale locale;
+		for (int i = 0; i < count; ++i) {
+			const double value = values->at(first + i);
+			if (std::isnan(value))
+				continue;
+			block->texts[i] = locale.toString(value, filter->numericFormat(), filter->numDigits());
+			block->valid.setBit(i);
+		}
+	} else {
+		const AbstractColumn* strings = col->asStringColumn();
+		for (int i = 0; i < count; ++i) {
+			if (!col->isValid(first + i))
+				continue;
+			block->texts[i] = strings->textAt(first + i);
+			block->valid.setBit(i);
+		}
+	}
+
+	m_text_cache.insert(key, block);
+	return block;
+}
+
+/*!
+	removes the cached texts of the column \c col starting at the block containing the row \c first
+*/
+void SpreadsheetModel::invalidateTexts(const AbstractColumn* col, int first) {
+	const int firstBlock = first / TextBlockSize;
+	foreach (const TextBlockKey& key, m_text_cache.keys()) {
+		if (key.first == col && key.second >= firstBlock)
+			m_text_cache.remove(key);
+	}
+}
@@ -32,7 +32,11 @@
 #define SPREADSHEETMODEL_H
 
 #include <QAbstractItemModel>
+#include <QBitArray>
+#include <QCache>
+#include <QPair>
 #include <QStringList>
+#include <QVector>
 
 class Column;
 class Spreadsheet;
@@ -84,11 +88,23 @@ protected:
 	void updateHorizontalHeader();
 
 private:
+	//texts of a block of consecutive rows of a column, formatted at once
+	struct TextBlock {
+		QVector<QString> texts;
+		QBitArray valid;
+	};
+	typedef QPair<const AbstractColumn*, int> TextBlockKey;
+	static const int TextBlockSize = 256;
+
+	const TextBlock* textBlock(const Column*, int row) const;
+	void invalidateTexts(const AbstractColumn*, int first = 0);
+
 	Spreadsheet* m_spreadsheet;
 	bool m_formula_mode;
-	QList<int> m_vertical_header_data;
+	int m_vertical_header_count;
 	QStringList m_horizontal_header_data;
 	int m_defaultHeaderHeight;
+	mutable QCache<TextBlockKey, TextBlock> m_text_cache;
 };
 
 #endif
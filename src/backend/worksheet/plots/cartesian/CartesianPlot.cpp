@@ -40,6 +40,7 @@
 #include "XYFitCurve.h"
 #include "XYFourierFilterCurve.h"
 #include "XYFourierTransformCurve.h"
+#include "XYPowerSpectrumCurve.h"
 #include "backend/core/Project.h"
 #include "backend/worksheet/plots/cartesian/CartesianPlotLegend.h"
 #include "backend/worksheet/plots/cartesian/CustomPoint.h"
@@ -362,6 +363,7 @@ void CartesianPlot::initActions() {
 	addFitCurveAction = new KAction(KIcon("labplot-xy-fit-curve"), i18n("xy-curve from a fit to data"), this);
 	addFourierFilterCurveAction = new KAction(i18n("xy-curve from a Fourier filter"), this);
 	addFourierTransformCurveAction = new KAction(i18n("xy-curve from a Fourier transform"), this);
+	addPowerSpectrumCurveAction = new KAction(i18n("xy-curve from a power spectrum"), this);
 //	addInterpolationCurveAction = new KAction(KIcon("labplot-xy-interpolation-curve"), i18n("xy-curve from an interpolation"), this);
 //	addSmoothCurveAction = new KAction(KIcon("labplot-xy-smooth-curve"), i18n("xy-curve from a smooth"), this);
 //	addFourierFilterCurveAction = new KAction(KIcon("labplot-xy-fourier_filter-curve"), i18n("xy-curve from a Fourier filter"), this);
@@ -378,6 +380,7 @@ void CartesianPlot::initActions() {
 	connect(addFitCurveAction, SIGNAL(triggered()), SLOT(addFitCurve()));
 	connect(addFourierFilterCurveAction, SIGNAL(triggered()), SLOT(addFourierFilterCurve()));
 	connect(addFourierTransformCurveAction, SIGNAL(triggered()), SLOT(addFourierTransformCurve()));
+	connect(addPowerSpectrumCurveAction, SIGNAL(triggered()), SLOT(addPowerSpectrumCurve()));
 	connect(addLegendAction, SIGNAL(triggered()), SLOT(addLegend()));
 	connect(addHorizontalAxisAction, SIGNAL(triggered()), SLOT(addHorizontalAxis()));
 	connect(addVerticalAxisAction, SIGNAL(triggered()), SLOT(addVerticalAxis()));
@@ -430,6 +433,7 @@ void CartesianPlot::initMenus() {
 	addNewMenu->addAction(addFitCurveAction);
 	addNewMenu->addAction(addFourierFilterCurveAction);
 	addNewMenu->addAction(addFourierTransformCurveAction);
+	addNewMenu->addAction(addPowerSpectrumCurveAction);
 	addNewMenu->addAction(addLegendAction);
 	addNewMenu->addSeparator();
 	addNewMenu->addAction(addHorizontalAxisAction);
@@ -799,6 +803,13 @@ XYFourierTransformCurve* CartesianPlot::addFourierTransformCurve() {
 	return curve;
 }
 
+XYPowerSpectrumCurve* CartesianPlot::addPowerSpectrumCurve() {
+	XYPowerSpectrumCurve* curve = new XYPowerSpectrumCurve("power spectrum");
+	this->addChild(curve);
+	this->applyThemeOnNewCurve(curve);
+	return curve;
+}
+
 void CartesianPlot::addLegend() {
 	//don't do anything if there's already a legend
 	if (m_legend)
@@ -2161,6 +2172,12 @@ bool CartesianPlot::load(XmlStreamReader* reader) {
 				removeChild(curve);
 				return false;
 			}
+		} else if (reader->name() == "xyPowerSpectrumCurve") {
+			XYPowerSpectrumCurve* curve = addPowerSpectrumCurve();
+			if (!curve->load(reader)) {
+				removeChild(curve);
+				return false;
+			}
 		} else if (reader->name() == "xySmoothCurve") {
 			XYSmoothCurve* curve = addSmoothCurve();
 			if (!curve->load(reader)) {
@@ -47,6 +47,7 @@ class XYFitCurve;
 class XYFourierFilterCurve;
 class KConfig;
 class XYFourierTransformCurve;
+class XYPowerSpectrumCurve;
 
 class CartesianPlot:public AbstractPlot{
 	Q_OBJECT
@@ -132,6 +133,7 @@ class CartesianPlot:public AbstractPlot{
 		QAction* addFitCurveAction;
 		QAction* addFourierFilterCurveAction;
 		QAction* addFourierTransformCurveAction;
+		QAction* addPowerSpectrumCurveAction;
 		QAction* addHorizontalAxisAction;
 		QAction* addVerticalAxisAction;
  		QAction* addLegendAction;
@@ -170,6 +172,7 @@ class CartesianPlot:public AbstractPlot{
 		XYFitCurve* addFitCurve();
 		XYFourierFilterCurve* addFourierFilterCurve();
 		XYFourierTransformCurve* addFourierTransformCurve();
+		XYPowerSpectrumCurve* addPowerSpectrumCurve();
 		void addLegend();
 		void addCustomPoint();
 		void scaleAuto();
@@ -0,0 +1,249 @@
+/***************************************************************************
+    File                 : XYAnalysisJob.cpp
+    Project              : LabPlot
+    Description          : Calculation of an analysis curve in a worker thread
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+/*!
+  \class XYAnalysisJob
+  \brief Calculation of an analysis curve (fit, smoothing, Fourier transform, ...) in a worker thread.
+
+  A job is created in the GUI thread with snapshots of the source columns and a copy of the settings of the curve.
+  compute() runs in a thread of the global thread pool and works on the snapshots only, the results are
+  kept in the job. When the job is finished, publish() writes the results into the curve in the GUI thread,
+  so the result columns always contain the complete result of one calculation.
+
+  The progress (0 to 100) and the cancellation are handled by the QFuture of the job, see XYCurve::completed()
+  and XYCurve::cancelRecalculation().
+
+  Before the calculation the job determines the key of its input (the hash of the source data and of the settings).
+  If the curve already shows the result for this key, compute() and publish() are skipped. Since the curves using
+  the result of an analysis curve as source data are only recalculated when this result was changed,
+  only the invalidated stages of a chain of analysis curves are calculated again.
+
+  \ingroup worksheet
+*/
+
+#include "XYAnalysisJob.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <cstring>
+
+//mixing of 64 bit words as in MurmurHash3
+static inline quint64 rotl64(quint64 x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline quint64 hashWord(quint64 h, quint64 word) {
+	word *= 0x87c37b91114253d5ULL;
+	word = rotl64(word, 31);
+	word *= 0x4cf5ad432745937fULL;
+	h ^= word;
+	return rotl64(h, 27) * 5 + 0x52dce729;
+}
+
+static inline quint64 hashFinalize(quint64 h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static quint64 hashBytes(quint64 h, const char* data, size_t size) {
+	const size_t nwords = size / sizeof(quint64);
+	for (size_t i = 0; i < nwords; ++i) {
+		quint64 word;
+		memcpy(&word, data + i * sizeof(quint64), sizeof(quint64));
+		h = hashWord(h, word);
+	}
+
+	quint64 tail = 0;
+	memcpy(&tail, data + nwords * sizeof(quint64), size - nwords * sizeof(quint64));
+	return hashWord(h, tail ^ size);
+}
+
+/*!
+ * hash of the values and of the masked rows of the snapshot
+ */
+quint64 ColumnSnapshot::hash() const {
+	quint64 h = hashBytes(0, reinterpret_cast<const char*>(m_values.constData()), m_values.size() * sizeof(double));
+	//masked rows behind the values are ignored
+	const int words = qMin(m_masked.wordCount(), (m_values.size() + 63) / 64);
+	for (int w = 0; w < words; ++w) {
+		quint64 word = m_masked.word(w);
+		if (w == words - 1 && m_values.size() % 64)
+			word &= (Q_UINT64_C(1) << (m_values.size() % 64)) - 1;
+		if (word)
+			h = hashWord(hashWord(h, w), word);
+	}
+	return hashFinalize(h);
+}
+
+/*!
+ * runs a job in the thread pool and keeps it alive until it is finished
+ */
+class XYAnalysisJobRunnable : public QRunnable {
+	public:
+		explicit XYAnalysisJobRunnable(const QSharedPointer<XYAnalysisJob>& job) : m_job(job) {}
+
+		void run() {
+			m_job->run();
+		}
+
+	private:
+		QSharedPointer<XYAnalysisJob> m_job;
+};
+
+XYAnalysisJob::XYAnalysisJob() : m_key(0), m_memoizedKey(0) {
+	m_timer.start();
+	m_future.setProgressRange(0, 100);
+	m_future.reportStarted();
+}
+
+XYAnalysisJob::~XYAnalysisJob() {
+}
+
+bool XYAnalysisJob::isThreadSafe() const {
+	return true;
+}
+
+/*!
+ * key of the source data and the settings of the calculation, available after run().
+ * The key is never 0, which is used for "no result".
+ */
+quint64 XYAnalysisJob::key() const {
+	return m_key;
+}
+
+/*!
+ * sets the \c key of the result currently shown by the curve (0 if there is no result)
+ */
+void XYAnalysisJob::setMemoizedKey(quint64 key) {
+	m_memoizedKey = key;
+}
+
+/*!
+ * returns \c true if the curve already shows the result of the calculation, compute() was not called
+ * and the job has nothing to publish.
+ */
+bool XYAnalysisJob::isMemoized() const {
+	return m_key != 0 && m_key == m_memoizedKey;
+}
+
+/*!
+ * future of the job used to watch the progress and the end of the calculation
+ */
+QFuture<void> XYAnalysisJob::future() {
+	return m_future.future();
+}
+
+/*!
+ * starts the calculation of \c job in a thread of the global thread pool
+ */
+void XYAnalysisJob::start(const QSharedPointer<XYAnalysisJob>& job) {
+	QThreadPool::globalInstance()->start(new XYAnalysisJobRunnable(job));
+}
+
+/*!
+ * does the calculation in the current thread (if the job wasn't canceled before and the result
+ * is not available in the curve yet) and finishes the future.
+ */
+void XYAnalysisJob::run() {
+	if (!m_future.isCanceled()) {
+		m_key = inputKey();
+		if (m_key == 0)
+			m_key = 1;
+		if (!isMemoized())
+			compute();
+	}
+	m_future.setProgressValue(100);
+	m_future.reportFinished();
+}
+
+/*!
+ * cancels the job. compute() should check isCanceled() regularly and return as soon as possible,
+ * the results of a canceled job are not published.
+ */
+void XYAnalysisJob::cancel() {
+	m_future.cancel();
+}
+
+bool XYAnalysisJob::isCanceled() const {
+	return m_future.isCanceled();
+}
+
+/*!
+ * reports the progress (0 to 100) of the calculation
+ */
+void XYAnalysisJob::setProgress(int value) {
+	m_future.setProgressValue(value);
+}
+
+/*!
+ * key of the source data \c x and \c y and of the serialized \c settings of the calculation
+ */
+quint64 XYAnalysisJob::dataKey(const QByteArray& settings, const ColumnSnapshot& x, const ColumnSnapshot& y) {
+	quint64 key = hashFinalize(hashBytes(0, settings.constData(), settings.size()));
+	key = combineKeys(key, x.hash());
+	return combineKeys(key, y.hash());
+}
+
+quint64 XYAnalysisJob::combineKeys(quint64 key1, quint64 key2) {
+	return hashFinalize(hashWord(key1, key2));
+}
+
+/*!
+ * time in ms since the job was created
+ */
+qint64 XYAnalysisJob::elapsedTime() const {
+	return m_timer.elapsed();
+}
+
+/*!
+ * sets the error \c message of the calculation. The message is translated in errorMessage() in the GUI thread.
+ */
+void XYAnalysisJob::setError(const KLocalizedString& message) {
+	m_error = message;
+}
+
+bool XYAnalysisJob::hasError() const {
+	return !m_error.isEmpty();
+}
+
+QString XYAnalysisJob::errorMessage() const {
+	return m_error.toString();
+}
+
+/*!
+ * copies the valid data points (no NaN and no masked value in \c x and \c y, x-value inside [\c xmin, \c xmax])
+ * of the snapshots into \c xdata and \c ydata, see ColumnView::validData().
+ */
+void XYAnalysisJob::copyValidData(const ColumnSnapshot& x, const ColumnSnapshot& y, double xmin, double xmax,
+		QVector<double>& xdata, QVector<double>& ydata) {
+	ColumnView::validData(x, y, xmin, xmax, xdata, ydata);
+}
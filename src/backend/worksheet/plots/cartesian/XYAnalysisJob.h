@@ -0,0 +1,95 @@
+/***************************************************************************
+    File                 : XYAnalysisJob.h
+    Project              : LabPlot
+    Description          : Calculation of an analysis curve in a worker thread
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef XYANALYSISJOB_H
+#define XYANALYSISJOB_H
+
+#include "backend/core/column/ColumnView.h"
+#include <KLocalizedString>
+#include <QElapsedTimer>
+#include <QFutureInterface>
+#include <QSharedPointer>
+#include <QVector>
+
+/*!
+ * view of all rows of a column at the time the snapshot was taken, see ColumnView.
+ */
+class ColumnSnapshot : public ColumnView {
+	public:
+		explicit ColumnSnapshot(const AbstractColumn* column = 0) : ColumnView(column) {}
+
+		quint64 hash() const;
+};
+
+class XYAnalysisJob {
+	public:
+		XYAnalysisJob();
+		virtual ~XYAnalysisJob();
+
+		//calculation on the snapshots of the source data, called in a worker thread
+		virtual void compute() = 0;
+		//writes the results into the curve, called in the GUI thread
+		virtual void publish() = 0;
+		//false if compute() uses global state (like the expression parser) and has to run in the GUI thread
+		virtual bool isThreadSafe() const;
+
+		quint64 key() const;
+		void setMemoizedKey(quint64 key);
+		bool isMemoized() const;
+
+		QFuture<void> future();
+		static void start(const QSharedPointer<XYAnalysisJob>& job);
+		void run();
+		void cancel();
+		bool isCanceled() const;
+		void setProgress(int value);
+
+	protected:
+		//hash of the source data and of the settings used in compute()
+		virtual quint64 inputKey() const = 0;
+		static quint64 dataKey(const QByteArray& settings, const ColumnSnapshot& x, const ColumnSnapshot& y);
+		static quint64 combineKeys(quint64 key1, quint64 key2);
+
+		qint64 elapsedTime() const;
+		void setError(const KLocalizedString& message);
+		bool hasError() const;
+		QString errorMessage() const;
+
+		static void copyValidData(const ColumnSnapshot& x, const ColumnSnapshot& y, double xmin, double xmax,
+				QVector<double>& xdata, QVector<double>& ydata);
+
+	private:
+		Q_DISABLE_COPY(XYAnalysisJob)
+
+		QFutureInterface<void> m_future;
+		QElapsedTimer m_timer;
+		KLocalizedString m_error;
+		quint64 m_key;
+		quint64 m_memoizedKey;
+};
+
+#endif
@@ -36,6 +36,7 @@
 
 #include "XYCurve.h"
 #include "XYCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "backend/core/column/Column.h"
 #include "backend/worksheet/plots/cartesian/CartesianCoordinateSystem.h"
 #include "backend/worksheet/plots/cartesian/CartesianPlot.h"
@@ -44,11 +45,13 @@
 #include "backend/spreadsheet/Spreadsheet.h"
 #include "backend/worksheet/Worksheet.h"
 #include "backend/lib/XmlStreamReader.h"
+#include "backend/lib/PackedDateTime.h"
 #include "backend/lib/macros.h"
 
 #include <QPainter>
 #include <QGraphicsSceneContextMenuEvent>
 #include <QMenu>
+#include <QFutureWatcher>
 // #include <QElapsedTimer>
 
 #include <KIcon>
@@ -677,9 +680,95 @@ void XYCurve::suppressRetransform(bool b) {
 	d->m_suppressRetransform = b;
 }
 
+/*!
+	returns \c true if the data of the analysis curve is being calculated in a worker thread.
+*/
+bool XYCurve::isRecalculating() const {
+	Q_D(const XYCurve);
+	return !d->analysisJob.isNull();
+}
+
+/*!
+	recalculates the data of curves calculated from other data (analysis and equation curves).
+	Nothing is done for curves showing the data of columns.
+*/
+void XYCurve::recalculate() {
+}
+
+/*!
+	called by analysis curves when the data of the \c source column was changed.
+	If \c source is the result of another analysis curve, the curve is recalculated to keep
+	the chain of analysis curves up to date and \c true is returned. The recalculation is done
+	in the next event loop iteration, once for all changed source columns.
+
+	If this curve already contributed to the change of \c source in the current pass through the chain
+	(cyclic source data), the curve is not recalculated again and \c false is returned.
+*/
+bool XYCurve::recalculateIfAnalysisResult(const QObject* source) {
+	const AbstractAspect* column = qobject_cast<const AbstractAspect*>(source);
+	const XYCurve* sourceCurve = column ? dynamic_cast<const XYCurve*>(column->parentAspect()) : 0;
+	if (!sourceCurve)
+		return false;
+
+	Q_D(XYCurve);
+	if (sourceCurve == this || sourceCurve->d_func()->chainCurves.contains(this))
+		return false;
+
+	d->pendingChainCurves.unite(sourceCurve->d_func()->chainCurves);
+	d->pendingChainCurves << sourceCurve;
+	if (!d->chainRecalculationPending) {
+		d->chainRecalculationPending = true;
+		QMetaObject::invokeMethod(this, "recalculateChain", Qt::QueuedConnection);
+	}
+	return true;
+}
+
 //##############################################################################
 //#################################  SLOTS  ####################################
 //##############################################################################
+/*!
+	cancels the calculation of the analysis curve running in a worker thread.
+	The current data of the curve is kept, recalculationFinished() is emitted.
+*/
+void XYCurve::cancelRecalculation() {
+	Q_D(XYCurve);
+	if (!d->analysisJob)
+		return;
+
+	d->cancelAnalysisJob();
+	emit recalculationFinished();
+}
+
+/*!
+	publishes the results of the finished analysis job in the GUI thread
+*/
+void XYCurve::analysisJobFinished() {
+	Q_D(XYCurve);
+	QFutureWatcher<void>* watcher = static_cast<QFutureWatcher<void>*>(sender());
+	watcher->deleteLater();
+	if (watcher != d->analysisJobWatcher)
+		return;	//canceled or replaced by a newer job
+
+	QSharedPointer<XYAnalysisJob> job = d->analysisJob;
+	d->analysisJob.clear();
+	d->analysisJobWatcher = 0;
+
+	d->publishAnalysisJob(job.data());
+}
+
+/*!
+	recalculates the analysis curve once for all source columns changed in the current event
+*/
+void XYCurve::recalculateChain() {
+	Q_D(XYCurve);
+	d->chainRecalculationPending = false;
+	d->chainCurves = d->pendingChainCurves;
+	d->pendingChainCurves.clear();
+	d->chainRecalculation = true;
+	recalculate();
+	d->chainRecalculation = false;
+}
+
 void XYCurve::retransform() {
 	DEBUG("XYCurve::retransform()");
 	Q_D(XYCurve);
@@ -794,7 +883,8 @@ void XYCurve::navigateTo() {
 //######################### Private implementation #############################
 //##############################################################################
 XYCurvePrivate::XYCurvePrivate(XYCurve *owner) : m_printing(false), m_hovered(false), m_suppressRecalc(false),
-	m_suppressRetransform(false), m_hoverEffectImageIsDirty(false), m_selectionEffectImageIsDirty(false), q(owner) {
+	m_suppressRetransform(false), m_hoverEffectImageIsDirty(false), m_selectionEffectImageIsDirty(false),
+	analysisJobWatcher(0), analysisKey(0), chainRecalculationPending(false), chainRecalculation(false), q(owner) {
 	setFlag(QGraphicsItem::ItemIsSelectable, true);
 	setAcceptHoverEvents(true);
 }
@@ -803,6 +893,67 @@ QString XYCurvePrivate::name() const {
 	return q->name();
 }
 
+/*!
+  starts the calculation \c job of an analysis curve, a calculation still running is canceled.
+  Thread-safe jobs are computed in the global thread pool and published in XYCurve::analysisJobFinished(),
+  other jobs are computed and published immediately.
+*/
+void XYCurvePrivate::startAnalysisJob(XYAnalysisJob* job) {
+	cancelAnalysisJob();
+	//a calculation not triggered by a source curve starts a new pass through the chain
+	if (!chainRecalculation)
+		chainCurves.clear();
+	job->setMemoizedKey(analysisKey);
+
+	if (!job->isThreadSafe()) {
+		job->run();
+		publishAnalysisJob(job);
+		delete job;
+		return;
+	}
+
+	analysisJob = QSharedPointer<XYAnalysisJob>(job);
+	analysisJobWatcher = new QFutureWatcher<void>(q);
+	QObject::connect(analysisJobWatcher, SIGNAL(progressValueChanged(int)), q, SIGNAL(completed(int)));
+	QObject::connect(analysisJobWatcher, SIGNAL(finished()), q, SLOT(analysisJobFinished()));
+	analysisJobWatcher->setFuture(job->future());
+	XYAnalysisJob::start(analysisJob);
+	emit q->recalculationStarted();
+}
+
+/*!
+  cancels the analysis job running in a worker thread, if any.
+*/
+void XYCurvePrivate::cancelAnalysisJob() {
+	if (!analysisJob)
+		return;
+
+	//the watcher is deleted when the canceled job has returned
+	analysisJob->cancel();
+	analysisJob.clear();
+	analysisJobWatcher = 0;
+}
+
+/*!
+  writes the results of the finished \c job into the curve. Nothing is changed if the curve
+  already shows the result for the source data and the settings of the job.
+*/
+void XYCurvePrivate::publishAnalysisJob(XYAnalysisJob* job) {
+	if (!job->isMemoized()) {
+		//the changed result columns notify the curves using them as source data,
+		//the curve itself is retransformed only once afterwards
+		const bool suppressed = m_suppressRetransform;
+		m_suppressRetransform = true;
+		job->publish();
+		m_suppressRetransform = suppressed;
+		analysisKey = job->key();
+
+		retransform();
+		emit q->dataChanged();
+	}
+	emit q->recalculationFinished();
+}
+
 QRectF XYCurvePrivate::boundingRect() const {
 	return boundingRectangle;
 }
@@ -825,6 +976,25 @@ bool XYCurvePrivate::swapVisible(bool on) {
 	return oldValue;
 }
 
+/*!
+  packed date time values of \c column if it is a DateTime, Month or Day column, 0 otherwise
+*/
+static const qint64* packedDateTimes(const AbstractColumn* column) {
+	const Column* col = dynamic_cast<const Column*>(column);
+	if (!col || col->columnMode() == AbstractColumn::Numeric || col->columnMode() == AbstractColumn::Text)
+		return 0;
+	return static_cast<QVector<qint64>* >(col->data())->constData();
+}
+
+/*!
+  logical coordinate of the date time value in row \c row (the Julian day as in DateTime2DoubleFilter)
+*/
+static inline double dateTimeValue(const AbstractColumn* column, const qint64* packed, int row) {
+	if (packed)
+		return PackedDateTime::toJulianDay(packed[row]);
+	return PackedDateTime::toJulianDay(PackedDateTime::pack(column->dateTimeAt(row)));
+}
+
 /*!
   recalculates the position of the points to be drawn. Called when the data was changed.
   Triggers the update of lines, drop lines, symbols etc.
@@ -854,6 +1024,8 @@ void XYCurvePrivate::retransform() {
 
 	AbstractColumn::ColumnMode xColMode = xColumn->columnMode();
 	AbstractColumn::ColumnMode yColMode = yColumn->columnMode();
+	const qint64* xDateTimes = packedDateTimes(xColumn);
+	const qint64* yDateTimes = packedDateTimes(yColumn);
 
 	//take over only valid and non masked points.
 	for (int row = startRow; row <= endRow; row++) {
@@ -865,11 +1037,12 @@ void XYCurvePrivate::retransform() {
 				tempPoint.setX(xColumn->valueAt(row));
 				break;
 			case AbstractColumn::Text:
-			//TODO
+				//TODO
+				break;
 			case AbstractColumn::DateTime:
 			case AbstractColumn::Month:
 			case AbstractColumn::Day:
-				//TODO
+				tempPoint.setX(dateTimeValue(xColumn, xDateTimes, row));
 				break;
 			}
 
@@ -878,11 +1051,12 @@ void XYCurvePrivate::retransform() {
 				tempPoint.setY(yColumn->valueAt(row));
 				break;
 			case AbstractColumn::Text:
-			//TODO
+				//TODO
+				break;
 			case AbstractColumn::DateTime:
 			case AbstractColumn::Month:
 			case AbstractColumn::Day:
-				//TODO
+				tempPoint.setY(dateTimeValue(yColumn, yDateTimes, row));
 				break;
 			}
 			symbolPointsLogical.append(tempPoint);
@@ -127,6 +127,8 @@ class XYCurve: public WorksheetElement {
 		virtual bool isVisible() const;
 		virtual void setPrinting(bool on);
 		void suppressRetransform(bool);
+		bool isRecalculating() const;
+		virtual void recalculate();
 
 		typedef WorksheetElement BaseClass;
 		typedef XYCurvePrivate Private;
@@ -134,6 +136,7 @@ class XYCurve: public WorksheetElement {
 	public slots:
 		virtual void retransform();
 		virtual void handlePageResize(double horizontalRatio, double verticalRatio);
+		void cancelRecalculation();
 
 	private slots:
 		void updateValues();
@@ -150,8 +153,12 @@ class XYCurve: public WorksheetElement {
 		void visibilityChanged();
 		void navigateTo();
 
+		void analysisJobFinished();
+		void recalculateChain();
+
 	protected:
 		XYCurve(const QString& name, XYCurvePrivate* dd);
+		bool recalculateIfAnalysisResult(const QObject* source);
 		XYCurvePrivate* const d_ptr;
 
 	private:
@@ -169,6 +176,11 @@ class XYCurve: public WorksheetElement {
 		void yDataChanged();
 		void visibilityChanged(bool);
 
+		//analysis curves (fit, smoothing, ...) calculated in a worker thread
+		void recalculationStarted(); //!< the calculation was started in a worker thread
+		void completed(int) const; //!< int ranging from 0 to 100 notifies about the status of the analysis process
+		void recalculationFinished(); //!< the results of the analysis are available or the calculation was canceled
+
 		friend class XYCurveSetXColumnCmd;
 		friend class XYCurveSetYColumnCmd;
 		void xColumnChanged(const AbstractColumn*);
@@ -30,9 +30,13 @@
 #define XYCURVEPRIVATE_H
 
 #include <QGraphicsItem>
+#include <QSet>
+#include <QSharedPointer>
 #include <vector>
 
 class CartesianPlot;
+class XYAnalysisJob;
+template <typename T> class QFutureWatcher;
 
 class XYCurvePrivate: public QGraphicsItem {
 	public:
@@ -154,6 +158,18 @@ class XYCurvePrivate: public QGraphicsItem {
 		QList<QString> valuesStrings;
 		QList<QPolygonF> fillPolygons;
 
+		//calculation of analysis curves in a worker thread
+		void startAnalysisJob(XYAnalysisJob*);
+		void publishAnalysisJob(XYAnalysisJob*);
+		void cancelAnalysisJob();
+		QSharedPointer<XYAnalysisJob> analysisJob;
+		QFutureWatcher<void>* analysisJobWatcher;
+		quint64 analysisKey;	//key of the source data and settings of the current result, 0 if there is no result
+		bool chainRecalculationPending;
+		bool chainRecalculation;	//recalculate() was called by recalculateChain()
+		QSet<const XYCurve*> chainCurves;	//curves recalculated before this curve in the current pass through the chain
+		QSet<const XYCurve*> pendingChainCurves;	//chainCurves of the pending chain recalculation
+
 		XYCurve* const q;
 
 	private:
@@ -35,6 +35,7 @@
 
 #include "XYDataReductionCurve.h"
 #include "XYDataReductionCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "CartesianCoordinateSystem.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
@@ -44,7 +45,7 @@
 
 #include <KIcon>
 #include <KLocale>
-#include <QElapsedTimer>
+#include <QDataStream>
 #include <QThreadPool>
 
 XYDataReductionCurve::XYDataReductionCurve(const QString& name)
@@ -142,6 +143,9 @@ void XYDataReductionCurve::setDataReductionData(const XYDataReductionCurve::Data
 //################################## SLOTS ####################################
 //##############################################################################
 void XYDataReductionCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
 	Q_D(XYDataReductionCurve);
 	d->sourceDataChangedSinceLastDataReduction = true;
 	emit sourceDataChangedSinceLastDataReduction();
@@ -163,89 +167,63 @@ XYDataReductionCurvePrivate::~XYDataReductionCurvePrivate() {
 	//when the parent aspect is removed
 }
 
-// ...
-// see XYFitCurvePrivate
-
-void XYDataReductionCurvePrivate::recalculate() {
-	QElapsedTimer timer;
-	timer.start();
-
-	//create dataReduction result columns if not available yet, clear them otherwise
-	if (!xColumn) {
-		xColumn = new Column("x", AbstractColumn::Numeric);
-		yColumn = new Column("y", AbstractColumn::Numeric);
-		xVector = static_cast<QVector<double>* >(xColumn->data());
-		yVector = static_cast<QVector<double>* >(yColumn->data());
-
-		xColumn->setHidden(true);
-		q->addChild(xColumn);
-		yColumn->setHidden(true);
-		q->addChild(yColumn);
-
-		q->setUndoAware(false);
-		q->setXColumn(xColumn);
-		q->setYColumn(yColumn);
-		q->setUndoAware(true);
-	} else {
-		xVector->clear();
-		yVector->clear();
-	}
-
-	// clear the previous result
-	dataReductionResult = XYDataReductionCurve::DataReductionResult();
-
-	if (!xDataColumn || !yDataColumn) {
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastDataReduction = false;
-		return;
-	}
-
-	//check column sizes
-	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
-		dataReductionResult.available = true;
-		dataReductionResult.valid = false;
-		dataReductionResult.status = i18n("Number of x and y data points must be equal.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastDataReduction = false;
-		return;
-	}
+/*!
+ * data reduction of the snapshots of the source columns in a worker thread
+ */
+class XYDataReductionCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYDataReductionCurveJob(XYDataReductionCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_dataReductionData(curve->dataReductionData) {}
+
+		void compute();
+		void publish();
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYDataReductionCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const XYDataReductionCurve::DataReductionData m_dataReductionData;
+		XYDataReductionCurve::DataReductionResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+};
+
+quint64 XYDataReductionCurveJob::inputKey() const {
+	const XYDataReductionCurve::DataReductionData& d = m_dataReductionData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << (int)d.type << d.autoTolerance << d.tolerance << d.autoTolerance2 << d.tolerance2
+		<< d.autoRange << d.xRange;
+	return dataKey(settings, m_xData, m_yData);
+}
 
+void XYDataReductionCurveJob::compute() {
 	//copy all valid data point for the data reduction to temporary vectors
 	QVector<double> xdataVector;
 	QVector<double> ydataVector;
-	const double xmin = dataReductionData.xRange.first();
-	const double xmax = dataReductionData.xRange.last();
-	for (int row=0; row<xDataColumn->rowCount(); ++row) {
-		//only copy those data where _all_ values (for x and y, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-			&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
-
-			// only when inside given range
-			if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-				xdataVector.append(xDataColumn->valueAt(row));
-				ydataVector.append(yDataColumn->valueAt(row));
-			}
-		}
-	}
+	copyValidData(m_xData, m_yData, m_dataReductionData.xRange.first(), m_dataReductionData.xRange.last(), xdataVector, ydataVector);
 
 	//number of data points to use
 	const unsigned int n = xdataVector.size();
 	if (n < 2) {
-		dataReductionResult.available = true;
-		dataReductionResult.valid = false;
-		dataReductionResult.status = i18n("Not enough data points available.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastDataReduction = false;
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("Not enough data points available."));
 		return;
 	}
+	if (isCanceled())
+		return;
 
 	double* xdata = xdataVector.data();
 	double* ydata = ydataVector.data();
 
 	// dataReduction settings
-	const nsl_geom_linesim_type type = dataReductionData.type;
-	const double tol = dataReductionData.tolerance;
-	const double tol2 = dataReductionData.tolerance2;
+	const nsl_geom_linesim_type type = m_dataReductionData.type;
+	const double tol = m_dataReductionData.tolerance;
+	const double tol2 = m_dataReductionData.tolerance2;
 
 	DEBUG("n =" << n);
 	DEBUG("type:" << nsl_geom_linesim_type_name[type]);
@@ -253,7 +231,7 @@ void XYDataReductionCurvePrivate::recalculate() {
 	DEBUG("tolerance2/repeat/maxtol/region:" << tol2);
 
 ///////////////////////////////////////////////////////////
-	emit q->completed(10);
+	setProgress(10);
 
 	size_t npoints = 0;
 	double calcTolerance = 0;		// calculated tolerance from Douglas-Peucker variant
@@ -298,16 +276,20 @@ void XYDataReductionCurvePrivate::recalculate() {
 	} else
 		Q_UNUSED(calcTolerance);
 
-	emit q->completed(80);
+	if (isCanceled()) {
+		free(index);
+		return;
+	}
+	setProgress(80);
 
-	xVector->resize(npoints);
-	yVector->resize(npoints);
+	m_x.resize(npoints);
+	m_y.resize(npoints);
 	for (unsigned int i = 0; i < npoints; i++) {
-		(*xVector)[i] = xdata[index[i]];
-		(*yVector)[i] = ydata[index[i]];
+		m_x[i] = xdata[index[i]];
+		m_y[i] = ydata[index[i]];
 	}
 
-	emit q->completed(90);
+	setProgress(90);
 	double posError = nsl_geom_linesim_positional_squared_error(xdata, ydata, n, index);
 	double areaError = nsl_geom_linesim_area_error(xdata, ydata, n, index);
 
@@ -315,21 +297,80 @@ void XYDataReductionCurvePrivate::recalculate() {
 
 ///////////////////////////////////////////////////////////
 
-	//write the result
-	dataReductionResult.available = true;
-	dataReductionResult.valid = true;
+	m_result.available = true;
+	m_result.valid = true;
 	if (npoints > 0)
-		dataReductionResult.status = QString("OK");
+		m_result.status = QString("OK");
 	else
-		dataReductionResult.status = QString("FAILURE");
-	dataReductionResult.elapsedTime = timer.elapsed();
-	dataReductionResult.npoints = npoints;
-	dataReductionResult.posError = posError;
-	dataReductionResult.areaError = areaError;
-
-	//redraw the curve
-	emit (q->dataChanged());
+		m_result.status = QString("FAILURE");
+	m_result.elapsedTime = elapsedTime();
+	m_result.npoints = npoints;
+	m_result.posError = posError;
+	m_result.areaError = areaError;
+}
+
+void XYDataReductionCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	m_curve->dataReductionResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * reduces the data of the source columns. The calculation is done in a worker thread,
+ * the result columns are updated when it is finished.
+ */
+void XYDataReductionCurvePrivate::recalculate() {
+	//create dataReduction result columns if not available yet
+	if (!xColumn) {
+		xColumn = new Column("x", AbstractColumn::Numeric);
+		yColumn = new Column("y", AbstractColumn::Numeric);
+		xVector = static_cast<QVector<double>* >(xColumn->data());
+		yVector = static_cast<QVector<double>* >(yColumn->data());
+
+		xColumn->setHidden(true);
+		q->addChild(xColumn);
+		yColumn->setHidden(true);
+		q->addChild(yColumn);
+
+		q->setUndoAware(false);
+		q->setXColumn(xColumn);
+		q->setYColumn(yColumn);
+		q->setUndoAware(true);
+	}
+
+	if (!xDataColumn || !yDataColumn) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		dataReductionResult = XYDataReductionCurve::DataReductionResult();
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastDataReduction = false;
+		return;
+	}
+
+	//check column sizes
+	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		dataReductionResult = XYDataReductionCurve::DataReductionResult();
+		dataReductionResult.available = true;
+		dataReductionResult.valid = false;
+		dataReductionResult.status = i18n("Number of x and y data points must be equal.");
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastDataReduction = false;
+		return;
+	}
+
 	sourceDataChangedSinceLastDataReduction = false;
+	startAnalysisJob(new XYDataReductionCurveJob(this));
 }
 
 //##############################################################################
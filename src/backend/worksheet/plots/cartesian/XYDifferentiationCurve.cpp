@@ -35,6 +35,7 @@
 
 #include "XYDifferentiationCurve.h"
 #include "XYDifferentiationCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "CartesianCoordinateSystem.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
@@ -48,7 +49,7 @@ extern "C" {
 
 #include <KIcon>
 #include <KLocale>
-#include <QElapsedTimer>
+#include <QDataStream>
 #include <QThreadPool>
 
 XYDifferentiationCurve::XYDifferentiationCurve(const QString& name)
@@ -146,6 +147,9 @@ void XYDifferentiationCurve::setDifferentiationData(const XYDifferentiationCurve
 //################################## SLOTS ####################################
 //##############################################################################
 void XYDifferentiationCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
 	Q_D(XYDifferentiationCurve);
 	d->sourceDataChangedSinceLastDifferentiation = true;
 	emit sourceDataChangedSinceLastDifferentiation();
@@ -167,88 +171,62 @@ XYDifferentiationCurvePrivate::~XYDifferentiationCurvePrivate() {
 	//when the parent aspect is removed
 }
 
-// ...
-// see XYFitCurvePrivate
-
-void XYDifferentiationCurvePrivate::recalculate() {
-	QElapsedTimer timer;
-	timer.start();
-
-	//create differentiation result columns if not available yet, clear them otherwise
-	if (!xColumn) {
-		xColumn = new Column("x", AbstractColumn::Numeric);
-		yColumn = new Column("y", AbstractColumn::Numeric);
-		xVector = static_cast<QVector<double>* >(xColumn->data());
-		yVector = static_cast<QVector<double>* >(yColumn->data());
-
-		xColumn->setHidden(true);
-		q->addChild(xColumn);
-		yColumn->setHidden(true);
-		q->addChild(yColumn);
-
-		q->setUndoAware(false);
-		q->setXColumn(xColumn);
-		q->setYColumn(yColumn);
-		q->setUndoAware(true);
-	} else {
-		xVector->clear();
-		yVector->clear();
-	}
-
-	// clear the previous result
-	differentiationResult = XYDifferentiationCurve::DifferentiationResult();
-
-	if (!xDataColumn || !yDataColumn) {
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastDifferentiation = false;
-		return;
-	}
-
-	//check column sizes
-	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
-		differentiationResult.available = true;
-		differentiationResult.valid = false;
-		differentiationResult.status = i18n("Number of x and y data points must be equal.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastDifferentiation = false;
-		return;
-	}
+/*!
+ * differentiation of the snapshots of the source columns in a worker thread
+ */
+class XYDifferentiationCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYDifferentiationCurveJob(XYDifferentiationCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_differentiationData(curve->differentiationData) {}
+
+		void compute();
+		void publish();
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYDifferentiationCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const XYDifferentiationCurve::DifferentiationData m_differentiationData;
+		XYDifferentiationCurve::DifferentiationResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+};
+
+quint64 XYDifferentiationCurveJob::inputKey() const {
+	const XYDifferentiationCurve::DifferentiationData& d = m_differentiationData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << (int)d.derivOrder << d.accOrder << d.autoRange << d.xRange;
+	return dataKey(settings, m_xData, m_yData);
+}
 
+void XYDifferentiationCurveJob::compute() {
 	//copy all valid data point for the differentiation to temporary vectors
-	QVector<double> xdataVector;
-	QVector<double> ydataVector;
-	const double xmin = differentiationData.xRange.first();
-	const double xmax = differentiationData.xRange.last();
-	for (int row=0; row<xDataColumn->rowCount(); ++row) {
-		//only copy those data where _all_ values (for x and y, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-			&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
-
-			// only when inside given range
-			if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-				xdataVector.append(xDataColumn->valueAt(row));
-				ydataVector.append(yDataColumn->valueAt(row));
-			}
-		}
-	}
+	copyValidData(m_xData, m_yData, m_differentiationData.xRange.first(), m_differentiationData.xRange.last(), m_x, m_y);
 
 	//number of data points to differentiate
-	const unsigned int n = xdataVector.size();
+	const unsigned int n = m_x.size();
 	if (n < 3) {
-		differentiationResult.available = true;
-		differentiationResult.valid = false;
-		differentiationResult.status = i18n("Not enough data points available.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastDifferentiation = false;
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("Not enough data points available."));
+		m_x.clear();
+		m_y.clear();
 		return;
 	}
+	if (isCanceled())
+		return;
+	setProgress(10);
 
-	double* xdata = xdataVector.data();
-	double* ydata = ydataVector.data();
+	const double* xdata = m_x.constData();
+	double* ydata = m_y.data();
 
 	// differentiation settings
-	const nsl_diff_deriv_order_type derivOrder = differentiationData.derivOrder;
-	const int accOrder = differentiationData.accOrder;
+	const nsl_diff_deriv_order_type derivOrder = m_differentiationData.derivOrder;
+	const int accOrder = m_differentiationData.accOrder;
 
 	DEBUG(nsl_diff_deriv_order_name[derivOrder] << "derivative");
 	DEBUG("accuracy order:" << accOrder);
@@ -276,22 +254,76 @@ void XYDifferentiationCurvePrivate::recalculate() {
 		status = nsl_diff_sixth_deriv(xdata, ydata, n, accOrder);
 		break;
 	}
-
-	xVector->resize(n);
-	yVector->resize(n);
-	memcpy(xVector->data(), xdata, n*sizeof(double));
-	memcpy(yVector->data(), ydata, n*sizeof(double));
 ///////////////////////////////////////////////////////////
 
-	//write the result
-	differentiationResult.available = true;
-	differentiationResult.valid = true;
-	differentiationResult.status = QString::number(status);
-	differentiationResult.elapsedTime = timer.elapsed();
+	m_result.available = true;
+	m_result.valid = true;
+	m_result.status = QString::number(status);
+	m_result.elapsedTime = elapsedTime();
+}
+
+void XYDifferentiationCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	m_curve->differentiationResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * differentiates the data of the source columns. The calculation is done in a worker thread,
+ * the result columns are updated when it is finished.
+ */
+void XYDifferentiationCurvePrivate::recalculate() {
+	//create differentiation result columns if not available yet
+	if (!xColumn) {
+		xColumn = new Column("x", AbstractColumn::Numeric);
+		yColumn = new Column("y", AbstractColumn::Numeric);
+		xVector = static_cast<QVector<double>* >(xColumn->data());
+		yVector = static_cast<QVector<double>* >(yColumn->data());
+
+		xColumn->setHidden(true);
+		q->addChild(xColumn);
+		yColumn->setHidden(true);
+		q->addChild(yColumn);
+
+		q->setUndoAware(false);
+		q->setXColumn(xColumn);
+		q->setYColumn(yColumn);
+		q->setUndoAware(true);
+	}
+
+	if (!xDataColumn || !yDataColumn) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		differentiationResult = XYDifferentiationCurve::DifferentiationResult();
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastDifferentiation = false;
+		return;
+	}
+
+	//check column sizes
+	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		differentiationResult = XYDifferentiationCurve::DifferentiationResult();
+		differentiationResult.available = true;
+		differentiationResult.valid = false;
+		differentiationResult.status = i18n("Number of x and y data points must be equal.");
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastDifferentiation = false;
+		return;
+	}
 
-	//redraw the curve
-	emit (q->dataChanged());
 	sourceDataChangedSinceLastDifferentiation = false;
+	startAnalysisJob(new XYDifferentiationCurveJob(this));
 }
 
 //##############################################################################
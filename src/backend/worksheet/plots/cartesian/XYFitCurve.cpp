@@ -37,18 +37,22 @@
 
 #include "XYFitCurve.h"
 #include "XYFitCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "backend/core/AbstractColumn.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
+#include "backend/spreadsheet/Spreadsheet.h"
 #include "backend/lib/macros.h"
 #include "backend/gsl/ExpressionParser.h"
 
 extern "C" {
 #include <gsl/gsl_blas.h>
+#include <gsl/gsl_multifit_nlin.h>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_version.h>
 #include "backend/gsl/parser.h" 
+#include "backend/gsl/parser_expr.h"
 #include "backend/nsl/nsl_fit.h"
 #include "backend/nsl/nsl_sf_stats.h"
 }
@@ -56,8 +60,11 @@ extern "C" {
 
 #include <KIcon>
 #include <KLocale>
-#include <QElapsedTimer>
+#include <QDataStream>
+#include <QFutureInterface>
 #include <QThreadPool>
+#include <QThreadStorage>
+#include <QtConcurrentMap>
 
 XYFitCurve::XYFitCurve(const QString& name)
 		: XYCurve(name, new XYFitCurvePrivate(this)) {
@@ -168,6 +175,9 @@ void XYFitCurve::setFitData(const XYFitCurve::FitData& fitData) {
 //################################## SLOTS ####################################
 //##############################################################################
 void XYFitCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
 	Q_D(XYFitCurve);
 	d->sourceDataChangedSinceLastFit = true;
 	emit sourceDataChangedSinceLastFit();
@@ -204,8 +214,23 @@ struct data {
 	double* paramMin;	// lower parameter limits
 	double* paramMax;	// upper parameter limits
 	bool* paramFixed;	// parameter fixed?
+	parser_expr* model;	// compiled model with the variables x and the parameters, 0 if not compiled
+	parser_expr* const* derivatives;	// compiled derivatives of the model with respect to the parameters, 0 if not available
+	double* buffer;	// n values for the evaluation of the compiled model
+	bool parallel;	// evaluate the compiled model in parallel
 };
 
+/*!
+ * fills \c vars with the variable values of the compiled model: x (set by the evaluation) and the bounded parameter values
+ */
+static void compiledModelVariables(const gsl_vector* paramValues, struct data* params, QVector<double>& vars) {
+	const int np = params->paramNames->size();
+	vars.resize(np + 1);
+	vars[0] = 0;
+	for (int i = 0; i < np; i++)
+		vars[i + 1] = nsl_fit_map_bound(gsl_vector_get(paramValues, i), params->paramMin[i], params->paramMax[i]);
+}
+
 /*!
  * \param paramValues vector containing current values of the fit parameters
  * \param params
@@ -222,6 +247,36 @@ int func_f(const gsl_vector* paramValues, void* params, gsl_vector* f) {
 	QStringList* paramNames = ((struct data*)params)->paramNames;
 	double *min = ((struct data*)params)->paramMin;
 	double *max = ((struct data*)params)->paramMax;
+	parser_expr* model = ((struct data*)params)->model;
+
+	// checks for allowed values of x for different models
+	// TODO: more to check
+	if (modelCategory == nsl_fit_model_distribution && modelType == nsl_sf_stats_lognormal) {
+		for (size_t i = 0; i < n; i++)
+			if (x[i] < 0)
+				x[i] = 0;
+	}
+
+	// evaluate the compiled model for all x values at once
+	if (model) {
+		QVector<double> vars;
+		compiledModelVariables(paramValues, (struct data*)params, vars);
+		double* Y = ((struct data*)params)->buffer;
+		if (parser_expr_eval_vector(model, vars.constData(), 0, x, n, Y, ((struct data*)params)->parallel) != 0)
+			return GSL_ENOMEM;
+
+		for (size_t i = 0; i < n; i++) {
+			if (std::isnan(x[i]) || std::isnan(y[i]))
+				continue;
+
+			if (sigma)
+				gsl_vector_set (f, i, (Y[i] - y[i])/sigma[i]);
+			else
+				gsl_vector_set (f, i, (Y[i] - y[i]));
+		}
+
+		return GSL_SUCCESS;
+	}
 
 	// set current values of the parameters
 	for (int i = 0; i < paramNames->size(); i++) {
@@ -237,13 +292,6 @@ int func_f(const gsl_vector* paramValues, void* params, gsl_vector* f) {
 		if (std::isnan(x[i]) || std::isnan(y[i]))
 			continue;
 
-		// checks for allowed values of x for different models
-		// TODO: more to check
-		if (modelCategory == nsl_fit_model_distribution && modelType == nsl_sf_stats_lognormal) {
-			if (x[i] < 0)
-				x[i] = 0;
-		}
-
 		assign_variable("x", x[i]);
 		double Yi = parse(func);
 
@@ -739,7 +787,28 @@ int func_df(const gsl_vector* paramValues, void* params, gsl_matrix* J) {
 			break;
 		}
 		break;
-	case nsl_fit_model_custom:
+	case nsl_fit_model_custom: {
+		// symbolic derivatives of the compiled model: J(i,j) = dY/dp_j(x_i)/sigma_i
+		parser_expr* const* derivatives = ((struct data*)params)->derivatives;
+		if (derivatives) {
+			QVector<double> vars;
+			compiledModelVariables(paramValues, (struct data*)params, vars);
+			double* dY = ((struct data*)params)->buffer;
+			for (int j = 0; j < paramNames->size(); ++j) {
+				if (fixed[j]) {
+					for (size_t i = 0; i < n; i++)
+						gsl_matrix_set(J, i, j, 0.);
+					continue;
+				}
+
+				if (parser_expr_eval_vector(derivatives[j], vars.constData(), 0, xVector, n, dY, ((struct data*)params)->parallel) != 0)
+					return GSL_ENOMEM;
+				for (size_t i = 0; i < n; i++)
+					gsl_matrix_set(J, i, j, sigmaVector ? dY[i]/sigmaVector[i] : dY[i]);
+			}
+			break;
+		}
+
 		QByteArray funcba = ((struct data*)params)->func->toLocal8Bit();
 		char* func = funcba.data();
 		QByteArray nameba;
@@ -781,6 +850,7 @@ int func_df(const gsl_vector* paramValues, void* params, gsl_matrix* J) {
 			}
 		}
 	}
+	}
 
 	return GSL_SUCCESS;
 }
@@ -792,148 +862,143 @@ int func_fdf(const gsl_vector* x, void* params, gsl_vector* f, gsl_matrix* J) {
 	return GSL_SUCCESS;
 }
 
-void XYFitCurvePrivate::recalculate() {
-	QElapsedTimer timer;
-	timer.start();
-
-	//create fit result columns if not available yet, clear them otherwise
-	if (!xColumn) {
-		xColumn = new Column("x", AbstractColumn::Numeric);
-		yColumn = new Column("y", AbstractColumn::Numeric);
-		residualsColumn = new Column("residuals", AbstractColumn::Numeric);
-		xVector = static_cast<QVector<double>* >(xColumn->data());
-		yVector = static_cast<QVector<double>* >(yColumn->data());
-		residualsVector = static_cast<QVector<double>* >(residualsColumn->data());
-
-		xColumn->setHidden(true);
-		q->addChild(xColumn);
-
-		yColumn->setHidden(true);
-		q->addChild(yColumn);
-
-		q->addChild(residualsColumn);
-
-		q->setUndoAware(false);
-		q->setXColumn(xColumn);
-		q->setYColumn(yColumn);
-		q->setUndoAware(true);
-	} else {
-		xVector->clear();
-		yVector->clear();
-		residualsVector->clear();
-	}
+/*!
+ * the model compiled once for all evaluations of a fit (see parser_expr.h) together with the
+ * derivatives with respect to the parameters for custom models.
+ * \c model is 0 if the model can't be compiled (e.g. assignments), the parser is used in this case.
+ */
+class CompiledFitModel {
+	public:
+		explicit CompiledFitModel(const XYFitCurve::FitData& fitData) : m_custom(fitData.modelCategory == nsl_fit_model_custom) {
+			QVector<QByteArray> variableNames;
+			variableNames << QByteArray("x");
+			foreach (const QString& name, fitData.paramNames)
+				variableNames << name.toLocal8Bit();
+			QVector<const char*> variables;
+			foreach (const QByteArray& name, variableNames)
+				variables << name.constData();
+
+			model = parser_expr_compile(fitData.model.toLocal8Bit().constData(), variables.constData(), variables.size());
+			if (!model || !m_custom)
+				return;
+
+			for (int i = 0; i < fitData.paramNames.size(); i++) {
+				parser_expr* derivative = parser_expr_derivative(model, i + 1);
+				if (!derivative)
+					break;
+				derivatives << derivative;
+			}
+			// finite differences are used if not all derivatives are available
+			if (derivatives.size() != fitData.paramNames.size()) {
+				foreach (parser_expr* derivative, derivatives)
+					parser_expr_free(derivative);
+				derivatives.clear();
+			}
+		}
 
-	// clear the previous result
-	fitResult = XYFitCurve::FitResult();
+		~CompiledFitModel() {
+			foreach (parser_expr* derivative, derivatives)
+				parser_expr_free(derivative);
+			parser_expr_free(model);
+		}
 
-	if (!xDataColumn || !yDataColumn) {
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastFit = false;
-		return;
-	}
+		//the fit doesn't use the (global) parser and can run in several threads at once
+		bool isThreadSafe() const {
+			return model && (!m_custom || !derivatives.isEmpty());
+		}
 
-	//fit settings
-	const int maxIters = fitData.maxIterations;	//maximal number of iterations
-	const double delta = fitData.eps;		//fit tolerance
-	const unsigned int np = fitData.paramNames.size(); //number of fit parameters
-	if (np == 0) {
-		fitResult.available = true;
-		fitResult.valid = false;
-		fitResult.status = i18n("Model has no parameters.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastFit = false;
-		return;
-	}
+		parser_expr* model;
+		QVector<parser_expr*> derivatives;
 
-	//check column sizes
-	if (xDataColumn->rowCount() != yDataColumn->rowCount()) {
-		fitResult.available = true;
-		fitResult.valid = false;
-		fitResult.status = i18n("Number of x and y data points must be equal.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastFit = false;
-		return;
-	}
-	if (weightsColumn) {
-		if (weightsColumn->rowCount() < xDataColumn->rowCount()) {
-			fitResult.available = true;
-			fitResult.valid = false;
-			fitResult.status = i18n("Not sufficient weight data points provided.");
-			emit (q->dataChanged());
-			sourceDataChangedSinceLastFit = false;
-			return;
-		}
-	}
+	private:
+		Q_DISABLE_COPY(CompiledFitModel)
+		bool m_custom;
+};
 
-	//copy all valid data point for the fit to temporary vectors
-	QVector<double> xdataVector;
-	QVector<double> ydataVector;
-	QVector<double> sigmaVector;
+/*!
+ * copies the valid data points in the rows \c first to \c last (x-value inside the fit range,
+ * no NaN and no masked values) into the vectors \c xdata, \c ydata and, if weights are used, \c sigma.
+ */
+static void copyFitData(const XYFitCurve::FitData& fitData, const ColumnSnapshot& xData, const ColumnSnapshot& yData,
+		const ColumnSnapshot* weights, int first, int last, QVector<double>& xdataVector, QVector<double>& ydataVector, QVector<double>& sigmaVector) {
 	double xmin = fitData.xRange.first();
 	double xmax = fitData.xRange.last();
-	for (int row=0; row < xDataColumn->rowCount(); ++row) {
+	for (int row = first; row <= last; ++row) {
+		const double x = xData.valueAt(row);
+		const double y = yData.valueAt(row);
 		//only copy those data where _all_ values (for x, y and sigma, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-			&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
+		if (!std::isnan(x) && !std::isnan(y) && !xData.isMasked(row) && !yData.isMasked(row)) {
 
 			// only when inside given range
-			if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-				if (!weightsColumn) {
-					xdataVector.append(xDataColumn->valueAt(row));
-					ydataVector.append(yDataColumn->valueAt(row));
+			if (x >= xmin && x <= xmax) {
+				if (!weights) {
+					xdataVector.append(x);
+					ydataVector.append(y);
 				} else {
-					if (!std::isnan(weightsColumn->valueAt(row))) {
-						xdataVector.append(xDataColumn->valueAt(row));
-						ydataVector.append(yDataColumn->valueAt(row));
+					const double weight = weights->valueAt(row);
+					if (!std::isnan(weight)) {
+						xdataVector.append(x);
+						ydataVector.append(y);
 
 						if (fitData.weightsType == XYFitCurve::WeightsFromColumn) {
 							//weights from a given column -> calculate the square root of the inverse (sigma = sqrt(1/weight))
-							sigmaVector.append( sqrt(1./weightsColumn->valueAt(row)) );
+							sigmaVector.append( sqrt(1./weight) );
 						} else if (fitData.weightsType == XYFitCurve::WeightsFromErrorColumn) {
 							//weights from a given column with error bars (sigma = error)
-							sigmaVector.append( weightsColumn->valueAt(row) );
+							sigmaVector.append( weight );
 						}
 					}
 				}
 			}
 		}
 	}
+}
 
-	//number of data points to fit
-	const size_t n = xdataVector.size();
-	if (n == 0) {
-		fitResult.available = true;
-		fitResult.valid = false;
-		fitResult.status = i18n("No data points available.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastFit = false;
-		return;
-	}
+/*!
+ * writes out the current state of the solver \c s to \c output
+ */
+static void writeSolverState(gsl_multifit_fdfsolver* s, const XYFitCurve::FitData& fitData, QString& output) {
+	QString state;
 
-	if (n < np) {
-		fitResult.available = true;
-		fitResult.valid = false;
-		fitResult.status = i18n("The number of data points (%1) must be greater than or equal to the number of parameters (%2).", n, np);
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastFit = false;
-		return;
+	//current parameter values, semicolon separated
+	const double* min = fitData.paramLowerLimits.constData();
+	const double* max = fitData.paramUpperLimits.constData();
+	for (int i = 0; i < fitData.paramNames.size(); ++i) {
+		double x = gsl_vector_get(s->x, i);
+		// map parameter if bounded
+		state += QString::number(nsl_fit_map_bound(x, min[i], max[i])) + '\t';
 	}
 
-	double* xdata = xdataVector.data();
-	double* ydata = ydataVector.data();
-	double* sigma = 0;
-	if (!sigmaVector.isEmpty())
-		sigma = sigmaVector.data();
+	//current value of the chi2-function
+	state += QString::number(gsl_pow_2(gsl_blas_dnrm2(s->f)));
+	state += ';';
+
+	output += state;
+}
+
+/*!
+ * fits the model in \c fitData to the \c n data points \c xdata, \c ydata (weighted with \c sigma, if not 0)
+ * and writes the status, the parameter values, their errors and the goodness-of-fit into \c fitResult.
+ * The solver workspace \c s has to be allocated for \c n points and all parameters.
+ * If \c job is given, the state of the solver after each iteration is written to the solver output of \c fitResult,
+ * the progress is reported to the job and the iteration stops when the job is canceled.
+ */
+static void runFit(XYFitCurve::FitData& fitData, const CompiledFitModel& compiled, bool parallel,
+		double* xdata, double* ydata, double* sigma, size_t n, gsl_multifit_fdfsolver* s,
+		XYFitCurve::FitResult& fitResult, XYAnalysisJob* job) {
+	const int maxIters = fitData.maxIterations;	//maximal number of iterations
+	const double delta = fitData.eps;		//fit tolerance
+	const unsigned int np = fitData.paramNames.size(); //number of fit parameters
 
 	/////////////////////// GSL >= 2 has a complete new interface! But the old one is still supported. ///////////////////////////
 	// GSL >= 2 : "the 'fdf' field of gsl_multifit_function_fdf is now deprecated and does not need to be specified for nonlinear least squares problems"
-	for (unsigned int i = 0; i < np; i++)
-		DEBUG("fixed parameter"<<i<<fitData.paramFixed.data()[i]);
 
 	//function to fit
+	QVector<double> buffer(compiled.model ? n : 0);
 	gsl_multifit_function_fdf f;
-	struct data params = {n, xdata, ydata, sigma, fitData.modelCategory, fitData.modelType, fitData.degree, &fitData.model, &fitData.paramNames, 
-				fitData.paramLowerLimits.data(), fitData.paramUpperLimits.data(), fitData.paramFixed.data()};
+	struct data params = {n, xdata, ydata, sigma, fitData.modelCategory, fitData.modelType, fitData.degree, &fitData.model, &fitData.paramNames,
+				fitData.paramLowerLimits.data(), fitData.paramUpperLimits.data(), fitData.paramFixed.data(),
+				compiled.model, compiled.derivatives.isEmpty() ? 0 : compiled.derivatives.constData(), buffer.data(), parallel};
 	f.f = &func_f;
 	f.df = &func_df;
 	f.fdf = &func_fdf;
@@ -941,10 +1006,6 @@ void XYFitCurvePrivate::recalculate() {
 	f.p = np;
 	f.params = &params;
 
-	// initialize the derivative solver (using Levenberg-Marquardt robust solver)
-	const gsl_multifit_fdfsolver_type* T = gsl_multifit_fdfsolver_lmsder;
-	gsl_multifit_fdfsolver* s = gsl_multifit_fdfsolver_alloc(T, n, np);
-
 	// set start values
 	double* x_init = fitData.paramStartValues.data();
 	double* x_min = fitData.paramLowerLimits.data();
@@ -959,12 +1020,17 @@ void XYFitCurvePrivate::recalculate() {
 	//iterate
 	int status;
 	int iter = 0;
-	fitResult.solverOutput.clear();
-	writeSolverState(s);
+	if (job)
+		writeSolverState(s, fitData, fitResult.solverOutput);
 	do {
 		iter++;
 		status = gsl_multifit_fdfsolver_iterate(s);
-		writeSolverState(s);
+		if (job) {
+			writeSolverState(s, fitData, fitResult.solverOutput);
+			if (job->isCanceled())
+				break;
+			job->setProgress(10 + 70*iter/maxIters);
+		}
 		if (status) break;
 		status = gsl_multifit_test_delta(s->dx, s->x, delta, delta);
 	} while (status == GSL_CONTINUE && iter < maxIters);
@@ -981,6 +1047,7 @@ void XYFitCurvePrivate::recalculate() {
 	gsl_matrix *J = gsl_matrix_alloc(s->fdf->n, s->fdf->p);
 	gsl_multifit_fdfsolver_jac(s, J);
 	gsl_multifit_covar(J, 0.0, covar);
+	gsl_matrix_free(J);
 #else
 	gsl_multifit_covar(s->J, 0.0, covar);
 #endif
@@ -1034,84 +1101,533 @@ void XYFitCurvePrivate::recalculate() {
 	for (unsigned int i = 0; i < np; i++) {
 		// scale resulting values if they are bounded
 		fitResult.paramValues[i] = nsl_fit_map_bound(gsl_vector_get(s->x, i), x_min[i], x_max[i]);
-		// use results as start values if desired
-		if (fitData.useResults) {
-			fitData.paramStartValues.data()[i] = fitResult.paramValues[i];
-			DEBUG("saving parameter"<<i<<fitResult.paramValues[i]<<fitData.paramStartValues.data()[i]);
-		}
 		fitResult.errorValues[i] = c*sqrt(gsl_matrix_get(covar, i, i));
 	}
 
+	gsl_matrix_free(covar);
+}
+
+/*!
+ * fit of the snapshots of the source columns in a worker thread.
+ * Models which can't be compiled are evaluated with the (global) parser, these fits are done in the GUI thread.
+ */
+class XYFitCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYFitCurveJob(XYFitCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_weightsData(curve->weightsColumn),
+			m_hasWeights(curve->weightsColumn != 0), m_fitData(curve->fitData), m_compiled(curve->fitData) {}
+
+		void compute();
+		void publish();
+		bool isThreadSafe() const { return m_compiled.isThreadSafe(); }
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYFitCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const ColumnSnapshot m_weightsData;
+		const bool m_hasWeights;
+		XYFitCurve::FitData m_fitData;	// own copy, the start values are scaled during the fit
+		const CompiledFitModel m_compiled;
+		XYFitCurve::FitResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+		QVector<double> m_residuals;
+};
+
+quint64 XYFitCurveJob::inputKey() const {
+	const XYFitCurve::FitData& d = m_fitData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << (int)d.modelCategory << d.modelType << (int)d.weightsType << d.degree << d.model
+		<< d.paramNames << d.paramStartValues << d.paramLowerLimits << d.paramUpperLimits << d.paramFixed
+		<< d.maxIterations << d.eps << (quint64)d.evaluatedPoints << d.evaluateFullRange << d.autoRange << d.xRange;
+	const quint64 key = dataKey(settings, m_xData, m_yData);
+	return m_hasWeights ? combineKeys(key, m_weightsData.hash()) : key;
+}
+
+void XYFitCurveJob::compute() {
+	const unsigned int np = m_fitData.paramNames.size(); //number of fit parameters
+
+	//copy all valid data point for the fit to temporary vectors
+	QVector<double> xdataVector;
+	QVector<double> ydataVector;
+	QVector<double> sigmaVector;
+	copyFitData(m_fitData, m_xData, m_yData, m_hasWeights ? &m_weightsData : 0, 0, m_xData.rowCount() - 1, xdataVector, ydataVector, sigmaVector);
+	double xmin = m_fitData.xRange.first();
+	double xmax = m_fitData.xRange.last();
+
+	//number of data points to fit
+	const size_t n = xdataVector.size();
+	if (n == 0) {
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("No data points available."));
+		return;
+	}
+
+	if (n < np) {
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("The number of data points (%1) must be greater than or equal to the number of parameters (%2).").subs(n).subs(np));
+		return;
+	}
+	if (isCanceled())
+		return;
+	setProgress(10);
+
+	double* xdata = xdataVector.data();
+	double* ydata = ydataVector.data();
+	double* sigma = 0;
+	if (!sigmaVector.isEmpty())
+		sigma = sigmaVector.data();
+
+	for (unsigned int i = 0; i < np; i++)
+		DEBUG("fixed parameter"<<i<<m_fitData.paramFixed.data()[i]);
+
+	// initialize the derivative solver (using Levenberg-Marquardt robust solver)
+	const gsl_multifit_fdfsolver_type* T = gsl_multifit_fdfsolver_lmsder;
+	gsl_multifit_fdfsolver* s = gsl_multifit_fdfsolver_alloc(T, n, np);
+
+	runFit(m_fitData, m_compiled, true, xdata, ydata, sigma, n, s, m_result, this);
+	if (isCanceled()) {
+		gsl_multifit_fdfsolver_free(s);
+		return;
+	}
+	setProgress(80);
+
 	// fill residuals vector. To get residuals on the correct x values, fill the rest with zeros.
-	residualsVector->resize(xDataColumn->rowCount());
-	if (fitData.evaluateFullRange) {	// evaluate full range of residuals
-		xVector->resize(xDataColumn->rowCount());
-		for (int i = 0; i < xDataColumn->rowCount(); i++)
-			(*xVector)[i] = xDataColumn->valueAt(i);
-		ExpressionParser* parser = ExpressionParser::getInstance();
-		bool rc = parser->evaluateCartesian(fitData.model, xVector, residualsVector,
-							fitData.paramNames, fitResult.paramValues);
-		for (int i = 0; i < xDataColumn->rowCount(); i++)
-			(*residualsVector)[i] = yDataColumn->valueAt(i) - (*residualsVector)[i];
+	const int rows = m_xData.rowCount();
+	m_residuals.resize(rows);
+	if (m_fitData.evaluateFullRange) {	// evaluate full range of residuals
+		bool rc;
+		if (m_compiled.model) {
+			QVector<double> vars;
+			vars << 0 << m_result.paramValues;
+			rc = (parser_expr_eval_vector(m_compiled.model, vars.constData(), 0, m_xData.constData(), rows, m_residuals.data(), true) == 0);
+			for (int i = 0; i < rows; i++)
+				if (!std::isfinite(m_residuals[i]))
+					m_residuals[i] = NAN;
+		} else {
+			QVector<double> xVector = m_xData.values();
+			ExpressionParser* parser = ExpressionParser::getInstance();
+			rc = parser->evaluateCartesian(m_fitData.model, &xVector, &m_residuals,
+							m_fitData.paramNames, m_result.paramValues);
+		}
+		for (int i = 0; i < rows; i++)
+			m_residuals[i] = m_yData.valueAt(i) - m_residuals[i];
 		if (!rc)
-			residualsVector->clear();
+			m_residuals.clear();
 	} else {	// only selected range
 		size_t j = 0;
-		for (int i = 0; i < xDataColumn->rowCount(); i++) {
-			if (xDataColumn->valueAt(i) >= xmin && xDataColumn->valueAt(i) <= xmax)
-				residualsVector->data()[i] = - gsl_vector_get(s->f, j++);
+		for (int i = 0; i < rows; i++) {
+			if (m_xData.valueAt(i) >= xmin && m_xData.valueAt(i) <= xmax)
+				m_residuals[i] = - gsl_vector_get(s->f, j++);
 			else	// outside range
-				residualsVector->data()[i] = 0;
+				m_residuals[i] = 0;
 		}
 	}
-	residualsColumn->setChanged();
 
 	//free resources
 	gsl_multifit_fdfsolver_free(s);
-	gsl_matrix_free(covar);
+	setProgress(90);
 
 	//calculate the fit function (vectors)
-	ExpressionParser* parser = ExpressionParser::getInstance();
-	if (fitData.evaluateFullRange) { // evaluate fit on full data range if selected
-		xmin = xDataColumn->minimum();
-		xmax = xDataColumn->maximum();
+	if (m_fitData.evaluateFullRange) { // evaluate fit on full data range if selected
+		xmin = m_xData.minimum();
+		xmax = m_xData.maximum();
+	}
+	const int points = m_fitData.evaluatedPoints;
+	m_x.resize(points);
+	m_y.resize(points);
+	bool rc;
+	if (m_compiled.model) {
+		const double step = (xmax - xmin)/(double)(points - 1);
+		for (int i = 0; i < points; i++)
+			m_x[i] = xmin + step*i;
+		QVector<double> vars;
+		vars << 0 << m_result.paramValues;
+		rc = (parser_expr_eval_vector(m_compiled.model, vars.constData(), 0, m_x.constData(), points, m_y.data(), true) == 0);
+		for (int i = 0; i < points; i++)
+			if (!std::isfinite(m_y[i]))
+				m_y[i] = NAN;
+	} else {
+		ExpressionParser* parser = ExpressionParser::getInstance();
+		rc = parser->evaluateCartesian(m_fitData.model, QString::number(xmin), QString::number(xmax), points, &m_x, &m_y,
+						m_fitData.paramNames, m_result.paramValues);
 	}
-	xVector->resize(fitData.evaluatedPoints);
-	yVector->resize(fitData.evaluatedPoints);
-	bool rc = parser->evaluateCartesian(fitData.model, QString::number(xmin), QString::number(xmax), fitData.evaluatedPoints, xVector, yVector,
-						fitData.paramNames, fitResult.paramValues);
 	if (!rc) {
+		m_x.clear();
+		m_y.clear();
+	}
+
+	m_result.elapsedTime = elapsedTime();
+}
+
+void XYFitCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	// use results as start values if desired
+	XYFitCurve::FitData& fitData = m_curve->fitData;
+	if (m_result.valid && fitData.useResults) {
+		for (int i = 0; i < fitData.paramStartValues.size() && i < m_result.paramValues.size(); i++) {
+			fitData.paramStartValues.data()[i] = m_result.paramValues[i];
+			DEBUG("saving parameter"<<i<<m_result.paramValues[i]<<fitData.paramStartValues.data()[i]);
+		}
+	}
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	*m_curve->residualsVector = m_residuals;
+	m_curve->residualsColumn->setChanged();
+	m_curve->fitResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * fits the model to the data of the source columns. The fit is done in a worker thread if the model
+ * could be compiled, the result columns are updated when it is finished.
+ */
+void XYFitCurvePrivate::recalculate() {
+	//create fit result columns if not available yet
+	if (!xColumn) {
+		xColumn = new Column("x", AbstractColumn::Numeric);
+		yColumn = new Column("y", AbstractColumn::Numeric);
+		residualsColumn = new Column("residuals", AbstractColumn::Numeric);
+		xVector = static_cast<QVector<double>* >(xColumn->data());
+		yVector = static_cast<QVector<double>* >(yColumn->data());
+		residualsVector = static_cast<QVector<double>* >(residualsColumn->data());
+
+		xColumn->setHidden(true);
+		q->addChild(xColumn);
+
+		yColumn->setHidden(true);
+		q->addChild(yColumn);
+
+		q->addChild(residualsColumn);
+
+		q->setUndoAware(false);
+		q->setXColumn(xColumn);
+		q->setYColumn(yColumn);
+		q->setUndoAware(true);
+	}
+
+	QString error;
+	if (xDataColumn && yDataColumn) {
+		if (fitData.paramNames.isEmpty())
+			error = i18n("Model has no parameters.");
+		else if (xDataColumn->rowCount() != yDataColumn->rowCount())
+			error = i18n("Number of x and y data points must be equal.");
+		else if (weightsColumn && weightsColumn->rowCount() < xDataColumn->rowCount())
+			error = i18n("Not sufficient weight data points provided.");
+	}
+
+	if (!xDataColumn || !yDataColumn || !error.isEmpty()) {
+		q->cancelRecalculation();
+		analysisKey = 0;
 		xVector->clear();
 		yVector->clear();
+		residualsVector->clear();
+		fitResult = XYFitCurve::FitResult();
+		if (!error.isEmpty()) {
+			fitResult.available = true;
+			fitResult.valid = false;
+			fitResult.status = error;
+		}
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastFit = false;
+		return;
 	}
 
-	fitResult.elapsedTime = timer.elapsed();
-
-	//redraw the curve
-	emit (q->dataChanged());
 	sourceDataChangedSinceLastFit = false;
+	startAnalysisJob(new XYFitCurveJob(this));
 }
 
 /*!
- * writes out the current state of the solver \c s
+ * solver workspace of a thread, reused by all fits of the same size done in this thread
  */
-void XYFitCurvePrivate::writeSolverState(gsl_multifit_fdfsolver* s) {
-	QString state;
+class FitWorkspace {
+	public:
+		FitWorkspace() : m_solver(0) {}
+		~FitWorkspace() {
+			if (m_solver)
+				gsl_multifit_fdfsolver_free(m_solver);
+		}
 
-	//current parameter values, semicolon separated
-	double* min = fitData.paramLowerLimits.data();
-	double* max = fitData.paramUpperLimits.data();
-	for (int i = 0; i < fitData.paramNames.size(); ++i) {
-		double x = gsl_vector_get(s->x, i);
-		// map parameter if bounded
-		state += QString::number(nsl_fit_map_bound(x, min[i], max[i])) + '\t';
+		gsl_multifit_fdfsolver* solver(size_t n, size_t np) {
+			if (m_solver && (m_solver->f->size != n || m_solver->x->size != np)) {
+				gsl_multifit_fdfsolver_free(m_solver);
+				m_solver = 0;
+			}
+			if (!m_solver)
+				m_solver = gsl_multifit_fdfsolver_alloc(gsl_multifit_fdfsolver_lmsder, n, np);
+			return m_solver;
+		}
+
+	private:
+		gsl_multifit_fdfsolver* m_solver;
+};
+
+static QThreadStorage<FitWorkspace*> fitWorkspaces;
+
+/*!
+ * one data set of a batch fit
+ */
+struct BatchFitSet {
+	BatchFitSet() : ready(false) {}
+
+	QString name;
+	XYFitCurve::FitData fitData;	// own copy, the start values are scaled during the fit
+	QVector<double> x;
+	QVector<double> y;
+	QVector<double> sigma;
+	bool ready;	// valid data available for the fit
+	XYFitCurve::FitResult result;
+};
+
+/*!
+ * fits one data set of a batch fit, called for all data sets by QtConcurrent::map()
+ */
+class BatchFitFunctor {
+	public:
+		typedef void result_type;
+
+		explicit BatchFitFunctor(const CompiledFitModel* compiled) : m_compiled(compiled) {}
+
+		void operator()(BatchFitSet& set) const {
+			if (!set.ready)
+				return;
+
+			if (!fitWorkspaces.hasLocalData())
+				fitWorkspaces.setLocalData(new FitWorkspace());
+
+			const size_t n = set.x.size();
+			gsl_multifit_fdfsolver* s = fitWorkspaces.localData()->solver(n, set.fitData.paramNames.size());
+			runFit(set.fitData, *m_compiled, false, set.x.data(), set.y.data(), set.sigma.isEmpty() ? 0 : set.sigma.data(),
+				n, s, set.result, 0);
+		}
+
+	private:
+		const CompiledFitModel* m_compiled;
+};
+
+/*!
+ * data of a batch fit. If the model can't be compiled, the (not thread-safe) parser is used and the data sets
+ * are fitted one after another in the thread of the batch fit, one data set per event loop iteration (timerEvent()).
+ */
+class BatchFitPrivate : public QObject {
+	public:
+		BatchFitPrivate() : compiled(0), nextSet(0), timerId(0) {}
+
+		void fitNext();
+		void finishSequentialFits();
+
+		QString name;
+		XYFitCurve::FitData fitData;
+		QVector<BatchFitSet> sets;
+		CompiledFitModel* compiled;
+		QFuture<void> future;
+
+		//fits in the thread of the batch fit
+		QFutureInterface<void> sequentialFits;
+		int nextSet;
+		int timerId;
+
+	protected:
+		void timerEvent(QTimerEvent*) {
+			fitNext();
+		}
+};
+
+/*!
+ * fits the next data set with the parser, finishes the fits if all data sets are fitted or if the fits were canceled
+ */
+void BatchFitPrivate::fitNext() {
+	if (sequentialFits.isCanceled() || nextSet >= sets.size()) {
+		finishSequentialFits();
+		return;
 	}
 
-	//current value of the chi2-function
-	state += QString::number(gsl_pow_2(gsl_blas_dnrm2(s->f)));
-	state += ';';
+	const BatchFitFunctor fit(compiled);
+	fit(sets[nextSet++]);
+	sequentialFits.setProgressValue(nextSet);
+}
+
+void BatchFitPrivate::finishSequentialFits() {
+	if (!timerId)
+		return;
 
-	fitResult.solverOutput += state;
+	killTimer(timerId);
+	timerId = 0;
+	sequentialFits.reportFinished();
+}
+
+/*!
+ * \class XYFitCurve::BatchFit
+ * \brief Applies the fit of a curve (model, start values, limits, weights and fit range) to many data sets.
+ *
+ * The data of all data sets is copied when the batch fit is created, the columns are not accessed during the fits.
+ * \c yDataColumns contains the y-data of the data sets, \c xDataColumns either one x-data column for all y-data columns
+ * or one x-data column per y-data column. Each column is divided into \c segments parts of equal size which are fitted separately.
+ */
+XYFitCurve::BatchFit::BatchFit(const XYFitCurve* curve, const QVector<const AbstractColumn*>& xDataColumns,
+		const QVector<const AbstractColumn*>& yDataColumns, int segments) : d(new BatchFitPrivate()) {
+	const XYFitCurvePrivate* cd = curve->d_func();
+	d->name = curve->name();
+	d->fitData = cd->fitData;
+	const FitData& fitData = d->fitData;
+	const int np = fitData.paramNames.size();
+	if (np == 0 || xDataColumns.isEmpty() || yDataColumns.isEmpty() || segments < 1)
+		return;
+	if (xDataColumns.size() != 1 && xDataColumns.size() != yDataColumns.size())
+		return;
+
+	d->sets.resize(yDataColumns.size()*segments);
+	const ColumnSnapshot weights(cd->weightsColumn);
+	for (int c = 0; c < yDataColumns.size(); ++c) {
+		const AbstractColumn* xDataColumn = xDataColumns.at(xDataColumns.size() == 1 ? 0 : c);
+		const AbstractColumn* yDataColumn = yDataColumns.at(c);
+		const ColumnSnapshot xData(xDataColumn);
+		const ColumnSnapshot yData(yDataColumn);
+		const int rows = yDataColumn->rowCount();
+		for (int k = 0; k < segments; ++k) {
+			BatchFitSet& set = d->sets[c*segments + k];
+			const int first = (int)((qint64)rows*k/segments);
+			const int last = (int)((qint64)rows*(k + 1)/segments) - 1;
+			if (segments == 1)
+				set.name = yDataColumn->name();
+			else
+				set.name = QString("%1 [%2-%3]").arg(yDataColumn->name()).arg(first + 1).arg(last + 1);
+			set.fitData = fitData;
+			set.result.available = true;
+
+			if (xDataColumn->rowCount() != rows) {
+				set.result.status = i18n("Number of x and y data points must be equal.");
+				continue;
+			}
+			if (cd->weightsColumn && cd->weightsColumn->rowCount() < rows) {
+				set.result.status = i18n("Not sufficient weight data points provided.");
+				continue;
+			}
+
+			copyFitData(fitData, xData, yData, cd->weightsColumn ? &weights : 0, first, last, set.x, set.y, set.sigma);
+			if (set.x.isEmpty())
+				set.result.status = i18n("No data points available.");
+			else if (set.x.size() < np)
+				set.result.status = i18n("The number of data points (%1) must be greater than or equal to the number of parameters (%2).", set.x.size(), np);
+			else
+				set.ready = true;
+		}
+	}
+}
+
+/*!
+ * cancels the fits that are not started yet and waits for the running fits
+ */
+XYFitCurve::BatchFit::~BatchFit() {
+	d->future.cancel();
+	waitForFinished();
+	delete d->compiled;
+	delete d;
+}
+
+/*!
+ * number of data sets (columns times segments), 0 if there is nothing to fit
+ */
+int XYFitCurve::BatchFit::dataSetCount() const {
+	return d->sets.size();
+}
+
+/*!
+ * starts the fits and returns the future used to watch the progress (number of fitted data sets) and to cancel the fits.
+ * The data sets are fitted in parallel if the model could be compiled. Otherwise the (not thread-safe) parser is used
+ * and the data sets are fitted one after another in the calling thread while its event loop is running,
+ * the fits can be canceled between two data sets.
+ */
+QFuture<void> XYFitCurve::BatchFit::start() {
+	gsl_set_error_handler_off();
+	if (!d->compiled)
+		d->compiled = new CompiledFitModel(d->fitData);
+
+	if (d->compiled->isThreadSafe())
+		d->future = QtConcurrent::map(d->sets, BatchFitFunctor(d->compiled));
+	else {
+		d->nextSet = 0;
+		d->sequentialFits.reportStarted();
+		d->sequentialFits.setProgressRange(0, d->sets.size());
+		d->future = d->sequentialFits.future();
+		d->timerId = d->startTimer(0);
+	}
+
+	return d->future;
+}
+
+/*!
+ * waits until the fits started with start() are finished. Fits done in the calling thread
+ * that are not canceled and not done yet are done before this function returns.
+ */
+void XYFitCurve::BatchFit::waitForFinished() {
+	while (d->timerId)
+		d->fitNext();
+	d->future.waitForFinished();
+}
+
+/*!
+ * returns a new spreadsheet with the parameter values, their errors and the goodness-of-fit of all data sets
+ * (one row per data set) or 0 if there is nothing to fit or if the fits were canceled.
+ * Must be called after the future returned by start() is finished.
+ */
+Spreadsheet* XYFitCurve::BatchFit::results() const {
+	if (d->sets.isEmpty() || d->future.isCanceled())
+		return 0;
+
+	//write the results, one row per data set
+	const FitData& fitData = d->fitData;
+	const int np = fitData.paramNames.size();
+	QStringList names;
+	QStringList status;
+	QVector<QVector<double> > values(np);
+	QVector<QVector<double> > errors(np);
+	QVector<double> iterations, sse, rmse, rsquared, rsquaredAdj;
+	foreach (const BatchFitSet& set, d->sets) {
+		const FitResult& result = set.result;
+		names << set.name;
+		status << result.status;
+		for (int i = 0; i < np; ++i) {
+			values[i] << (result.valid ? result.paramValues.at(i) : NAN);
+			errors[i] << (result.valid ? result.errorValues.at(i) : NAN);
+		}
+		iterations << (result.valid ? result.iterations : NAN);
+		sse << (result.valid ? result.sse : NAN);
+		rmse << (result.valid ? result.rmse : NAN);
+		rsquared << (result.valid ? result.rsquared : NAN);
+		rsquaredAdj << (result.valid ? result.rsquaredAdj : NAN);
+	}
+
+	Spreadsheet* spreadsheet = new Spreadsheet(0, i18n("%1 - batch fit", d->name), true);
+	spreadsheet->addChild(new Column(i18n("data set"), names));
+	for (int i = 0; i < np; ++i) {
+		Column* column = new Column(fitData.paramNames.at(i), values.at(i));
+		column->setPlotDesignation(AbstractColumn::Y);
+		spreadsheet->addChild(column);
+
+		column = new Column(i18n("%1 error", fitData.paramNames.at(i)), errors.at(i));
+		column->setPlotDesignation(AbstractColumn::yErr);
+		spreadsheet->addChild(column);
+	}
+	spreadsheet->addChild(new Column(i18n("iterations"), iterations));
+	spreadsheet->addChild(new Column(i18n("sse"), sse));
+	spreadsheet->addChild(new Column(i18n("rmse"), rmse));
+	spreadsheet->addChild(new Column(i18n("R-squared"), rsquared));
+	spreadsheet->addChild(new Column(i18n("adj. R-squared"), rsquaredAdj));
+	spreadsheet->addChild(new Column(i18n("status"), status));
+
+	return spreadsheet;
 }
 
 
@@ -35,6 +35,10 @@ extern "C" {
 #include "backend/nsl/nsl_fit.h"
 }
 
+#include <QFuture>
+
+class Spreadsheet;
+class BatchFitPrivate;
 class XYFitCurvePrivate;
 class XYFitCurve : public XYCurve {
 	Q_OBJECT
@@ -98,6 +102,22 @@ class XYFitCurve : public XYCurve {
 			QString solverOutput;
 		};
 
+		class BatchFit {
+			public:
+				BatchFit(const XYFitCurve* curve, const QVector<const AbstractColumn*>& xDataColumns,
+						const QVector<const AbstractColumn*>& yDataColumns, int segments = 1);
+				~BatchFit();
+
+				int dataSetCount() const;
+				QFuture<void> start();
+				void waitForFinished();
+				Spreadsheet* results() const;
+
+			private:
+				Q_DISABLE_COPY(BatchFit)
+				BatchFitPrivate* const d;
+		};
+
 		explicit XYFitCurve(const QString& name);
 		virtual ~XYFitCurve();
 
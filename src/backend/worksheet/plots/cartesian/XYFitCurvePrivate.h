@@ -35,10 +35,6 @@
 class XYFitCurve;
 class Column;
 
-extern "C" {
-#include <gsl/gsl_multifit_nlin.h>
-}
-
 class XYFitCurvePrivate: public XYCurvePrivate {
 	public:
 		explicit XYFitCurvePrivate(XYFitCurve*);
@@ -67,9 +63,6 @@ class XYFitCurvePrivate: public XYCurvePrivate {
 		bool sourceDataChangedSinceLastFit; //<! \c true if the data in the source columns (x, y, or weights) was changed, \c false otherwise
 
 		XYFitCurve* const q;
-
-	private:
-		void writeSolverState(gsl_multifit_fdfsolver* s);
 };
 
 #endif
@@ -35,6 +35,7 @@
 
 #include "XYFourierFilterCurve.h"
 #include "XYFourierFilterCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "backend/core/AbstractColumn.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
@@ -53,7 +54,7 @@ extern "C" {
 
 #include <KIcon>
 #include <KLocale>
-#include <QElapsedTimer>
+#include <QDataStream>
 #include <QThreadPool>
 
 XYFourierFilterCurve::XYFourierFilterCurve(const QString& name)
@@ -151,6 +152,9 @@ void XYFourierFilterCurve::setFilterData(const XYFourierFilterCurve::FilterData&
 //################################## SLOTS ####################################
 //##############################################################################
 void XYFourierFilterCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
 	Q_D(XYFourierFilterCurve);
 	d->sourceDataChangedSinceLastFilter = true;
 	emit sourceDataChangedSinceLastFilter();
@@ -172,91 +176,65 @@ XYFourierFilterCurvePrivate::~XYFourierFilterCurvePrivate() {
 	//when the parent aspect is removed
 }
 
-// ...
-// see XYFitCurvePrivate
-
-void XYFourierFilterCurvePrivate::recalculate() {
-	QElapsedTimer timer;
-	timer.start();
-
-	//create filter result columns if not available yet, clear them otherwise
-	if (!xColumn) {
-		xColumn = new Column("x", AbstractColumn::Numeric);
-		yColumn = new Column("y", AbstractColumn::Numeric);
-		xVector = static_cast<QVector<double>* >(xColumn->data());
-		yVector = static_cast<QVector<double>* >(yColumn->data());
-
-		xColumn->setHidden(true);
-		q->addChild(xColumn);
-		yColumn->setHidden(true);
-		q->addChild(yColumn);
-
-		q->setUndoAware(false);
-		q->setXColumn(xColumn);
-		q->setYColumn(yColumn);
-		q->setUndoAware(true);
-	} else {
-		xVector->clear();
-		yVector->clear();
-	}
-
-	// clear the previous result
-	filterResult = XYFourierFilterCurve::FilterResult();
-
-	if (!xDataColumn || !yDataColumn) {
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastFilter = false;
-		return;
-	}
-
-	//check column sizes
-	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
-		filterResult.available = true;
-		filterResult.valid = false;
-		filterResult.status = i18n("Number of x and y data points must be equal.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastFilter = false;
-		return;
-	}
+/*!
+ * Fourier filter of the snapshots of the source columns in a worker thread
+ */
+class XYFourierFilterCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYFourierFilterCurveJob(XYFourierFilterCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_filterData(curve->filterData) {}
+
+		void compute();
+		void publish();
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYFourierFilterCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const XYFourierFilterCurve::FilterData m_filterData;
+		XYFourierFilterCurve::FilterResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+};
+
+quint64 XYFourierFilterCurveJob::inputKey() const {
+	const XYFourierFilterCurve::FilterData& d = m_filterData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << (int)d.type << (int)d.form << d.order << d.cutoff << (int)d.unit
+		<< d.cutoff2 << (int)d.unit2 << d.autoRange << d.xRange;
+	return dataKey(settings, m_xData, m_yData);
+}
 
+void XYFourierFilterCurveJob::compute() {
 	//copy all valid data point for the filter to temporary vectors
-	QVector<double> xdataVector;
-	QVector<double> ydataVector;
-	const double xmin = filterData.xRange.first();
-	const double xmax = filterData.xRange.last();
-	for (int row=0; row<xDataColumn->rowCount(); ++row) {
-		//only copy those data where _all_ values (for x and y, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-				&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
-			// only when inside given range
-			if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-				xdataVector.append(xDataColumn->valueAt(row));
-				ydataVector.append(yDataColumn->valueAt(row));
-			}
-		}
-	}
+	const double xmin = m_filterData.xRange.first();
+	const double xmax = m_filterData.xRange.last();
+	copyValidData(m_xData, m_yData, xmin, xmax, m_x, m_y);
 
 	//number of data points to filter
-	unsigned int n = xdataVector.size();
+	unsigned int n = m_x.size();
 	if (n == 0) {
-		filterResult.available = true;
-		filterResult.valid = false;
-		filterResult.status = i18n("No data points available.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastFilter = false;
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("No data points available."));
 		return;
 	}
+	if (isCanceled())
+		return;
+	setProgress(10);
 
-	//double* xdata = xdataVector.data();
-	double* ydata = ydataVector.data();
-
+	double* ydata = m_y.data();
 
 	// filter settings
-	const nsl_filter_type type = filterData.type;
-	const nsl_filter_form form = filterData.form;
-	const unsigned int order = filterData.order;
-	const double cutoff = filterData.cutoff, cutoff2 = filterData.cutoff2;
-	const nsl_filter_cutoff_unit unit = filterData.unit, unit2 = filterData.unit2;
+	const nsl_filter_type type = m_filterData.type;
+	const nsl_filter_form form = m_filterData.form;
+	const unsigned int order = m_filterData.order;
+	const double cutoff = m_filterData.cutoff, cutoff2 = m_filterData.cutoff2;
+	const nsl_filter_cutoff_unit unit = m_filterData.unit, unit2 = m_filterData.unit2;
 
 	DEBUG("n ="<<n);
 	DEBUG("type:"<<nsl_filter_type_name[type]);
@@ -290,6 +268,8 @@ void XYFourierFilterCurvePrivate::recalculate() {
 	const double bandwidth = (cutindex2 - cutindex);
 	if ((type == nsl_filter_type_band_pass || type == nsl_filter_type_band_reject) && bandwidth <= 0) {
 		qWarning()<<"band width must be > 0. Giving up.";
+		m_x.clear();
+		m_y.clear();
 		return;
 	}
 
@@ -298,22 +278,76 @@ void XYFourierFilterCurvePrivate::recalculate() {
 
 	// run filter
 	int status = nsl_filter_fourier(ydata, n, type, form, order, cutindex, bandwidth);
-
-	xVector->resize(n);
-	yVector->resize(n);
-	memcpy(xVector->data(), xdataVector.data(), n*sizeof(double));
-	memcpy(yVector->data(), ydata, n*sizeof(double));
 ///////////////////////////////////////////////////////////
 
-	//write the result
-	filterResult.available = true;
-	filterResult.valid = true;
-	filterResult.status = QString(gsl_strerror(status));;
-	filterResult.elapsedTime = timer.elapsed();
+	m_result.available = true;
+	m_result.valid = true;
+	m_result.status = QString(gsl_strerror(status));
+	m_result.elapsedTime = elapsedTime();
+}
+
+void XYFourierFilterCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	m_curve->filterResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * filters the data of the source columns. The calculation is done in a worker thread,
+ * the result columns are updated when it is finished.
+ */
+void XYFourierFilterCurvePrivate::recalculate() {
+	//create filter result columns if not available yet
+	if (!xColumn) {
+		xColumn = new Column("x", AbstractColumn::Numeric);
+		yColumn = new Column("y", AbstractColumn::Numeric);
+		xVector = static_cast<QVector<double>* >(xColumn->data());
+		yVector = static_cast<QVector<double>* >(yColumn->data());
+
+		xColumn->setHidden(true);
+		q->addChild(xColumn);
+		yColumn->setHidden(true);
+		q->addChild(yColumn);
+
+		q->setUndoAware(false);
+		q->setXColumn(xColumn);
+		q->setYColumn(yColumn);
+		q->setUndoAware(true);
+	}
+
+	if (!xDataColumn || !yDataColumn) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		filterResult = XYFourierFilterCurve::FilterResult();
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastFilter = false;
+		return;
+	}
+
+	//check column sizes
+	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		filterResult = XYFourierFilterCurve::FilterResult();
+		filterResult.available = true;
+		filterResult.valid = false;
+		filterResult.status = i18n("Number of x and y data points must be equal.");
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastFilter = false;
+		return;
+	}
 
-	//redraw the curve
-	emit (q->dataChanged());
 	sourceDataChangedSinceLastFilter = false;
+	startAnalysisJob(new XYFourierFilterCurveJob(this));
 }
 
 //##############################################################################
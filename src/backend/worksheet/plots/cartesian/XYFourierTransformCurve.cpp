@@ -35,6 +35,7 @@
 
 #include "XYFourierTransformCurve.h"
 #include "XYFourierTransformCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "backend/core/AbstractColumn.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
@@ -48,7 +49,7 @@ extern "C" {
 
 #include <KIcon>
 #include <KLocale>
-#include <QElapsedTimer>
+#include <QDataStream>
 #include <QThreadPool>
 
 XYFourierTransformCurve::XYFourierTransformCurve(const QString& name)
@@ -146,6 +147,9 @@ void XYFourierTransformCurve::setTransformData(const XYFourierTransformCurve::Tr
 //################################## SLOTS ####################################
 //##############################################################################
 void XYFourierTransformCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
 	Q_D(XYFourierTransformCurve);
 	d->sourceDataChangedSinceLastTransform = true;
 	emit sourceDataChangedSinceLastTransform();
@@ -167,90 +171,68 @@ XYFourierTransformCurvePrivate::~XYFourierTransformCurvePrivate() {
 	//when the parent aspect is removed
 }
 
-// ...
-// see XYFitCurvePrivate
-
-void XYFourierTransformCurvePrivate::recalculate() {
-	QElapsedTimer timer;
-	timer.start();
-
-	//create transform result columns if not available yet, clear them otherwise
-	if (!xColumn) {
-		xColumn = new Column("x", AbstractColumn::Numeric);
-		yColumn = new Column("y", AbstractColumn::Numeric);
-		xVector = static_cast<QVector<double>* >(xColumn->data());
-		yVector = static_cast<QVector<double>* >(yColumn->data());
-
-		xColumn->setHidden(true);
-		q->addChild(xColumn);
-		yColumn->setHidden(true);
-		q->addChild(yColumn);
-
-		q->setUndoAware(false);
-		q->setXColumn(xColumn);
-		q->setYColumn(yColumn);
-		q->setUndoAware(true);
-	} else {
-		xVector->clear();
-		yVector->clear();
-	}
-
-	// clear the previous result
-	transformResult = XYFourierTransformCurve::TransformResult();
-
-	if (!xDataColumn || !yDataColumn) {
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastTransform = false;
-		return;
-	}
-
-	//check column sizes
-	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
-		transformResult.available = true;
-		transformResult.valid = false;
-		transformResult.status = i18n("Number of x and y data points must be equal.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastTransform = false;
-		return;
-	}
+/*!
+ * Fourier transform of the snapshots of the source columns in a worker thread
+ */
+class XYFourierTransformCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYFourierTransformCurveJob(XYFourierTransformCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_transformData(curve->transformData) {}
+
+		void compute();
+		void publish();
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYFourierTransformCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const XYFourierTransformCurve::TransformData m_transformData;
+		XYFourierTransformCurve::TransformResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+};
+
+quint64 XYFourierTransformCurveJob::inputKey() const {
+	const XYFourierTransformCurve::TransformData& d = m_transformData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << (int)d.type << d.twoSided << d.shifted << (int)d.xScale << (int)d.windowType
+		<< d.autoRange << d.xRange;
+	return dataKey(settings, m_xData, m_yData);
+}
 
+void XYFourierTransformCurveJob::compute() {
 	//copy all valid data point for the transform to temporary vectors
 	QVector<double> xdataVector;
 	QVector<double> ydataVector;
-	const double xmin = transformData.xRange.first();
-	const double xmax = transformData.xRange.last();
-	for (int row=0; row<xDataColumn->rowCount(); ++row) {
-		//only copy those data where _all_ values (for x and y, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-				&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
-			// only when inside given range
-			if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-				xdataVector.append(xDataColumn->valueAt(row));
-				ydataVector.append(yDataColumn->valueAt(row));
-			}
-		}
-	}
+	const double xmin = m_transformData.xRange.first();
+	const double xmax = m_transformData.xRange.last();
+	copyValidData(m_xData, m_yData, xmin, xmax, xdataVector, ydataVector);
 
 	//number of data points to transform
 	unsigned int n = ydataVector.size();
 	if (n == 0) {
-		transformResult.available = true;
-		transformResult.valid = false;
-		transformResult.status = i18n("No data points available.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastTransform = false;
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("No data points available."));
 		return;
 	}
+	if (isCanceled())
+		return;
+	setProgress(10);
 
 	double* xdata = xdataVector.data();
 	double* ydata = ydataVector.data();
 
 	// transform settings
-	const nsl_sf_window_type windowType = transformData.windowType;
-	const nsl_dft_result_type type = transformData.type;
-	const bool twoSided = transformData.twoSided;
-	const bool shifted = transformData.shifted;
-	const nsl_dft_xscale xScale = transformData.xScale;
+	const nsl_sf_window_type windowType = m_transformData.windowType;
+	const nsl_dft_result_type type = m_transformData.type;
+	const bool twoSided = m_transformData.twoSided;
+	const bool shifted = m_transformData.shifted;
+	const nsl_dft_xscale xScale = m_transformData.xScale;
 
 	DEBUG("n =" << n);
 	DEBUG("window type:" << nsl_sf_window_type_name[windowType]);
@@ -258,15 +240,13 @@ void XYFourierTransformCurvePrivate::recalculate() {
 	DEBUG("scale:" << nsl_dft_xscale_name[xScale]);
 	DEBUG("two sided:" << twoSided);
 	DEBUG("shifted:" << shifted);
-#ifndef NDEBUG
-	QDebug out = qDebug();
-	for (unsigned int i=0; i < n; i++)
-		out<<ydata[i];
-#endif
 
 ///////////////////////////////////////////////////////////
 	// transform with window
 	int status = nsl_dft_transform_window(ydata, 1, n, twoSided, type, windowType);
+	if (isCanceled())
+		return;
+	setProgress(80);
 
 	unsigned int N=n;
 	if(twoSided == false)
@@ -298,34 +278,88 @@ void XYFourierTransformCurvePrivate::recalculate() {
 		break;
 	}
 	}
-#ifndef NDEBUG
-	out = qDebug();
-	for (unsigned int i=0; i < N; i++)
-		out << ydata[i] << '(' << xdata[i] << ')';
-#endif
-
-	xVector->resize(N);
-	yVector->resize(N);
+
+	m_x.resize(N);
+	m_y.resize(N);
 	if(shifted) {
-		memcpy(xVector->data(), &xdata[n/2], n/2*sizeof(double));
-		memcpy(&xVector->data()[n/2], xdata, n/2*sizeof(double));
-		memcpy(yVector->data(), &ydata[n/2], n/2*sizeof(double));
-		memcpy(&yVector->data()[n/2], ydata, n/2*sizeof(double));
+		memcpy(m_x.data(), &xdata[n/2], n/2*sizeof(double));
+		memcpy(&m_x.data()[n/2], xdata, n/2*sizeof(double));
+		memcpy(m_y.data(), &ydata[n/2], n/2*sizeof(double));
+		memcpy(&m_y.data()[n/2], ydata, n/2*sizeof(double));
 	} else {
-		memcpy(xVector->data(), xdata, N*sizeof(double));
-		memcpy(yVector->data(), ydata, N*sizeof(double));
+		memcpy(m_x.data(), xdata, N*sizeof(double));
+		memcpy(m_y.data(), ydata, N*sizeof(double));
 	}
 ///////////////////////////////////////////////////////////
 
-	//write the result
-	transformResult.available = true;
-	transformResult.valid = true;
-	transformResult.status = QString(gsl_strerror(status));;
-	transformResult.elapsedTime = timer.elapsed();
+	m_result.available = true;
+	m_result.valid = true;
+	m_result.status = QString(gsl_strerror(status));
+	m_result.elapsedTime = elapsedTime();
+}
+
+void XYFourierTransformCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	m_curve->transformResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * transforms the data of the source columns. The calculation is done in a worker thread,
+ * the result columns are updated when it is finished.
+ */
+void XYFourierTransformCurvePrivate::recalculate() {
+	//create transform result columns if not available yet
+	if (!xColumn) {
+		xColumn = new Column("x", AbstractColumn::Numeric);
+		yColumn = new Column("y", AbstractColumn::Numeric);
+		xVector = static_cast<QVector<double>* >(xColumn->data());
+		yVector = static_cast<QVector<double>* >(yColumn->data());
+
+		xColumn->setHidden(true);
+		q->addChild(xColumn);
+		yColumn->setHidden(true);
+		q->addChild(yColumn);
+
+		q->setUndoAware(false);
+		q->setXColumn(xColumn);
+		q->setYColumn(yColumn);
+		q->setUndoAware(true);
+	}
+
+	if (!xDataColumn || !yDataColumn) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		transformResult = XYFourierTransformCurve::TransformResult();
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastTransform = false;
+		return;
+	}
+
+	//check column sizes
+	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		transformResult = XYFourierTransformCurve::TransformResult();
+		transformResult.available = true;
+		transformResult.valid = false;
+		transformResult.status = i18n("Number of x and y data points must be equal.");
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastTransform = false;
+		return;
+	}
 
-	//redraw the curve
-	emit (q->dataChanged());
 	sourceDataChangedSinceLastTransform = false;
+	startAnalysisJob(new XYFourierTransformCurveJob(this));
 }
 
 //##############################################################################
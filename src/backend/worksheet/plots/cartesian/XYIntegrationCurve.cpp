@@ -35,6 +35,7 @@
 
 #include "XYIntegrationCurve.h"
 #include "XYIntegrationCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "CartesianCoordinateSystem.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
@@ -48,7 +49,7 @@ extern "C" {
 
 #include <KIcon>
 #include <KLocale>
-#include <QElapsedTimer>
+#include <QDataStream>
 #include <QThreadPool>
 
 XYIntegrationCurve::XYIntegrationCurve(const QString& name)
@@ -146,6 +147,9 @@ void XYIntegrationCurve::setIntegrationData(const XYIntegrationCurve::Integratio
 //################################## SLOTS ####################################
 //##############################################################################
 void XYIntegrationCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
 	Q_D(XYIntegrationCurve);
 	d->sourceDataChangedSinceLastIntegration = true;
 	emit sourceDataChangedSinceLastIntegration();
@@ -167,14 +171,115 @@ XYIntegrationCurvePrivate::~XYIntegrationCurvePrivate() {
 	//when the parent aspect is removed
 }
 
-// ...
-// see XYFitCurvePrivate
+/*!
+ * integration of the snapshots of the source columns in a worker thread
+ */
+class XYIntegrationCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYIntegrationCurveJob(XYIntegrationCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_integrationData(curve->integrationData) {}
+
+		void compute();
+		void publish();
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYIntegrationCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const XYIntegrationCurve::IntegrationData m_integrationData;
+		XYIntegrationCurve::IntegrationResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+};
+
+quint64 XYIntegrationCurveJob::inputKey() const {
+	const XYIntegrationCurve::IntegrationData& d = m_integrationData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << (int)d.method << d.absolute << d.autoRange << d.xRange;
+	return dataKey(settings, m_xData, m_yData);
+}
 
-void XYIntegrationCurvePrivate::recalculate() {
-	QElapsedTimer timer;
-	timer.start();
+void XYIntegrationCurveJob::compute() {
+	//copy all valid data point for the integration to temporary vectors
+	copyValidData(m_xData, m_yData, m_integrationData.xRange.first(), m_integrationData.xRange.last(), m_x, m_y);
+
+	const size_t n = m_x.size();	// number of data points to integrate
+	if (n < 2) {
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("Not enough data points available."));
+		m_x.clear();
+		m_y.clear();
+		return;
+	}
+	if (isCanceled())
+		return;
+	setProgress(10);
+
+	//x is only changed by the Simpson rules, don't detach it from the source data otherwise
+	const double* xdata = m_x.constData();
+	double* ydata = m_y.data();
 
-	//create integration result columns if not available yet, clear them otherwise
+	// integration settings
+	const nsl_int_method_type method = m_integrationData.method;
+	const bool absolute = m_integrationData.absolute;
+
+	DEBUG("method:"<<nsl_int_method_name[method]);
+	DEBUG("absolute area:"<<absolute);
+
+///////////////////////////////////////////////////////////
+	int status=0;
+	size_t np=n;
+
+	switch (method) {
+	case nsl_int_method_rectangle:
+		status = nsl_int_rectangle(xdata, ydata, n, absolute);
+		break;
+	case nsl_int_method_trapezoid:
+		status = nsl_int_trapezoid(xdata, ydata, n, absolute);
+		break;
+	case nsl_int_method_simpson:
+		np = nsl_int_simpson(m_x.data(), ydata, n, absolute);
+		break;
+	case nsl_int_method_simpson_3_8:
+		np = nsl_int_simpson_3_8(m_x.data(), ydata, n, absolute);
+		break;
+	}
+
+	if (np != n) {
+		m_x.resize(np);
+		m_y.resize(np);
+	}
+///////////////////////////////////////////////////////////
+
+	m_result.available = true;
+	m_result.valid = true;
+	m_result.status = QString::number(status);
+	m_result.elapsedTime = elapsedTime();
+	m_result.value = m_y[np-1];
+}
+
+void XYIntegrationCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	m_curve->integrationResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * integrates the data of the source columns. The calculation is done in a worker thread,
+ * the result columns are updated when it is finished.
+ */
+void XYIntegrationCurvePrivate::recalculate() {
+	//create integration result columns if not available yet
 	if (!xColumn) {
 		xColumn = new Column("x", AbstractColumn::Numeric);
 		yColumn = new Column("y", AbstractColumn::Numeric);
@@ -190,22 +295,26 @@ void XYIntegrationCurvePrivate::recalculate() {
 		q->setXColumn(xColumn);
 		q->setYColumn(yColumn);
 		q->setUndoAware(true);
-	} else {
-		xVector->clear();
-		yVector->clear();
 	}
 
-	// clear the previous result
-	integrationResult = XYIntegrationCurve::IntegrationResult();
-
 	if (!xDataColumn || !yDataColumn) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		integrationResult = XYIntegrationCurve::IntegrationResult();
 		emit (q->dataChanged());
 		sourceDataChangedSinceLastIntegration = false;
 		return;
 	}
 
 	//check column sizes
-	if (xDataColumn->rowCount() != yDataColumn->rowCount()) {
+	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		integrationResult = XYIntegrationCurve::IntegrationResult();
 		integrationResult.available = true;
 		integrationResult.valid = false;
 		integrationResult.status = i18n("Number of x and y data points must be equal.");
@@ -214,79 +323,8 @@ void XYIntegrationCurvePrivate::recalculate() {
 		return;
 	}
 
-	//copy all valid data point for the integration to temporary vectors
-	QVector<double> xdataVector;
-	QVector<double> ydataVector;
-	const double xmin = integrationData.xRange.first();
-	const double xmax = integrationData.xRange.last();
-	for (int row=0; row < xDataColumn->rowCount(); ++row) {
-		//only copy those data where _all_ values (for x and y, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-			&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
-
-			// only when inside given range
-			if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-				xdataVector.append(xDataColumn->valueAt(row));
-				ydataVector.append(yDataColumn->valueAt(row));
-			}
-		}
-	}
-
-	const size_t n = xdataVector.size();	// number of data points to integrate
-	if (n < 2) {
-		integrationResult.available = true;
-		integrationResult.valid = false;
-		integrationResult.status = i18n("Not enough data points available.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastIntegration = false;
-		return;
-	}
-
-	double* xdata = xdataVector.data();
-	double* ydata = ydataVector.data();
-
-	// integration settings
-	const nsl_int_method_type method = integrationData.method;
-	const bool absolute = integrationData.absolute;
-
-	DEBUG("method:"<<nsl_int_method_name[method]);
-	DEBUG("absolute area:"<<absolute);
-
-///////////////////////////////////////////////////////////
-	int status=0;
-	size_t np=n;
-
-	switch (method) {
-	case nsl_int_method_rectangle:
-		status = nsl_int_rectangle(xdata, ydata, n, absolute);
-		break;
-	case nsl_int_method_trapezoid:
-		status = nsl_int_trapezoid(xdata, ydata, n, absolute);
-		break;
-	case nsl_int_method_simpson:
-		np = nsl_int_simpson(xdata, ydata, n, absolute);
-		break;
-	case nsl_int_method_simpson_3_8:
-		np = nsl_int_simpson_3_8(xdata, ydata, n, absolute);
-		break;
-	}
-
-	xVector->resize(np);
-	yVector->resize(np);
-	memcpy(xVector->data(), xdata, np*sizeof(double));
-	memcpy(yVector->data(), ydata, np*sizeof(double));
-///////////////////////////////////////////////////////////
-
-	//write the result
-	integrationResult.available = true;
-	integrationResult.valid = true;
-	integrationResult.status = QString::number(status);
-	integrationResult.elapsedTime = timer.elapsed();
-	integrationResult.value = ydata[np-1];
-
-	//redraw the curve
-	emit (q->dataChanged());
 	sourceDataChangedSinceLastIntegration = false;
+	startAnalysisJob(new XYIntegrationCurveJob(this));
 }
 
 //##############################################################################
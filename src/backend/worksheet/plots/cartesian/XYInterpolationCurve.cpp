@@ -35,6 +35,7 @@
 
 #include "XYInterpolationCurve.h"
 #include "XYInterpolationCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "CartesianCoordinateSystem.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
@@ -52,7 +53,7 @@ extern "C" {
 
 #include <KIcon>
 #include <KLocale>
-#include <QElapsedTimer>
+#include <QDataStream>
 #include <QThreadPool>
 
 XYInterpolationCurve::XYInterpolationCurve(const QString& name)
@@ -150,6 +151,9 @@ void XYInterpolationCurve::setInterpolationData(const XYInterpolationCurve::Inte
 //################################## SLOTS ####################################
 //##############################################################################
 void XYInterpolationCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
 	Q_D(XYInterpolationCurve);
 	d->sourceDataChangedSinceLastInterpolation = true;
 	emit sourceDataChangedSinceLastInterpolation();
@@ -171,93 +175,70 @@ XYInterpolationCurvePrivate::~XYInterpolationCurvePrivate() {
 	//when the parent aspect is removed
 }
 
-// ...
-// see XYFitCurvePrivate
-
-void XYInterpolationCurvePrivate::recalculate() {
-	QElapsedTimer timer;
-	timer.start();
-
-	//create interpolation result columns if not available yet, clear them otherwise
-	if (!xColumn) {
-		xColumn = new Column("x", AbstractColumn::Numeric);
-		yColumn = new Column("y", AbstractColumn::Numeric);
-		xVector = static_cast<QVector<double>* >(xColumn->data());
-		yVector = static_cast<QVector<double>* >(yColumn->data());
-
-		xColumn->setHidden(true);
-		q->addChild(xColumn);
-		yColumn->setHidden(true);
-		q->addChild(yColumn);
-
-		q->setUndoAware(false);
-		q->setXColumn(xColumn);
-		q->setYColumn(yColumn);
-		q->setUndoAware(true);
-	} else {
-		xVector->clear();
-		yVector->clear();
-	}
-
-	// clear the previous result
-	interpolationResult = XYInterpolationCurve::InterpolationResult();
-
-	if (!xDataColumn || !yDataColumn) {
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastInterpolation = false;
-		return;
-	}
-
-	//check column sizes
-	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
-		interpolationResult.available = true;
-		interpolationResult.valid = false;
-		interpolationResult.status = i18n("Number of x and y data points must be equal.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastInterpolation = false;
-		return;
-	}
+/*!
+ * interpolation of the snapshots of the source columns in a worker thread
+ */
+class XYInterpolationCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYInterpolationCurveJob(XYInterpolationCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_interpolationData(curve->interpolationData) {}
+
+		void compute();
+		void publish();
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYInterpolationCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const XYInterpolationCurve::InterpolationData m_interpolationData;
+		XYInterpolationCurve::InterpolationResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+};
+
+quint64 XYInterpolationCurveJob::inputKey() const {
+	const XYInterpolationCurve::InterpolationData& d = m_interpolationData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << (int)d.type << (int)d.variant << d.tension << d.continuity << d.bias
+		<< (int)d.evaluate << d.npoints << (int)d.pointsMode << d.autoRange << d.xRange;
+	return dataKey(settings, m_xData, m_yData);
+}
 
+void XYInterpolationCurveJob::compute() {
 	//copy all valid data point for the interpolation to temporary vectors
 	QVector<double> xdataVector;
 	QVector<double> ydataVector;
-	const double xmin = interpolationData.xRange.first();
-	const double xmax = interpolationData.xRange.last();
-	for (int row=0; row<xDataColumn->rowCount(); ++row) {
-		//only copy those data where _all_ values (for x and y, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-			&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
-
-			// only when inside given range
-			if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-				xdataVector.append(xDataColumn->valueAt(row));
-				ydataVector.append(yDataColumn->valueAt(row));
-			}
-		}
-	}
+	const double xmin = m_interpolationData.xRange.first();
+	const double xmax = m_interpolationData.xRange.last();
+	copyValidData(m_xData, m_yData, xmin, xmax, xdataVector, ydataVector);
 
 	//number of data points to interpolate
 	const unsigned int n = xdataVector.size();
 	if (n < 2) {
-		interpolationResult.available = true;
-		interpolationResult.valid = false;
-		interpolationResult.status = i18n("Not enough data points available.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastInterpolation = false;
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("Not enough data points available."));
 		return;
 	}
+	if (isCanceled())
+		return;
+	setProgress(10);
 
 	double* xdata = xdataVector.data();
 	double* ydata = ydataVector.data();
 
 	// interpolation settings
-	const nsl_interp_type type = interpolationData.type;
-	const nsl_interp_pch_variant variant = interpolationData.variant;
-	const double tension = interpolationData.tension;
-	const double continuity = interpolationData.continuity;
-	const double bias = interpolationData.bias;
-	const nsl_interp_evaluate evaluate = interpolationData.evaluate;
-	const unsigned int npoints = interpolationData.npoints;
+	const nsl_interp_type type = m_interpolationData.type;
+	const nsl_interp_pch_variant variant = m_interpolationData.variant;
+	const double tension = m_interpolationData.tension;
+	const double continuity = m_interpolationData.continuity;
+	const double bias = m_interpolationData.bias;
+	const nsl_interp_evaluate evaluate = m_interpolationData.evaluate;
+	const unsigned int npoints = m_interpolationData.npoints;
 
 	DEBUG("type:"<<nsl_interp_type_name[type]);
 	DEBUG("cubic Hermite variant:"<<nsl_interp_pch_variant_name[variant]<<tension<<continuity<<bias);
@@ -307,13 +288,21 @@ void XYInterpolationCurvePrivate::recalculate() {
 		break;
 	}
 
-	xVector->resize(npoints);
-	yVector->resize(npoints);
+	m_x.resize(npoints);
+	m_y.resize(npoints);
+	double* xresult = m_x.data();
+	double* yresult = m_y.data();
 	for (unsigned int i = 0; i < npoints; i++) {
+		if (i % 4096 == 0) {
+			if (isCanceled())
+				break;
+			setProgress(10 + (int)(80.*i/npoints));
+		}
+
 		unsigned int a=0,b=n-1;
 
 		double x = xmin + i*(xmax-xmin)/(npoints-1);
-		(*xVector)[i] = x;
+		xresult[i] = x;
 
 		// find index a,b for interval [x[a],x[b]] around x[i] using bisection
 		int j=0;
@@ -339,27 +328,27 @@ void XYInterpolationCurvePrivate::recalculate() {
 		case nsl_interp_type_steffen:
 			switch (evaluate) {
 			case nsl_interp_evaluate_function:
-				(*yVector)[i] = gsl_spline_eval(spline, x, acc);
+				yresult[i] = gsl_spline_eval(spline, x, acc);
 				break;
 			case nsl_interp_evaluate_derivative:
-				(*yVector)[i] = gsl_spline_eval_deriv(spline, x, acc);
+				yresult[i] = gsl_spline_eval_deriv(spline, x, acc);
 				break;
 			case nsl_interp_evaluate_second_derivative:
-				(*yVector)[i] = gsl_spline_eval_deriv2(spline, x, acc);
+				yresult[i] = gsl_spline_eval_deriv2(spline, x, acc);
 				break;
 			case nsl_interp_evaluate_integral:
-				(*yVector)[i] = gsl_spline_eval_integ(spline, xmin, x, acc);
+				yresult[i] = gsl_spline_eval_integ(spline, xmin, x, acc);
 				break;
 			}
 			break;
 		case nsl_interp_type_cosine:
 			t = (x-xdata[a])/(xdata[b]-xdata[a]);
 			t = (1.-cos(M_PI*t))/2.;
-			(*yVector)[i] =  ydata[a] + t*(ydata[b]-ydata[a]);
+			yresult[i] =  ydata[a] + t*(ydata[b]-ydata[a]);
 			break;
 		case nsl_interp_type_exponential:
 			t = (x-xdata[a])/(xdata[b]-xdata[a]);
-			(*yVector)[i] = ydata[a]*pow(ydata[b]/ydata[a],t);
+			yresult[i] = ydata[a]*pow(ydata[b]/ydata[a],t);
 			break;
 		case nsl_interp_type_pch: {
 			t = (x-xdata[a])/(xdata[b]-xdata[a]);
@@ -420,13 +409,13 @@ void XYInterpolationCurvePrivate::recalculate() {
 			}	
 
 			// Hermite polynomial
-			(*yVector)[i] = ydata[a]*h1+ydata[b]*h2+(xdata[b]-xdata[a])*(m1*h3+m2*h4);
+			yresult[i] = ydata[a]*h1+ydata[b]*h2+(xdata[b]-xdata[a])*(m1*h3+m2*h4);
 		}
 			break;
 		case nsl_interp_type_rational: {
 			double v,dv;
 			nsl_interp_ratint(xdata, ydata, n, x, &v, &dv);
-			(*yVector)[i] = v;
+			yresult[i] = v;
 			//TODO: use error dv
 			break;
 		}
@@ -439,23 +428,23 @@ void XYInterpolationCurvePrivate::recalculate() {
 		case nsl_interp_evaluate_function:
 			break;
 		case nsl_interp_evaluate_derivative:
-			nsl_diff_first_deriv_second_order(xVector->data(), yVector->data(), npoints);
+			nsl_diff_first_deriv_second_order(xresult, yresult, npoints);
 			break;
 		case nsl_interp_evaluate_second_derivative:
-			nsl_diff_second_deriv_second_order(xVector->data(), yVector->data(), npoints);
+			nsl_diff_second_deriv_second_order(xresult, yresult, npoints);
 			break;
 		case nsl_interp_evaluate_integral:
-			nsl_int_trapezoid(xVector->data(), yVector->data(), npoints, 0);
+			nsl_int_trapezoid(xresult, yresult, npoints, 0);
 			break;
 		}
 	}
 
 	// check values
 	for (unsigned int i = 0; i < npoints; i++) {
-		if ((*yVector)[i] > CartesianScale::LIMIT_MAX)
-			(*yVector)[i] = CartesianScale::LIMIT_MAX;
-		else if ((*yVector)[i] < CartesianScale::LIMIT_MIN)
-			(*yVector)[i] = CartesianScale::LIMIT_MIN;
+		if (yresult[i] > CartesianScale::LIMIT_MAX)
+			yresult[i] = CartesianScale::LIMIT_MAX;
+		else if (yresult[i] < CartesianScale::LIMIT_MIN)
+			yresult[i] = CartesianScale::LIMIT_MIN;
 	}
 
 	gsl_spline_free(spline);
@@ -463,15 +452,74 @@ void XYInterpolationCurvePrivate::recalculate() {
 
 ///////////////////////////////////////////////////////////
 
-	//write the result
-	interpolationResult.available = true;
-	interpolationResult.valid = true;
-	interpolationResult.status = QString(gsl_strerror(status));;
-	interpolationResult.elapsedTime = timer.elapsed();
+	m_result.available = true;
+	m_result.valid = true;
+	m_result.status = QString(gsl_strerror(status));
+	m_result.elapsedTime = elapsedTime();
+}
+
+void XYInterpolationCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	m_curve->interpolationResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * interpolates the data of the source columns. The calculation is done in a worker thread,
+ * the result columns are updated when it is finished.
+ */
+void XYInterpolationCurvePrivate::recalculate() {
+	//create interpolation result columns if not available yet
+	if (!xColumn) {
+		xColumn = new Column("x", AbstractColumn::Numeric);
+		yColumn = new Column("y", AbstractColumn::Numeric);
+		xVector = static_cast<QVector<double>* >(xColumn->data());
+		yVector = static_cast<QVector<double>* >(yColumn->data());
+
+		xColumn->setHidden(true);
+		q->addChild(xColumn);
+		yColumn->setHidden(true);
+		q->addChild(yColumn);
+
+		q->setUndoAware(false);
+		q->setXColumn(xColumn);
+		q->setYColumn(yColumn);
+		q->setUndoAware(true);
+	}
+
+	if (!xDataColumn || !yDataColumn) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		interpolationResult = XYInterpolationCurve::InterpolationResult();
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastInterpolation = false;
+		return;
+	}
+
+	//check column sizes
+	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		interpolationResult = XYInterpolationCurve::InterpolationResult();
+		interpolationResult.available = true;
+		interpolationResult.valid = false;
+		interpolationResult.status = i18n("Number of x and y data points must be equal.");
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastInterpolation = false;
+		return;
+	}
 
-	//redraw the curve
-	emit (q->dataChanged());
 	sourceDataChangedSinceLastInterpolation = false;
+	startAnalysisJob(new XYInterpolationCurveJob(this));
 }
 
 //##############################################################################
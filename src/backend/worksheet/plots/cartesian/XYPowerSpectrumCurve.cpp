@@ -0,0 +1,545 @@
+/***************************************************************************
+    File                 : XYPowerSpectrumCurve.cpp
+    Project              : LabPlot
+    Description          : A xy-curve defined by the power spectrum (Welch's method) of the data
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+/*!
+  \class XYPowerSpectrumCurve
+  \brief A xy-curve defined by the power spectrum of the data
+
+  The signal is split into overlapping segments, every segment is windowed and transformed
+  and the periodograms of all segments are averaged (Welch's method). Only one segment per thread
+  is kept in memory, so that also very long recordings can be analyzed.
+  The periodograms of the single segments (short-time Fourier transform) can be put into
+  a matrix (spectrogram) with createSpectrogram().
+
+  \ingroup worksheet
+*/
+
+#include "XYPowerSpectrumCurve.h"
+#include "XYPowerSpectrumCurvePrivate.h"
+#include "XYAnalysisJob.h"
+#include "backend/core/AbstractColumn.h"
+#include "backend/core/column/Column.h"
+#include "backend/matrix/Matrix.h"
+#include "backend/lib/commandtemplates.h"
+#include "backend/lib/macros.h"
+
+#include <cmath>	// isnan
+extern "C" {
+#include <gsl/gsl_errno.h>
+}
+
+#include <KIcon>
+#include <KLocale>
+#include <QDataStream>
+#include <QThreadPool>
+
+XYPowerSpectrumCurve::XYPowerSpectrumCurve(const QString& name)
+		: XYCurve(name, new XYPowerSpectrumCurvePrivate(this)) {
+	init();
+}
+
+XYPowerSpectrumCurve::XYPowerSpectrumCurve(const QString& name, XYPowerSpectrumCurvePrivate* dd)
+		: XYCurve(name, dd) {
+	init();
+}
+
+
+XYPowerSpectrumCurve::~XYPowerSpectrumCurve() {
+	//no need to delete the d-pointer here - it inherits from QGraphicsItem
+	//and is deleted during the cleanup in QGraphicsScene
+}
+
+void XYPowerSpectrumCurve::init() {
+	Q_D(XYPowerSpectrumCurve);
+
+	//TODO: read from the saved settings for XYPowerSpectrumCurve?
+	d->lineType = XYCurve::Line;
+	d->symbolsStyle = Symbol::NoSymbols;
+}
+
+void XYPowerSpectrumCurve::recalculate() {
+	Q_D(XYPowerSpectrumCurve);
+	d->recalculate();
+}
+
+/*!
+	Calculates the short-time Fourier transform of the source data with the current settings
+	and returns it as a new matrix (columns: segments, rows: frequencies).
+	The caller takes ownership of the matrix. Returns 0 if there is no valid data.
+*/
+Matrix* XYPowerSpectrumCurve::createSpectrogram() {
+	Q_D(XYPowerSpectrumCurve);
+	return d->createSpectrogram();
+}
+
+/*!
+	Returns an icon to be used in the project explorer.
+*/
+QIcon XYPowerSpectrumCurve::icon() const {
+	return KIcon("labplot-xy-fourier_transform-curve");
+}
+
+//##############################################################################
+//##########################  getter methods  ##################################
+//##############################################################################
+BASIC_SHARED_D_READER_IMPL(XYPowerSpectrumCurve, const AbstractColumn*, xDataColumn, xDataColumn)
+BASIC_SHARED_D_READER_IMPL(XYPowerSpectrumCurve, const AbstractColumn*, yDataColumn, yDataColumn)
+const QString& XYPowerSpectrumCurve::xDataColumnPath() const { Q_D(const XYPowerSpectrumCurve); return d->xDataColumnPath; }
+const QString& XYPowerSpectrumCurve::yDataColumnPath() const { Q_D(const XYPowerSpectrumCurve); return d->yDataColumnPath; }
+
+BASIC_SHARED_D_READER_IMPL(XYPowerSpectrumCurve, XYPowerSpectrumCurve::PowerSpectrumData, powerSpectrumData, powerSpectrumData)
+
+const XYPowerSpectrumCurve::PowerSpectrumResult& XYPowerSpectrumCurve::powerSpectrumResult() const {
+	Q_D(const XYPowerSpectrumCurve);
+	return d->powerSpectrumResult;
+}
+
+bool XYPowerSpectrumCurve::isSourceDataChangedSinceLastPowerSpectrum() const {
+	Q_D(const XYPowerSpectrumCurve);
+	return d->sourceDataChangedSinceLastPowerSpectrum;
+}
+
+//##############################################################################
+//#################  setter methods and undo commands ##########################
+//##############################################################################
+STD_SETTER_CMD_IMPL_S(XYPowerSpectrumCurve, SetXDataColumn, const AbstractColumn*, xDataColumn)
+void XYPowerSpectrumCurve::setXDataColumn(const AbstractColumn* column) {
+	Q_D(XYPowerSpectrumCurve);
+	if (column != d->xDataColumn) {
+		exec(new XYPowerSpectrumCurveSetXDataColumnCmd(d, column, i18n("%1: assign x-data")));
+		emit sourceDataChangedSinceLastPowerSpectrum();
+		if (column) {
+			connect(column, SIGNAL(dataChanged(const AbstractColumn*)), this, SLOT(handleSourceDataChanged()));
+			//TODO disconnect on undo
+		}
+	}
+}
+
+STD_SETTER_CMD_IMPL_S(XYPowerSpectrumCurve, SetYDataColumn, const AbstractColumn*, yDataColumn)
+void XYPowerSpectrumCurve::setYDataColumn(const AbstractColumn* column) {
+	Q_D(XYPowerSpectrumCurve);
+	if (column != d->yDataColumn) {
+		exec(new XYPowerSpectrumCurveSetYDataColumnCmd(d, column, i18n("%1: assign y-data")));
+		emit sourceDataChangedSinceLastPowerSpectrum();
+		if (column) {
+			connect(column, SIGNAL(dataChanged(const AbstractColumn*)), this, SLOT(handleSourceDataChanged()));
+			//TODO disconnect on undo
+		}
+	}
+}
+
+STD_SETTER_CMD_IMPL_F_S(XYPowerSpectrumCurve, SetPowerSpectrumData, XYPowerSpectrumCurve::PowerSpectrumData, powerSpectrumData, recalculate);
+void XYPowerSpectrumCurve::setPowerSpectrumData(const XYPowerSpectrumCurve::PowerSpectrumData& powerSpectrumData) {
+	Q_D(XYPowerSpectrumCurve);
+	exec(new XYPowerSpectrumCurveSetPowerSpectrumDataCmd(d, powerSpectrumData, i18n("%1: set options and calculate the power spectrum")));
+}
+
+//##############################################################################
+//################################## SLOTS ####################################
+//##############################################################################
+void XYPowerSpectrumCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
+	Q_D(XYPowerSpectrumCurve);
+	d->sourceDataChangedSinceLastPowerSpectrum = true;
+	emit sourceDataChangedSinceLastPowerSpectrum();
+}
+//##############################################################################
+//######################### Private implementation #############################
+//##############################################################################
+XYPowerSpectrumCurvePrivate::XYPowerSpectrumCurvePrivate(XYPowerSpectrumCurve* owner) : XYCurvePrivate(owner),
+	xDataColumn(0), yDataColumn(0),
+	xColumn(0), yColumn(0),
+	xVector(0), yVector(0),
+	sourceDataChangedSinceLastPowerSpectrum(false),
+	q(owner) {
+
+}
+
+XYPowerSpectrumCurvePrivate::~XYPowerSpectrumCurvePrivate() {
+	//no need to delete xColumn and yColumn, they are deleted
+	//when the parent aspect is removed
+}
+
+/*!
+	copies the valid y-values inside of the x-range of \c data from the snapshots to \c ydata and determines
+	the start value \c xmin and the sample frequency \c fs of the (equidistant) data.
+	Returns \c false and sets \c status if there is no data to analyze.
+*/
+static bool powerSpectrumSourceData(const ColumnSnapshot& xData, const ColumnSnapshot& yData,
+		const XYPowerSpectrumCurve::PowerSpectrumData& data, QVector<double>& ydata, double& xmin, double& fs, KLocalizedString& status) {
+	if (xData.rowCount() != yData.rowCount()) {
+		status = ki18n("Number of x and y data points must be equal.");
+		return false;
+	}
+
+	const double rangeMin = data.xRange.first();
+	const double rangeMax = data.xRange.last();
+	double xfirst = 0, xlast = 0;
+	ydata.reserve(yData.rowCount());
+	for (int row=0; row<xData.rowCount(); ++row) {
+		//only use those data where _all_ values (for x and y) are valid
+		const double x = xData.valueAt(row);
+		const double y = yData.valueAt(row);
+		if (std::isnan(x) || std::isnan(y) || xData.isMasked(row) || yData.isMasked(row))
+			continue;
+		// only when inside given range
+		if (x < rangeMin || x > rangeMax)
+			continue;
+
+		if (ydata.isEmpty())
+			xfirst = x;
+		xlast = x;
+		ydata.append(y);
+	}
+
+	const int n = ydata.size();
+	if (n < 2) {
+		status = ki18n("Not enough data points available.");
+		return false;
+	}
+	if (xlast <= xfirst) {
+		status = ki18n("The x-data must be increasing.");
+		return false;
+	}
+
+	xmin = xfirst;
+	fs = (n-1)/(xlast-xfirst);
+	return true;
+}
+
+/*!
+	limits the segment length and the overlap of the settings \c data to the \c n available data points.
+*/
+static void powerSpectrumSegmentation(const XYPowerSpectrumCurve::PowerSpectrumData& data, size_t n, size_t& segment, size_t& overlap) {
+	segment = (size_t)qMax(data.segmentLength, 2);
+	if (segment > n)
+		segment = n;
+	overlap = (size_t)qBound(0, data.overlap, (int)segment-1);
+}
+
+/*!
+ * power spectrum of the snapshots of the source columns in a worker thread
+ */
+class XYPowerSpectrumCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYPowerSpectrumCurveJob(XYPowerSpectrumCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_powerSpectrumData(curve->powerSpectrumData) {}
+
+		void compute();
+		void publish();
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYPowerSpectrumCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const XYPowerSpectrumCurve::PowerSpectrumData m_powerSpectrumData;
+		XYPowerSpectrumCurve::PowerSpectrumResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+};
+
+quint64 XYPowerSpectrumCurveJob::inputKey() const {
+	const XYPowerSpectrumCurve::PowerSpectrumData& d = m_powerSpectrumData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << d.segmentLength << d.overlap << (int)d.windowType << (int)d.scaling << d.dB
+		<< d.autoRange << d.xRange;
+	return dataKey(settings, m_xData, m_yData);
+}
+
+void XYPowerSpectrumCurveJob::compute() {
+	QVector<double> ydataVector;
+	double xmin, fs;
+	KLocalizedString errorStatus;
+	if (!powerSpectrumSourceData(m_xData, m_yData, m_powerSpectrumData, ydataVector, xmin, fs, errorStatus)) {
+		m_result.available = true;
+		m_result.valid = false;
+		setError(errorStatus);
+		return;
+	}
+	if (isCanceled())
+		return;
+	setProgress(10);
+
+	const size_t n = ydataVector.size();
+	size_t segment, overlap;
+	powerSpectrumSegmentation(m_powerSpectrumData, n, segment, overlap);
+	const size_t m = segment/2+1;
+
+	DEBUG("n =" << n);
+	DEBUG("segment length =" << segment);
+	DEBUG("overlap =" << overlap);
+	DEBUG("window type:" << nsl_sf_window_type_name[m_powerSpectrumData.windowType]);
+	DEBUG("scaling:" << nsl_psd_scaling_name[m_powerSpectrumData.scaling]);
+
+///////////////////////////////////////////////////////////
+	m_x.resize(m);
+	m_y.resize(m);
+	int status = nsl_psd_welch(ydataVector.constData(), n, segment, overlap, m_powerSpectrumData.windowType, fs,
+			m_powerSpectrumData.scaling, m_y.data());
+
+	double* xdata = m_x.data();
+	double* ydata = m_y.data();
+	for (size_t i = 0; i < m; i++) {
+		xdata[i] = i*fs/segment;
+		if (m_powerSpectrumData.dB)
+			ydata[i] = 10.*log10(ydata[i]);
+	}
+///////////////////////////////////////////////////////////
+
+	m_result.available = true;
+	m_result.valid = (status == 0);
+	m_result.status = QString(gsl_strerror(status));
+	m_result.segmentCount = nsl_psd_segment_count(n, segment, overlap);
+	m_result.elapsedTime = elapsedTime();
+}
+
+void XYPowerSpectrumCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	m_curve->powerSpectrumResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * calculates the power spectrum of the data of the source columns. The calculation is done in a worker thread,
+ * the result columns are updated when it is finished.
+ */
+void XYPowerSpectrumCurvePrivate::recalculate() {
+	//create result columns if not available yet
+	if (!xColumn) {
+		xColumn = new Column("x", AbstractColumn::Numeric);
+		yColumn = new Column("y", AbstractColumn::Numeric);
+		xVector = static_cast<QVector<double>* >(xColumn->data());
+		yVector = static_cast<QVector<double>* >(yColumn->data());
+
+		xColumn->setHidden(true);
+		q->addChild(xColumn);
+		yColumn->setHidden(true);
+		q->addChild(yColumn);
+
+		q->setUndoAware(false);
+		q->setXColumn(xColumn);
+		q->setYColumn(yColumn);
+		q->setUndoAware(true);
+	}
+
+	if (!xDataColumn || !yDataColumn) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		powerSpectrumResult = XYPowerSpectrumCurve::PowerSpectrumResult();
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastPowerSpectrum = false;
+		return;
+	}
+
+	sourceDataChangedSinceLastPowerSpectrum = false;
+	startAnalysisJob(new XYPowerSpectrumCurveJob(this));
+}
+
+Matrix* XYPowerSpectrumCurvePrivate::createSpectrogram() {
+	if (!xDataColumn || !yDataColumn)
+		return 0;
+
+	QVector<double> ydataVector;
+	double xmin, fs;
+	KLocalizedString errorStatus;
+	if (!powerSpectrumSourceData(ColumnSnapshot(xDataColumn), ColumnSnapshot(yDataColumn), powerSpectrumData, ydataVector, xmin, fs, errorStatus))
+		return 0;
+
+	const size_t n = ydataVector.size();
+	size_t segment, overlap;
+	powerSpectrumSegmentation(powerSpectrumData, n, segment, overlap);
+	const size_t m = segment/2+1;
+	const size_t count = nsl_psd_segment_count(n, segment, overlap);
+
+	//one column per segment, one row per frequency. The transform writes directly into the columns of the matrix.
+	Matrix* matrix = new Matrix(0, i18n("%1 spectrogram", q->name()));
+	matrix->setDimensions((int)m, (int)count);
+	QVector<QVector<double> >& matrixData = matrix->data();
+	QVector<double*> columns(count);
+	for (size_t k = 0; k < count; k++)
+		columns[k] = matrixData[k].data();
+
+	int status = nsl_psd_stft(ydataVector.constData(), n, segment, overlap, powerSpectrumData.windowType, fs,
+			powerSpectrumData.scaling, columns.data());
+	if (status != 0) {
+		delete matrix;
+		return 0;
+	}
+
+	if (powerSpectrumData.dB) {
+		for (size_t k = 0; k < count; k++)
+			for (size_t i = 0; i < m; i++)
+				columns[k][i] = 10.*log10(columns[k][i]);
+	}
+
+	//x: time of the segment centers, y: frequencies
+	const size_t step = segment-overlap;
+	const double center = (segment-1)/2./fs;
+	matrix->setCoordinates(xmin + center, xmin + (count-1)*step/fs + center, 0., (m-1)*fs/segment);
+
+	return matrix;
+}
+
+//##############################################################################
+//##################  Serialization/Deserialization  ###########################
+//##############################################################################
+//! Save as XML
+void XYPowerSpectrumCurve::save(QXmlStreamWriter* writer) const{
+	Q_D(const XYPowerSpectrumCurve);
+
+	writer->writeStartElement("xyPowerSpectrumCurve");
+
+	//write xy-curve information
+	XYCurve::save(writer);
+
+	//write xy-power-spectrum-curve specific information
+	writer->writeStartElement("powerSpectrumData");
+	WRITE_COLUMN(d->xDataColumn, xDataColumn);
+	WRITE_COLUMN(d->yDataColumn, yDataColumn);
+	writer->writeAttribute( "autoRange", QString::number(d->powerSpectrumData.autoRange) );
+	writer->writeAttribute( "xRangeMin", QString::number(d->powerSpectrumData.xRange.first()) );
+	writer->writeAttribute( "xRangeMax", QString::number(d->powerSpectrumData.xRange.last()) );
+	writer->writeAttribute( "segmentLength", QString::number(d->powerSpectrumData.segmentLength) );
+	writer->writeAttribute( "overlap", QString::number(d->powerSpectrumData.overlap) );
+	writer->writeAttribute( "windowType", QString::number(d->powerSpectrumData.windowType) );
+	writer->writeAttribute( "scaling", QString::number(d->powerSpectrumData.scaling) );
+	writer->writeAttribute( "dB", QString::number(d->powerSpectrumData.dB) );
+	writer->writeEndElement();// powerSpectrumData
+
+	//power spectrum results (generated columns)
+	writer->writeStartElement("powerSpectrumResult");
+	writer->writeAttribute( "available", QString::number(d->powerSpectrumResult.available) );
+	writer->writeAttribute( "valid", QString::number(d->powerSpectrumResult.valid) );
+	writer->writeAttribute( "status", d->powerSpectrumResult.status );
+	writer->writeAttribute( "segmentCount", QString::number(d->powerSpectrumResult.segmentCount) );
+	writer->writeAttribute( "time", QString::number(d->powerSpectrumResult.elapsedTime) );
+
+	//save calculated columns if available
+	if (d->xColumn && d->yColumn) {
+		d->xColumn->save(writer);
+		d->yColumn->save(writer);
+	}
+	writer->writeEndElement(); //"powerSpectrumResult"
+	writer->writeEndElement(); //"xyPowerSpectrumCurve"
+}
+
+//! Load from XML
+bool XYPowerSpectrumCurve::load(XmlStreamReader* reader) {
+	Q_D(XYPowerSpectrumCurve);
+
+	if (!reader->isStartElement() || reader->name() != "xyPowerSpectrumCurve") {
+		reader->raiseError(i18n("no xy power spectrum curve element found"));
+		return false;
+	}
+
+	QString attributeWarning = i18n("Attribute '%1' missing or empty, default value is used");
+	QXmlStreamAttributes attribs;
+	QString str;
+
+	while (!reader->atEnd()) {
+		reader->readNext();
+		if (reader->isEndElement() && reader->name() == "xyPowerSpectrumCurve")
+			break;
+
+		if (!reader->isStartElement())
+			continue;
+
+		if (reader->name() == "xyCurve") {
+			if ( !XYCurve::load(reader) )
+				return false;
+		} else if (reader->name() == "powerSpectrumData") {
+			attribs = reader->attributes();
+
+			READ_COLUMN(xDataColumn);
+			READ_COLUMN(yDataColumn);
+
+			READ_INT_VALUE("autoRange", powerSpectrumData.autoRange, bool);
+			READ_DOUBLE_VALUE("xRangeMin", powerSpectrumData.xRange.first());
+			READ_DOUBLE_VALUE("xRangeMax", powerSpectrumData.xRange.last());
+			READ_INT_VALUE("segmentLength", powerSpectrumData.segmentLength, int);
+			READ_INT_VALUE("overlap", powerSpectrumData.overlap, int);
+			READ_INT_VALUE("windowType", powerSpectrumData.windowType, nsl_sf_window_type);
+			READ_INT_VALUE("scaling", powerSpectrumData.scaling, nsl_psd_scaling);
+			READ_INT_VALUE("dB", powerSpectrumData.dB, bool);
+		} else if (reader->name() == "powerSpectrumResult") {
+			attribs = reader->attributes();
+
+			READ_INT_VALUE("available", powerSpectrumResult.available, int);
+			READ_INT_VALUE("valid", powerSpectrumResult.valid, int);
+			READ_STRING_VALUE("status", powerSpectrumResult.status);
+			READ_INT_VALUE("segmentCount", powerSpectrumResult.segmentCount, int);
+			READ_INT_VALUE("time", powerSpectrumResult.elapsedTime, int);
+		} else if (reader->name() == "column") {
+			Column* column = new Column("", AbstractColumn::Numeric);
+			if (!column->load(reader)) {
+				delete column;
+				return false;
+			}
+
+			if (column->name() == "x")
+				d->xColumn = column;
+			else if (column->name() == "y")
+				d->yColumn = column;
+		}
+	}
+
+	// wait for data to be read before using the pointers
+	QThreadPool::globalInstance()->waitForDone();
+
+	if (d->xColumn && d->yColumn) {
+		d->xColumn->setHidden(true);
+		addChild(d->xColumn);
+
+		d->yColumn->setHidden(true);
+		addChild(d->yColumn);
+
+		d->xVector = static_cast<QVector<double>* >(d->xColumn->data());
+		d->yVector = static_cast<QVector<double>* >(d->yColumn->data());
+
+		setUndoAware(false);
+		XYCurve::d_ptr->xColumn = d->xColumn;
+		XYCurve::d_ptr->yColumn = d->yColumn;
+		setUndoAware(true);
+	} else {
+		qWarning()<<"	d->xColumn == NULL!";
+	}
+
+	return true;
+}
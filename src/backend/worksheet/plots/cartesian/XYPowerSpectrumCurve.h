@@ -0,0 +1,107 @@
+/***************************************************************************
+    File                 : XYPowerSpectrumCurve.h
+    Project              : LabPlot
+    Description          : A xy-curve defined by the power spectrum (Welch's method) of the data
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef XYPOWERSPECTRUMCURVE_H
+#define XYPOWERSPECTRUMCURVE_H
+
+#include "backend/worksheet/plots/cartesian/XYCurve.h"
+extern "C" {
+#include "backend/nsl/nsl_psd.h"
+#include "backend/nsl/nsl_sf_window.h"
+}
+
+class Matrix;
+class XYPowerSpectrumCurvePrivate;
+class XYPowerSpectrumCurve: public XYCurve {
+	Q_OBJECT
+
+	public:
+		struct PowerSpectrumData {
+			PowerSpectrumData() : segmentLength(1024), overlap(512), windowType(nsl_sf_window_hann),
+				scaling(nsl_psd_scaling_density), dB(false), autoRange(true), xRange(2) {};
+
+			int segmentLength;		// number of points per segment
+			int overlap;			// number of points shared by consecutive segments
+			nsl_sf_window_type windowType;
+			nsl_psd_scaling scaling;
+			bool dB;			// show 10*log10() of the power
+			bool autoRange;			// use all data?
+			QVector<double> xRange;		// x range for the spectrum
+		};
+		struct PowerSpectrumResult {
+			PowerSpectrumResult() : available(false), valid(false), segmentCount(0), elapsedTime(0) {};
+
+			bool available;
+			bool valid;
+			QString status;
+			int segmentCount;
+			qint64 elapsedTime;
+		};
+
+		explicit XYPowerSpectrumCurve(const QString& name);
+		virtual ~XYPowerSpectrumCurve();
+
+		void recalculate();
+		Matrix* createSpectrogram();
+		virtual QIcon icon() const;
+		virtual void save(QXmlStreamWriter*) const;
+		virtual bool load(XmlStreamReader*);
+
+		POINTER_D_ACCESSOR_DECL(const AbstractColumn, xDataColumn, XDataColumn)
+		POINTER_D_ACCESSOR_DECL(const AbstractColumn, yDataColumn, YDataColumn)
+		const QString& xDataColumnPath() const;
+		const QString& yDataColumnPath() const;
+
+		CLASS_D_ACCESSOR_DECL(PowerSpectrumData, powerSpectrumData, PowerSpectrumData)
+		const PowerSpectrumResult& powerSpectrumResult() const;
+		bool isSourceDataChangedSinceLastPowerSpectrum() const;
+
+		typedef WorksheetElement BaseClass;
+		typedef XYPowerSpectrumCurvePrivate Private;
+
+	protected:
+		XYPowerSpectrumCurve(const QString& name, XYPowerSpectrumCurvePrivate* dd);
+
+	private:
+		Q_DECLARE_PRIVATE(XYPowerSpectrumCurve)
+		void init();
+
+	private slots:
+		void handleSourceDataChanged();
+
+	signals:
+		friend class XYPowerSpectrumCurveSetXDataColumnCmd;
+		friend class XYPowerSpectrumCurveSetYDataColumnCmd;
+		void xDataColumnChanged(const AbstractColumn*);
+		void yDataColumnChanged(const AbstractColumn*);
+
+		friend class XYPowerSpectrumCurveSetPowerSpectrumDataCmd;
+		void powerSpectrumDataChanged(const XYPowerSpectrumCurve::PowerSpectrumData&);
+		void sourceDataChangedSinceLastPowerSpectrum();
+};
+
+#endif
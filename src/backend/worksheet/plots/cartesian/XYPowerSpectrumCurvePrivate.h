@@ -0,0 +1,62 @@
+/***************************************************************************
+    File                 : XYPowerSpectrumCurvePrivate.h
+    Project              : LabPlot
+    Description          : Private members of XYPowerSpectrumCurve
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef XYPOWERSPECTRUMCURVEPRIVATE_H
+#define XYPOWERSPECTRUMCURVEPRIVATE_H
+
+#include "backend/worksheet/plots/cartesian/XYCurvePrivate.h"
+#include "backend/worksheet/plots/cartesian/XYPowerSpectrumCurve.h"
+
+class XYPowerSpectrumCurve;
+class Column;
+
+class XYPowerSpectrumCurvePrivate: public XYCurvePrivate {
+	public:
+		explicit XYPowerSpectrumCurvePrivate(XYPowerSpectrumCurve*);
+		~XYPowerSpectrumCurvePrivate();
+		void recalculate();
+		Matrix* createSpectrogram();
+
+		const AbstractColumn* xDataColumn; //<! column storing the values for the x-data (time)
+		const AbstractColumn* yDataColumn; //<! column storing the values for the y-data (signal)
+		QString xDataColumnPath;
+		QString yDataColumnPath;
+
+		XYPowerSpectrumCurve::PowerSpectrumData powerSpectrumData;
+		XYPowerSpectrumCurve::PowerSpectrumResult powerSpectrumResult;
+
+		Column* xColumn; //<! column used internally for storing the x-values (frequencies) of the result curve
+		Column* yColumn; //<! column used internally for storing the y-values (power) of the result curve
+		QVector<double>* xVector;
+		QVector<double>* yVector;
+
+		bool sourceDataChangedSinceLastPowerSpectrum; //<! \c true if the data in the source columns (x, y) was changed, \c false otherwise
+
+		XYPowerSpectrumCurve* const q;
+};
+
+#endif
@@ -35,13 +35,15 @@
 
 #include "XYSmoothCurve.h"
 #include "XYSmoothCurvePrivate.h"
+#include "XYAnalysisJob.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
 #include "backend/lib/macros.h"
 
 #include <KIcon>
 #include <KLocale>
-#include <QElapsedTimer>
+#include <QDataStream>
+#include <QMutex>
 #include <QThreadPool>
 
 extern "C" {
@@ -145,6 +147,9 @@ void XYSmoothCurve::setSmoothData(const XYSmoothCurve::SmoothData& smoothData) {
 //################################## SLOTS ####################################
 //##############################################################################
 void XYSmoothCurve::handleSourceDataChanged() {
+	if (recalculateIfAnalysisResult(sender()))
+		return;
+
 	Q_D(XYSmoothCurve);
 	d->sourceDataChangedSinceLastSmooth = true;
 	emit sourceDataChangedSinceLastSmooth();
@@ -166,94 +171,71 @@ XYSmoothCurvePrivate::~XYSmoothCurvePrivate() {
 	//when the parent aspect is removed
 }
 
-// ...
-// see XYFitCurvePrivate
-
-void XYSmoothCurvePrivate::recalculate() {
-	QElapsedTimer timer;
-	timer.start();
-
-	//create smooth result columns if not available yet, clear them otherwise
-	if (!xColumn) {
-		xColumn = new Column("x", AbstractColumn::Numeric);
-		yColumn = new Column("y", AbstractColumn::Numeric);
-		xVector = static_cast<QVector<double>* >(xColumn->data());
-		yVector = static_cast<QVector<double>* >(yColumn->data());
-
-		xColumn->setHidden(true);
-		q->addChild(xColumn);
-		yColumn->setHidden(true);
-		q->addChild(yColumn);
-
-		q->setUndoAware(false);
-		q->setXColumn(xColumn);
-		q->setYColumn(yColumn);
-		q->setUndoAware(true);
-	} else {
-		xVector->clear();
-		yVector->clear();
-	}
-
-	// clear the previous result
-	smoothResult = XYSmoothCurve::SmoothResult();
-
-	if (!xDataColumn || !yDataColumn) {
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastSmooth = false;
-		return;
-	}
-
-	//check column sizes
-	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
-		smoothResult.available = true;
-		smoothResult.valid = false;
-		smoothResult.status = i18n("Number of x and y data points must be equal.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastSmooth = false;
-		return;
-	}
+/*!
+ * smoothing of the snapshots of the source columns in a worker thread
+ */
+class XYSmoothCurveJob : public XYAnalysisJob {
+	public:
+		explicit XYSmoothCurveJob(XYSmoothCurvePrivate* curve) : m_curve(curve),
+			m_xData(curve->xDataColumn), m_yData(curve->yDataColumn), m_smoothData(curve->smoothData) {}
+
+		void compute();
+		void publish();
+
+	protected:
+		quint64 inputKey() const;
+
+	private:
+		XYSmoothCurvePrivate* const m_curve;
+		const ColumnSnapshot m_xData;
+		const ColumnSnapshot m_yData;
+		const XYSmoothCurve::SmoothData m_smoothData;
+		XYSmoothCurve::SmoothResult m_result;
+		QVector<double> m_x;
+		QVector<double> m_y;
+};
+
+//the constant padding values are global in nsl_smooth
+static QMutex smoothPadConstantMutex;
+
+quint64 XYSmoothCurveJob::inputKey() const {
+	const XYSmoothCurve::SmoothData& d = m_smoothData;
+	QByteArray settings;
+	QDataStream out(&settings, QIODevice::WriteOnly);
+	out << (int)d.type << d.points << (int)d.weight << d.percentile << d.order
+		<< (int)d.mode << d.lvalue << d.rvalue << d.autoRange << d.xRange;
+	return dataKey(settings, m_xData, m_yData);
+}
 
+void XYSmoothCurveJob::compute() {
 	//copy all valid data point for the smooth to temporary vectors
-	QVector<double> xdataVector;
-	QVector<double> ydataVector;
-	const double xmin = smoothData.xRange.first();
-	const double xmax = smoothData.xRange.last();
-	for (int row=0; row<xDataColumn->rowCount(); ++row) {
-		//only copy those data where _all_ values (for x and y, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-			&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
-
-			// only when inside given range
-			if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-				xdataVector.append(xDataColumn->valueAt(row));
-				ydataVector.append(yDataColumn->valueAt(row));
-			}
-		}
-	}
+	copyValidData(m_xData, m_yData, m_smoothData.xRange.first(), m_smoothData.xRange.last(), m_x, m_y);
 
 	//number of data points to smooth
-	const unsigned int n = xdataVector.size();
+	const unsigned int n = m_x.size();
 	if (n < 2) {
-		smoothResult.available = true;
-		smoothResult.valid = false;
-		smoothResult.status = i18n("Not enough data points available.");
-		emit (q->dataChanged());
-		sourceDataChangedSinceLastSmooth = false;
+		m_result.available = true;
+		m_result.valid = false;
+		setError(ki18n("Not enough data points available."));
+		m_x.clear();
+		m_y.clear();
 		return;
 	}
+	if (isCanceled())
+		return;
+	setProgress(10);
 
-	double* xdata = xdataVector.data();
-	double* ydata = ydataVector.data();
+	double* ydata = m_y.data();
 
 	// smooth settings
-	const nsl_smooth_type type = smoothData.type;
-	const unsigned int points = smoothData.points;
-	const nsl_smooth_weight_type weight = smoothData.weight;
-	const double percentile = smoothData.percentile;
-	const unsigned int order = smoothData.order;
-	const nsl_smooth_pad_mode mode = smoothData.mode;
-	const double lvalue = smoothData.lvalue;
-	const double rvalue = smoothData.rvalue;
+	const nsl_smooth_type type = m_smoothData.type;
+	const unsigned int points = m_smoothData.points;
+	const nsl_smooth_weight_type weight = m_smoothData.weight;
+	const double percentile = m_smoothData.percentile;
+	const unsigned int order = m_smoothData.order;
+	const nsl_smooth_pad_mode mode = m_smoothData.mode;
+	const double lvalue = m_smoothData.lvalue;
+	const double rvalue = m_smoothData.rvalue;
 
 	DEBUG("type:"<<nsl_smooth_type_name[type]);
 	DEBUG("points ="<<points);
@@ -266,6 +248,10 @@ void XYSmoothCurvePrivate::recalculate() {
 ///////////////////////////////////////////////////////////
 	int status=0;
 
+	QMutexLocker locker(mode == nsl_smooth_pad_constant ? &smoothPadConstantMutex : 0);
+	if (mode == nsl_smooth_pad_constant)
+		nsl_smooth_pad_constant_set(lvalue, rvalue);
+
 	switch (type) {
 	case nsl_smooth_type_moving_average:
 		status = nsl_smooth_moving_average(ydata, n, points, weight, mode);
@@ -277,27 +263,79 @@ void XYSmoothCurvePrivate::recalculate() {
 		status = nsl_smooth_percentile(ydata, n, points, percentile, mode);
 		break;
 	case nsl_smooth_type_savitzky_golay:
-		if (mode == nsl_smooth_pad_constant)
-			nsl_smooth_pad_constant_set(lvalue, rvalue);
 		status = nsl_smooth_savgol(ydata, n, points, order, mode);
 		break;
 	}
-
-	xVector->resize(n);
-	yVector->resize(n);
-	memcpy(xVector->data(), xdata, n*sizeof(double));
-	memcpy(yVector->data(), ydata, n*sizeof(double));
 ///////////////////////////////////////////////////////////
 
-	//write the result
-	smoothResult.available = true;
-	smoothResult.valid = true;
-	smoothResult.status = QString::number(status);
-	smoothResult.elapsedTime = timer.elapsed();
+	m_result.available = true;
+	m_result.valid = true;
+	m_result.status = QString::number(status);
+	m_result.elapsedTime = elapsedTime();
+}
+
+void XYSmoothCurveJob::publish() {
+	if (hasError())
+		m_result.status = errorMessage();
+
+	*m_curve->xVector = m_x;
+	*m_curve->yVector = m_y;
+	m_curve->smoothResult = m_result;
+	m_curve->xColumn->setChanged();
+	m_curve->yColumn->setChanged();
+}
+
+/*!
+ * smooths the data of the source columns. The smoothing is done in a worker thread,
+ * the result columns are updated when it is finished.
+ */
+void XYSmoothCurvePrivate::recalculate() {
+	//create smooth result columns if not available yet
+	if (!xColumn) {
+		xColumn = new Column("x", AbstractColumn::Numeric);
+		yColumn = new Column("y", AbstractColumn::Numeric);
+		xVector = static_cast<QVector<double>* >(xColumn->data());
+		yVector = static_cast<QVector<double>* >(yColumn->data());
+
+		xColumn->setHidden(true);
+		q->addChild(xColumn);
+		yColumn->setHidden(true);
+		q->addChild(yColumn);
+
+		q->setUndoAware(false);
+		q->setXColumn(xColumn);
+		q->setYColumn(yColumn);
+		q->setUndoAware(true);
+	}
+
+	if (!xDataColumn || !yDataColumn) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		smoothResult = XYSmoothCurve::SmoothResult();
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastSmooth = false;
+		return;
+	}
+
+	//check column sizes
+	if (xDataColumn->rowCount()!=yDataColumn->rowCount()) {
+		q->cancelRecalculation();
+		analysisKey = 0;
+		xVector->clear();
+		yVector->clear();
+		smoothResult = XYSmoothCurve::SmoothResult();
+		smoothResult.available = true;
+		smoothResult.valid = false;
+		smoothResult.status = i18n("Number of x and y data points must be equal.");
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastSmooth = false;
+		return;
+	}
 
-	//redraw the curve
-	emit (q->dataChanged());
 	sourceDataChangedSinceLastSmooth = false;
+	startAnalysisJob(new XYSmoothCurveJob(this));
 }
 
 //##############################################################################
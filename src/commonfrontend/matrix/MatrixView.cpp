@@ -34,6 +34,8 @@
 #include "backend/matrix/matrixcommands.h"
 #include "backend/lib/macros.h"
 #include "backend/core/column/Column.h"
+#include "backend/datasources/filters/AsciiFilter.h"
+#include "backend/datasources/filters/ColumnarBinaryFilter.h"
 
 #include "kdefrontend/matrix/MatrixFunctionDialog.h"
 #include "kdefrontend/spreadsheet/StatisticsDialog.h"
@@ -54,9 +56,11 @@
 #include <QThreadPool>
 #include <QMutex>
 #include <QProcess>
+#include <QProgressDialog>
 // #include <QElapsedTimer>
 
 #include <KLocale>
+#include <KMessageBox>
 #include <KAction>
 #include <KIcon>
 
@@ -1059,29 +1063,32 @@ void MatrixView::print(QPrinter* printer) const {
 	RESET_CURSOR;
 }
 
-void MatrixView::exportToFile(const QString& path, const QString& separator) const {
-	QFile file(path);
-	if (!file.open(QFile::WriteOnly | QFile::Truncate))
-		return;
+void MatrixView::exportToFile(const QString& path, const QString& separator, const bool fullPrecision) const {
+	AsciiFilter filter;
+	filter.setHeaderEnabled(false);
+	filter.setSeparatingCharacter(separator);
+	filter.setFullPrecisionEnabled(fullPrecision);
 
-	QTextStream out(&file);
+	QProgressDialog progress(i18n("Exporting %1...", m_matrix->name()), QString(), 0, 100, const_cast<MatrixView*>(this));
+	progress.setWindowModality(Qt::WindowModal);
+	connect(&filter, SIGNAL(completed(int)), &progress, SLOT(setValue(int)));
 
-	QString sep = separator;
-	sep = sep.replace(QLatin1String("TAB"), QLatin1String("\t"), Qt::CaseInsensitive);
-	sep = sep.replace(QLatin1String("SPACE"), QLatin1String(" "), Qt::CaseInsensitive);
+	filter.write(path, m_matrix);
+	if (!filter.errorString().isEmpty())
+		KMessageBox::error(const_cast<MatrixView*>(this), i18n("Failed to export to %1: %2", path, filter.errorString()));
+}
 
-	//export values
-	const int cols = m_matrix->columnCount();
-	const int rows = m_matrix->rowCount();
-	const QVector<QVector<double> >& matrixData = m_matrix->data();
-	for (int row=0; row<rows; ++row) {
-		for (int col=0; col<cols; ++col) {
-			out << matrixData[col][row];
-			if (col!=cols-1)
-				out<<sep;
-		}
-		out << '\n';
-	}
+void MatrixView::exportToColumnarBinary(const QString& path, const bool compression) const {
+	ColumnarBinaryFilter filter;
+	filter.setCompressionEnabled(compression);
+
+	QProgressDialog progress(i18n("Exporting %1...", m_matrix->name()), QString(), 0, 100, const_cast<MatrixView*>(this));
+	progress.setWindowModality(Qt::WindowModal);
+	connect(&filter, SIGNAL(completed(int)), &progress, SLOT(setValue(int)));
+
+	filter.write(path, m_matrix);
+	if (!filter.errorString().isEmpty())
+		KMessageBox::error(const_cast<MatrixView*>(this), i18n("Failed to export to %1: %2", path, filter.errorString()));
 }
 
 void MatrixView::exportToLaTeX(const QString& path, const bool verticalHeaders, const bool horizontalHeaders,
@@ -68,7 +68,8 @@ class MatrixView : public QWidget {
 
 		void resizeHeaders();
 		void adjustHeaders();
-		void exportToFile(const QString& path, const QString& separator) const;
+		void exportToFile(const QString& path, const QString& separator, const bool fullPrecision) const;
+		void exportToColumnarBinary(const QString& path, const bool compression) const;
         void exportToLaTeX(const QString&, const bool verticalHeaders, const bool horizontalHeaders,
                            const bool latexHeaders, const bool gridLines,
                            const bool entire, const bool captions) const;
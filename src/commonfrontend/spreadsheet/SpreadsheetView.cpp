@@ -34,11 +34,14 @@
 #include "backend/lib/macros.h"
 
 #include "backend/core/column/Column.h"
+#include "backend/core/column/ColumnView.h"
 #include "backend/core/datatypes/SimpleCopyThroughFilter.h"
 #include "backend/core/datatypes/Double2StringFilter.h"
 #include "backend/core/datatypes/String2DoubleFilter.h"
 #include "backend/core/datatypes/DateTime2StringFilter.h"
 #include "backend/core/datatypes/String2DateTimeFilter.h"
+#include "backend/datasources/filters/AsciiFilter.h"
+#include "backend/datasources/filters/ColumnarBinaryFilter.h"
 
 #include <QTableView>
 #include <QHBoxLayout>
@@ -53,9 +56,13 @@
 #include <QToolBar>
 #include <QTextStream>
 #include <QProcess>
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
 
 #include <KAction>
 #include <KLocale>
+#include <KMessageBox>
 
 #include "kdefrontend/spreadsheet/DropValuesDialog.h"
 #include "kdefrontend/spreadsheet/SortDialog.h"
@@ -66,6 +73,133 @@
 #include "kdefrontend/widgets/FITSHeaderEditDialog.h"
 
 #include <algorithm> //for std::reverse
+#include <cmath>
+
+extern "C" {
+#include "backend/nsl/nsl_rng.h"
+}
+
+static double uniformSample(const gsl_rng* r, const void* param) {
+	Q_UNUSED(param);
+	return gsl_rng_uniform(r);
+}
+
+static bool intervalLessThan(const Interval<int>& a, const Interval<int>& b) {
+	return a.start() < b.start();
+}
+
+//the cells of the selection are formatted and parsed in parallel in blocks of about this many cells
+static const int CellBlockSize = 16384;
+//a progress dialog is shown when copying or pasting more cells
+static const int ProgressCellCount = 1000000;
+
+/*!
+ * calls \c function for all \c blocks in the global thread pool. For more than ProgressCellCount \c cells
+ * a progress dialog with \c label is shown while the GUI stays responsive.
+ * Returns \c false if the operation was canceled in the progress dialog.
+ */
+template<class Block>
+static bool mapBlocks(QVector<Block>& blocks, void (*function)(Block&), int cells, const QString& label, QWidget* parent) {
+	if (cells < ProgressCellCount) {
+		QtConcurrent::blockingMap(blocks, function);
+		return true;
+	}
+
+	QProgressDialog progress(label, i18n("Cancel"), 0, 0, parent);
+	progress.setWindowModality(Qt::WindowModal);
+	QFutureWatcher<void> watcher;
+	QObject::connect(&watcher, SIGNAL(progressRangeChanged(int,int)), &progress, SLOT(setRange(int,int)));
+	QObject::connect(&watcher, SIGNAL(progressValueChanged(int)), &progress, SLOT(setValue(int)));
+	QObject::connect(&watcher, SIGNAL(finished()), &progress, SLOT(reset()));
+	QObject::connect(&progress, SIGNAL(canceled()), &watcher, SLOT(cancel()));
+	watcher.setFuture(QtConcurrent::map(blocks, function));
+	progress.exec();
+	watcher.waitForFinished();
+	return !watcher.isCanceled();
+}
+
+//source of the texts of one selected column in copySelection()
+struct CopyColumn {
+	bool numeric;
+	ColumnView values;	//numeric columns
+	QStringList texts;	//texts of the other columns and of the formulas, starting at textOffset
+	int textOffset;
+	char format;
+	MaskBitmap selected;
+};
+
+//rows of the selection formatted into one text in copySelection()
+struct CopyBlock {
+	const QVector<CopyColumn>* columns;
+	int firstRow;
+	int rowCount;
+	bool lastBlock;
+	QString text;
+};
+
+static void formatBlock(CopyBlock& block) {
+	const QLocale locale;
+	const int cols = block.columns->size();
+	block.text.reserve(block.rowCount * cols * 8);
+	for (int r = 0; r < block.rowCount; ++r) {
+		const int row = block.firstRow + r;
+		for (int c = 0; c < cols; ++c) {
+			const CopyColumn& column = block.columns->at(c);
+			if (column.selected.isSet(row)) {
+				if (!column.numeric)
+					block.text += column.texts.value(row - column.textOffset);
+				else if (row < column.values.rowCount())
+					block.text += locale.toString(column.values.valueAt(row), column.format, 16); // copy with max. precision
+			}
+			if (c < cols-1)
+				block.text += '\t';
+		}
+		if (r < block.rowCount-1 || !block.lastBlock)
+			block.text += '\n';
+	}
+}
+
+//rows of the clipboard text split into cells in pasteIntoSelection()
+struct SplitBlock {
+	const QStringList* rows;
+	QStringList* cells;
+	int first;
+	int count;
+};
+
+static void splitBlock(SplitBlock& block) {
+	const QRegExp separator("\\s+");
+	for (int i = block.first; i < block.first + block.count; ++i)
+		block.cells[i] = block.rows->at(i).trimmed().split(separator);
+}
+
+//selected rows of a column with a cell in the clipboard in pasteIntoSelection()
+struct PasteRun {
+	Column* column;
+	int col;	//column in the clipboard
+	int first;
+	int count;
+	QVector<double> values;	//converted texts for numeric columns
+};
+
+//texts of the clipboard converted to the values of a numeric column in pasteIntoSelection()
+struct ParseBlock {
+	const QVector<QStringList>* cells;
+	int cellRow;	//first row in cells
+	int col;	//column in cells
+	QLocale locale;	//numeric locale of the input filter of the column
+	double* values;
+	int count;
+};
+
+static void parseBlock(ParseBlock& block) {
+	//same conversion as in String2DoubleFilter
+	bool valid;
+	for (int i = 0; i < block.count; ++i) {
+		const double value = block.locale.toDouble(block.cells->at(block.cellRow + i).at(block.col), &valid);
+		block.values[i] = valid ? value : NAN;
+	}
+}
 
 /*!
 	\class SpreadsheetView
@@ -653,6 +787,14 @@ int SpreadsheetView::lastSelectedColumn(bool full) {
   */
 int SpreadsheetView::firstSelectedRow(bool full) {
 	int rows = m_spreadsheet->rowCount();
+	if (!full) {
+		//the first row of the selection ranges, the rows are not checked one by one
+		int first = rows;
+		foreach (const QItemSelectionRange& range, m_tableView->selectionModel()->selection())
+			first = qMin(first, qMax(range.top(), 0));
+		return first < rows ? first : -1;
+	}
+
 	for (int i=0; i<rows; i++) {
 		if (isRowSelected(i, full))
 			return i;
@@ -666,6 +808,13 @@ int SpreadsheetView::firstSelectedRow(bool full) {
   */
 int SpreadsheetView::lastSelectedRow(bool full) {
 	int rows = m_spreadsheet->rowCount();
+	if (!full) {
+		int last = -2;
+		foreach (const QItemSelectionRange& range, m_tableView->selectionModel()->selection())
+			last = qMax(last, qMin(range.bottom(), rows-1));
+		return last >= 0 ? last : -2;
+	}
+
 	for (int i=rows-1; i>=0; i--)
 		if (isRowSelected(i, full)) return i;
 
@@ -681,6 +830,34 @@ bool SpreadsheetView::isCellSelected(int row, int col) {
 	return m_tableView->selectionModel()->isSelected(m_model->index(row, col));
 }
 
+/*!
+  Returns the sorted intervals of the selected rows in the column \c col.
+  The intervals are taken from the ranges of the selection, the rows are not checked one by one.
+ */
+QList< Interval<int> > SpreadsheetView::selectedRowIntervals(int col) {
+	QList< Interval<int> > ranges;
+	const int rows = m_spreadsheet->rowCount();
+	foreach (const QItemSelectionRange& range, m_tableView->selectionModel()->selection()) {
+		if (col < range.left() || col > range.right())
+			continue;
+		const int top = qMax(range.top(), 0);
+		const int bottom = qMin(range.bottom(), rows-1);
+		if (top <= bottom)
+			ranges << Interval<int>(top, bottom);
+	}
+	std::sort(ranges.begin(), ranges.end(), intervalLessThan);
+
+	//merge overlapping and adjacent ranges
+	QList< Interval<int> > intervals;
+	foreach (const Interval<int>& range, ranges) {
+		if (!intervals.isEmpty() && range.start() <= intervals.last().end() + 1)
+			intervals.last().setEnd(qMax(intervals.last().end(), range.end()));
+		else
+			intervals << range;
+	}
+	return intervals;
+}
+
 /*!
   Get the complete set of selected rows.
  */
@@ -839,28 +1016,55 @@ void SpreadsheetView::copySelection() {
 	int rows = last_row - first_row +1;
 
 	WAIT_CURSOR;
-	QString output_str;
-
-	for (int r=0; r<rows; r++) {
-		for (int c=0; c<cols; c++) {
-			Column *col_ptr = m_spreadsheet->column(first_col + c);
-			if (isCellSelected(first_row + r, first_col + c)) {
-				if (formulaModeActive())
-					output_str += col_ptr->formula(first_row + r);
-				else if (col_ptr->columnMode() == AbstractColumn::Numeric) {
-					Double2StringFilter * out_fltr = static_cast<Double2StringFilter *>(col_ptr->outputFilter());
-					output_str += QLocale().toString(col_ptr->valueAt(first_row + r),
-					                                 out_fltr->numericFormat(), 16); // copy with max. precision
-				} else
-					output_str += m_spreadsheet->column(first_col+c)->asStringColumn()->textAt(first_row + r);
-			}
-			if (c < cols-1)
-				output_str += '\t';
+
+	//numeric values are formatted in the worker threads, the texts of the other columns are taken here
+	QVector<CopyColumn> columns(cols);
+	for (int c=0; c<cols; c++) {
+		Column* col_ptr = m_spreadsheet->column(first_col + c);
+		CopyColumn& column = columns[c];
+		column.selected = MaskBitmap(selectedRowIntervals(first_col + c));
+		column.numeric = false;
+		column.textOffset = 0;
+		column.format = 'e';
+		if (formulaModeActive()) {
+			column.textOffset = first_row;
+			for (int row = first_row; row <= last_row; row++)
+				column.texts << col_ptr->formula(row);
+		} else if (col_ptr->columnMode() == AbstractColumn::Numeric) {
+			column.numeric = true;
+			column.values = ColumnView(col_ptr);
+			column.format = static_cast<Double2StringFilter*>(col_ptr->outputFilter())->numericFormat();
+		} else if (col_ptr->columnMode() == AbstractColumn::Text) {
+			column.texts = *static_cast<QStringList*>(col_ptr->data());
+		} else {
+			column.textOffset = first_row;
+			const AbstractColumn* strings = col_ptr->asStringColumn();
+			for (int row = first_row; row <= last_row; row++)
+				column.texts << (column.selected.isSet(row) ? strings->textAt(row) : QString());
 		}
-		if (r < rows-1)
-			output_str += '\n';
 	}
-	QApplication::clipboard()->setText(output_str);
+
+	const int blockRows = qMax(CellBlockSize / cols, 1);
+	QVector<CopyBlock> blocks;
+	for (int row = first_row; row <= last_row; row += blockRows) {
+		CopyBlock block;
+		block.columns = &columns;
+		block.firstRow = row;
+		block.rowCount = qMin(blockRows, last_row - row + 1);
+		block.lastBlock = (row + block.rowCount > last_row);
+		blocks << block;
+	}
+
+	if (mapBlocks(blocks, formatBlock, rows*cols, i18n("Copying %1 cells...", rows*cols), this)) {
+		int length = 0;
+		foreach (const CopyBlock& block, blocks)
+			length += block.text.size();
+		QString output_str;
+		output_str.reserve(length);
+		foreach (const CopyBlock& block, blocks)
+			output_str += block.text;
+		QApplication::clipboard()->setText(output_str);
+	}
 	RESET_CURSOR;
 }
 
@@ -868,106 +1072,187 @@ void SpreadsheetView::pasteIntoSelection() {
 	if (m_spreadsheet->columnCount() < 1 || m_spreadsheet->rowCount() < 1)
 		return;
 
-	WAIT_CURSOR;
-	m_spreadsheet->beginMacro(i18n("%1: paste from clipboard", m_spreadsheet->name()));
 	const QMimeData * mime_data = QApplication::clipboard()->mimeData();
+	if (!mime_data->hasFormat("text/plain"))
+		return;
 
-	if (mime_data->hasFormat("text/plain")) {
-		int first_col = firstSelectedColumn(false);
-		int last_col = lastSelectedColumn(false);
-		int first_row = firstSelectedRow(false);
-		int last_row = lastSelectedRow(false);
-		int input_row_count = 0;
-		int input_col_count = 0;
-		int rows, cols;
-
-		QString input_str = QString(mime_data->data("text/plain")).trimmed();
-		QList< QStringList > cellTexts;
-		QStringList input_rows(input_str.split('\n'));
-		input_row_count = input_rows.count();
-		input_col_count = 0;
-		for (int i=0; i<input_row_count; i++) {
-			cellTexts.append(input_rows.at(i).trimmed().split(QRegExp("\\s+")));
-			if (cellTexts.at(i).count() > input_col_count) input_col_count = cellTexts.at(i).count();
-		}
+	WAIT_CURSOR;
+	int first_col = firstSelectedColumn(false);
+	int last_col = lastSelectedColumn(false);
+	int first_row = firstSelectedRow(false);
+	int last_row = lastSelectedRow(false);
+	int input_row_count = 0;
+	int input_col_count = 0;
+	int rows, cols;
+
+	QString input_str = QString(mime_data->data("text/plain")).trimmed();
+	QStringList input_rows(input_str.split('\n'));
+	input_row_count = input_rows.count();
+	const int input_cell_count = input_str.count('\t') + input_row_count;	//estimated, only used for the progress
+	input_str.clear();
+
+	//split the rows into cells in parallel
+	QVector<QStringList> cellTexts(input_row_count);
+	QVector<SplitBlock> splitBlocks;
+	for (int i=0; i<input_row_count; i+=CellBlockSize) {
+		SplitBlock block;
+		block.rows = &input_rows;
+		block.cells = cellTexts.data();
+		block.first = i;
+		block.count = qMin(CellBlockSize, input_row_count - i);
+		splitBlocks << block;
+	}
+	if (!mapBlocks(splitBlocks, splitBlock, input_cell_count, i18n("Reading the clipboard..."), this)) {
+		RESET_CURSOR;
+		return;
+	}
+	input_rows.clear();
 
-		if ( (first_col == -1 || first_row == -1) ||
-		        (last_row == first_row && last_col == first_col) )
-			// if the is no selection or only one cell selected, the
-			// selection will be expanded to the needed size from the current cell
-		{
-			int current_row, current_col;
-			getCurrentCell(&current_row, &current_col);
-			if (current_row == -1) current_row = 0;
-			if (current_col == -1) current_col = 0;
-			setCellSelected(current_row, current_col);
-			first_col = current_col;
-			first_row = current_row;
-			last_row = first_row + input_row_count -1;
-			last_col = first_col + input_col_count -1;
-			// resize the spreadsheet if necessary
-			if (last_col >= m_spreadsheet->columnCount()) {
-				for (int i=0; i<last_col+1-m_spreadsheet->columnCount(); i++) {
-					Column * new_col = new Column(QString::number(i+1), AbstractColumn::Text);
-					new_col->setPlotDesignation(AbstractColumn::Y);
-					new_col->insertRows(0, m_spreadsheet->rowCount());
-					m_spreadsheet->addChild(new_col);
+	input_col_count = 0;
+	for (int i=0; i<input_row_count; i++) {
+		if (cellTexts.at(i).count() > input_col_count) input_col_count = cellTexts.at(i).count();
+	}
+
+	// if the is no selection or only one cell selected, the
+	// selection will be expanded to the needed size from the current cell
+	const bool expand = (first_col == -1 || first_row == -1) || (last_row == first_row && last_col == first_col);
+	if (expand) {
+		int current_row, current_col;
+		getCurrentCell(&current_row, &current_col);
+		if (current_row == -1) current_row = 0;
+		if (current_col == -1) current_col = 0;
+		first_col = current_col;
+		first_row = current_row;
+		last_row = first_row + input_row_count -1;
+		last_col = first_col + input_col_count -1;
+	}
+
+	rows = qMin(last_row - first_row + 1, input_row_count);
+	cols = qMin(last_col - first_col + 1, input_col_count);
+
+	//runs of selected rows with a cell in the clipboard, one command is used for each run.
+	//the clipboard is parsed before the spreadsheet is resized, the column of a run is 0
+	//if it is added to the spreadsheet for the pasted cells.
+	QList<PasteRun> runs;
+	for (int c=0; c<cols; c++) {
+		QList< Interval<int> > intervals;
+		if (expand)
+			intervals << Interval<int>(first_row, last_row);
+		else
+			intervals = selectedRowIntervals(first_col + c);
+
+		foreach (const Interval<int>& interval, intervals) {
+			int row = qMax(interval.start(), first_row);
+			const int end = qMin(interval.end(), first_row + rows - 1);
+			while (row <= end) {
+				if (c >= cellTexts.at(row - first_row).count()) {
+					row++;
+					continue;
 				}
+				PasteRun run;
+				run.column = (first_col + c < m_spreadsheet->columnCount()) ? m_spreadsheet->column(first_col + c) : 0;
+				run.col = c;
+				run.first = row;
+				while (row <= end && c < cellTexts.at(row - first_row).count())
+					row++;
+				run.count = row - run.first;
+				runs << run;
 			}
-			if (last_row >= m_spreadsheet->rowCount())
-				m_spreadsheet->appendRows(last_row+1-m_spreadsheet->rowCount());
-			// select the rectangle to be pasted in
-			setCellsSelected(first_row, first_col, last_row, last_col);
 		}
+	}
 
-		rows = last_row - first_row + 1;
-		cols = last_col - first_col + 1;
-		for (int r=0; r<rows && r<input_row_count; r++) {
-			for (int c=0; c<cols && c<input_col_count; c++) {
-				//TODO c->setSuppressDataChangedSignal(true);
-				if (isCellSelected(first_row + r, first_col + c) && (c < cellTexts.at(r).count()) ) {
-					Column * col_ptr = m_spreadsheet->column(first_col + c);
-					if (formulaModeActive())
-						col_ptr->setFormula(first_row + r, cellTexts.at(r).at(c));
-					else
-						col_ptr->asStringColumn()->setTextAt(first_row+r, cellTexts.at(r).at(c));
-				}
+	//convert the texts for numeric columns in parallel with the numeric locale of the column
+	QVector<ParseBlock> parseBlocks;
+	for (int i=0; i<runs.size(); i++) {
+		PasteRun& run = runs[i];
+		if (formulaModeActive() || !run.column || run.column->columnMode() != AbstractColumn::Numeric)
+			continue;
+
+		const String2DoubleFilter* filter = qobject_cast<String2DoubleFilter*>(run.column->inputFilter());
+		const QLocale locale = filter ? filter->numericLocale() : QLocale();
+
+		run.values.resize(run.count);
+		for (int r=0; r<run.count; r+=CellBlockSize) {
+			ParseBlock block;
+			block.cells = &cellTexts;
+			block.cellRow = run.first - first_row + r;
+			block.col = run.col;
+			block.locale = locale;
+			block.values = run.values.data() + r;
+			block.count = qMin(CellBlockSize, run.count - r);
+			parseBlocks << block;
+		}
+	}
+
+	if (!mapBlocks(parseBlocks, parseBlock, rows*cols, i18n("Pasting %1 cells...", rows*cols), this)) {
+		RESET_CURSOR;
+		return;
+	}
+
+	m_spreadsheet->beginMacro(i18n("%1: paste from clipboard", m_spreadsheet->name()));
+	if (expand) {
+		// resize the spreadsheet if necessary
+		if (last_col >= m_spreadsheet->columnCount()) {
+			for (int i=0; i<last_col+1-m_spreadsheet->columnCount(); i++) {
+				Column * new_col = new Column(QString::number(i+1), AbstractColumn::Text);
+				new_col->setPlotDesignation(AbstractColumn::Y);
+				new_col->insertRows(0, m_spreadsheet->rowCount());
+				m_spreadsheet->addChild(new_col);
 			}
 		}
+		if (last_row >= m_spreadsheet->rowCount())
+			m_spreadsheet->appendRows(last_row+1-m_spreadsheet->rowCount());
+		// select the rectangle to be pasted in
+		setCellsSelected(first_row, first_col, last_row, last_col);
+	}
+
+	for (int i=0; i<runs.size(); i++) {
+		PasteRun& run = runs[i];
+		if (!run.column)
+			run.column = m_spreadsheet->column(first_col + run.col);
+
+		if (formulaModeActive()) {
+			for (int r=0; r<run.count; r++)
+				run.column->setFormula(run.first + r, cellTexts.at(run.first - first_row + r).at(run.col));
+		} else if (run.column->columnMode() == AbstractColumn::Numeric) {
+			run.column->replaceValues(run.first, run.values);
+		} else {
+			QStringList texts;
+			texts.reserve(run.count);
+			for (int r=0; r<run.count; r++)
+				texts << cellTexts.at(run.first - first_row + r).at(run.col);
+			run.column->asStringColumn()->replaceTexts(run.first, texts);
+		}
 	}
 	m_spreadsheet->endMacro();
 	RESET_CURSOR;
 }
 
 void SpreadsheetView::maskSelection() {
-	int first = firstSelectedRow();
-	int last = lastSelectedRow();
-	if ( first < 0 ) return;
+	if (firstSelectedRow() < 0) return;
 
 	WAIT_CURSOR;
 	m_spreadsheet->beginMacro(i18n("%1: mask selected cells", m_spreadsheet->name()));
 	QList<Column*> list = selectedColumns();
 	foreach(Column * col_ptr, list) {
 		int col = m_spreadsheet->indexOfChild<Column>(col_ptr);
-		for (int row=first; row<=last; row++)
-			if (isCellSelected(row, col)) col_ptr->setMasked(row);
+		foreach (const Interval<int>& interval, selectedRowIntervals(col))
+			col_ptr->setMasked(interval);
 	}
 	m_spreadsheet->endMacro();
 	RESET_CURSOR;
 }
 
 void SpreadsheetView::unmaskSelection() {
-	int first = firstSelectedRow();
-	int last = lastSelectedRow();
-	if ( first < 0 ) return;
+	if (firstSelectedRow() < 0) return;
 
 	WAIT_CURSOR;
 	m_spreadsheet->beginMacro(i18n("%1: unmask selected cells", m_spreadsheet->name()));
 	QList<Column*> list = selectedColumns();
-	foreach(Column * col_ptr, list)	{
+	foreach(Column * col_ptr, list) {
 		int col = m_spreadsheet->indexOfChild<Column>(col_ptr);
-		for (int row=first; row<=last; row++)
-			if (isCellSelected(row, col)) col_ptr->setMasked(row, false);
+		foreach (const Interval<int>& interval, selectedRowIntervals(col))
+			col_ptr->setMasked(interval, false);
 	}
 	m_spreadsheet->endMacro();
 	RESET_CURSOR;
@@ -1031,10 +1316,12 @@ void SpreadsheetView::fillWithRowNumbers() {
 	                                m_spreadsheet->name(),
 	                                selectedColumnCount()));
 
+	//the row numbers are shared by all columns, replaceValues() doesn't copy them
 	const int rows = m_spreadsheet->rowCount();
 	QVector<double> new_data(rows);
+	double* data = new_data.data();
 	for (int i=0; i<rows; ++i)
-		new_data[i] = i+1;
+		data[i] = i+1;
 
 	foreach(Column* col, selectedColumns()) {
 		if (col->columnMode() != AbstractColumn::Numeric)
@@ -1055,26 +1342,30 @@ void SpreadsheetView::fillSelectedCellsWithRandomNumbers() {
 
 	WAIT_CURSOR;
 	m_spreadsheet->beginMacro(i18n("%1: fill cells with random values", m_spreadsheet->name()));
-	qsrand(QTime::currentTime().msec());
+	//uniform random numbers in [0,1), calculated in parallel with the stream of the column index
+	const unsigned long seed = QTime::currentTime().msec();
 	foreach(Column* col_ptr, selectedColumns()) {
 		int col = m_spreadsheet->indexOfChild<Column>(col_ptr);
+		const bool full = isColumnSelected(col, true);
+		QVector<double> random(last-first+1);
+		nsl_rng_fill(random.data(), random.size(), seed, col, &uniformSample, 0);
+
 		col_ptr->setSuppressDataChangedSignal(true);
 		switch (col_ptr->columnMode()) {
 		case AbstractColumn::Numeric: {
-				QVector<double> results(last-first+1);
-				for (int row=first; row<=last; row++)
-					if (isCellSelected(row, col))
-						results[row-first] = double(qrand())/double(RAND_MAX);
-					else
-						results[row-first] = col_ptr->valueAt(row);
-				col_ptr->replaceValues(first, results);
+				if (!full) {
+					for (int row=first; row<=last; row++)
+						if (!isCellSelected(row, col))
+							random[row-first] = col_ptr->valueAt(row);
+				}
+				col_ptr->replaceValues(first, random);
 				break;
 			}
 		case AbstractColumn::Text: {
 				QStringList results;
 				for (int row=first; row<=last; row++)
-					if (isCellSelected(row, col))
-						results << QString::number(double(qrand())/double(RAND_MAX));
+					if (full || isCellSelected(row, col))
+						results << QString::number(random.at(row-first));
 					else
 						results << col_ptr->textAt(row);
 				col_ptr->replaceTexts(first, results);
@@ -1088,10 +1379,13 @@ void SpreadsheetView::fillSelectedCellsWithRandomNumbers() {
 				QDate latestDate(2999,12,31);
 				QTime midnight(0,0,0,0);
 				for (int row=first; row<=last; row++)
-					if (isCellSelected(row, col))
-						results << QDateTime(
-						            earliestDate.addDays(((double)qrand())*((double)earliestDate.daysTo(latestDate))/((double)RAND_MAX)),
-						            midnight.addMSecs(((qint64)qrand())*1000*60*60*24/RAND_MAX));
+					if (full || isCellSelected(row, col)) {
+						//the fractional part of the day is used for the time
+						const double r = random.at(row-first);
+						const double days = r*earliestDate.daysTo(latestDate);
+						results << QDateTime(earliestDate.addDays((qint64)days),
+						                     midnight.addMSecs((qint64)((days - floor(days))*1000*60*60*24)));
+					}
 					else
 						results << col_ptr->dateTimeAt(row);
 				col_ptr->replaceDateTimes(first, results);
@@ -1153,12 +1447,12 @@ void SpreadsheetView::fillSelectedCellsWithConstValues() {
 					                                      i18n("Value"), 0, -2147483647, 2147483647, 6, &doubleOk);
 				if (doubleOk) {
 					WAIT_CURSOR;
-					QVector<double> results(last-first+1);
-					for (int row=first; row<=last; row++) {
-						if (isCellSelected(row, col))
-							results[row-first] = doubleValue;
-						else
-							results[row-first] = col_ptr->valueAt(row);
+					QVector<double> results(last-first+1, doubleValue);
+					if (!isColumnSelected(col, true)) {
+						for (int row=first; row<=last; row++) {
+							if (!isCellSelected(row, col))
+								results[row-first] = col_ptr->valueAt(row);
+						}
 					}
 					col_ptr->replaceValues(first, results);
 					RESET_CURSOR;
@@ -1171,9 +1465,11 @@ void SpreadsheetView::fillSelectedCellsWithConstValues() {
 					                                    i18n("Value"), QLineEdit::Normal, 0, &stringOk);
 				if (stringOk && !stringValue.isEmpty()) {
 					WAIT_CURSOR;
+					const bool full = isColumnSelected(col, true);
 					QStringList results;
+					results.reserve(last-first+1);
 					for (int row=first; row<=last; row++) {
-						if (isCellSelected(row, col))
+						if (full || isCellSelected(row, col))
 							results << stringValue;
 						else
 							results << col_ptr->textAt(row);
@@ -1425,12 +1721,19 @@ void SpreadsheetView::showRowStatistics() {
 	QString dlgTitle(m_spreadsheet->name() + " row statistics");
 	StatisticsDialog* dlg = new StatisticsDialog(dlgTitle);
 
+	//views of the columns share the data with the columns, only the values of the selected rows are copied
+	const int columnCount = m_spreadsheet->columnCount();
+	QVector<ColumnView> columns;
+	columns.reserve(columnCount);
+	for (int j = 0; j < columnCount; ++j)
+		columns << ColumnView(m_spreadsheet->column(j));
+
 	QList<Column*> list;
 	for (int i = 0; i < m_spreadsheet->rowCount(); ++i) {
 		if (isRowSelected(i)) {
-			QVector<double> rowValues;
-			for (int j = 0; j < m_spreadsheet->columnCount(); ++j)
-				rowValues << m_spreadsheet->column(j)->valueAt(i);
+			QVector<double> rowValues(columnCount);
+			for (int j = 0; j < columnCount; ++j)
+				rowValues[j] = i < columns.at(j).rowCount() ? columns.at(j).valueAt(i) : NAN;
 			list << new Column(QString::number(i+1), rowValues);
 		}
 	}
@@ -1512,27 +1815,49 @@ void SpreadsheetView::clearSelectedRows() {
 }
 
 void SpreadsheetView::clearSelectedCells() {
-	int first = firstSelectedRow();
-	int last = lastSelectedRow();
-	if (first < 0) return;
+	if (firstSelectedRow() < 0) return;
 
 	WAIT_CURSOR;
 	m_spreadsheet->beginMacro(i18n("%1: clear selected cells", m_spreadsheet->name()));
 	QList<Column*> list = selectedColumns();
 	foreach (Column* col_ptr, list) {
 		col_ptr->setSuppressDataChangedSignal(true);
-		if (formulaModeActive()) {
-			int col = m_spreadsheet->indexOfChild<Column>(col_ptr);
-			for (int row = last; row >= first; row--)
-				if (isCellSelected(row, col))
-					col_ptr->setFormula(row, "");
-		} else {
-			int col = m_spreadsheet->indexOfChild<Column>(col_ptr);
-			for (int row = last; row >= first; row--)
-				if (isCellSelected(row, col)) {
-					if (row < col_ptr->rowCount())
-						col_ptr->asStringColumn()->setTextAt(row, QString());
+		int col = m_spreadsheet->indexOfChild<Column>(col_ptr);
+		//one command for each interval of selected rows
+		foreach (const Interval<int>& interval, selectedRowIntervals(col)) {
+			if (formulaModeActive()) {
+				col_ptr->setFormula(interval, "");
+				continue;
+			}
+
+			const int first = interval.start();
+			const int count = qMin(interval.end(), col_ptr->rowCount()-1) - first + 1;
+			if (count <= 0)
+				continue;
+
+			switch (col_ptr->columnMode()) {
+			case AbstractColumn::Numeric:
+				col_ptr->replaceValues(first, QVector<double>(count, NAN));
+				break;
+			case AbstractColumn::Text: {
+					QStringList texts;
+					texts.reserve(count);
+					for (int i = 0; i < count; ++i)
+						texts << QString();
+					col_ptr->replaceTexts(first, texts);
+					break;
+				}
+			case AbstractColumn::DateTime:
+			case AbstractColumn::Month:
+			case AbstractColumn::Day: {
+					QList<QDateTime> dateTimes;
+					dateTimes.reserve(count);
+					for (int i = 0; i < count; ++i)
+						dateTimes << QDateTime();
+					col_ptr->replaceDateTimes(first, dateTimes);
+					break;
 				}
+			}
 		}
 		col_ptr->setSuppressDataChangedSignal(false);
 		col_ptr->setChanged();
@@ -1802,37 +2127,32 @@ void SpreadsheetView::print(QPrinter* printer) const {
 	RESET_CURSOR;
 }
 
-void SpreadsheetView::exportToFile(const QString& path, const bool exportHeader, const QString& separator) const {
-	QFile file(path);
-	if (!file.open(QFile::WriteOnly | QFile::Truncate))
-		return;
+void SpreadsheetView::exportToFile(const QString& path, const bool exportHeader, const QString& separator, const bool fullPrecision) const {
+	AsciiFilter filter;
+	filter.setHeaderEnabled(exportHeader);
+	filter.setSeparatingCharacter(separator);
+	filter.setFullPrecisionEnabled(fullPrecision);
 
-	QTextStream out(&file);
-	const int cols = m_spreadsheet->columnCount();
+	QProgressDialog progress(i18n("Exporting %1...", m_spreadsheet->name()), QString(), 0, 100, const_cast<SpreadsheetView*>(this));
+	progress.setWindowModality(Qt::WindowModal);
+	connect(&filter, SIGNAL(completed(int)), &progress, SLOT(setValue(int)));
 
-	QString sep = separator;
-	sep = sep.replace(QLatin1String("TAB"), QLatin1String("\t"), Qt::CaseInsensitive);
-	sep = sep.replace(QLatin1String("SPACE"), QLatin1String(" "), Qt::CaseInsensitive);
+	filter.write(path, m_spreadsheet);
+	if (!filter.errorString().isEmpty())
+		KMessageBox::error(const_cast<SpreadsheetView*>(this), i18n("Failed to export to %1: %2", path, filter.errorString()));
+}
 
-	//export header (column names)
-	if (exportHeader) {
-		for (int j=0; j<cols; ++j) {
-			out << m_spreadsheet->column(j)->name();
-			if (j!=cols-1)
-				out<<sep;
-		}
-		out << '\n';
-	}
+void SpreadsheetView::exportToColumnarBinary(const QString& path, const bool compression) const {
+	ColumnarBinaryFilter filter;
+	filter.setCompressionEnabled(compression);
 
-	//export values
-	for (int i=0; i<m_spreadsheet->rowCount(); ++i) {
-		for (int j=0; j<cols; ++j) {
-			out << m_spreadsheet->column(j)->asStringColumn()->textAt(i);
-			if (j!=cols-1)
-				out<<sep;
-		}
-		out << '\n';
-	}
+	QProgressDialog progress(i18n("Exporting %1...", m_spreadsheet->name()), QString(), 0, 100, const_cast<SpreadsheetView*>(this));
+	progress.setWindowModality(Qt::WindowModal);
+	connect(&filter, SIGNAL(completed(int)), &progress, SLOT(setValue(int)));
+
+	filter.write(path, m_spreadsheet);
+	if (!filter.errorString().isEmpty())
+		KMessageBox::error(const_cast<SpreadsheetView*>(this), i18n("Failed to export to %1: %2", path, filter.errorString()));
 }
 
 void SpreadsheetView::exportToLaTeX(const QString & path, const bool exportHeaders,
@@ -70,10 +70,12 @@ class SpreadsheetView : public QWidget {
 		int lastSelectedRow(bool full = false);
 		IntervalAttribute<bool> selectedRows(bool full = false);
 		bool isCellSelected(int row, int col);
+		QList< Interval<int> > selectedRowIntervals(int col);
 		void setCellSelected(int row, int col, bool select = true);
 		void setCellsSelected(int first_row, int first_col, int last_row, int last_col, bool select = true);
 		void getCurrentCell(int* row, int* col);
-		void exportToFile(const QString&, const bool, const QString&) const;
+		void exportToFile(const QString&, const bool, const QString&, const bool) const;
+		void exportToColumnarBinary(const QString& path, const bool compression) const;
         void exportToLaTeX(const QString&, const bool exportHeaders,
                            const bool gridLines, const bool captions, const bool latexHeaders,
                            const bool skipEmptyRows,const bool exportEntire) const;
@@ -189,7 +189,7 @@ bool TreeViewComboBox::eventFilter(QObject* object, QEvent* event) {
 
 void TreeViewComboBox::treeViewIndexActivated(const QModelIndex& index) {
 	DEBUG("TreeViewComboBox::treeViewIndexActivated()");
-	if (index.internalPointer()) {
+	if (index.internalPointer() && (index.flags() & Qt::ItemIsSelectable)) {
 		AbstractAspect* aspect = static_cast<AbstractAspect*>(index.internalPointer());
 		const char* currentClassName = aspect->metaObject()->className();
 		foreach (const char* className, m_selectableClasses) {
@@ -292,6 +292,7 @@ void WorksheetView::initActions() {
 	addSmoothCurveAction = new KAction(i18n("xy-curve from a smooth"), cartesianPlotAddNewActionGroup);
 	addFourierFilterCurveAction = new KAction(i18n("xy-curve from a Fourier filter"), cartesianPlotAddNewActionGroup);
 	addFourierTransformCurveAction = new KAction(i18n("xy-curve from a Fourier transform"), cartesianPlotAddNewActionGroup);
+	addPowerSpectrumCurveAction = new KAction(i18n("xy-curve from a power spectrum"), cartesianPlotAddNewActionGroup);
 //	addInterpolationCurveAction = new KAction(KIcon("labplot-xy-interpolation-curve"), i18n("xy-curve from an interpolation"), cartesianPlotAddNewActionGroup);
 //	addSmoothCurveAction = new KAction(KIcon("labplot-xy-smooth-curve"), i18n("xy-curve from a smooth"), cartesianPlotAddNewActionGroup);
 	addFitCurveAction = new KAction(KIcon("labplot-xy-fit-curve"), i18n("xy-curve from a fit to data"), cartesianPlotAddNewActionGroup);
@@ -313,6 +314,7 @@ void WorksheetView::initActions() {
 	addFitAction = new KAction(KIcon("labplot-xy-fit-curve"), i18n("Data fitting"), cartesianPlotAddNewActionGroup);
 	addFourierFilterAction = new KAction(i18n("Fourier filter"), cartesianPlotAddNewActionGroup);
 	addFourierTransformAction = new KAction(i18n("Fourier transform"), cartesianPlotAddNewActionGroup);
+	addPowerSpectrumAction = new KAction(i18n("Power spectrum"), cartesianPlotAddNewActionGroup);
 //	addInterpolationAction = new KAction(KIcon("labplot-xy-interpolation-curve"), i18n("Interpolation"), cartesianPlotAddNewActionGroup);
 //	addSmoothAction = new KAction(KIcon("labplot-xy-smooth-curve"), i18n("Smooth"), cartesianPlotAddNewActionGroup);
 //	addFourierFilterAction = new KAction(KIcon("labplot-xy-fourier_filter-curve"), i18n("Fourier filter"), cartesianPlotAddNewActionGroup);
@@ -431,6 +433,7 @@ void WorksheetView::initMenus() {
 	m_cartesianPlotAddNewMenu->addAction(addFitCurveAction);
 	m_cartesianPlotAddNewMenu->addAction(addFourierFilterCurveAction);
 	m_cartesianPlotAddNewMenu->addAction(addFourierTransformCurveAction);
+	m_cartesianPlotAddNewMenu->addAction(addPowerSpectrumCurveAction);
 	m_cartesianPlotAddNewMenu->addAction(addLegendAction);
 	m_cartesianPlotAddNewMenu->addSeparator();
 	m_cartesianPlotAddNewMenu->addAction(addHorizontalAxisAction);
@@ -520,6 +523,7 @@ void WorksheetView::createAnalysisMenu(QMenu* menu) const {
 	menu->addAction(addFitAction);
 	menu->addAction(addFourierFilterAction);
 	menu->addAction(addFourierTransformAction);
+	menu->addAction(addPowerSpectrumAction);
 }
 
 void WorksheetView::fillToolBar(QToolBar* toolBar) {
@@ -1362,6 +1366,7 @@ void WorksheetView::handleCartesianPlotActions() {
 	addFitCurveAction->setEnabled(plot);
 	addFourierFilterCurveAction->setEnabled(plot);
 	addFourierTransformCurveAction->setEnabled(plot);
+	addPowerSpectrumCurveAction->setEnabled(plot);
 	addHorizontalAxisAction->setEnabled(plot);
 	addVerticalAxisAction->setEnabled(plot);
 	addLegendAction->setEnabled(plot);
@@ -1391,6 +1396,7 @@ void WorksheetView::handleCartesianPlotActions() {
 	addFitAction->setEnabled(plot);
 	addFourierFilterAction->setEnabled(plot);
 	addFourierTransformAction->setEnabled(plot);
+	addPowerSpectrumAction->setEnabled(plot);
 }
 
 void WorksheetView::exportToFile(const QString& path, const ExportFormat format, const ExportArea area, const bool background, const int resolution) {
@@ -1646,6 +1652,8 @@ void WorksheetView::cartesianPlotAdd(CartesianPlot* plot, QAction* action) {
 		plot->addFourierFilterCurve();
 	else if (action == addFourierTransformCurveAction)
 		plot->addFourierTransformCurve();
+	else if (action == addPowerSpectrumCurveAction)
+		plot->addPowerSpectrumCurve();
 	else if (action == addSmoothCurveAction)
 		plot->addSmoothCurve();
 	else if (action == addLegendAction)
@@ -1671,6 +1679,8 @@ void WorksheetView::cartesianPlotAdd(CartesianPlot* plot, QAction* action) {
 		plot->addFourierFilterCurve();
 	else if (action == addFourierTransformAction)
 		plot->addFourierTransformCurve();
+	else if (action == addPowerSpectrumAction)
+		plot->addPowerSpectrumCurve();
 	else if (action == addSmoothAction)
 		plot->addSmoothCurve();
 }
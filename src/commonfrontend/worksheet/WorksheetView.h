@@ -187,6 +187,7 @@ private:
 	QAction* addFitCurveAction;
 	QAction* addFourierFilterCurveAction;
 	QAction* addFourierTransformCurveAction;
+	QAction* addPowerSpectrumCurveAction;
 	QAction* addHorizontalAxisAction;
 	QAction* addVerticalAxisAction;
 	QAction* addLegendAction;
@@ -216,6 +217,7 @@ private:
 	QAction* addFitAction;
 	QAction* addFourierFilterAction;
 	QAction* addFourierTransformAction;
+	QAction* addPowerSpectrumAction;
 
 public slots:
 	void createContextMenu(QMenu*) const;
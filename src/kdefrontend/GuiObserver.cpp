@@ -62,6 +62,7 @@
 #include "kdefrontend/dockwidgets/XYFitCurveDock.h"
 #include "kdefrontend/dockwidgets/XYFourierFilterCurveDock.h"
 #include "kdefrontend/dockwidgets/XYFourierTransformCurveDock.h"
+#include "kdefrontend/dockwidgets/XYPowerSpectrumCurveDock.h"
 #include "kdefrontend/dockwidgets/XYSmoothCurveDock.h"
 #include "kdefrontend/dockwidgets/CustomPointDock.h"
 #include "kdefrontend/dockwidgets/WorksheetDock.h"
@@ -360,6 +361,22 @@ void GuiObserver::selectedAspectsChanged(QList<AbstractAspect*>& selectedAspects
 		mainWindow->xyFourierTransformCurveDock->setCurves(list);
 
 		mainWindow->stackedWidget->setCurrentWidget(mainWindow->xyFourierTransformCurveDock);
+	} else if (className == "XYPowerSpectrumCurve") {
+		mainWindow->m_propertiesDock->setWindowTitle(i18n("Power Spectrum"));
+
+		if (!mainWindow->xyPowerSpectrumCurveDock) {
+			mainWindow->xyPowerSpectrumCurveDock = new XYPowerSpectrumCurveDock(mainWindow->stackedWidget);
+			mainWindow->xyPowerSpectrumCurveDock->setupGeneral();
+			connect(mainWindow->xyPowerSpectrumCurveDock, SIGNAL(info(QString)), mainWindow->statusBar(), SLOT(showMessage(QString)));
+			mainWindow->stackedWidget->addWidget(mainWindow->xyPowerSpectrumCurveDock);
+		}
+
+		QList<XYCurve*> list;
+		foreach (aspect, selectedAspects)
+			list << qobject_cast<XYCurve*>(aspect);
+		mainWindow->xyPowerSpectrumCurveDock->setCurves(list);
+
+		mainWindow->stackedWidget->setCurrentWidget(mainWindow->xyPowerSpectrumCurveDock);
 	} else if (className == "XYFourierFilterCurve") {
 		mainWindow->m_propertiesDock->setWindowTitle(i18n("Fourier Filter"));
 
@@ -74,6 +74,11 @@
 #include <KStatusBar>
 #include <KLocale>
 #include <KFilterDev>
+#include <KStandardDirs>
+
+extern "C" {
+#include "backend/nsl/nsl_dft.h"
+}
 
 /*!
 \class MainWin
@@ -116,6 +121,7 @@ MainWin::MainWin(QWidget *parent, const QString& filename)
 	  xyFitCurveDock(0),
 	  xyFourierFilterCurveDock(0),
 	  xyFourierTransformCurveDock(0),
+	  xyPowerSpectrumCurveDock(0),
 	  worksheetDock(0),
 	  textLabelDock(0),
 	  customPointDock(0),
@@ -134,6 +140,9 @@ MainWin::~MainWin() {
 
 	KGlobal::config()->sync();
 
+	//keep the FFT plans measured in this session
+	nsl_dft_save_wisdom(QFile::encodeName(KGlobal::dirs()->locateLocal("appdata", "fftw_wisdom")).constData());
+
 	if (m_project != 0) {
 		m_mdiArea->closeAllSubWindows();
 		disconnect(m_project, 0, this, 0);
@@ -173,6 +182,9 @@ void MainWin::initGUI(const QString& fileName) {
 	//load recently used projects
 	m_recentProjectsAction->loadEntries( KGlobal::config()->group("Recent Files") );
 
+	//load the FFT plans measured in previous sessions
+	nsl_dft_load_wisdom(QFile::encodeName(KGlobal::dirs()->locateLocal("appdata", "fftw_wisdom")).constData());
+
 	//set the view mode of the mdi area
 	KConfigGroup group = KGlobal::config()->group(QLatin1String("Settings_General"));
 	int viewMode = group.readEntry("ViewMode", 0);
@@ -193,6 +205,9 @@ void MainWin::initGUI(const QString& fileName) {
 	m_autoSaveTimer.setInterval(interval);
 	connect(&m_autoSaveTimer, SIGNAL(timeout()), this, SLOT(autoSaveProject()));
 
+	//memory for the data of undoable changes in columns (in MB)
+	Column::setUndoMemoryLimit(group.readEntry("UndoMemory", 512)*Q_INT64_C(1024)*1024);
+
 	if (!fileName.isEmpty())
 		openProject(fileName);
 	else {
@@ -1475,6 +1490,8 @@ void MainWin::handleSettingsChanges() {
 	interval *= 60*1000;
 	if (interval != m_autoSaveTimer.interval())
 		m_autoSaveTimer.setInterval(interval);
+
+	Column::setUndoMemoryLimit(group.readEntry("UndoMemory", 512)*Q_INT64_C(1024)*1024);
 }
 
 /***************************************************************************************/
@@ -64,6 +64,7 @@ class XYSmoothCurveDock;
 class XYFitCurveDock;
 class XYFourierFilterCurveDock;
 class XYFourierTransformCurveDock;
+class XYPowerSpectrumCurveDock;
 class WorksheetDock;
 class LabelWidget;
 class ImportFileDialog;
@@ -180,6 +181,7 @@ private:
 	XYFitCurveDock* xyFitCurveDock;
 	XYFourierFilterCurveDock* xyFourierFilterCurveDock;
 	XYFourierTransformCurveDock* xyFourierTransformCurveDock;
+	XYPowerSpectrumCurveDock* xyPowerSpectrumCurveDock;
 	WorksheetDock* worksheetDock;
 	LabelWidget* textLabelDock;
 	CustomPointDock* customPointDock;
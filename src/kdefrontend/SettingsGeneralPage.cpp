@@ -42,6 +42,7 @@ SettingsGeneralPage::SettingsGeneralPage(QWidget* parent) : SettingsPage(parent)
 	connect(ui.cbMdiVisibility, SIGNAL(currentIndexChanged(int)), this, SLOT(changed()) );
 	connect(ui.cbTabPosition, SIGNAL(currentIndexChanged(int)), this, SLOT(changed()) );
 	connect(ui.chkAutoSave, SIGNAL(stateChanged(int)), this, SLOT(changed()) );
+	connect(ui.sbUndoMemory, SIGNAL(valueChanged(int)), this, SLOT(changed()) );
 
 	loadSettings();
 	interfaceChanged(ui.cbInterface->currentIndex());
@@ -55,6 +56,7 @@ void SettingsGeneralPage::applySettings() {
 	group.writeEntry(QLatin1String("MdiWindowVisibility"), ui.cbMdiVisibility->currentIndex());
 	group.writeEntry(QLatin1String("AutoSave"), ui.chkAutoSave->isChecked());
 	group.writeEntry(QLatin1String("AutoSaveInterval"), ui.sbAutoSaveInterval->value());
+	group.writeEntry(QLatin1String("UndoMemory"), ui.sbUndoMemory->value());
 }
 
 void SettingsGeneralPage::restoreDefaults() {
@@ -69,6 +71,7 @@ void SettingsGeneralPage::loadSettings() {
 	ui.cbMdiVisibility->setCurrentIndex(group.readEntry(QLatin1String("MdiWindowVisibility"), 0));
 	ui.chkAutoSave->setChecked(group.readEntry<bool>(QLatin1String("AutoSave"), 0));
 	ui.sbAutoSaveInterval->setValue(group.readEntry(QLatin1String("AutoSaveInterval"), 0));
+	ui.sbUndoMemory->setValue(group.readEntry(QLatin1String("UndoMemory"), 512));
 }
 
 void SettingsGeneralPage::retranslateUi() {
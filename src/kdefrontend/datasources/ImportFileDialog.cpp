@@ -32,11 +32,13 @@
 #include "backend/core/AspectTreeModel.h"
 #include "backend/datasources/FileDataSource.h"
 #include "backend/datasources/filters/AbstractFileFilter.h"
+#include "backend/datasources/filters/AsciiFilter.h"
 #include "backend/datasources/filters/HDFFilter.h"
 #include "backend/datasources/filters/NetCDFFilter.h"
 #include "backend/spreadsheet/Spreadsheet.h"
 #include "backend/matrix/Matrix.h"
 #include "backend/core/Workbook.h"
+#include "backend/core/column/Column.h"
 #include "commonfrontend/widgets/TreeViewComboBox.h"
 #include "kdefrontend/MainWin.h"
 
@@ -47,6 +49,13 @@
 #include <QDir>
 #include <QInputDialog>
 #include <KMenu>
+#include <QProgressDialog>
+#include <QThreadPool>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 /*!
 	\class ImportFileDialog
@@ -206,7 +215,16 @@ void ImportFileDialog::importTo(QStatusBar* statusBar) const {
 		return;
 	}
 
-	QString fileName = importFileWidget->fileName();
+	//several files selected -> batch import
+	const QStringList fileNames = importFileWidget->fileNames();
+	if (fileNames.size() > 1 && importFileWidget->currentFileType() != FileDataSource::FITS) {
+		importFilesTo(aspect, fileNames, statusBar);
+		return;
+	}
+
+	//the expanded file name, also if a wildcard matches only one file or the list contains only one file
+	const QString fileName = (importFileWidget->currentFileType() == FileDataSource::FITS || fileNames.isEmpty())
+			? importFileWidget->fileName() : fileNames.first();
 	AbstractFileFilter* filter = importFileWidget->currentFileFilter();
 	AbstractFileFilter::ImportMode mode = AbstractFileFilter::ImportMode(cbPosition->currentIndex());
 
@@ -298,6 +316,213 @@ void ImportFileDialog::importTo(QStatusBar* statusBar) const {
 	delete filter;
 }
 
+/*!
+	reads one file into vectors, used for the parallel import of several ASCII files.
+	Every task uses its own filter since the filter is modified during the import.
+*/
+class AsciiFileReadTask : public QRunnable {
+	public:
+		AsciiFileReadTask(AsciiFilter* filter, const QString& fileName, const QAtomicInt& canceled, QAtomicInt& finished) :
+			m_filter(filter), m_fileName(fileName), m_canceled(canceled), m_finished(finished) {
+			setAutoDelete(false);
+		}
+
+		~AsciiFileReadTask() {
+			delete m_filter;
+		}
+
+		void run() {
+			if (!m_canceled)
+				m_filter->readVectors(m_fileName, vectors, names, &m_canceled);
+			m_finished.ref();
+		}
+
+		QVector<QVector<double> > vectors;
+		QStringList names;
+
+	private:
+		AsciiFilter* m_filter;
+		const QString m_fileName;
+		const QAtomicInt& m_canceled;
+		QAtomicInt& m_finished;
+};
+
+/*!
+	imports the files \c fileNames with the current filter settings.
+	If a workbook is selected, a new spreadsheet is created for every file.
+	If a spreadsheet is selected, the content of all files is concatenated
+	and an additional column with the name of the source file is added.
+	ASCII files are parsed in parallel, the other file types are read one after another.
+*/
+void ImportFileDialog::importFilesTo(AbstractAspect* aspect, const QStringList& fileNames, QStatusBar* statusBar) const {
+	const AbstractFileFilter::ImportMode mode = AbstractFileFilter::ImportMode(cbPosition->currentIndex());
+	const int count = fileNames.size();
+	Spreadsheet* spreadsheet = qobject_cast<Spreadsheet*>(aspect);
+	Workbook* workbook = qobject_cast<Workbook*>(aspect);
+
+	QProgressDialog progress(i18n("Importing %1 files...", count), i18n("Cancel"), 0, count, m_mainWin);
+	progress.setWindowModality(Qt::WindowModal);
+	progress.setMinimumDuration(0);
+
+	QTime timer;
+	timer.start();
+	WAIT_CURSOR;
+
+	if (!spreadsheet && !workbook) {
+		//matrix: import the files one after another
+		Matrix* matrix = qobject_cast<Matrix*>(aspect);
+		for (int i = 0; i < count && !progress.wasCanceled(); ++i) {
+			AbstractFileFilter* filter = importFileWidget->currentFileFilter();
+			filter->read(fileNames.at(i), matrix, i == 0 ? mode : AbstractFileFilter::Append);
+			delete filter;
+			progress.setValue(i + 1);
+		}
+		RESET_CURSOR;
+		statusBar->showMessage( i18n("%1 files imported in %2 seconds.", count, (float)timer.elapsed()/1000) );
+		return;
+	}
+
+	//read the data of all files
+	QVector<QVector<QVector<double> > > data(count);
+	QVector<QStringList> names(count);
+	if (importFileWidget->currentFileType() == FileDataSource::Ascii) {
+		QAtomicInt canceled(0);
+		QAtomicInt finished(0);
+		QThreadPool pool;
+		QList<AsciiFileReadTask*> tasks;
+		for (int i = 0; i < count; ++i) {
+			AsciiFileReadTask* task = new AsciiFileReadTask((AsciiFilter*)importFileWidget->currentFileFilter(), fileNames.at(i), canceled, finished);
+			tasks << task;
+			pool.start(task);
+		}
+
+		//wait until all files were read, keep the progress dialog responsive
+		while (!pool.waitForDone(100)) {
+			progress.setValue(finished);
+			QApplication::processEvents(QEventLoop::AllEvents, 100);
+			if (progress.wasCanceled())
+				canceled = 1;
+		}
+
+		for (int i = 0; i < count; ++i) {
+			data[i] = tasks.at(i)->vectors;
+			names[i] = tasks.at(i)->names;
+		}
+		qDeleteAll(tasks);
+	} else {
+		//read the files to a temporary spreadsheet and take over the numeric data
+		for (int i = 0; i < count && !progress.wasCanceled(); ++i) {
+			AbstractFileFilter* filter = importFileWidget->currentFileFilter();
+			Spreadsheet tmpSpreadsheet(0, QLatin1String("tmp"));
+			filter->read(fileNames.at(i), &tmpSpreadsheet, AbstractFileFilter::Replace);
+			foreach (Column* column, tmpSpreadsheet.children<Column>()) {
+				if (column->columnMode() != AbstractColumn::Numeric)
+					continue;
+				data[i] << *static_cast<QVector<double>*>(column->data());
+				names[i] << column->name();
+			}
+			delete filter;
+			progress.setValue(i + 1);
+		}
+	}
+
+	if (progress.wasCanceled()) {
+		RESET_CURSOR;
+		statusBar->showMessage(i18n("Import canceled."));
+		return;
+	}
+	progress.setValue(count);
+
+	if (workbook) {
+		//one spreadsheet per file
+		for (int i = 0; i < count; ++i) {
+			if (data.at(i).isEmpty())
+				continue;
+
+			Spreadsheet* sheet = new Spreadsheet(0, QFileInfo(fileNames.at(i)).completeBaseName());
+			workbook->addChild(sheet);
+			const int cols = data.at(i).size();
+			const int rows = data.at(i).first().size();
+			QVector<QVector<double>*> dataPointers;
+			sheet->create(dataPointers, AbstractFileFilter::Replace, rows, cols, names.at(i));
+			for (int n = 0; n < cols; ++n)
+				*dataPointers[n] = data.at(i).at(n);
+			finalizeImport(sheet, 0, cols, rows, AbstractFileFilter::Replace);
+		}
+	} else {
+		//concatenate the content of all files, the column names of the first file are used
+		int rows = 0;
+		int cols = 0;
+		QStringList columnNames;
+		for (int i = 0; i < count; ++i) {
+			if (data.at(i).isEmpty())
+				continue;
+			rows += data.at(i).first().size();
+			cols = qMax(cols, data.at(i).size());
+			if (columnNames.isEmpty())
+				columnNames = names.at(i);
+		}
+
+		//the column with the names of the source files is created together with the data columns,
+		//so it is placed next to them and is not undoable separately
+		while (columnNames.size() < cols)
+			columnNames << "Column " + QString::number(columnNames.size() + 1);
+		columnNames = columnNames.mid(0, cols);
+		columnNames << i18n("Source File");
+
+		QVector<QVector<double>*> dataPointers;
+		const int columnOffset = spreadsheet->create(dataPointers, mode, rows, cols + 1, columnNames);
+		QStringList sources;
+		sources.reserve(rows);
+		int startRow = 0;
+		for (int i = 0; i < count; ++i) {
+			if (data.at(i).isEmpty())
+				continue;
+
+			const int fileRows = data.at(i).first().size();
+			for (int n = 0; n < cols; ++n) {
+				double* dest = dataPointers[n]->data() + startRow;
+				if (n < data.at(i).size())
+					memcpy(dest, data.at(i).at(n).constData(), fileRows*sizeof(double));
+				else
+					std::fill(dest, dest + fileRows, NAN);
+			}
+
+			const QString source = QFileInfo(fileNames.at(i)).fileName();
+			for (int r = 0; r < fileRows; ++r)
+				sources << source;
+			startRow += fileRows;
+		}
+		Column* sourceColumn = spreadsheet->column(columnOffset + cols);
+		dataPointers[cols]->clear();
+		sourceColumn->setColumnMode(AbstractColumn::Text);
+		sourceColumn->replaceTexts(0, sources);
+		finalizeImport(spreadsheet, columnOffset, cols + 1, rows, mode);
+		sourceColumn->setComment(i18n("name of the imported file"));
+	}
+
+	RESET_CURSOR;
+	statusBar->showMessage( i18n("%1 files imported in %2 seconds.", count, (float)timer.elapsed()/1000) );
+}
+
+/*!
+	makes the columns of \c spreadsheet filled directly via the data pointers undo/redo-able again
+	and notifies about the changed data.
+*/
+void ImportFileDialog::finalizeImport(Spreadsheet* spreadsheet, int columnOffset, int cols, int rows, AbstractFileFilter::ImportMode mode) {
+	const QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", rows);
+	for (int n = 0; n < cols; ++n) {
+		Column* column = spreadsheet->column(columnOffset + n);
+		column->setComment(comment);
+		column->setUndoAware(true);
+		if (mode == AbstractFileFilter::Replace) {
+			column->setSuppressDataChangedSignal(false);
+			column->setChanged();
+		}
+	}
+	spreadsheet->setUndoAware(true);
+}
+
 void ImportFileDialog::toggleOptions() {
 	importFileWidget->showOptions(!m_showOptions);
 	m_showOptions = !m_showOptions;
@@ -384,10 +609,13 @@ void ImportFileDialog::checkOkButton() {
 
 	QString fileName = importFileWidget->fileName();
 	if (importFileWidget->currentFileType() != FileDataSource::FITS) {
-#ifndef HAVE_WINDOWS
-		if (!fileName.isEmpty() && fileName.left(1) != QDir::separator())
-			fileName = QDir::homePath() + QDir::separator() + fileName;
-#endif
+		//all files must exist if several files were selected
+		const QStringList fileNames = importFileWidget->fileNames();
+		bool exist = !fileNames.isEmpty();
+		foreach (const QString& name, fileNames)
+			exist = exist && QFile::exists(name);
+		enableButtonOk(exist);
+		return;
 	} else {
 		int extensionBraceletPos = -1;
 		if (!fileName.isEmpty()) {
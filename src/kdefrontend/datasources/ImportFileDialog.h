@@ -31,11 +31,14 @@
 #define IMPORTFILEDIALOG_H
 
 #include <KDialog>
+#include "backend/datasources/filters/AbstractFileFilter.h"
 
 class MainWin;
 class ImportFileWidget;
 class FileDataSource;
 class TreeViewComboBox;
+class AbstractAspect;
+class Spreadsheet;
 
 class KMenu;
 class QStatusBar;
@@ -59,6 +62,8 @@ public:
 	void setCurrentIndex(const QModelIndex&);
 private:
 	void setModel(QAbstractItemModel*);
+	void importFilesTo(AbstractAspect*, const QStringList&, QStatusBar*) const;
+	static void finalizeImport(Spreadsheet*, int columnOffset, int cols, int rows, AbstractFileFilter::ImportMode);
 
 	MainWin* m_mainWin;
 	QVBoxLayout* vLayout;
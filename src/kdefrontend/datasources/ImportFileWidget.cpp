@@ -31,6 +31,7 @@ Copyright            : (C) 2009-2017 Alexander Semke (alexander.semke@web.de)
 #include "FileInfoDialog.h"
 #include "backend/datasources/filters/AsciiFilter.h"
 #include "backend/datasources/filters/BinaryFilter.h"
+#include "backend/datasources/filters/ColumnarBinaryFilter.h"
 #include "backend/datasources/filters/HDFFilter.h"
 #include "backend/datasources/filters/NetCDFFilter.h"
 #include "backend/datasources/filters/ImageFilter.h"
@@ -116,6 +117,9 @@ ImportFileWidget::ImportFileWidget(QWidget* parent, const QString& fileName) : Q
 	fitsOptionsWidget.twPreview->setEditTriggers(QAbstractItemView::NoEditTriggers);
 	ui.swOptions->insertWidget(FileDataSource::FITS, fitsw);
 
+	//the columnar binary format is self-describing, there are no format options
+	ui.swOptions->insertWidget(FileDataSource::ColumnarBinary, new QWidget(0));
+
 	// the table widget for preview
 	twPreview = new QTableWidget(ui.tePreview);
 	twPreview->horizontalHeader()->hide();
@@ -266,25 +270,53 @@ void ImportFileWidget::showOptions(bool b) {
 	resize(layout()->minimumSize());
 }
 
+/*!
+	returns the name of the file to be imported. Wildcards and lists of files separated by ';' are expanded
+	(see fileNames()) and the first file is returned. For FITS files the selected extension is appended.
+*/
 QString ImportFileWidget::fileName() const {
-	if (currentFileType() == FileDataSource::FITS) {
-		if (fitsOptionsWidget.twExtensions->currentItem() != 0) {
-			if (fitsOptionsWidget.twExtensions->currentItem()->text(0) != i18n("Primary header")) {
-				return ui.kleFileName->text() + QLatin1String("[") +
-				       fitsOptionsWidget.twExtensions->currentItem()->text(fitsOptionsWidget.twExtensions->currentColumn()) + QLatin1String("]");
-			}
-		}
+	if (currentFileType() != FileDataSource::FITS)
+		return fileNames().value(0);
 
+	if (fitsOptionsWidget.twExtensions->currentItem() != 0) {
+		if (fitsOptionsWidget.twExtensions->currentItem()->text(0) != i18n("Primary header")) {
+			return ui.kleFileName->text() + QLatin1String("[") +
+			       fitsOptionsWidget.twExtensions->currentItem()->text(fitsOptionsWidget.twExtensions->currentColumn()) + QLatin1String("]");
+		}
 	}
 	return ui.kleFileName->text();
 }
 
+/*!
+	returns the list of the files to be imported.
+	Several files can be specified separated by ';', wildcards ('*' and '?') in the file names are expanded.
+*/
+QStringList ImportFileWidget::fileNames() const {
+	QStringList names;
+	foreach (QString name, ui.kleFileName->text().split(';', QString::SkipEmptyParts)) {
+		name = name.trimmed();
+#ifndef HAVE_WINDOWS
+		if (!name.isEmpty() && name.left(1) != QDir::separator())
+			name = QDir::homePath() + QDir::separator() + name;
+#endif
+		if (name.contains('*') || name.contains('?')) {
+			const QFileInfo fileInfo(name);
+			const QDir dir = fileInfo.absoluteDir();
+			foreach (const QString& file, dir.entryList(QStringList() << fileInfo.fileName(), QDir::Files, QDir::Name))
+				names << dir.absoluteFilePath(file);
+		} else if (!name.isEmpty())
+			names << name;
+	}
+
+	return names;
+}
+
 /*!
 	saves the settings to the data source \c source.
 */
 void ImportFileWidget::saveSettings(FileDataSource* source) const {
 	//save the data source information
-	source->setFileName( ui.kleFileName->text() );
+	source->setFileName( fileName() );
 	source->setName( ui.kleSourceName->text() );
 	source->setComment( ui.kleFileName->text() );
 	source->setFileWatched( ui.chbWatchFile->isChecked() );
@@ -397,6 +429,14 @@ AbstractFileFilter* ImportFileWidget::currentFileFilter() const {
 			filter->setEndColumn( ui.sbEndColumn->value());
 			return filter;
 		}
+	case FileDataSource::ColumnarBinary: {
+			ColumnarBinaryFilter* filter = new ColumnarBinaryFilter();
+			filter->setStartRow( ui.sbStartRow->value() );
+			filter->setEndRow( ui.sbEndRow->value() );
+			filter->setStartColumn( ui.sbStartColumn->value() );
+			filter->setEndColumn( ui.sbEndColumn->value() );
+			return filter;
+		}
 	}
 
 	return 0;
@@ -408,10 +448,12 @@ AbstractFileFilter* ImportFileWidget::currentFileFilter() const {
 void ImportFileWidget::selectFile() {
 	KConfigGroup conf(KSharedConfig::openConfig(), "ImportFileWidget");
 	QString dir = conf.readEntry("LastDir", "");
-	QString path = QFileDialog::getOpenFileName(this, i18n("Select the File Data Source"), dir);
-	if (path.isEmpty())
+	const QStringList paths = QFileDialog::getOpenFileNames(this, i18n("Select the File Data Source"), dir);
+	if (paths.isEmpty())
 		return; //cancel was clicked in the file-dialog
 
+	const QString& path = paths.first();
+
 	int pos = path.lastIndexOf(QDir::separator());
 	if (pos != -1) {
 		QString newDir = path.left(pos);
@@ -419,7 +461,8 @@ void ImportFileWidget::selectFile() {
 			conf.writeEntry("LastDir", newDir);
 	}
 
-	ui.kleFileName->setText(path);
+	//several selected files are imported at once
+	ui.kleFileName->setText(paths.join(";"));
 
 	//use the file name as the name of the data source,
 	//if there is no data source name provided yet
@@ -427,11 +470,6 @@ void ImportFileWidget::selectFile() {
 		QString fileName = QFileInfo(path).fileName();
 		ui.kleSourceName->setText(fileName);
 	}
-
-	//TODO: decide whether the selection of several files should be possible
-// 	QStringList filelist = QFileDialog::getOpenFileNames(this,i18n("Select one or more files to open"));
-// 	if (! filelist.isEmpty() )
-// 		ui.kleFileName->setText(filelist.join(";"));
 }
 
 /************** SLOTS **************************************************************/
@@ -442,14 +480,14 @@ void ImportFileWidget::selectFile() {
 	and activates the corresponding options.
 */
 void ImportFileWidget::fileNameChanged(const QString& name) {
-	QString fileName = name;
-#ifndef HAVE_WINDOWS
-	// make relative path
-	if ( !fileName.isEmpty() && fileName.left(1) != QDir::separator())
-		fileName = QDir::homePath() + QDir::separator() + fileName;
-#endif
-
-	bool fileExists = QFile::exists(fileName);
+	Q_UNUSED(name);
+
+	//for several files, the first file is used to determine the file format
+	const QStringList files = fileNames();
+	const QString fileName = files.isEmpty() ? QString() : files.first();
+	bool fileExists = !files.isEmpty();
+	foreach (const QString& file, files)
+		fileExists = fileExists && QFile::exists(file);
 	if (fileExists)
 		ui.kleFileName->setStyleSheet("");
 	else
@@ -484,7 +522,7 @@ void ImportFileWidget::fileNameChanged(const QString& name) {
 	//check, if we can guess the file type by content
 	QProcess *proc = new QProcess(this);
 	QStringList args;
-	args << "-b" << ui.kleFileName->text();
+	args << "-b" << fileName;
 	proc->start("file", args);
 	if (proc->waitForReadyRead(1000) == false) {
 		QDEBUG("ERROR: reading file type of file" << fileName);
@@ -494,7 +532,9 @@ void ImportFileWidget::fileNameChanged(const QString& name) {
 #endif
 
 	QByteArray imageFormat = QImageReader::imageFormat(fileName);
-	if (fileInfo.contains(QLatin1String("compressed data")) || fileInfo.contains(QLatin1String("ASCII")) ||
+	if (ColumnarBinaryFilter::isColumnarBinaryFile(fileName)) {
+		ui.cbFileType->setCurrentIndex(FileDataSource::ColumnarBinary);
+	} else if (fileInfo.contains(QLatin1String("compressed data")) || fileInfo.contains(QLatin1String("ASCII")) ||
 	        fileName.endsWith(QLatin1String("dat"), Qt::CaseInsensitive) || fileName.endsWith(QLatin1String("txt"), Qt::CaseInsensitive)) {
 		//probably ascii data
 		ui.cbFileType->setCurrentIndex(FileDataSource::Ascii);
@@ -618,6 +658,10 @@ void ImportFileWidget::fileTypeChanged(int fileType) {
 		ui.tabWidget->removeTab(1);
 		ui.tabWidget->setCurrentIndex(0);
 		break;
+	case FileDataSource::ColumnarBinary:
+		ui.lFilter->hide();
+		ui.cbFilter->hide();
+		break;
 	default:
 		DEBUG("unknown file type");
 	}
@@ -819,7 +863,8 @@ void ImportFileWidget::fileInfoDialog() {
 void ImportFileWidget::filterChanged(int index) {
 	// ignore filter for these formats
 	if (ui.cbFileType->currentIndex() == FileDataSource::HDF || ui.cbFileType->currentIndex() == FileDataSource::NETCDF
-	        || ui.cbFileType->currentIndex() == FileDataSource::Image || ui.cbFileType->currentIndex() == FileDataSource::FITS) {
+	        || ui.cbFileType->currentIndex() == FileDataSource::Image || ui.cbFileType->currentIndex() == FileDataSource::FITS
+	        || ui.cbFileType->currentIndex() == FileDataSource::ColumnarBinary) {
 		ui.swOptions->setEnabled(true);
 		return;
 	}
@@ -855,17 +900,15 @@ void ImportFileWidget::refreshPreview() {
 	DEBUG("refreshPreview()");
 	WAIT_CURSOR;
 
-	QString fileName = ui.kleFileName->text();
-#ifndef HAVE_WINDOWS
-	if (fileName.left(1) != QDir::separator())
-		fileName = QDir::homePath() + QDir::separator() + fileName;
-#endif
+	//for several files, the first file is shown in the preview
+	const QStringList files = fileNames();
+	QString fileName = files.isEmpty() ? QString() : files.first();
 
 	QList<QStringList> importedStrings;
 	FileDataSource::FileType fileType = (FileDataSource::FileType)ui.cbFileType->currentIndex();
 
 	// generic table widget
-	if (fileType == FileDataSource::Ascii || fileType == FileDataSource::Binary)
+	if (fileType == FileDataSource::Ascii || fileType == FileDataSource::Binary || fileType == FileDataSource::ColumnarBinary)
 		twPreview->show();
 	else
 		twPreview->hide();
@@ -873,13 +916,15 @@ void ImportFileWidget::refreshPreview() {
 	int lines = ui.sbPreviewLines->value();
 
 	bool ok = true;
+	int rowCount = -1;
 	QTableWidget *tmpTableWidget = 0;
 	switch (fileType) {
 	case FileDataSource::Ascii: {
 			ui.tePreview->clear();
 
 			AsciiFilter *filter = (AsciiFilter *)this->currentFileFilter();
-			importedStrings = filter->readData(fileName, NULL, AbstractFileFilter::Replace, lines);
+			importedStrings = filter->preview(fileName, lines);
+			rowCount = filter->estimatedRowCount(fileName);
 			tmpTableWidget = twPreview;
 			break;
 		}
@@ -887,7 +932,17 @@ void ImportFileWidget::refreshPreview() {
 			ui.tePreview->clear();
 
 			BinaryFilter *filter = (BinaryFilter *)this->currentFileFilter();
-			importedStrings = filter->readData(fileName, NULL, AbstractFileFilter::Replace, lines);
+			importedStrings = filter->preview(fileName, lines);
+			rowCount = filter->estimatedRowCount(fileName);
+			tmpTableWidget = twPreview;
+			break;
+		}
+	case FileDataSource::ColumnarBinary: {
+			ui.tePreview->clear();
+
+			ColumnarBinaryFilter *filter = (ColumnarBinaryFilter *)this->currentFileFilter();
+			importedStrings = filter->preview(fileName, lines);
+			rowCount = filter->estimatedRowCount(fileName);
 			tmpTableWidget = twPreview;
 			break;
 		}
@@ -910,7 +965,7 @@ void ImportFileWidget::refreshPreview() {
 	case FileDataSource::NETCDF: {
 			NetCDFFilter *filter = (NetCDFFilter *)this->currentFileFilter();
 			lines = netcdfOptionsWidget.sbPreviewLines->value();
-			importedStrings = filter->readCurrentVar(fileName, NULL, AbstractFileFilter::Replace, lines);
+			importedStrings = filter->preview(fileName, lines);
 			tmpTableWidget = netcdfOptionsWidget.twPreview;
 			break;
 		}
@@ -988,5 +1043,10 @@ void ImportFileWidget::refreshPreview() {
 
 		tmpTableWidget->horizontalHeader()->resizeSections(QHeaderView::ResizeToContents);
 	}
+
+	if (rowCount != -1)
+		tmpTableWidget->setToolTip(i18n("The file contains approx. %1 rows", rowCount));
+	else
+		tmpTableWidget->setToolTip(QString());
 	RESET_CURSOR;
 }
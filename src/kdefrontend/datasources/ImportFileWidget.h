@@ -55,6 +55,7 @@ public:
 	FileDataSource::FileType currentFileType() const;
 	AbstractFileFilter* currentFileFilter() const;
 	QString fileName() const;
+	QStringList fileNames() const;
 	const QStringList selectedHDFNames() const;
 	const QStringList selectedNetCDFNames() const;
 	const QStringList selectedFITSExtensions() const;
@@ -40,6 +40,7 @@
 #include "kdefrontend/GuiTools.h"
 
 #include <QPainter>
+#include <QProgressBar>
 #include <QDir>
 #include <QFileDialog>
 #include <KUrlCompletion>
@@ -59,7 +60,9 @@ XYCurveDock::XYCurveDock(QWidget *parent): QWidget(parent),
 	cbXColumn(0),
 	cbYColumn(0),
 	m_curve(0),
-	m_aspectTreeModel(0) {
+	m_aspectTreeModel(0),
+	m_recalculationProgress(0),
+	m_recalculationProgressBar(0) {
 
 	ui.setupUi(this);
 
@@ -658,6 +661,39 @@ void XYCurveDock::initTabs() {
 	connect(m_curve, SIGNAL(errorBarsTypeChanged(XYCurve::ErrorBarsType)), this, SLOT(curveErrorBarsTypeChanged(XYCurve::ErrorBarsType)));
 	connect(m_curve, SIGNAL(errorBarsPenChanged(QPen)), this, SLOT(curveErrorBarsPenChanged(QPen)));
 	connect(m_curve, SIGNAL(errorBarsOpacityChanged(qreal)), this, SLOT(curveErrorBarsOpacityChanged(qreal)));
+
+	//progress of analysis curves calculated in a worker thread
+	if (m_recalculationProgress) {
+		connect(m_curve, SIGNAL(recalculationStarted()), this, SLOT(curveRecalculationStarted()));
+		connect(m_curve, SIGNAL(completed(int)), this, SLOT(curveRecalculationProgress(int)));
+		connect(m_curve, SIGNAL(recalculationFinished()), this, SLOT(curveRecalculationEnded()));
+		m_recalculationProgressBar->setValue(0);
+		m_recalculationProgress->setVisible(m_curve->isRecalculating());
+	}
+}
+
+/*!
+  adds a progress bar and a button to cancel the calculation of analysis curves in the row of the button \c pbRecalculate.
+  Both are shown while the curve is calculated in a worker thread. Called by the docks of the analysis curves in setupGeneral().
+*/
+void XYCurveDock::setupRecalculationProgress(QPushButton* pbRecalculate) {
+	QGridLayout* layout = static_cast<QGridLayout*>(pbRecalculate->parentWidget()->layout());
+	int row, column, rowSpan, columnSpan;
+	layout->getItemPosition(layout->indexOf(pbRecalculate), &row, &column, &rowSpan, &columnSpan);
+
+	m_recalculationProgress = new QWidget(pbRecalculate->parentWidget());
+	QHBoxLayout* hLayout = new QHBoxLayout(m_recalculationProgress);
+	hLayout->setContentsMargins(0, 0, 0, 0);
+	m_recalculationProgressBar = new QProgressBar(m_recalculationProgress);
+	m_recalculationProgressBar->setRange(0, 100);
+	hLayout->addWidget(m_recalculationProgressBar);
+	QPushButton* pbCancel = new QPushButton(KIcon("process-stop"), i18n("Cancel"), m_recalculationProgress);
+	pbCancel->setToolTip(i18n("Cancel the calculation, the current data of the curve is kept"));
+	hLayout->addWidget(pbCancel);
+	layout->addWidget(m_recalculationProgress, row, 0, 1, column);
+	m_recalculationProgress->hide();
+
+	connect(pbCancel, SIGNAL(clicked()), this, SLOT(cancelRecalculationClicked()));
 }
 
 /*!
@@ -782,6 +818,32 @@ void XYCurveDock::setModelIndexFromColumn(TreeViewComboBox* cb, const AbstractCo
 //*************************************************************
 //********** SLOTs for changes triggered in XYCurveDock ********
 //*************************************************************
+void XYCurveDock::cancelRecalculationClicked() {
+	foreach (XYCurve* curve, m_curvesList)
+		curve->cancelRecalculation();
+}
+
+//*************************************************************
+//********** SLOTs for changes triggered in XYCurve ***********
+//*************************************************************
+void XYCurveDock::curveRecalculationStarted() {
+	if (sender() != m_curve)
+		return;
+
+	m_recalculationProgressBar->setValue(0);
+	m_recalculationProgress->show();
+}
+
+void XYCurveDock::curveRecalculationProgress(int value) {
+	if (sender() == m_curve)
+		m_recalculationProgressBar->setValue(value);
+}
+
+void XYCurveDock::curveRecalculationEnded() {
+	if (sender() == m_curve)
+		m_recalculationProgress->hide();
+}
+
 void XYCurveDock::retranslateUi() {
 	//TODO:
 // 	uiGeneralTab.lName->setText(i18n("Name"));
@@ -42,6 +42,7 @@ class TreeViewComboBox;
 class AspectTreeModel;
 class Column;
 class KUrlCompletion;
+class QProgressBar;
 
 class XYCurveDock : public QWidget {
 	Q_OBJECT
@@ -84,6 +85,11 @@ protected:
 	void initTabs();
 	virtual void setModel();
 	void setModelIndexFromColumn(TreeViewComboBox*, const AbstractColumn*);
+	void setupRecalculationProgress(QPushButton*);
+
+private:
+	QWidget* m_recalculationProgress;
+	QProgressBar* m_recalculationProgressBar;
 
 private slots:
 	void init();
@@ -95,6 +101,7 @@ private slots:
 	void xColumnChanged(const QModelIndex&);
 	void yColumnChanged(const QModelIndex&);
 	void visibilityChanged(bool);
+	void cancelRecalculationClicked();
 
 	//Line-Tab
 	void lineTypeChanged(int);
@@ -166,6 +173,9 @@ private slots:
 	void curveXColumnChanged(const AbstractColumn*);
 	void curveYColumnChanged(const AbstractColumn*);
 	void curveVisibilityChanged(bool);
+	void curveRecalculationStarted();
+	void curveRecalculationProgress(int);
+	void curveRecalculationEnded();
 
 	//Line-Tab
 	void curveLineTypeChanged(XYCurve::LineType);
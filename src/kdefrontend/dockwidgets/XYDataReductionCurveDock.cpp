@@ -29,6 +29,7 @@
 #include "XYDataReductionCurveDock.h"
 #include "backend/core/AspectTreeModel.h"
 #include "backend/core/Project.h"
+#include "backend/core/column/ColumnView.h"
 #include "backend/worksheet/plots/cartesian/XYDataReductionCurve.h"
 #include "commonfrontend/widgets/TreeViewComboBox.h"
 
@@ -41,8 +42,6 @@
 #include <QDebug>
 #endif
 
-#include <cmath>        // isnan
-
 /*!
   \class XYDataReductionCurveDock
  \brief  Provides a widget for editing the properties of the XYDataReductionCurves
@@ -111,6 +110,7 @@ void XYDataReductionCurveDock::setupGeneral() {
 	connect( uiGeneralTab.sbTolerance2, SIGNAL(valueChanged(double)), this, SLOT(tolerance2Changed()) );
 
 	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
 }
 
 void XYDataReductionCurveDock::initGeneralTab() {
@@ -170,6 +170,7 @@ void XYDataReductionCurveDock::initGeneralTab() {
 	connect(m_dataReductionCurve, SIGNAL(yDataColumnChanged(const AbstractColumn*)), this, SLOT(curveYDataColumnChanged(const AbstractColumn*)));
 	connect(m_dataReductionCurve, SIGNAL(dataReductionDataChanged(XYDataReductionCurve::DataReductionData)), this, SLOT(curveDataReductionDataChanged(XYDataReductionCurve::DataReductionData)));
 	connect(m_dataReductionCurve, SIGNAL(sourceDataChangedSinceLastDataReduction()), this, SLOT(enableRecalculate()));
+	connect(m_dataReductionCurve, SIGNAL(recalculationFinished()), this, SLOT(showDataReductionResult()));
 }
 
 void XYDataReductionCurveDock::setModel() {
@@ -237,22 +238,11 @@ void XYDataReductionCurveDock::updateTolerance() {
 	if(xDataColumn == 0 || yDataColumn == 0)
 			return;
 
-	//copy all valid data points for calculating tolerance to temporary vectors
+	//valid data points for calculating the tolerance, shared with the columns if all data points are valid
 	QVector<double> xdataVector;
 	QVector<double> ydataVector;
-	const double xmin = m_dataReductionData.xRange.first();
-	const double xmax = m_dataReductionData.xRange.last();
-	for (int row=0; row<xDataColumn->rowCount(); ++row) {
-		//only copy those data where _all_ values (for x and y, if given) are valid
-		if (!std::isnan(xDataColumn->valueAt(row)) && !std::isnan(yDataColumn->valueAt(row))
-			&& !xDataColumn->isMasked(row) && !yDataColumn->isMasked(row)) {
-				// only when inside given range
-				if (xDataColumn->valueAt(row) >= xmin && xDataColumn->valueAt(row) <= xmax) {
-					xdataVector.append(xDataColumn->valueAt(row));
-					ydataVector.append(yDataColumn->valueAt(row));
-				}
-		}
-	}
+	ColumnView::validData(ColumnView(xDataColumn), ColumnView(yDataColumn),
+			m_dataReductionData.xRange.first(), m_dataReductionData.xRange.last(), xdataVector, ydataVector);
 
 	if(xdataVector.size() > 1) {
 		uiGeneralTab.cbType->setEnabled(true);
@@ -262,21 +252,21 @@ void XYDataReductionCurveDock::updateTolerance() {
 	}
 #ifndef NDEBUG
 	qDebug()<<"automatic tolerance:";
-	qDebug()<<"clip_diag_perpoint ="<<nsl_geom_linesim_clip_diag_perpoint(xdataVector.data(), ydataVector.data(), xdataVector.size());
-	qDebug()<<"clip_area_perpoint ="<<nsl_geom_linesim_clip_area_perpoint(xdataVector.data(), ydataVector.data(), xdataVector.size());
-	qDebug()<<"avg_dist_perpoint ="<<nsl_geom_linesim_avg_dist_perpoint(xdataVector.data(), ydataVector.data(), xdataVector.size());
+	qDebug()<<"clip_diag_perpoint ="<<nsl_geom_linesim_clip_diag_perpoint(xdataVector.constData(), ydataVector.constData(), xdataVector.size());
+	qDebug()<<"clip_area_perpoint ="<<nsl_geom_linesim_clip_area_perpoint(xdataVector.constData(), ydataVector.constData(), xdataVector.size());
+	qDebug()<<"avg_dist_perpoint ="<<nsl_geom_linesim_avg_dist_perpoint(xdataVector.constData(), ydataVector.constData(), xdataVector.size());
 #endif
 
 	nsl_geom_linesim_type type = (nsl_geom_linesim_type)uiGeneralTab.cbType->currentIndex();
 	if (type == nsl_geom_linesim_type_raddist || type == nsl_geom_linesim_type_opheim)
-		m_dataReductionData.tolerance = 10.*nsl_geom_linesim_clip_diag_perpoint(xdataVector.data(), ydataVector.data(), xdataVector.size());
+		m_dataReductionData.tolerance = 10.*nsl_geom_linesim_clip_diag_perpoint(xdataVector.constData(), ydataVector.constData(), xdataVector.size());
 	else if (type == nsl_geom_linesim_type_visvalingam_whyatt)
-		m_dataReductionData.tolerance = 0.1*nsl_geom_linesim_clip_area_perpoint(xdataVector.data(), ydataVector.data(), xdataVector.size());
+		m_dataReductionData.tolerance = 0.1*nsl_geom_linesim_clip_area_perpoint(xdataVector.constData(), ydataVector.constData(), xdataVector.size());
 	else if (type == nsl_geom_linesim_type_douglas_peucker_variant)
 		m_dataReductionData.tolerance = xdataVector.size()/10.;	// reduction to 10%
 	else 
-		m_dataReductionData.tolerance = 2.*nsl_geom_linesim_avg_dist_perpoint(xdataVector.data(), ydataVector.data(), xdataVector.size());
-		//m_dataReductionData.tolerance = nsl_geom_linesim_clip_diag_perpoint(xdataVector.data(), ydataVector.data(), xdataVector.size());
+		m_dataReductionData.tolerance = 2.*nsl_geom_linesim_avg_dist_perpoint(xdataVector.constData(), ydataVector.constData(), xdataVector.size());
+		//m_dataReductionData.tolerance = nsl_geom_linesim_clip_diag_perpoint(xdataVector.constData(), ydataVector.constData(), xdataVector.size());
 	uiGeneralTab.sbTolerance->setValue(m_dataReductionData.tolerance);
 }
 
@@ -516,20 +506,22 @@ void XYDataReductionCurveDock::tolerance2Changed() {
 }
 
 void XYDataReductionCurveDock::recalculateClicked() {
-        //show a progress bar in the status bar
-        QProgressBar* progressBar = new QProgressBar();
-        progressBar->setMinimum(0);
-        progressBar->setMaximum(100);
+	//show a progress bar in the status bar until the calculation in the worker thread is finished
+	QProgressBar* progressBar = new QProgressBar();
+	progressBar->setMinimum(0);
+	progressBar->setMaximum(100);
 	connect(m_curve, SIGNAL(completed(int)), progressBar, SLOT(setValue(int)));
-        statusBar->clearMessage();
-        statusBar->addWidget(progressBar, 1);
+	connect(m_curve, SIGNAL(recalculationFinished()), progressBar, SLOT(deleteLater()));
+	statusBar->clearMessage();
+	statusBar->addWidget(progressBar, 1);
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
 	foreach (XYCurve* curve, m_curvesList)
 		dynamic_cast<XYDataReductionCurve*>(curve)->setDataReductionData(m_dataReductionData);
 
-        QApplication::restoreOverrideCursor();
-        statusBar->removeWidget(progressBar);
+	QApplication::restoreOverrideCursor();
+	if (!m_curve->isRecalculating())
+		delete progressBar;
 
 	uiGeneralTab.pbRecalculate->setEnabled(false);
 }
@@ -551,6 +543,11 @@ void XYDataReductionCurveDock::enableRecalculate() const {
  */
 void XYDataReductionCurveDock::showDataReductionResult() {
 	const XYDataReductionCurve::DataReductionResult& dataReductionResult = m_dataReductionCurve->dataReductionResult();
+	if (m_dataReductionCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
 	if (!dataReductionResult.available) {
 		uiGeneralTab.teResult->clear();
 		return;
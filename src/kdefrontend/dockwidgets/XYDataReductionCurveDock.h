@@ -46,7 +46,6 @@ public:
 
 private:
 	virtual void initGeneralTab();
-	void showDataReductionResult();
 	void updateTolerance();
 	void updateTolerance2();
 
@@ -81,6 +80,7 @@ private slots:
 	void recalculateClicked();
 
 	void enableRecalculate() const;
+	void showDataReductionResult();
 
 	//SLOTs for changes triggered in XYCurve
 	//General-Tab
@@ -105,6 +105,7 @@ void XYDifferentiationCurveDock::setupGeneral() {
 	connect( uiGeneralTab.sbAccOrder, SIGNAL(valueChanged(int)), this, SLOT(accOrderChanged()) );
 
 	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
 }
 
 void XYDifferentiationCurveDock::initGeneralTab() {
@@ -158,6 +159,7 @@ void XYDifferentiationCurveDock::initGeneralTab() {
 	connect(m_differentiationCurve, SIGNAL(yDataColumnChanged(const AbstractColumn*)), this, SLOT(curveYDataColumnChanged(const AbstractColumn*)));
 	connect(m_differentiationCurve, SIGNAL(differentiationDataChanged(XYDifferentiationCurve::DifferentiationData)), this, SLOT(curveDifferentiationDataChanged(XYDifferentiationCurve::DifferentiationData)));
 	connect(m_differentiationCurve, SIGNAL(sourceDataChangedSinceLastDifferentiation()), this, SLOT(enableRecalculate()));
+	connect(m_differentiationCurve, SIGNAL(recalculationFinished()), this, SLOT(showDifferentiationResult()));
 }
 
 void XYDifferentiationCurveDock::setModel() {
@@ -437,6 +439,11 @@ void XYDifferentiationCurveDock::enableRecalculate() const {
  */
 void XYDifferentiationCurveDock::showDifferentiationResult() {
 	const XYDifferentiationCurve::DifferentiationResult& differentiationResult = m_differentiationCurve->differentiationResult();
+	if (m_differentiationCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
 	if (!differentiationResult.available) {
 		uiGeneralTab.teResult->clear();
 		return;
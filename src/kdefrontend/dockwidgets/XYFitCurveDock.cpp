@@ -31,6 +31,8 @@
 #include "backend/core/AspectTreeModel.h"
 #include "backend/core/Project.h"
 #include "commonfrontend/widgets/TreeViewComboBox.h"
+#include "backend/spreadsheet/Spreadsheet.h"
+#include "kdefrontend/widgets/BatchFitDialog.h"
 #include "kdefrontend/widgets/ConstantsWidget.h"
 #include "kdefrontend/widgets/FunctionsWidget.h"
 #include "kdefrontend/widgets/FitOptionsWidget.h"
@@ -128,6 +130,8 @@ void XYFitCurveDock::setupGeneral() {
 	connect( uiGeneralTab.pbParameters, SIGNAL(clicked()), this, SLOT(showParameters()) );
 	connect( uiGeneralTab.pbOptions, SIGNAL(clicked()), this, SLOT(showOptions()) );
 	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
+	connect( uiGeneralTab.pbBatchFit, SIGNAL(clicked()), this, SLOT(batchFitClicked()) );
 }
 
 void XYFitCurveDock::initGeneralTab() {
@@ -185,6 +189,7 @@ void XYFitCurveDock::initGeneralTab() {
 	connect(m_fitCurve, SIGNAL(weightsColumnChanged(const AbstractColumn*)), this, SLOT(curveWeightsColumnChanged(const AbstractColumn*)));
 	connect(m_fitCurve, SIGNAL(fitDataChanged(XYFitCurve::FitData)), this, SLOT(curveFitDataChanged(XYFitCurve::FitData)));
 	connect(m_fitCurve, SIGNAL(sourceDataChangedSinceLastFit()), this, SLOT(enableRecalculate()));
+	connect(m_fitCurve, SIGNAL(recalculationFinished()), this, SLOT(curveRecalculationFinished()));
 }
 
 void XYFitCurveDock::setModel() {
@@ -950,6 +955,27 @@ void XYFitCurveDock::recalculateClicked() {
 	QApplication::restoreOverrideCursor();
 }
 
+/*!
+ * fits the model of the curve to further columns or segments of columns, see XYFitCurve::BatchFit.
+ * The spreadsheet with the results is added next to the curve.
+ */
+void XYFitCurveDock::batchFitClicked() {
+	//apply the current settings first
+	if (uiGeneralTab.pbRecalculate->isEnabled())
+		recalculateClicked();
+
+	BatchFitDialog dlg(m_fitCurve, this);
+	if (dlg.exec() != QDialog::Accepted)
+		return;
+
+	Spreadsheet* results = dlg.results();
+	if (results) {
+		m_fitCurve->folder()->addChild(results);
+		emit info(i18n("Batch fit results '%1' for %2 data sets created.", results->name(), results->rowCount()));
+	} else
+		emit info(i18n("No batch fit results created."));
+}
+
 void XYFitCurveDock::enableRecalculate() const {
 	if (m_initializing)
 		return;
@@ -971,6 +997,11 @@ void XYFitCurveDock::enableRecalculate() const {
  */
 void XYFitCurveDock::showFitResult() {
 	const XYFitCurve::FitResult& fitResult = m_fitCurve->fitResult();
+	if (m_fitCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
 	if (!fitResult.available) {
 		uiGeneralTab.teResult->clear();
 		return;
@@ -1073,6 +1104,15 @@ void XYFitCurveDock::curveFitDataChanged(const XYFitCurve::FitData& data) {
 	m_initializing = false;
 }
 
+/*!
+ * the fit in the worker thread is finished, take over the start values
+ * (changed in the curve if the results are used as start values) and show the result
+ */
+void XYFitCurveDock::curveRecalculationFinished() {
+	m_fitData.paramStartValues = m_fitCurve->fitData().paramStartValues;
+	this->showFitResult();
+}
+
 void XYFitCurveDock::dataChanged() {
 	this->enableRecalculate();
 }
@@ -45,7 +45,6 @@ public:
 
 private:
 	virtual void initGeneralTab();
-	void showFitResult();
 
 	Ui::XYFitCurveDockGeneralTab uiGeneralTab;
 	TreeViewComboBox* cbXDataColumn;
@@ -82,8 +81,11 @@ private slots:
 	void insertFunction(const QString&);
 	void insertConstant(const QString&);
 	void recalculateClicked();
+	void batchFitClicked();
 	void updateModelEquation();
 	void enableRecalculate() const;
+	void showFitResult();
+	void curveRecalculationFinished();
 
 	//SLOTs for changes triggered in XYCurve
 	//General-Tab
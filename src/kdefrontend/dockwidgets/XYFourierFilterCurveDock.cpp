@@ -114,6 +114,7 @@ void XYFourierFilterCurveDock::setupGeneral() {
 
 //	connect( uiGeneralTab.pbOptions, SIGNAL(clicked()), this, SLOT(showOptions()) );
 	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
 }
 
 void XYFourierFilterCurveDock::initGeneralTab() {
@@ -172,6 +173,7 @@ void XYFourierFilterCurveDock::initGeneralTab() {
 	connect(m_filterCurve, SIGNAL(yDataColumnChanged(const AbstractColumn*)), this, SLOT(curveYDataColumnChanged(const AbstractColumn*)));
 	connect(m_filterCurve, SIGNAL(filterDataChanged(XYFourierFilterCurve::FilterData)), this, SLOT(curveFilterDataChanged(XYFourierFilterCurve::FilterData)));
 	connect(m_filterCurve, SIGNAL(sourceDataChangedSinceLastFilter()), this, SLOT(enableRecalculate()));
+	connect(m_filterCurve, SIGNAL(recalculationFinished()), this, SLOT(showFilterResult()));
 }
 
 void XYFourierFilterCurveDock::setModel() {
@@ -544,6 +546,11 @@ void XYFourierFilterCurveDock::enableRecalculate() const {
  */
 void XYFourierFilterCurveDock::showFilterResult() {
 	const XYFourierFilterCurve::FilterResult& filterResult = m_filterCurve->filterResult();
+	if (m_filterCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
 	if (!filterResult.available) {
 		uiGeneralTab.teResult->clear();
 		return;
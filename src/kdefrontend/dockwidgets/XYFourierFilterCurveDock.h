@@ -45,7 +45,6 @@ public:
 
 private:
 	virtual void initGeneralTab();
-	void showFilterResult();
 
 	Ui::XYFourierFilterCurveDockGeneralTab uiGeneralTab;
 	TreeViewComboBox* cbXDataColumn;
@@ -77,6 +76,7 @@ private slots:
 	void recalculateClicked();
 
 	void enableRecalculate() const;
+	void showFilterResult();
 
 	//SLOTs for changes triggered in XYCurve
 	//General-Tab
@@ -103,6 +103,7 @@ void XYFourierTransformCurveDock::setupGeneral() {
 
 //	connect( uiGeneralTab.pbOptions, SIGNAL(clicked()), this, SLOT(showOptions()) );
 	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
 }
 
 void XYFourierTransformCurveDock::initGeneralTab() {
@@ -158,6 +159,7 @@ void XYFourierTransformCurveDock::initGeneralTab() {
 	connect(m_transformCurve, SIGNAL(yDataColumnChanged(const AbstractColumn*)), this, SLOT(curveYDataColumnChanged(const AbstractColumn*)));
 	connect(m_transformCurve, SIGNAL(transformDataChanged(XYFourierTransformCurve::TransformData)), this, SLOT(curveTransformDataChanged(XYFourierTransformCurve::TransformData)));
 	connect(m_transformCurve, SIGNAL(sourceDataChangedSinceLastTransform()), this, SLOT(enableRecalculate()));
+	connect(m_transformCurve, SIGNAL(recalculationFinished()), this, SLOT(showTransformResult()));
 }
 
 void XYFourierTransformCurveDock::setModel() {
@@ -357,6 +359,11 @@ void XYFourierTransformCurveDock::enableRecalculate() const {
  */
 void XYFourierTransformCurveDock::showTransformResult() {
 	const XYFourierTransformCurve::TransformResult& transformResult = m_transformCurve->transformResult();
+	if (m_transformCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
 	if (!transformResult.available) {
 		uiGeneralTab.teResult->clear();
 		return;
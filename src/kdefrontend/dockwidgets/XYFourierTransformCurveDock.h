@@ -45,7 +45,6 @@ public:
 
 private:
 	virtual void initGeneralTab();
-	void showTransformResult();
 
 	Ui::XYFourierTransformCurveDockGeneralTab uiGeneralTab;
 	TreeViewComboBox* cbXDataColumn;
@@ -77,6 +76,7 @@ private slots:
 	void recalculateClicked();
 
 	void enableRecalculate() const;
+	void showTransformResult();
 
 	//SLOTs for changes triggered in XYCurve
 	//General-Tab
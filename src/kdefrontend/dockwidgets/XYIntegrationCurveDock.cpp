@@ -105,6 +105,7 @@ void XYIntegrationCurveDock::setupGeneral() {
 	connect( uiGeneralTab.cbAbsolute, SIGNAL(clicked(bool)), this, SLOT(absoluteChanged()) );
 
 	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
 }
 
 void XYIntegrationCurveDock::initGeneralTab() {
@@ -158,6 +159,7 @@ void XYIntegrationCurveDock::initGeneralTab() {
 	connect(m_integrationCurve, SIGNAL(yDataColumnChanged(const AbstractColumn*)), this, SLOT(curveYDataColumnChanged(const AbstractColumn*)));
 	connect(m_integrationCurve, SIGNAL(integrationDataChanged(XYIntegrationCurve::IntegrationData)), this, SLOT(curveIntegrationDataChanged(XYIntegrationCurve::IntegrationData)));
 	connect(m_integrationCurve, SIGNAL(sourceDataChangedSinceLastIntegration()), this, SLOT(enableRecalculate()));
+	connect(m_integrationCurve, SIGNAL(recalculationFinished()), this, SLOT(showIntegrationResult()));
 }
 
 void XYIntegrationCurveDock::setModel() {
@@ -350,6 +352,11 @@ void XYIntegrationCurveDock::enableRecalculate() const {
  */
 void XYIntegrationCurveDock::showIntegrationResult() {
 	const XYIntegrationCurve::IntegrationResult& integrationResult = m_integrationCurve->integrationResult();
+	if (m_integrationCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
 	if (!integrationResult.available) {
 		uiGeneralTab.teResult->clear();
 		return;
@@ -45,7 +45,6 @@ public:
 
 private:
 	virtual void initGeneralTab();
-	void showIntegrationResult();
 
 	Ui::XYIntegrationCurveDockGeneralTab uiGeneralTab;
 	TreeViewComboBox* cbXDataColumn;
@@ -74,6 +73,7 @@ private slots:
 	void recalculateClicked();
 
 	void enableRecalculate() const;
+	void showIntegrationResult();
 
 	//SLOTs for changes triggered in XYCurve
 	//General-Tab
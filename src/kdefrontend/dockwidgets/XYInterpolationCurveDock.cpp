@@ -125,6 +125,7 @@ void XYInterpolationCurveDock::setupGeneral() {
 	connect( uiGeneralTab.cbPointsMode, SIGNAL(currentIndexChanged(int)), this, SLOT(pointsModeChanged()) );
 
 	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
 }
 
 void XYInterpolationCurveDock::initGeneralTab() {
@@ -187,6 +188,7 @@ void XYInterpolationCurveDock::initGeneralTab() {
 	connect(m_interpolationCurve, SIGNAL(yDataColumnChanged(const AbstractColumn*)), this, SLOT(curveYDataColumnChanged(const AbstractColumn*)));
 	connect(m_interpolationCurve, SIGNAL(interpolationDataChanged(XYInterpolationCurve::InterpolationData)), this, SLOT(curveInterpolationDataChanged(XYInterpolationCurve::InterpolationData)));
 	connect(m_interpolationCurve, SIGNAL(sourceDataChangedSinceLastInterpolation()), this, SLOT(enableRecalculate()));
+	connect(m_interpolationCurve, SIGNAL(recalculationFinished()), this, SLOT(showInterpolationResult()));
 }
 
 void XYInterpolationCurveDock::setModel() {
@@ -570,6 +572,11 @@ void XYInterpolationCurveDock::enableRecalculate() const {
  */
 void XYInterpolationCurveDock::showInterpolationResult() {
 	const XYInterpolationCurve::InterpolationResult& interpolationResult = m_interpolationCurve->interpolationResult();
+	if (m_interpolationCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
 	if (!interpolationResult.available) {
 		uiGeneralTab.teResult->clear();
 		return;
@@ -45,7 +45,6 @@ public:
 
 private:
 	virtual void initGeneralTab();
-	void showInterpolationResult();
 
 	Ui::XYInterpolationCurveDockGeneralTab uiGeneralTab;
 	TreeViewComboBox* cbXDataColumn;
@@ -81,6 +80,7 @@ private slots:
 	void recalculateClicked();
 
 	void enableRecalculate() const;
+	void showInterpolationResult();
 
 	//SLOTs for changes triggered in XYCurve
 	//General-Tab
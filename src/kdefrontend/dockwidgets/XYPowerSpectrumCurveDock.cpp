@@ -0,0 +1,439 @@
+/***************************************************************************
+    File             : XYPowerSpectrumCurveDock.cpp
+    Project          : LabPlot
+    --------------------------------------------------------------------
+    Description      : widget for editing properties of power spectrum curves
+
+ ***************************************************************************/
+
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "XYPowerSpectrumCurveDock.h"
+#include "backend/core/AspectTreeModel.h"
+#include "backend/core/Folder.h"
+#include "backend/core/Project.h"
+#include "backend/matrix/Matrix.h"
+#include "backend/worksheet/plots/cartesian/XYPowerSpectrumCurve.h"
+#include "commonfrontend/widgets/TreeViewComboBox.h"
+
+/*!
+  \class XYPowerSpectrumCurveDock
+ \brief  Provides a widget for editing the properties of the XYPowerSpectrumCurves
+		(2D-curves defined by the power spectrum of the data) currently selected in
+		the project explorer.
+
+  If more then one curves are set, the properties of the first column are shown.
+  The changes of the properties are applied to all curves.
+  The exclusions are the name, the comment and the datasets (columns) of
+  the curves  - these properties can only be changed if there is only one single curve.
+
+  \ingroup kdefrontend
+*/
+
+XYPowerSpectrumCurveDock::XYPowerSpectrumCurveDock(QWidget *parent):
+	XYCurveDock(parent), cbXDataColumn(0), cbYDataColumn(0), m_powerSpectrumCurve(0) {
+
+	//remove the tab "Error bars"
+	ui.tabWidget->removeTab(5);
+}
+
+/*!
+ * 	// Tab "General"
+ */
+void XYPowerSpectrumCurveDock::setupGeneral() {
+	QWidget* generalTab = new QWidget(ui.tabGeneral);
+	uiGeneralTab.setupUi(generalTab);
+
+	QGridLayout* gridLayout = dynamic_cast<QGridLayout*>(generalTab->layout());
+	if (gridLayout) {
+		gridLayout->setContentsMargins(2,2,2,2);
+		gridLayout->setHorizontalSpacing(2);
+		gridLayout->setVerticalSpacing(2);
+	}
+
+	cbXDataColumn = new TreeViewComboBox(generalTab);
+	gridLayout->addWidget(cbXDataColumn, 5, 2, 1, 2);
+	cbYDataColumn = new TreeViewComboBox(generalTab);
+	gridLayout->addWidget(cbYDataColumn, 6, 2, 1, 2);
+
+	for (int i=0; i < NSL_SF_WINDOW_TYPE_COUNT; i++)
+		uiGeneralTab.cbWindowType->addItem(i18n(nsl_sf_window_type_name[i]));
+	for (int i=0; i < NSL_PSD_SCALING_COUNT; i++)
+		uiGeneralTab.cbScaling->addItem(i18n(nsl_psd_scaling_name[i]));
+
+	QHBoxLayout* layout = new QHBoxLayout(ui.tabGeneral);
+	layout->setMargin(0);
+	layout->addWidget(generalTab);
+
+	//Slots
+	connect( uiGeneralTab.leName, SIGNAL(returnPressed()), this, SLOT(nameChanged()) );
+	connect( uiGeneralTab.leComment, SIGNAL(returnPressed()), this, SLOT(commentChanged()) );
+	connect( uiGeneralTab.chkVisible, SIGNAL(clicked(bool)), this, SLOT(visibilityChanged(bool)) );
+	connect( uiGeneralTab.cbAutoRange, SIGNAL(clicked(bool)), this, SLOT(autoRangeChanged()) );
+	connect( uiGeneralTab.sbMin, SIGNAL(valueChanged(double)), this, SLOT(xRangeMinChanged()) );
+	connect( uiGeneralTab.sbMax, SIGNAL(valueChanged(double)), this, SLOT(xRangeMaxChanged()) );
+
+	connect( uiGeneralTab.cbWindowType, SIGNAL(currentIndexChanged(int)), this, SLOT(windowTypeChanged()) );
+	connect( uiGeneralTab.sbSegmentLength, SIGNAL(valueChanged(int)), this, SLOT(segmentLengthChanged()) );
+	connect( uiGeneralTab.sbOverlap, SIGNAL(valueChanged(int)), this, SLOT(overlapChanged()) );
+	connect( uiGeneralTab.cbScaling, SIGNAL(currentIndexChanged(int)), this, SLOT(scalingChanged()) );
+	connect( uiGeneralTab.cbDB, SIGNAL(stateChanged(int)), this, SLOT(dBChanged()) );
+
+	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
+	connect( uiGeneralTab.pbSpectrogram, SIGNAL(clicked()), this, SLOT(spectrogramClicked()) );
+}
+
+void XYPowerSpectrumCurveDock::initGeneralTab() {
+	//if there are more then one curve in the list, disable the tab "general"
+	if (m_curvesList.size()==1) {
+		uiGeneralTab.lName->setEnabled(true);
+		uiGeneralTab.leName->setEnabled(true);
+		uiGeneralTab.lComment->setEnabled(true);
+		uiGeneralTab.leComment->setEnabled(true);
+
+		uiGeneralTab.leName->setText(m_curve->name());
+		uiGeneralTab.leComment->setText(m_curve->comment());
+	}else {
+		uiGeneralTab.lName->setEnabled(false);
+		uiGeneralTab.leName->setEnabled(false);
+		uiGeneralTab.lComment->setEnabled(false);
+		uiGeneralTab.leComment->setEnabled(false);
+
+		uiGeneralTab.leName->setText("");
+		uiGeneralTab.leComment->setText("");
+	}
+
+	//show the properties of the first curve
+	m_powerSpectrumCurve = dynamic_cast<XYPowerSpectrumCurve*>(m_curve);
+	Q_ASSERT(m_powerSpectrumCurve);
+	XYCurveDock::setModelIndexFromColumn(cbXDataColumn, m_powerSpectrumCurve->xDataColumn());
+	XYCurveDock::setModelIndexFromColumn(cbYDataColumn, m_powerSpectrumCurve->yDataColumn());
+	uiGeneralTab.cbAutoRange->setChecked(m_powerSpectrumData.autoRange);
+	uiGeneralTab.sbMin->setValue(m_powerSpectrumData.xRange.first());
+	uiGeneralTab.sbMax->setValue(m_powerSpectrumData.xRange.last());
+	this->autoRangeChanged();
+
+	uiGeneralTab.cbWindowType->setCurrentIndex(m_powerSpectrumData.windowType);
+	uiGeneralTab.sbSegmentLength->setValue(m_powerSpectrumData.segmentLength);
+	uiGeneralTab.sbOverlap->setValue(m_powerSpectrumData.overlap);
+	uiGeneralTab.cbScaling->setCurrentIndex(m_powerSpectrumData.scaling);
+	uiGeneralTab.cbDB->setChecked(m_powerSpectrumData.dB);
+	this->showPowerSpectrumResult();
+
+	//enable the "recalculate"-button if the source data was changed since the last calculation
+	uiGeneralTab.pbRecalculate->setEnabled(m_powerSpectrumCurve->isSourceDataChangedSinceLastPowerSpectrum());
+
+	uiGeneralTab.chkVisible->setChecked( m_curve->isVisible() );
+
+	//Slots
+	connect(m_powerSpectrumCurve, SIGNAL(aspectDescriptionChanged(const AbstractAspect*)), this, SLOT(curveDescriptionChanged(const AbstractAspect*)));
+	connect(m_powerSpectrumCurve, SIGNAL(xDataColumnChanged(const AbstractColumn*)), this, SLOT(curveXDataColumnChanged(const AbstractColumn*)));
+	connect(m_powerSpectrumCurve, SIGNAL(yDataColumnChanged(const AbstractColumn*)), this, SLOT(curveYDataColumnChanged(const AbstractColumn*)));
+	connect(m_powerSpectrumCurve, SIGNAL(powerSpectrumDataChanged(XYPowerSpectrumCurve::PowerSpectrumData)), this, SLOT(curvePowerSpectrumDataChanged(XYPowerSpectrumCurve::PowerSpectrumData)));
+	connect(m_powerSpectrumCurve, SIGNAL(sourceDataChangedSinceLastPowerSpectrum()), this, SLOT(enableRecalculate()));
+	connect(m_powerSpectrumCurve, SIGNAL(recalculationFinished()), this, SLOT(showPowerSpectrumResult()));
+}
+
+void XYPowerSpectrumCurveDock::setModel() {
+	QList<const char*>  list;
+	list<<"Folder"<<"Workbook"<<"Datapicker"<<"DatapickerCurve"<<"Spreadsheet"
+		<<"FileDataSource"<<"Column"<<"Worksheet"<<"CartesianPlot"<<"XYFitCurve";
+	cbXDataColumn->setTopLevelClasses(list);
+	cbYDataColumn->setTopLevelClasses(list);
+
+ 	list.clear();
+	list<<"Column";
+	cbXDataColumn->setSelectableClasses(list);
+	cbYDataColumn->setSelectableClasses(list);
+
+	cbXDataColumn->setModel(m_aspectTreeModel);
+	cbYDataColumn->setModel(m_aspectTreeModel);
+
+	connect( cbXDataColumn, SIGNAL(currentModelIndexChanged(QModelIndex)), this, SLOT(xDataColumnChanged(QModelIndex)) );
+	connect( cbYDataColumn, SIGNAL(currentModelIndexChanged(QModelIndex)), this, SLOT(yDataColumnChanged(QModelIndex)) );
+	XYCurveDock::setModel();
+}
+
+/*!
+  sets the curves. The properties of the curves in the list \c list can be edited in this widget.
+*/
+void XYPowerSpectrumCurveDock::setCurves(QList<XYCurve*> list) {
+	m_initializing=true;
+	m_curvesList=list;
+	m_curve=list.first();
+	m_powerSpectrumCurve = dynamic_cast<XYPowerSpectrumCurve*>(m_curve);
+	Q_ASSERT(m_powerSpectrumCurve);
+	m_aspectTreeModel = new AspectTreeModel(m_curve->project());
+	this->setModel();
+	m_powerSpectrumData = m_powerSpectrumCurve->powerSpectrumData();
+	initGeneralTab();
+	initTabs();
+	m_initializing=false;
+}
+
+//*************************************************************
+//**** SLOTs for changes triggered in XYPowerSpectrumCurveDock *****
+//*************************************************************
+void XYPowerSpectrumCurveDock::nameChanged() {
+	if (m_initializing)
+		return;
+
+	m_curve->setName(uiGeneralTab.leName->text());
+}
+
+void XYPowerSpectrumCurveDock::commentChanged() {
+	if (m_initializing)
+		return;
+
+	m_curve->setComment(uiGeneralTab.leComment->text());
+}
+
+void XYPowerSpectrumCurveDock::xDataColumnChanged(const QModelIndex& index) {
+	if (m_initializing)
+		return;
+
+	AbstractAspect* aspect = static_cast<AbstractAspect*>(index.internalPointer());
+	AbstractColumn* column = 0;
+	if (aspect) {
+		column = dynamic_cast<AbstractColumn*>(aspect);
+		Q_ASSERT(column);
+	}
+
+	foreach(XYCurve* curve, m_curvesList)
+		dynamic_cast<XYPowerSpectrumCurve*>(curve)->setXDataColumn(column);
+
+	if (column != 0) {
+		if (uiGeneralTab.cbAutoRange->isChecked()) {
+			uiGeneralTab.sbMin->setValue(column->minimum());
+			uiGeneralTab.sbMax->setValue(column->maximum());
+		}
+	}
+}
+
+void XYPowerSpectrumCurveDock::yDataColumnChanged(const QModelIndex& index) {
+	if (m_initializing)
+		return;
+
+	AbstractAspect* aspect = static_cast<AbstractAspect*>(index.internalPointer());
+	AbstractColumn* column = 0;
+	if (aspect) {
+		column = dynamic_cast<AbstractColumn*>(aspect);
+		Q_ASSERT(column);
+	}
+
+	foreach(XYCurve* curve, m_curvesList)
+		dynamic_cast<XYPowerSpectrumCurve*>(curve)->setYDataColumn(column);
+}
+
+void XYPowerSpectrumCurveDock::autoRangeChanged() {
+	bool autoRange = uiGeneralTab.cbAutoRange->isChecked();
+	m_powerSpectrumData.autoRange = autoRange;
+
+	if (autoRange) {
+		uiGeneralTab.lMin->setEnabled(false);
+		uiGeneralTab.sbMin->setEnabled(false);
+		uiGeneralTab.lMax->setEnabled(false);
+		uiGeneralTab.sbMax->setEnabled(false);
+		m_powerSpectrumCurve = dynamic_cast<XYPowerSpectrumCurve*>(m_curve);
+		Q_ASSERT(m_powerSpectrumCurve);
+		if (m_powerSpectrumCurve->xDataColumn()) {
+			uiGeneralTab.sbMin->setValue(m_powerSpectrumCurve->xDataColumn()->minimum());
+			uiGeneralTab.sbMax->setValue(m_powerSpectrumCurve->xDataColumn()->maximum());
+		}
+	} else {
+		uiGeneralTab.lMin->setEnabled(true);
+		uiGeneralTab.sbMin->setEnabled(true);
+		uiGeneralTab.lMax->setEnabled(true);
+		uiGeneralTab.sbMax->setEnabled(true);
+	}
+
+}
+void XYPowerSpectrumCurveDock::xRangeMinChanged() {
+	double xMin = uiGeneralTab.sbMin->value();
+
+	m_powerSpectrumData.xRange.first() = xMin;
+	uiGeneralTab.pbRecalculate->setEnabled(true);
+}
+
+void XYPowerSpectrumCurveDock::xRangeMaxChanged() {
+	double xMax = uiGeneralTab.sbMax->value();
+
+	m_powerSpectrumData.xRange.last() = xMax;
+	uiGeneralTab.pbRecalculate->setEnabled(true);
+}
+
+void XYPowerSpectrumCurveDock::windowTypeChanged() {
+	nsl_sf_window_type windowType = (nsl_sf_window_type)uiGeneralTab.cbWindowType->currentIndex();
+	m_powerSpectrumData.windowType = windowType;
+
+	enableRecalculate();
+}
+
+void XYPowerSpectrumCurveDock::segmentLengthChanged() {
+	int segmentLength = uiGeneralTab.sbSegmentLength->value();
+	m_powerSpectrumData.segmentLength = segmentLength;
+
+	//the segments have to advance by at least one point
+	uiGeneralTab.sbOverlap->setMaximum(segmentLength-1);
+
+	enableRecalculate();
+}
+
+void XYPowerSpectrumCurveDock::overlapChanged() {
+	m_powerSpectrumData.overlap = uiGeneralTab.sbOverlap->value();
+
+	enableRecalculate();
+}
+
+void XYPowerSpectrumCurveDock::scalingChanged() {
+	nsl_psd_scaling scaling = (nsl_psd_scaling)uiGeneralTab.cbScaling->currentIndex();
+	m_powerSpectrumData.scaling = scaling;
+
+	enableRecalculate();
+}
+
+void XYPowerSpectrumCurveDock::dBChanged() {
+	m_powerSpectrumData.dB = uiGeneralTab.cbDB->isChecked();
+
+	enableRecalculate();
+}
+
+void XYPowerSpectrumCurveDock::recalculateClicked() {
+
+	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+	foreach(XYCurve* curve, m_curvesList)
+		dynamic_cast<XYPowerSpectrumCurve*>(curve)->setPowerSpectrumData(m_powerSpectrumData);
+
+	uiGeneralTab.pbRecalculate->setEnabled(false);
+	QApplication::restoreOverrideCursor();
+}
+
+/*!
+ * creates a matrix with the short-time Fourier transform of the data of the first curve
+ * next to the curve in the project
+ */
+void XYPowerSpectrumCurveDock::spectrogramClicked() {
+	//apply the current settings first
+	if (uiGeneralTab.pbRecalculate->isEnabled())
+		recalculateClicked();
+
+	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+	Matrix* matrix = m_powerSpectrumCurve->createSpectrogram();
+	if (matrix) {
+		m_powerSpectrumCurve->folder()->addChild(matrix);
+		emit info(i18n("Spectrogram '%1' with %2 segments created.", matrix->name(), matrix->columnCount()));
+	} else
+		emit info(i18n("No spectrogram could be calculated from the data."));
+	QApplication::restoreOverrideCursor();
+}
+
+void XYPowerSpectrumCurveDock::enableRecalculate() const {
+	if (m_initializing)
+		return;
+
+	//no calculation possible without the x- and y-data
+	AbstractAspect* aspectX = static_cast<AbstractAspect*>(cbXDataColumn->currentModelIndex().internalPointer());
+	AbstractAspect* aspectY = static_cast<AbstractAspect*>(cbYDataColumn->currentModelIndex().internalPointer());
+	bool data = (aspectX!=0 && aspectY!=0);
+
+	uiGeneralTab.pbRecalculate->setEnabled(data);
+}
+
+/*!
+ * show the result and details of the power spectrum
+ */
+void XYPowerSpectrumCurveDock::showPowerSpectrumResult() {
+	const XYPowerSpectrumCurve::PowerSpectrumResult& powerSpectrumResult = m_powerSpectrumCurve->powerSpectrumResult();
+	if (m_powerSpectrumCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
+	if (!powerSpectrumResult.available) {
+		uiGeneralTab.teResult->clear();
+		return;
+	}
+
+	QString str = i18n("status:") + ' ' + powerSpectrumResult.status + "<br>";
+
+	if (!powerSpectrumResult.valid) {
+		uiGeneralTab.teResult->setText(str);
+		return; //result is not valid, there was an error which is shown in the status-string, nothing to show more.
+	}
+
+	str += i18n("segments: %1", powerSpectrumResult.segmentCount) + "<br>";
+
+	if (powerSpectrumResult.elapsedTime>1000)
+		str += i18n("calculation time: %1 s").arg(QString::number(powerSpectrumResult.elapsedTime/1000)) + "<br>";
+	else
+		str += i18n("calculation time: %1 ms").arg(QString::number(powerSpectrumResult.elapsedTime)) + "<br>";
+
+ 	str += "<br><br>";
+
+	uiGeneralTab.teResult->setText(str);
+}
+
+//*************************************************************
+//*********** SLOTs for changes triggered in XYCurve **********
+//*************************************************************
+//General-Tab
+void XYPowerSpectrumCurveDock::curveDescriptionChanged(const AbstractAspect* aspect) {
+	if (m_curve != aspect)
+		return;
+
+	m_initializing = true;
+	if (aspect->name() != uiGeneralTab.leName->text()) {
+		uiGeneralTab.leName->setText(aspect->name());
+	} else if (aspect->comment() != uiGeneralTab.leComment->text()) {
+		uiGeneralTab.leComment->setText(aspect->comment());
+	}
+	m_initializing = false;
+}
+
+void XYPowerSpectrumCurveDock::curveXDataColumnChanged(const AbstractColumn* column) {
+	m_initializing = true;
+	XYCurveDock::setModelIndexFromColumn(cbXDataColumn, column);
+	m_initializing = false;
+}
+
+void XYPowerSpectrumCurveDock::curveYDataColumnChanged(const AbstractColumn* column) {
+	m_initializing = true;
+	XYCurveDock::setModelIndexFromColumn(cbYDataColumn, column);
+	m_initializing = false;
+}
+
+void XYPowerSpectrumCurveDock::curvePowerSpectrumDataChanged(const XYPowerSpectrumCurve::PowerSpectrumData& data) {
+	m_initializing = true;
+	m_powerSpectrumData = data;
+	uiGeneralTab.cbWindowType->setCurrentIndex(m_powerSpectrumData.windowType);
+	uiGeneralTab.sbSegmentLength->setValue(m_powerSpectrumData.segmentLength);
+	uiGeneralTab.sbOverlap->setValue(m_powerSpectrumData.overlap);
+	uiGeneralTab.cbScaling->setCurrentIndex(m_powerSpectrumData.scaling);
+	uiGeneralTab.cbDB->setChecked(m_powerSpectrumData.dB);
+
+	this->showPowerSpectrumResult();
+	m_initializing = false;
+}
+
+void XYPowerSpectrumCurveDock::dataChanged() {
+	this->enableRecalculate();
+}
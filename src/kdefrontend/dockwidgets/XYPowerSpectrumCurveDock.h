@@ -0,0 +1,91 @@
+/***************************************************************************
+    File             : XYPowerSpectrumCurveDock.h
+    Project          : LabPlot
+    --------------------------------------------------------------------
+    Description      : widget for editing properties of power spectrum curves
+
+ ***************************************************************************/
+
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef XYPOWERSPECTRUMCURVEDOCK_H
+#define XYPOWERSPECTRUMCURVEDOCK_H
+
+#include "kdefrontend/dockwidgets/XYCurveDock.h"
+#include "backend/worksheet/plots/cartesian/XYPowerSpectrumCurve.h"
+#include "ui_xypowerspectrumcurvedockgeneraltab.h"
+
+class TreeViewComboBox;
+
+class XYPowerSpectrumCurveDock: public XYCurveDock {
+	Q_OBJECT
+
+public:
+	explicit XYPowerSpectrumCurveDock(QWidget *parent);
+	void setCurves(QList<XYCurve*>);
+	virtual void setupGeneral();
+
+private:
+	virtual void initGeneralTab();
+
+	Ui::XYPowerSpectrumCurveDockGeneralTab uiGeneralTab;
+	TreeViewComboBox* cbXDataColumn;
+	TreeViewComboBox* cbYDataColumn;
+
+	XYPowerSpectrumCurve* m_powerSpectrumCurve;
+	XYPowerSpectrumCurve::PowerSpectrumData m_powerSpectrumData;
+
+protected:
+	virtual void setModel();
+
+private slots:
+	//SLOTs for changes triggered in XYPowerSpectrumCurveDock
+	//general tab
+	void nameChanged();
+	void commentChanged();
+	void xDataColumnChanged(const QModelIndex&);
+	void yDataColumnChanged(const QModelIndex&);
+	void autoRangeChanged();
+	void xRangeMinChanged();
+	void xRangeMaxChanged();
+	void windowTypeChanged();
+	void segmentLengthChanged();
+	void overlapChanged();
+	void scalingChanged();
+	void dBChanged();
+
+	void recalculateClicked();
+	void spectrogramClicked();
+
+	void enableRecalculate() const;
+	void showPowerSpectrumResult();
+
+	//SLOTs for changes triggered in XYCurve
+	//General-Tab
+	void curveDescriptionChanged(const AbstractAspect*);
+	void curveXDataColumnChanged(const AbstractColumn*);
+	void curveYDataColumnChanged(const AbstractColumn*);
+	void curvePowerSpectrumDataChanged(const XYPowerSpectrumCurve::PowerSpectrumData&);
+	void dataChanged();
+
+};
+
+#endif
@@ -120,6 +120,7 @@ void XYSmoothCurveDock::setupGeneral() {
 	connect( uiGeneralTab.sbRightValue, SIGNAL(valueChanged(double)), this, SLOT(valueChanged()) );
 
 	connect( uiGeneralTab.pbRecalculate, SIGNAL(clicked()), this, SLOT(recalculateClicked()) );
+	setupRecalculationProgress(uiGeneralTab.pbRecalculate);
 }
 
 void XYSmoothCurveDock::initGeneralTab() {
@@ -185,6 +186,7 @@ void XYSmoothCurveDock::initGeneralTab() {
 	connect(m_smoothCurve, SIGNAL(yDataColumnChanged(const AbstractColumn*)), this, SLOT(curveYDataColumnChanged(const AbstractColumn*)));
 	connect(m_smoothCurve, SIGNAL(smoothDataChanged(XYSmoothCurve::SmoothData)), this, SLOT(curveSmoothDataChanged(XYSmoothCurve::SmoothData)));
 	connect(m_smoothCurve, SIGNAL(sourceDataChangedSinceLastSmooth()), this, SLOT(enableRecalculate()));
+	connect(m_smoothCurve, SIGNAL(recalculationFinished()), this, SLOT(showSmoothResult()));
 }
 
 void XYSmoothCurveDock::setModel() {
@@ -467,6 +469,11 @@ void XYSmoothCurveDock::enableRecalculate() const {
  */
 void XYSmoothCurveDock::showSmoothResult() {
 	const XYSmoothCurve::SmoothResult& smoothResult = m_smoothCurve->smoothResult();
+	if (m_smoothCurve->isRecalculating()) {
+		uiGeneralTab.teResult->setText(i18n("calculating..."));
+		return;
+	}
+
 	if (!smoothResult.available) {
 		uiGeneralTab.teResult->clear();
 		return;
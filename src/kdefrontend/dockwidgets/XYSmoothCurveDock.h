@@ -45,7 +45,6 @@ public:
 
 private:
 	virtual void initGeneralTab();
-	void showSmoothResult();
 
 	Ui::XYSmoothCurveDockGeneralTab uiGeneralTab;
 	TreeViewComboBox* cbXDataColumn;
@@ -79,6 +78,7 @@ private slots:
 	void recalculateClicked();
 
 	void enableRecalculate() const;
+	void showSmoothResult();
 
 	//SLOTs for changes triggered in XYCurve
 	//General-Tab
@@ -30,6 +30,8 @@
 #include "backend/lib/macros.h"
 #include "backend/spreadsheet/Spreadsheet.h"
 
+#include <cmath>
+
 /*!
 	\class EquidistantValuesDialog
 	\brief Dialog for equidistant values.
@@ -151,16 +153,15 @@ void EquidistantValuesDialog::generate() {
 	if (m_spreadsheet->rowCount()<number)
 		m_spreadsheet->setRowCount(number);
 
+	//the values are calculated once and shared by all columns, the rows behind them are cleared
+	QVector<double> new_data(m_spreadsheet->rowCount(), NAN);
+	double* data = new_data.data();
+	for (int i=0; i<number; ++i)
+		data[i] = start + dist*i;
+
 	foreach(Column* col, m_columns) {
 		col->setSuppressDataChangedSignal(true);
-
-		if (m_spreadsheet->rowCount()>number)
-			col->clear();
-
-		for (int i=0; i<number; ++i) {
-			col->setValueAt(i, start + dist*i);
-		}
-
+		col->replaceValues(0, new_data);
 		col->setSuppressDataChangedSignal(false);
 		col->setChanged();
 	}
@@ -52,6 +52,7 @@ ExportSpreadsheetDialog::ExportSpreadsheetDialog(QWidget* parent) : KDialog(pare
 	ui.cbFormat->addItem("Binary");
 	ui.cbFormat->addItem("LaTeX");
 	ui.cbFormat->addItem("FITS");
+	ui.cbFormat->addItem(i18n("LabPlot columnar binary"));
 
 	ui.cbSeparator->addItem("TAB");
 	ui.cbSeparator->addItem("SPACE");
@@ -98,6 +99,8 @@ ExportSpreadsheetDialog::ExportSpreadsheetDialog(QWidget* parent) : KDialog(pare
 	ui.chkMatrixVHeader->setChecked(conf.readEntry("MatrixVerticalHeader", true));
 	ui.chkMatrixVHeader->setChecked(conf.readEntry("FITSSpreadsheetColumnsUnits", true));
 	ui.cbExportToFITS->setCurrentIndex(conf.readEntry("FITSTo", 0));
+	ui.chkCompression->setChecked(conf.readEntry("ColumnarCompression", true));
+	ui.chkFullPrecision->setChecked(conf.readEntry("FullPrecision", false));
 	m_showOptions = conf.readEntry("ShowOptions", false);
 	ui.gbOptions->setVisible(m_showOptions);
 	m_showOptions ? setButtonText(KDialog::User1,i18n("Hide Options")) : setButtonText(KDialog::User1,i18n("Show Options"));
@@ -120,6 +123,8 @@ ExportSpreadsheetDialog::~ExportSpreadsheetDialog() {
 	conf.writeEntry("MatrixHorizontalHeader", ui.chkMatrixHHeader->isChecked());
 	conf.writeEntry("FITSTo", ui.cbExportToFITS->currentIndex());
 	conf.writeEntry("FITSSpreadsheetColumnsUnits", ui.chkColumnsAsUnits->isChecked());
+	conf.writeEntry("ColumnarCompression", ui.chkCompression->isChecked());
+	conf.writeEntry("FullPrecision", ui.chkFullPrecision->isChecked());
 
 	saveDialogSize(conf);
 	delete urlCompletion;
@@ -152,7 +157,7 @@ void ExportSpreadsheetDialog::setMatrixMode(bool b) {
 		ui.chkExportHeader->hide();
 		ui.lEmptyRows->hide();
 		ui.chkEmptyRows->hide();
-		if (ui.cbFormat->currentIndex() != 3) {
+		if (ui.cbFormat->currentIndex() != 3 && ui.cbFormat->currentIndex() != 4) {
 			ui.chkMatrixHHeader->show();
 			ui.chkMatrixVHeader->show();
 			ui.lMatrixHHeader->show();
@@ -219,6 +224,14 @@ bool ExportSpreadsheetDialog::commentsAsUnitsFits() const {
 	return ui.chkColumnsAsUnits->isChecked();
 }
 
+bool ExportSpreadsheetDialog::compression() const {
+	return ui.chkCompression->isChecked();
+}
+
+bool ExportSpreadsheetDialog::fullPrecision() const {
+	return ui.chkFullPrecision->isChecked();
+}
+
 QString ExportSpreadsheetDialog::separator() const {
 	return ui.cbSeparator->currentText();
 }
@@ -302,7 +315,7 @@ void ExportSpreadsheetDialog::selectFile() {
  */
 void ExportSpreadsheetDialog::formatChanged(int index) {
 	QStringList extensions;
-	extensions << ".txt" << ".bin" << ".tex" << ".fits";
+	extensions << ".txt" << ".bin" << ".tex" << ".fits" << ".lcb";
 	QString path = ui.kleFileName->text();
 	int i = path.indexOf(".");
 	if (index != 1) {
@@ -406,6 +419,28 @@ void ExportSpreadsheetDialog::formatChanged(int index) {
 		ui.lExportHeader->hide();
 	}
 
+	//the columnar binary format always contains the column names, only the compression can be chosen
+	if (ui.cbFormat->currentIndex() == 4) {
+		ui.cbSeparator->hide();
+		ui.lSeparator->hide();
+		ui.chkExportHeader->hide();
+		ui.lExportHeader->hide();
+		ui.lCompression->show();
+		ui.chkCompression->show();
+	} else {
+		ui.lCompression->hide();
+		ui.chkCompression->hide();
+	}
+
+	//the numeric values are formatted only in the ASCII export (also used for "Binary")
+	if (ui.cbFormat->currentIndex() <= 1) {
+		ui.lFullPrecision->show();
+		ui.chkFullPrecision->show();
+	} else {
+		ui.lFullPrecision->hide();
+		ui.chkFullPrecision->hide();
+	}
+
 	setFormat(static_cast<Format>(index));
 	ui.kleFileName->setText(path);
 }
@@ -57,6 +57,8 @@ public:
 	QString separator() const;
 	int exportToFits() const;
 	bool commentsAsUnitsFits() const;
+	bool compression() const;
+	bool fullPrecision() const;
 	void setExportTo(const QStringList& to);
 	void setExportToImage(bool possible);
 
@@ -65,6 +67,7 @@ public:
 		Binary,
 		LaTeX,
 		FITS,
+		ColumnarBinary
 	};
 
 	Format format() const;
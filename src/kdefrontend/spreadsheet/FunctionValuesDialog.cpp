@@ -29,9 +29,9 @@
 #include "backend/core/AspectTreeModel.h"
 #include "backend/core/column/Column.h"
 #include "backend/core/Project.h"
-#include "backend/gsl/ExpressionParser.h"
 #include "backend/lib/macros.h"
 #include "backend/spreadsheet/Spreadsheet.h"
+#include "backend/spreadsheet/FormulaEngine.h"
 #include "commonfrontend/widgets/TreeViewComboBox.h"
 #include "kdefrontend/widgets/ConstantsWidget.h"
 #include "kdefrontend/widgets/FunctionsWidget.h"
@@ -103,6 +103,13 @@ void FunctionValuesDialog::setColumns(QList<Column*> list) {
 	m_columns = list;
 	ui.teEquation->setPlainText(m_columns.first()->formula());
 
+	//the columns to be generated can't be used as variables of their own formula,
+	//such a formula would be a circular dependency and would never be calculated
+	QList<const AbstractAspect*> targets;
+	foreach (const Column* col, m_columns)
+		targets << col;
+	m_aspectTreeModel->setNonSelectableAspects(targets);
+
 	const QStringList& variableNames = m_columns.first()->formulaVariableNames();
 	if (!variableNames.size()) {
 		//no formular was used for this column -> add the first variable "x"
@@ -121,7 +128,7 @@ void FunctionValuesDialog::setColumns(QList<Column*> list) {
 			foreach (const AbstractAspect* aspect, columns) {
 				if (aspect->path() == columnPathes.at(i)) {
 					const AbstractColumn* column = dynamic_cast<const AbstractColumn*>(aspect);
-					if (column)
+					if (column && !targets.contains(aspect))
 						m_variableDataColumns[i]->setCurrentModelIndex(m_aspectTreeModel->modelIndexOfAspect(column));
 					else
 						m_variableDataColumns[i]->setCurrentModelIndex(QModelIndex());
@@ -150,7 +157,7 @@ void FunctionValuesDialog::checkValues() {
 
 		TreeViewComboBox* cb = m_variableDataColumns.at(i);
 		AbstractAspect* aspect = static_cast<AbstractAspect*>(cb->currentModelIndex().internalPointer());
-		if (!aspect) {
+		if (!aspect || m_columns.contains(dynamic_cast<Column*>(aspect))) {
 			enableButton(KDialog::Ok, false);
 			return;
 		}
@@ -223,7 +230,14 @@ void FunctionValuesDialog::addVariable() {
 	cb->setTopLevelClasses(m_topLevelClasses);
 	cb->setSelectableClasses(m_selectableClasses);
 	cb->setModel(m_aspectTreeModel.get());
-	cb->setCurrentModelIndex(m_aspectTreeModel->modelIndexOfAspect(m_spreadsheet->column(0)));
+
+	//preselect the first column of the spreadsheet that is not generated
+	foreach (Column* column, m_spreadsheet->children<Column>()) {
+		if (!m_columns.contains(column)) {
+			cb->setCurrentModelIndex(m_aspectTreeModel->modelIndexOfAspect(column));
+			break;
+		}
+	}
 
 	//move the add-button to the next row
 	layout->removeWidget(ui.bAddVariable);
@@ -294,11 +308,9 @@ void FunctionValuesDialog::generate() {
 									m_spreadsheet->name(),
 									m_columns.size()));
 
-	//determine variable names and the data vectors of the specified columns
+	//determine variable names and the pathes of the specified columns
 	QStringList variableNames;
 	QStringList columnPathes;
-	QVector<QVector<double>*> xVectors;
-	QVector<Column*> xColumns;
 	int maxRowCount = m_spreadsheet->rowCount();
 	for (int i=0; i<m_variableNames.size(); ++i) {
 		variableNames << m_variableNames.at(i)->text().simplified();
@@ -308,8 +320,6 @@ void FunctionValuesDialog::generate() {
 		Column* column = dynamic_cast<Column*>(aspect);
 		Q_ASSERT(column);
 		columnPathes << column->path();
-		xColumns << column;
-		xVectors << static_cast<QVector<double>* >(column->data());
 
 		if (column->rowCount()>maxRowCount)
 			maxRowCount = column->rowCount();
@@ -319,23 +329,12 @@ void FunctionValuesDialog::generate() {
 	if (m_spreadsheet->rowCount()<maxRowCount)
 		m_spreadsheet->setRowCount(maxRowCount);
 
-	//create new vector for storing the calculated values
-	//the vectors with the variable data can be smaller then the result vector. So, not all values in the result vector might get initialized.
-	//->"clean" the result vector first
-	QVector<double> new_data(maxRowCount);
-	for (int i=0; i<new_data.size(); ++i)
-		new_data[i] = NAN;
-
-	//evaluate the expression for f(x_1, x_2, ...) and write the calculated values into a new vector.
-	ExpressionParser* parser = ExpressionParser::getInstance();
+	//store the expression, variable names and the used data columns and calculate the new values.
+	//the formula columns depending on the columns are recalculated too.
 	const QString& expression = ui.teEquation->toPlainText();
-	parser->evaluateCartesian(expression, variableNames, xVectors, &new_data);
-
-	//set the new values and store the expression, variable names and the used data columns
-	foreach(Column* col, m_columns) {
+	foreach(Column* col, m_columns)
 		col->setFormula(expression, variableNames, columnPathes);
-		col->replaceValues(0, new_data);
-	}
+	m_spreadsheet->project()->formulaEngine()->recalculate(m_columns);
 
 	m_spreadsheet->endMacro();
 	RESET_CURSOR;
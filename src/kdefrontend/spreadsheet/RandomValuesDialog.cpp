@@ -35,7 +35,6 @@
 extern "C" {
 #include "backend/nsl/nsl_sf_stats.h"
 #include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
 }
 
 /*!
@@ -121,6 +120,7 @@ void RandomValuesDialog::distributionChanged(int index) {
 	ui.lParameter3->hide();
 	ui.kleParameter3->hide();
 	ui.lFunc->setText("p(x) =");
+	ui.kleParameter1->setToolTip(QString());
 
 	switch (dist) {
 	case nsl_sf_stats_gaussian:
@@ -144,6 +144,7 @@ void RandomValuesDialog::distributionChanged(int index) {
 		ui.kleParameter2->hide();
 		ui.lParameter1->setText(QString::fromUtf8("λ ="));
 		ui.kleParameter1->setText("1.0");
+		ui.kleParameter1->setToolTip(i18n("Rate λ, the mean of the generated values is 1/λ"));
 		break;
 	case nsl_sf_stats_laplace:
 		ui.lParameter1->setText(QString::fromUtf8("\u03c3 ="));
@@ -343,10 +344,11 @@ void RandomValuesDialog::checkValues() {
 void RandomValuesDialog::generate() {
 	Q_ASSERT(m_spreadsheet);
 
-	//create a generator chosen by the environment variable GSL_RNG_TYPE
+	//the values are calculated in parallel with the counter-based generator of nsl_rng with the seed
+	//given by the environment variable GSL_RNG_SEED. Column i uses the stream i, so the values are
+	//reproducible and don't depend on the number of threads.
 	gsl_rng_env_setup();
-	const gsl_rng_type* T = gsl_rng_default;
-	gsl_rng* r = gsl_rng_alloc(T);
+	const unsigned long seed = gsl_rng_default_seed;
 
 	WAIT_CURSOR;
 	foreach (Column* col, m_columns)
@@ -358,321 +360,15 @@ void RandomValuesDialog::generate() {
 
 	int index = ui.cbDistribution->currentIndex();
 	nsl_sf_stats_distribution dist = (nsl_sf_stats_distribution)ui.cbDistribution->itemData(index).toInt();
+	const double parameters[3] = {ui.kleParameter1->text().toDouble(), ui.kleParameter2->text().toDouble(),
+		ui.kleParameter3->text().toDouble()};
 
 	const int rows = m_spreadsheet->rowCount();
-	QVector<double> new_data(rows);
-
-	switch (dist) {
-	case nsl_sf_stats_gaussian: {
-		double mu = ui.kleParameter1->text().toDouble();
-		double sigma = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_gaussian(r, sigma) + mu;
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_gaussian_tail: {
-		double mu = ui.kleParameter1->text().toDouble();
-		double sigma = ui.kleParameter2->text().toDouble();
-		double a = ui.kleParameter3->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_gaussian_tail(r, a, sigma) + mu;
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_exponential: {
-		double mu = ui.kleParameter1->text().toDouble();
-		mu = 1./mu; //GSL uses the inverse for exp. distrib.
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_exponential(r, mu);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_laplace: {
-		double s = ui.kleParameter1->text().toDouble();
-		double mu = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_laplace(r, s) + mu;
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_exponential_power: {
-		double mu = ui.kleParameter1->text().toDouble();
-		double a = ui.kleParameter2->text().toDouble();
-		double b = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_exppow(r, a, b) + mu;
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_cauchy_lorentz: {
-		double gamma = ui.kleParameter1->text().toDouble();
-		double mu = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_cauchy(r, gamma) + mu;
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_rayleigh: {
-		double s = ui.kleParameter1->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_rayleigh(r, s);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_rayleigh_tail: {
-		double sigma = ui.kleParameter1->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_rayleigh(r, sigma);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_landau:
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_landau(r);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	case nsl_sf_stats_levy_alpha_stable: {
-		double c = ui.kleParameter1->text().toDouble();
-		double alpha = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_levy(r, c, alpha);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_levy_skew_alpha_stable: {
-		double c = ui.kleParameter1->text().toDouble();
-		double alpha = ui.kleParameter2->text().toDouble();
-		double beta = ui.kleParameter3->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_levy_skew(r, c, alpha, beta);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_gamma: {
-		double a = ui.kleParameter1->text().toDouble();
-		double b = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_gamma(r, a, b);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_flat: {
-		double a = ui.kleParameter1->text().toDouble();
-		double b = ui.kleParameter2->text().toDouble();
-		foreach(Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_flat(r, a, b);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_lognormal: {
-		double s = ui.kleParameter1->text().toDouble();
-		double mu = ui.kleParameter2->text().toDouble();
-		foreach(Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_lognormal(r, mu, s);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_chi_squared: {
-		double n = ui.kleParameter1->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_chisq(r, n);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_fdist: {
-		double nu1 = ui.kleParameter1->text().toDouble();
-		double nu2 = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_fdist(r, nu1, nu2);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_tdist: {
-		double nu = ui.kleParameter1->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_tdist(r, nu);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_beta: {
-		double a = ui.kleParameter1->text().toDouble();
-		double b = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_beta(r, a, b);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_logistic: {
-		double s = ui.kleParameter1->text().toDouble();
-		double mu = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_logistic(r, s) + mu;
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_pareto: {
-		double a = ui.kleParameter1->text().toDouble();
-		double b = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_pareto(r, a, b);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_weibull: {
-		double k = ui.kleParameter1->text().toDouble();
-		double l = ui.kleParameter2->text().toDouble();
-		double mu = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_weibull(r, l, k) + mu;
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_gumbel1: {
-		double s = ui.kleParameter1->text().toDouble();
-		double b = ui.kleParameter2->text().toDouble();
-		double mu = ui.kleParameter3->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_gumbel1(r, 1./s, b) + mu;
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_gumbel2: {
-		double a = ui.kleParameter1->text().toDouble();
-		double b = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_gumbel2(r, a, b);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_poisson: {
-		double l = ui.kleParameter1->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_poisson(r, l);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_bernoulli: {
-		double p = ui.kleParameter1->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_bernoulli(r, p);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_binomial: {
-		double p = ui.kleParameter1->text().toDouble();
-		double n = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_binomial(r, p, n);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_negative_bionomial: {
-		double p = ui.kleParameter1->text().toDouble();
-		double n = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_negative_binomial(r, p, n);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_pascal: {
-		double p = ui.kleParameter1->text().toDouble();
-		double n = ui.kleParameter2->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_pascal(r, p, n);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_geometric: {
-		double p = ui.kleParameter1->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_geometric(r, p);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_hypergeometric: {
-		double n1 = ui.kleParameter1->text().toDouble();
-		double n2 = ui.kleParameter2->text().toDouble();
-		double t = ui.kleParameter3->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_hypergeometric(r, n1, n2, t);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_logarithmic: {
-		double p = ui.kleParameter1->text().toDouble();
-		foreach (Column* col, m_columns) {
-			for (int i = 0; i < rows; ++i)
-				new_data[i] = gsl_ran_logarithmic(r, p);
-			col->replaceValues(0, new_data);
-		}
-		break;
-	}
-	case nsl_sf_stats_maxwell_boltzmann:	// additional non-GSL distros
-	case nsl_sf_stats_sech:
-	case nsl_sf_stats_levy:
-	case nsl_sf_stats_frechet:
-		break;
+	for (int i = 0; i < m_columns.size(); ++i) {
+		//the values are generated directly into the vector shared with the column in replaceValues()
+		QVector<double> new_data(rows);
+		if (nsl_sf_stats_random_fill(dist, parameters, new_data.data(), rows, seed, i) == 0)
+			m_columns.at(i)->replaceValues(0, new_data);
 	}
 
 	foreach (Column* col, m_columns) {
@@ -681,6 +377,4 @@ void RandomValuesDialog::generate() {
 	}
 	m_spreadsheet->endMacro();
 	RESET_CURSOR;
-
-	gsl_rng_free(r);
 }
@@ -0,0 +1,158 @@
+/***************************************************************************
+    File                 : BatchFitDialog.cpp
+    Project              : LabPlot
+    Description          : Dialog for fitting the model of a fit curve to many data sets
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#include "BatchFitDialog.h"
+#include "backend/core/column/Column.h"
+#include "backend/spreadsheet/Spreadsheet.h"
+#include "backend/worksheet/plots/cartesian/XYFitCurve.h"
+
+#include <QComboBox>
+#include <QFutureWatcher>
+#include <QGroupBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLayout>
+#include <QProgressDialog>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <KLocale>
+#include <KIcon>
+
+/*!
+	\class BatchFitDialog
+	\brief Dialog for applying the fit of a fit curve (model, start values, limits) to many pairs of x- and y-data columns
+	or to segments of columns of the spreadsheet containing the y-data of the curve.
+
+	The fits are done in the background with a progress dialog and can be canceled.
+	The parameters, their errors and the goodness-of-fit of all fits are written into a new spreadsheet.
+
+	\ingroup kdefrontend
+ */
+BatchFitDialog::BatchFitDialog(XYFitCurve* curve, QWidget* parent, Qt::WFlags fl) : KDialog(parent, fl),
+	m_fitCurve(curve), m_results(0) {
+
+	setWindowIcon(KIcon("run-build"));
+	setWindowTitle(i18n("Batch fit"));
+	setSizeGripEnabled(true);
+
+	QGroupBox* widget = new QGroupBox(i18n("Data sets"));
+	QGridLayout* layout = new QGridLayout(widget);
+	layout->setSpacing(4);
+	layout->setContentsMargins(4,4,4,4);
+
+	twDataSets = new QTableWidget(0, 2);
+	twDataSets->setHorizontalHeaderLabels(QStringList() << i18n("y-data") << i18n("x-data"));
+	twDataSets->horizontalHeader()->setStretchLastSection(true);
+	twDataSets->verticalHeader()->hide();
+	twDataSets->setSelectionMode(QAbstractItemView::NoSelection);
+	layout->addWidget(twDataSets, 0, 0, 1, 2);
+
+	layout->addWidget(new QLabel(i18n("Segments per column")), 1, 0);
+	sbSegments = new QSpinBox();
+	sbSegments->setRange(1, 100000);
+	sbSegments->setToolTip(i18n("Number of parts of equal size each column is divided into, the parts are fitted separately"));
+	layout->addWidget(sbSegments, 1, 1);
+
+	setMainWidget(widget);
+
+	setButtons(KDialog::Ok | KDialog::Cancel);
+	setButtonText(KDialog::Ok, i18n("&Fit"));
+
+	//one row per numeric column of the spreadsheet containing the y-data of the curve, the y-data column is selected.
+	//the x-data of each row can be any of these columns, the x-data column of the curve is used by default.
+	const AbstractColumn* yDataColumn = curve->yDataColumn();
+	if (yDataColumn && yDataColumn->parentAspect()) {
+		foreach (const Column* column, yDataColumn->parentAspect()->children<Column>()) {
+			if (column->columnMode() == AbstractColumn::Numeric)
+				m_columns << column;
+		}
+	}
+
+	const int xIndex = qMax(m_columns.indexOf(curve->xDataColumn()), 0);
+	twDataSets->setRowCount(m_columns.size());
+	for (int i = 0; i < m_columns.size(); ++i) {
+		QTableWidgetItem* item = new QTableWidgetItem(m_columns.at(i)->name());
+		item->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled);
+		item->setCheckState(m_columns.at(i) == yDataColumn ? Qt::Checked : Qt::Unchecked);
+		twDataSets->setItem(i, 0, item);
+
+		QComboBox* cbXData = new QComboBox();
+		foreach (const AbstractColumn* column, m_columns)
+			cbXData->addItem(column->name());
+		cbXData->setCurrentIndex(xIndex);
+		twDataSets->setCellWidget(i, 1, cbXData);
+	}
+	twDataSets->resizeColumnToContents(0);
+
+	connect(this, SIGNAL(okClicked()), this, SLOT(fit()));
+	connect(twDataSets, SIGNAL(itemChanged(QTableWidgetItem*)), this, SLOT(checkColumns()));
+	checkColumns();
+
+	this->resize(400,0);
+}
+
+/*!
+ * the spreadsheet with the results of the batch fit or 0 if no fit was done or if the fit was canceled
+ */
+Spreadsheet* BatchFitDialog::results() const {
+	return m_results;
+}
+
+void BatchFitDialog::checkColumns() {
+	bool checked = false;
+	for (int i = 0; i < twDataSets->rowCount() && !checked; ++i)
+		checked = (twDataSets->item(i, 0)->checkState() == Qt::Checked);
+
+	enableButtonOk(checked);
+}
+
+void BatchFitDialog::fit() {
+	QVector<const AbstractColumn*> xDataColumns;
+	QVector<const AbstractColumn*> yDataColumns;
+	for (int i = 0; i < twDataSets->rowCount(); ++i) {
+		if (twDataSets->item(i, 0)->checkState() == Qt::Checked) {
+			const QComboBox* cbXData = static_cast<QComboBox*>(twDataSets->cellWidget(i, 1));
+			xDataColumns << m_columns.at(cbXData->currentIndex());
+			yDataColumns << m_columns.at(i);
+		}
+	}
+
+	XYFitCurve::BatchFit batchFit(m_fitCurve, xDataColumns, yDataColumns, sbSegments->value());
+	QProgressDialog progress(i18np("Fitting %1 data set...", "Fitting %1 data sets...", batchFit.dataSetCount()), i18n("Cancel"), 0, 0, this);
+	progress.setWindowModality(Qt::WindowModal);
+	QFutureWatcher<void> watcher;
+	connect(&watcher, SIGNAL(progressRangeChanged(int,int)), &progress, SLOT(setRange(int,int)));
+	connect(&watcher, SIGNAL(progressValueChanged(int)), &progress, SLOT(setValue(int)));
+	connect(&watcher, SIGNAL(finished()), &progress, SLOT(reset()));
+	connect(&progress, SIGNAL(canceled()), &watcher, SLOT(cancel()));
+	const QFuture<void> future = batchFit.start();
+	watcher.setFuture(future);
+	if (!future.isFinished())
+		progress.exec();
+	batchFit.waitForFinished();
+
+	m_results = batchFit.results();
+}
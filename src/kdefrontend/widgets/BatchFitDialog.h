@@ -0,0 +1,59 @@
+/***************************************************************************
+    File                 : BatchFitDialog.h
+    Project              : LabPlot
+    Description          : Dialog for fitting the model of a fit curve to many data sets
+    --------------------------------------------------------------------
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef BATCHFITDIALOG_H
+#define BATCHFITDIALOG_H
+
+#include <KDialog>
+
+class AbstractColumn;
+class Spreadsheet;
+class XYFitCurve;
+class QTableWidget;
+class QSpinBox;
+
+class BatchFitDialog : public KDialog {
+	Q_OBJECT
+
+	public:
+		explicit BatchFitDialog(XYFitCurve*, QWidget* parent = 0, Qt::WFlags fl = 0);
+
+		Spreadsheet* results() const;
+
+	private slots:
+		void fit();
+		void checkColumns();
+
+	private:
+		XYFitCurve* m_fitCurve;
+		QList<const AbstractColumn*> m_columns;	//numeric columns available as x- and y-data
+		Spreadsheet* m_results;
+
+		QTableWidget* twDataSets;
+		QSpinBox* sbSegments;
+};
+
+#endif